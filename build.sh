@@ -6,7 +6,7 @@ BUILD_PATH="build"
 BUILD_TYPE="${1:-Debug}"
 SHADER_DIR="shaders"
 SHADER_OUT_DIR="${BUILD_PATH}/shaders"
-SHADERS=("atomic_sum.comp" "vector_add.comp")
+SHADERS=("atomic_sum.comp" "vector_add.comp" "atomic_sum_bda.comp" "vector_add_bda.comp")
 
 # Clean previous build
 echo "Cleaning previous build..."
@@ -0,0 +1,211 @@
+/**
+ * @file examples/allocator.c
+ * @brief Multi-threaded stress benchmark for the Vulkan host allocator.
+ *
+ * Each worker keeps a small working set of blocks and replaces random slots with
+ * fresh allocations of 16-512 bytes, alternating OBJECT and COMMAND scope, the way
+ * a driver does while building pipelines and recording command buffers.
+ *
+ * The same workload runs against a single shared PageAllocator (the previous
+ * callback path) and against vkc_allocator_callbacks(), for 1, 2, 4, ... threads
+ * and then the number of online cores, followed by the allocator's per-scope telemetry.
+ * No GPU is required.
+ *
+ * Usage: ./build/examples/allocator [operations-per-thread]
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "allocator/page.h"
+#include "vk/allocator.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_SLOTS 256
+#define BENCH_MIN_SIZE 16
+#define BENCH_MAX_SIZE 512
+
+typedef enum BenchBackend {
+    BENCH_PAGE,
+    BENCH_VKC,
+} BenchBackend;
+
+typedef struct BenchWorker {
+    pthread_t thread;
+    BenchBackend backend;
+    PageAllocator* pager;
+    const VkAllocationCallbacks* callbacks;
+    size_t operations;
+    uint32_t seed;
+} BenchWorker;
+
+static inline uint32_t bench_next(uint32_t* state) {
+    // xorshift32: cheap and reproducible per worker
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Next thread count: powers of two, then the core count when it is not one.
+ */
+static size_t bench_step(size_t threads, long cores) {
+    size_t next = threads * 2;
+    return threads < (size_t) cores && next > (size_t) cores ? (size_t) cores : next;
+}
+
+static void* bench_worker(void* arg) {
+    BenchWorker* worker = (BenchWorker*) arg;
+    void* slots[BENCH_SLOTS] = {0};
+    uint32_t state = worker->seed;
+
+    for (size_t i = 0; i < worker->operations; i++) {
+        uint32_t r = bench_next(&state);
+        size_t slot = r % BENCH_SLOTS;
+        size_t size = BENCH_MIN_SIZE + (r >> 8) % (BENCH_MAX_SIZE - BENCH_MIN_SIZE + 1);
+        VkSystemAllocationScope scope = (r & 0x80000000u) ? VK_SYSTEM_ALLOCATION_SCOPE_OBJECT
+                                                          : VK_SYSTEM_ALLOCATION_SCOPE_COMMAND;
+
+        if (BENCH_PAGE == worker->backend) {
+            if (slots[slot]) {
+                page_free(worker->pager, slots[slot]);
+            }
+            slots[slot] = page_malloc(worker->pager, size, alignof(max_align_t));
+        } else {
+            const VkAllocationCallbacks* cb = worker->callbacks;
+            if (slots[slot]) {
+                cb->pfnFree(cb->pUserData, slots[slot]);
+            }
+            slots[slot] = cb->pfnAllocation(cb->pUserData, size, alignof(max_align_t), scope);
+        }
+
+        if (slots[slot]) {
+            *(volatile uint8_t*) slots[slot] = (uint8_t) i; // Touch the block
+        }
+    }
+
+    for (size_t slot = 0; slot < BENCH_SLOTS; slot++) {
+        if (!slots[slot]) {
+            continue;
+        }
+        if (BENCH_PAGE == worker->backend) {
+            page_free(worker->pager, slots[slot]);
+        } else {
+            worker->callbacks->pfnFree(worker->callbacks->pUserData, slots[slot]);
+        }
+    }
+
+    return NULL;
+}
+
+static double bench_run(BenchBackend backend, size_t threads, size_t operations) {
+    PageAllocator* pager = NULL;
+    if (BENCH_PAGE == backend) {
+        pager = page_allocator_create(1024);
+        if (!pager) {
+            return 0.0;
+        }
+    }
+
+    BenchWorker* workers = calloc(threads, sizeof(*workers));
+    if (!workers) {
+        if (pager) {
+            page_allocator_free(pager);
+        }
+        return 0.0;
+    }
+
+    double start = bench_now();
+    size_t started = 0;
+    for (; started < threads; started++) {
+        workers[started] = (BenchWorker) {
+            .backend = backend,
+            .pager = pager,
+            .callbacks = vkc_allocator_callbacks(),
+            .operations = operations,
+            .seed = 0x9E3779B9u ^ (uint32_t) (started + 1),
+        };
+        int error = pthread_create(&workers[started].thread, NULL, bench_worker, &workers[started]);
+        if (0 != error) {
+            LOG_ERROR("[Bench] Failed to start worker %zu: %s.", started, strerror(error));
+            break;
+        }
+    }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    double elapsed = bench_now() - start;
+
+    free(workers);
+    if (pager) {
+        page_allocator_free(pager);
+    }
+
+    // A short run would not be comparable with the other thread counts.
+    if (started < threads) {
+        return 0.0;
+    }
+    return (double) (threads * operations) / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    size_t operations = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        cores = 1;
+    }
+
+    if (!vkc_allocator_create()) {
+        LOG_ERROR("[Bench] Failed to create the Vulkan host allocator.");
+        return EXIT_FAILURE;
+    }
+
+    printf("threads  page (Mops/s)  vkc (Mops/s)  vkc scaling\n");
+    double baseline = 0.0;
+    for (size_t threads = 1; threads <= (size_t) cores; threads = bench_step(threads, cores)) {
+        double page = bench_run(BENCH_PAGE, threads, operations);
+        double vkc = bench_run(BENCH_VKC, threads, operations);
+        if (1 == threads) {
+            baseline = vkc;
+        }
+        printf("%7zu  %13.2f  %12.2f  %10.2fx\n", threads, page, vkc, vkc / baseline);
+    }
+
+    VkcAllocatorStats stats;
+    if (vkc_allocator_stats(&stats)) {
+        static const char* scopes[VKC_ALLOCATOR_SCOPE_COUNT] = {
+            "command", "object", "cache", "device", "instance"
+        };
+        printf("\nscope     live (B)   peak (B)     allocations  frees        reallocs\n");
+        for (size_t i = 0; i < VKC_ALLOCATOR_SCOPE_COUNT; i++) {
+            VkcAllocatorScopeStats* s = &stats.scopes[i];
+            printf(
+                "%-8s  %9llu  %9llu  %11llu  %11llu  %8llu\n",
+                scopes[i],
+                (unsigned long long) s->live_bytes,
+                (unsigned long long) s->peak_bytes,
+                (unsigned long long) s->allocations,
+                (unsigned long long) s->frees,
+                (unsigned long long) s->reallocations
+            );
+        }
+    }
+
+    vkc_allocator_destroy();
+    return EXIT_SUCCESS;
+}
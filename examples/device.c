@@ -35,11 +35,13 @@ int main(void) {
     /** @} */
 
     /**
-     * @name Initialize Global Allocators
+     * @name Initialize the Allocation Context
+     * @brief Everything created for this device allocates from its own context.
      * @{
      */
 
-    if (!vkc_allocator_create()) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    if (!context) {
         return EXIT_FAILURE;
     }
 
@@ -54,7 +56,7 @@ int main(void) {
         "VK_LAYER_KHRONOS_validation",
     };
 
-    VkcInstanceLayer* layer = vkc_instance_layer_create();
+    VkcInstanceLayer* layer = vkc_instance_layer_create(context);
     VkcInstanceLayerMatch* layer_match = vkc_instance_layer_match_create(
         layer, validation_layers, 1
     );
@@ -72,7 +74,7 @@ int main(void) {
         "VK_EXT_debug_utils",
     };
 
-    VkcInstanceExtension* extension = vkc_instance_extension_create();
+    VkcInstanceExtension* extension = vkc_instance_extension_create(context);
     VkcInstanceExtensionMatch* extension_match = vkc_instance_extension_match_create(
         extension, extension_names, 3
     );
@@ -84,14 +86,14 @@ int main(void) {
      * @{
      */
 
-    VkcInstance* instance = vkc_instance_create(layer_match, extension_match);
+    VkcInstance* instance = vkc_instance_create(context, layer_match, extension_match);
     if (!instance) {
         goto cleanup_instance_layer;
     }
 
     /** @} */
 
-    VkcDeviceList* device_list = vkc_device_list_create(instance->object);
+    VkcDeviceList* device_list = vkc_device_list_create(context, instance->object);
     if (!device_list) {
         goto cleanup_instance;
     }
@@ -119,9 +121,7 @@ int main(void) {
     vkc_instance_layer_match_free(layer_match);
     vkc_instance_layer_free(layer);
 
-    if (!vkc_allocator_destroy()) {
-        return EXIT_FAILURE;
-    }
+    vkc_allocator_context_destroy(context);
 
 #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
     LOG_DEBUG("[VkCompute] Debug Mode: Exit Success");
@@ -147,7 +147,7 @@ cleanup_instance_layer:
     vkc_instance_extension_free(extension);
     vkc_instance_layer_match_free(layer_match);
     vkc_instance_layer_free(layer);
-    vkc_allocator_destroy();
+    vkc_allocator_context_destroy(context);
 
 #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
     LOG_DEBUG("[VkCompute] Debug Mode: Exit Failure");
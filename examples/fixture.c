@@ -0,0 +1,172 @@
+/**
+ * @file examples/fixture.c
+ * @brief Device setup shared by the benchmark examples.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool example_fail(const ExampleDeviceInfo* info, const char* message) {
+    if (!info->quiet) {
+        LOG_ERROR("[Example] %s", message);
+    }
+    return false;
+}
+
+/**
+ * @brief Collect the wanted extensions the device exposes into `names`, setting `found`.
+ */
+static uint32_t example_extensions(
+    ExampleDevice* device, const ExampleDeviceInfo* info, const char** names
+) {
+    uint32_t available = 0;
+    vkEnumerateDeviceExtensionProperties(device->physical, NULL, &available, NULL);
+    VkExtensionProperties* properties = calloc(available ? available : 1, sizeof(*properties));
+    if (!properties) {
+        return 0;
+    }
+    vkEnumerateDeviceExtensionProperties(device->physical, NULL, &available, properties);
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < info->extension_count && i < 32; i++) {
+        for (uint32_t j = 0; j < available; j++) {
+            if (0 == strcmp(properties[j].extensionName, info->extensions[i].name)) {
+                device->found |= 1u << i;
+                names[kept++] = info->extensions[i].name;
+                break;
+            }
+        }
+    }
+    free(properties);
+    return kept;
+}
+
+bool example_device_create(ExampleDevice* device, const ExampleDeviceInfo* info) {
+    VkApplicationInfo application = {
+        .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+        .pApplicationName = info->name,
+        .apiVersion = VK_API_VERSION_1_1,
+    };
+    VkInstanceCreateInfo instance_info = {
+        .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pApplicationInfo = &application,
+    };
+    if (VK_SUCCESS != vkCreateInstance(&instance_info, NULL, &device->instance)) {
+        return example_fail(info, "Failed to create instance.");
+    }
+
+    uint32_t count = 1;
+    VkResult result = vkEnumeratePhysicalDevices(device->instance, &count, &device->physical);
+    if ((VK_SUCCESS != result && VK_INCOMPLETE != result) || 0 == count) {
+        return example_fail(info, "No physical device.");
+    }
+
+    // Any family can copy: graphics and compute queues support transfers implicitly.
+    VkQueueFamilyProperties families[16];
+    count = 16;
+    vkGetPhysicalDeviceQueueFamilyProperties(device->physical, &count, families);
+    VkQueueFlags copy = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+    device->queue_family = UINT32_MAX;
+    for (uint32_t i = 0; i < count && UINT32_MAX == device->queue_family; i++) {
+        if (families[i].queueFlags & copy) {
+            device->queue_family = i;
+        }
+    }
+    if (UINT32_MAX == device->queue_family) {
+        return example_fail(info, "No queue family supports transfers.");
+    }
+
+    const char* names[32];
+    uint32_t enabled = example_extensions(device, info, names);
+    VkcMemoryPoolFlags flags = info->flags;
+    for (uint32_t i = 0; i < info->extension_count && i < 32; i++) {
+        if (device->found & (1u << i)) {
+            flags |= info->extensions[i].flags;
+        }
+    }
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+        .queueFamilyIndex = device->queue_family,
+        .queueCount = 1,
+        .pQueuePriorities = &priority,
+    };
+    VkDeviceCreateInfo device_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .queueCreateInfoCount = 1,
+        .pQueueCreateInfos = &queue_info,
+        .enabledExtensionCount = enabled,
+        .ppEnabledExtensionNames = enabled ? names : NULL,
+    };
+    if (VK_SUCCESS != vkCreateDevice(device->physical, &device_info, NULL, &device->device)) {
+        return example_fail(info, "Failed to create device.");
+    }
+    vkGetDeviceQueue(device->device, device->queue_family, 0, &device->queue);
+
+    device->pool = vkc_memory_pool_create(device->physical, device->device, NULL, 0, flags);
+    if (!device->pool) {
+        return example_fail(info, "Failed to create memory pool.");
+    }
+    if (!info->commands) {
+        return true;
+    }
+
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = device->queue_family,
+    };
+    VkCommandBufferAllocateInfo command_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandBufferCount = 1,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    };
+    VkFenceCreateInfo fence_info = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    if (VK_SUCCESS != vkCreateCommandPool(device->device, &pool_info, NULL, &device->commands)) {
+        return example_fail(info, "Failed to create command pool.");
+    }
+    command_info.commandPool = device->commands;
+    if (VK_SUCCESS != vkAllocateCommandBuffers(device->device, &command_info, &device->command)
+        || VK_SUCCESS != vkCreateFence(device->device, &fence_info, NULL, &device->fence)) {
+        return example_fail(info, "Failed to create command buffer or fence.");
+    }
+    return true;
+}
+
+void example_device_destroy(ExampleDevice* device) {
+    if (device->device) {
+        vkDeviceWaitIdle(device->device);
+        vkc_memory_pool_destroy(device->pool);
+        if (device->fence) {
+            vkDestroyFence(device->device, device->fence, NULL);
+        }
+        if (device->commands) {
+            vkDestroyCommandPool(device->device, device->commands, NULL);
+        }
+        vkDestroyDevice(device->device, NULL);
+    }
+    if (device->instance) {
+        vkDestroyInstance(device->instance, NULL);
+    }
+    *device = (ExampleDevice) {0};
+}
+
+bool example_device_submit(ExampleDevice* device) {
+    VkSubmitInfo submit = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &device->command,
+    };
+    bool done = VK_SUCCESS == vkQueueSubmit(device->queue, 1, &submit, device->fence)
+                && VK_SUCCESS
+                       == vkWaitForFences(device->device, 1, &device->fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(device->device, 1, &device->fence);
+    vkResetCommandBuffer(device->command, 0);
+    return done;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file examples/fixture.h
+ * @brief Device setup shared by the benchmark examples.
+ *
+ * Creates an instance at API 1.1 on the first physical device, one queue from the first
+ * family able to copy, and a VkcMemoryPool; optionally a command pool with one command
+ * buffer and a fence. Optional device extensions are enabled when present, and each one
+ * found can add flags to the pool.
+ */
+
+#ifndef VKC_EXAMPLES_FIXTURE_H
+#define VKC_EXAMPLES_FIXTURE_H
+
+#include "vk/pool.h"
+
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief An optional device extension and the pool flags it unlocks.
+ */
+typedef struct ExampleExtension {
+    const char* name;
+    VkcMemoryPoolFlags flags; /**< Added to the pool's flags when the extension is enabled. */
+} ExampleExtension;
+
+typedef struct ExampleDeviceInfo {
+    const char* name; /**< Application name. */
+    const ExampleExtension* extensions; /**< Enabled when the device exposes them. */
+    uint32_t extension_count; /**< At most 32. */
+    VkcMemoryPoolFlags flags; /**< Pool flags regardless of extensions. */
+    bool commands; /**< Also create a command pool, one command buffer and a fence. */
+    bool quiet; /**< Fail without logging, for callers that carry on without a device. */
+} ExampleDeviceInfo;
+
+typedef struct ExampleDevice {
+    VkInstance instance;
+    VkPhysicalDevice physical;
+    VkDevice device;
+    VkQueue queue;
+    uint32_t queue_family;
+    VkCommandPool commands;
+    VkCommandBuffer command;
+    VkFence fence;
+    VkcMemoryPool* pool;
+    uint32_t found; /**< Bit i is set when info->extensions[i] was enabled. */
+} ExampleDevice;
+
+/**
+ * @brief Create everything `info` asks for into a zeroed `device`.
+ *
+ * On failure the handles created so far are kept; example_device_destroy() releases them.
+ */
+bool example_device_create(ExampleDevice* device, const ExampleDeviceInfo* info);
+
+/**
+ * @brief Wait for the device to idle, then release the pool, commands, device and instance.
+ *
+ * Buffers allocated from `device->pool` must be destroyed first.
+ */
+void example_device_destroy(ExampleDevice* device);
+
+/**
+ * @brief Submit the recorded command buffer, wait on the fence, then reset both.
+ */
+bool example_device_submit(ExampleDevice* device);
+
+#endif // VKC_EXAMPLES_FIXTURE_H
@@ -0,0 +1,377 @@
+/**
+ * @file examples/hugepage.c
+ * @brief Huge-page benchmark for large host allocations and uploads.
+ *
+ * Models a host-to-device upload of a multi-GB dataset: the dataset and a host staging
+ * buffer are allocated through the Vulkan host callbacks, the dataset is populated,
+ * streamed into the staging buffer in 64 MiB windows, and gathered into it as
+ * scattered 256-byte records (the access pattern of packing sparse tiles, which is
+ * where TLB reach matters most).
+ *
+ * When a Vulkan device is available the dataset is then uploaded for real: copied in
+ * 16 MiB pieces into a VkcStaging ring and from there into a device-local buffer with
+ * vkCmdCopyBuffer, one submission and wait per filled ring. The upload column is that
+ * end-to-end rate; only the source pages differ between modes, so it shows how much of
+ * the host-side difference survives the device copy. Without a device it reads n/a.
+ *
+ * Every page mode runs on its own VkcAllocatorContext. dTLB load misses come from
+ * perf_event_open() and read n/a where the kernel does not allow it. HUGETLB needs
+ * pages reserved in /proc/sys/vm/nr_hugepages and is skipped otherwise.
+ *
+ * Usage: ./build/examples/hugepage [GiB] [gather-records]
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/extent.h"
+#include "vk/allocator.h"
+#include "vk/pool.h"
+#include "vk/buffer.h"
+#include "vk/staging.h"
+#include "fixture.h"
+
+#include <linux/perf_event.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_STAGING (64 * 1024 * 1024)
+#define BENCH_RECORD 256
+#define BENCH_PIECE (16 * 1024 * 1024) /**< Bytes per staged copy. */
+#define BENCH_TARGET (256 * 1024 * 1024) /**< Device buffer the upload wraps around. */
+
+typedef struct BenchResult {
+    double populate; /**< GB/s of first-touch writes. */
+    double stream; /**< GB/s of sequential upload copies. */
+    double gather; /**< Million records per second. */
+    double upload; /**< GB/s through the staging ring into device memory, or -1. */
+    long long misses; /**< dTLB load misses during the gather, or -1. */
+    size_t huge; /**< Bytes backed by huge pages after populating. */
+} BenchResult;
+
+/**
+ * @brief Device, transfer queue and upload path shared by every page mode.
+ */
+typedef struct BenchDevice {
+    ExampleDevice base;
+    VkcStaging* staging;
+    VkcBuffer target;
+} BenchDevice;
+
+static inline uint64_t bench_next(uint64_t* state) {
+    // xorshift64: the same seed gathers the same records in every mode
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static int bench_tlb_open(void) {
+    struct perf_event_attr attr = {0};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static long long bench_tlb_read(int fd) {
+    long long count = -1;
+    if (fd < 0 || sizeof(count) != read(fd, &count, sizeof(count))) {
+        return -1;
+    }
+    return count;
+}
+
+static size_t bench_huge_bytes(void) {
+    FILE* file = fopen("/proc/self/smaps_rollup", "r");
+    if (!file) {
+        return 0;
+    }
+
+    // Transparent huge pages and hugetlbfs pages are reported separately.
+    size_t total = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long kib = 0;
+        if (1 == sscanf(line, "AnonHugePages: %lu kB", &kib)
+            || 1 == sscanf(line, "Private_Hugetlb: %lu kB", &kib)) {
+            total += (size_t) kib * 1024;
+        }
+    }
+    fclose(file);
+    return total;
+}
+
+static bool bench_hugetlb_reserved(void) {
+    FILE* file = fopen("/proc/sys/vm/nr_hugepages", "r");
+    if (!file) {
+        return false;
+    }
+
+    unsigned long count = 0;
+    bool reserved = 1 == fscanf(file, "%lu", &count) && count > 0;
+    fclose(file);
+    return reserved;
+}
+
+static void bench_device_destroy(BenchDevice* device) {
+    if (device->base.device) {
+        vkDeviceWaitIdle(device->base.device);
+        vkc_buffer_destroy(device->base.pool, &device->target);
+        vkc_staging_destroy(device->staging);
+    }
+    example_device_destroy(&device->base);
+    *device = (BenchDevice) {0};
+}
+
+/**
+ * @brief Create the upload path on the first device with a transfer-capable queue.
+ *
+ * Staging retires submissions on fences of its own, so the fixture's fence goes unused.
+ */
+static bool bench_device_create(BenchDevice* device) {
+    ExampleDeviceInfo info = {.name = "hugepage", .commands = true, .quiet = true};
+    if (!example_device_create(&device->base, &info)) {
+        bench_device_destroy(device);
+        return false;
+    }
+
+    VkcMemoryPool* pool = device->base.pool;
+    device->staging = vkc_staging_create(device->base.device, pool, NULL, BENCH_STAGING);
+    if (!device->staging
+        || VK_SUCCESS
+               != vkc_buffer_create(
+                   pool,
+                   BENCH_TARGET,
+                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                   VKC_MEMORY_USAGE_GPU_ONLY,
+                   &device->target
+               )) {
+        LOG_ERROR("[Bench] Failed to create the staging ring or device buffer.");
+        bench_device_destroy(device);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Submit the copies queued so far and wait for them.
+ */
+static VkResult bench_device_submit(BenchDevice* device) {
+    VkCommandBufferBeginInfo begin = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VkResult result = vkBeginCommandBuffer(device->base.command, &begin);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+    vkc_staging_record(device->staging, device->base.command);
+    result = vkEndCommandBuffer(device->base.command);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    VkFence fence = VK_NULL_HANDLE;
+    result = vkc_staging_fence(device->staging, &fence);
+    if (VK_SUCCESS == result) {
+        result = vkc_memory_pool_flush(device->base.pool);
+    }
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    VkSubmitInfo submit = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &device->base.command,
+    };
+    result = vkQueueSubmit(device->base.queue, 1, &submit, fence);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+    return vkWaitForFences(device->base.device, 1, &fence, VK_TRUE, UINT64_MAX);
+}
+
+/**
+ * @brief Upload `size` bytes of `data` through the staging ring; GB/s, or -1 on failure.
+ */
+static double bench_device_upload(BenchDevice* device, const uint8_t* data, size_t size) {
+    double start = bench_now();
+    size_t staged = 0;
+    for (size_t offset = 0; offset < size; offset += BENCH_PIECE) {
+        size_t piece = size - offset < BENCH_PIECE ? size - offset : BENCH_PIECE;
+        VkResult result = vkc_staging_upload(
+            device->staging, device->target.object, offset % BENCH_TARGET, data + offset, piece
+        );
+        staged += piece;
+        if (VK_SUCCESS == result && (staged >= BENCH_STAGING || offset + piece == size)) {
+            result = bench_device_submit(device);
+            staged = 0;
+        }
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[Bench] Upload failed at offset %zu (VkResult=%d).", offset, result);
+            return -1.0;
+        }
+    }
+    return (double) size / (bench_now() - start) / 1e9;
+}
+
+static bool bench_run(
+    VkcExtentPages pages, size_t size, size_t records, BenchDevice* device, BenchResult* result
+) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    if (!context) {
+        return false;
+    }
+    vkc_allocator_context_huge_pages(context, pages);
+
+    const VkAllocationCallbacks* cb = vkc_allocator_context_callbacks(context);
+    uint8_t* dataset = cb->pfnAllocation(
+        cb->pUserData, size, alignof(max_align_t), VK_SYSTEM_ALLOCATION_SCOPE_OBJECT
+    );
+    uint8_t* staging = cb->pfnAllocation(
+        cb->pUserData, BENCH_STAGING, alignof(max_align_t), VK_SYSTEM_ALLOCATION_SCOPE_OBJECT
+    );
+    if (!dataset || !staging) {
+        LOG_ERROR("[Bench] Failed to allocate %zu bytes.", size);
+        vkc_allocator_context_destroy(context);
+        return false;
+    }
+
+    double start = bench_now();
+    memset(dataset, 0x5a, size);
+    memset(staging, 0, BENCH_STAGING);
+    result->populate = (double) size / (bench_now() - start) / 1e9;
+    result->huge = bench_huge_bytes();
+
+    start = bench_now();
+    for (size_t offset = 0; offset < size; offset += BENCH_STAGING) {
+        size_t window = size - offset < BENCH_STAGING ? size - offset : BENCH_STAGING;
+        memcpy(staging, dataset + offset, window);
+    }
+    result->stream = (double) size / (bench_now() - start) / 1e9;
+
+    int fd = bench_tlb_open();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    size_t slots = BENCH_STAGING / BENCH_RECORD;
+    size_t rows = size / BENCH_RECORD;
+    start = bench_now();
+    for (size_t i = 0; i < records; i++) {
+        size_t row = (size_t) (bench_next(&state) % rows);
+        memcpy(staging + (i % slots) * BENCH_RECORD, dataset + row * BENCH_RECORD, BENCH_RECORD);
+    }
+    result->gather = (double) records / (bench_now() - start) / 1e6;
+
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    result->misses = bench_tlb_read(fd);
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    // Touch the output so the copies cannot be optimized away.
+    volatile uint8_t sink = staging[(records - 1) % slots * BENCH_RECORD];
+    (void) sink;
+
+    result->upload = device ? bench_device_upload(device, dataset, size) : -1.0;
+
+    // Destroying the context unmaps both buffers; no per-block frees needed.
+    vkc_allocator_context_destroy(context);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t gib = argc > 1 ? strtoull(argv[1], NULL, 10) : 2;
+    size_t records = argc > 2 ? strtoull(argv[2], NULL, 10) : 20000000;
+    if (0 == gib || 0 == records) {
+        LOG_ERROR("[Bench] Usage: %s [GiB] [gather-records]", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static const char* names[] = {"base", "thp", "hugetlb"};
+    VkcExtentPages modes[] = {
+        VKC_EXTENT_PAGES_BASE,
+        VKC_EXTENT_PAGES_ADVISE,
+        VKC_EXTENT_PAGES_HUGETLB,
+    };
+    size_t mode_count = bench_hugetlb_reserved() ? 3 : 2;
+
+    BenchDevice device = {0};
+    bool uploads = bench_device_create(&device);
+
+    size_t size = gib << 30;
+    printf("dataset %zu GiB, staging %d MiB, ", gib, BENCH_STAGING >> 20);
+    printf("%zu gathered records\n\n", records);
+    printf("pages    huge (MiB)  populate (GB/s)  stream (GB/s)  gather (Mrec/s)  dTLB misses");
+    printf("  upload (GB/s)\n");
+
+    double baseline = 0.0;
+    for (size_t i = 0; i < mode_count; i++) {
+        BenchResult result = {0};
+        if (!bench_run(modes[i], size, records, uploads ? &device : NULL, &result)) {
+            bench_device_destroy(&device);
+            return EXIT_FAILURE;
+        }
+        if (0 == i) {
+            baseline = result.gather;
+        }
+
+        char misses[32] = "n/a";
+        if (result.misses >= 0) {
+            snprintf(misses, sizeof(misses), "%lld", result.misses);
+        }
+        char upload[32] = "n/a";
+        if (result.upload >= 0) {
+            snprintf(upload, sizeof(upload), "%.2f", result.upload);
+        }
+        printf(
+            "%-7s  %10zu  %15.2f  %13.2f  %9.2f (%.2fx)  %11s  %13s\n",
+            names[i],
+            result.huge >> 20,
+            result.populate,
+            result.stream,
+            result.gather,
+            result.gather / baseline,
+            misses,
+            upload
+        );
+    }
+
+    if (3 != mode_count) {
+        printf("\nhugetlb skipped: no pages reserved in /proc/sys/vm/nr_hugepages\n");
+    }
+    if (!uploads) {
+        printf("\nupload skipped: no Vulkan device with a transfer queue\n");
+    }
+    bench_device_destroy(&device);
+
+    return EXIT_SUCCESS;
+}
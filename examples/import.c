@@ -0,0 +1,243 @@
+/**
+ * @file examples/import.c
+ * @brief Host memory import benchmark: wrapping input pages versus copying them.
+ *
+ * Models inputs that already sit in host memory, as a mapped file or pages the
+ * application owns: the input is an anonymous mapping, populated before timing starts.
+ * For every size, the input becomes a transfer source with vkc_buffer_import() on two
+ * pools. One lacks VKC_MEMORY_POOL_HOST_IMPORT_BIT, so it copies the input into a fresh
+ * buffer and flushes it. The other wraps the pages through VK_EXT_external_memory_host.
+ *
+ * "ready" times the step from host pointer to a buffer the device may read. "read" adds
+ * one device pass over the buffer, copied in 64 MiB windows into a scratch buffer, so
+ * reads of imported pages pay their cost too. Each figure is the best of a few runs.
+ *
+ * Runs on any device exposing VK_EXT_external_memory_host, lavapipe included; without
+ * the extension only the copy column is filled in.
+ *
+ * Usage: ./build/examples/import [max-MiB]
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/pool.h"
+#include "vk/buffer.h"
+#include "fixture.h"
+
+#include <vulkan/vulkan.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define BENCH_WINDOW (64ull * 1024 * 1024)
+#define BENCH_REPEAT 3
+
+typedef struct BenchContext {
+    ExampleDevice device; /**< Its pool lacks host import: every input is copied. */
+    VkcMemoryPool* import; /**< Pool importing aligned inputs; NULL without the extension. */
+    VkcBuffer scratch; /**< Destination of the device read pass. */
+} BenchContext;
+
+typedef struct BenchResult {
+    double ready; /**< Seconds until the device may read the input. */
+    double read; /**< Seconds until it has, once. */
+    bool imported; /**< The input was wrapped rather than copied. */
+} BenchResult;
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static bool bench_create(BenchContext* context, VkDeviceSize scratch_size) {
+    ExampleExtension host = {.name = VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME};
+    ExampleDeviceInfo info = {
+        .name = "import",
+        .extensions = &host,
+        .extension_count = 1,
+        .commands = true,
+    };
+    if (!example_device_create(&context->device, &info)) {
+        return false;
+    }
+
+    ExampleDevice* device = &context->device;
+    if (device->found) {
+        context->import = vkc_memory_pool_create(
+            device->physical, device->device, NULL, 0, VKC_MEMORY_POOL_HOST_IMPORT_BIT
+        );
+        if (!context->import) {
+            LOG_ERROR("[Bench] Failed to create the import pool.");
+            return false;
+        }
+    }
+
+    VkResult scratch = vkc_buffer_create(
+        device->pool,
+        scratch_size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VKC_MEMORY_USAGE_GPU_ONLY,
+        &context->scratch
+    );
+    if (VK_SUCCESS != scratch) {
+        LOG_ERROR("[Bench] Failed to create scratch buffer.");
+        return false;
+    }
+    return true;
+}
+
+static void bench_destroy(BenchContext* context) {
+    if (context->device.pool) {
+        vkc_buffer_destroy(context->device.pool, &context->scratch);
+    }
+    vkc_memory_pool_destroy(context->import);
+    example_device_destroy(&context->device);
+}
+
+/**
+ * @brief Have the device read a whole buffer once and wait for it.
+ */
+static bool bench_read(BenchContext* context, const VkcBuffer* buffer) {
+    VkCommandBuffer command = context->device.command;
+    VkCommandBufferBeginInfo begin = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(command, &begin);
+
+    // Windows overwrite the same scratch range, so order them as the writes they are.
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    for (VkDeviceSize offset = 0; offset < buffer->size; offset += context->scratch.size) {
+        VkDeviceSize left = buffer->size - offset;
+        VkBufferCopy region = {
+            .srcOffset = offset,
+            .size = left < context->scratch.size ? left : context->scratch.size,
+        };
+        if (offset) {
+            vkCmdPipelineBarrier(
+                command,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                1,
+                &barrier,
+                0,
+                NULL,
+                0,
+                NULL
+            );
+        }
+        vkCmdCopyBuffer(command, buffer->object, context->scratch.object, 1, &region);
+    }
+    vkEndCommandBuffer(command);
+
+    return example_device_submit(&context->device);
+}
+
+static bool bench_run(
+    BenchContext* context, VkcMemoryPool* pool, void* input, size_t size, BenchResult* result
+) {
+    *result = (BenchResult) {.ready = 1e30, .read = 1e30};
+    for (int repeat = 0; repeat < BENCH_REPEAT; repeat++) {
+        VkcBuffer buffer;
+        double start = bench_now();
+        if (VK_SUCCESS
+            != vkc_buffer_import(pool, input, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &buffer)) {
+            LOG_ERROR("[Bench] Failed to make a %zu byte buffer of the input.", size);
+            return false;
+        }
+        vkc_memory_pool_flush(pool);
+        double ready = bench_now() - start;
+
+        bool read = bench_read(context, &buffer);
+        double total = bench_now() - start;
+        result->imported = VKC_MEMORY_PLACEMENT_IMPORTED == buffer.memory.placement;
+        vkc_buffer_destroy(pool, &buffer);
+        if (!read) {
+            LOG_ERROR("[Bench] Device read failed.");
+            return false;
+        }
+
+        result->ready = ready < result->ready ? ready : result->ready;
+        result->read = total < result->read ? total : result->read;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t max_mib = argc > 1 ? strtoull(argv[1], NULL, 10) : 1024;
+    if (0 == max_mib) {
+        LOG_ERROR("[Bench] Usage: %s [max-MiB]", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t max_size = max_mib << 20;
+    BenchContext context = {0};
+    if (!bench_create(&context, max_size < BENCH_WINDOW ? max_size : BENCH_WINDOW)) {
+        bench_destroy(&context);
+        return EXIT_FAILURE;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.device.physical, &properties);
+    printf("device %s, ", properties.deviceName);
+    if (context.import) {
+        VkDeviceSize alignment = vkc_memory_pool_import_alignment(context.import);
+        printf("import alignment %llu\n\n", (unsigned long long) alignment);
+    } else {
+        printf("VK_EXT_external_memory_host unsupported\n\n");
+    }
+    printf("size (MiB)  copy ready (ms)  copy read (ms)  import ready (ms)  import read (ms)\n");
+
+    int status = EXIT_SUCCESS;
+    for (size_t mib = 1; mib <= max_mib; mib *= 4) {
+        size_t size = mib << 20;
+
+        // mmap() returns page-aligned memory, which is what imports need.
+        void* input = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == input) {
+            LOG_ERROR("[Bench] Failed to map %zu bytes.", size);
+            status = EXIT_FAILURE;
+            break;
+        }
+        memset(input, 0x5a, size);
+
+        BenchResult copied = {0};
+        BenchResult imported = {0};
+        bool ran = bench_run(&context, context.device.pool, input, size, &copied)
+                   && (!context.import
+                       || bench_run(&context, context.import, input, size, &imported));
+        munmap(input, size);
+        if (!ran) {
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        printf("%10zu  %15.3f  %14.3f", mib, copied.ready * 1e3, copied.read * 1e3);
+        if (!context.import) {
+            printf("  %17s  %16s\n", "n/a", "n/a");
+        } else {
+            printf(
+                "  %17.3f  %16.3f%s\n",
+                imported.ready * 1e3,
+                imported.read * 1e3,
+                imported.imported ? "" : "  (copied)"
+            );
+        }
+    }
+
+    bench_destroy(&context);
+    return status;
+}
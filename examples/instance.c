@@ -44,7 +44,7 @@ int main(void) {
         "VK_LAYER_KHRONOS_validation",
     };
 
-    VkcInstanceLayer* layer = vkc_instance_layer_create();
+    VkcInstanceLayer* layer = vkc_instance_layer_create(NULL);
     VkcInstanceLayerMatch* layer_match = vkc_instance_layer_match_create(
         layer, validation_layers, 1
     );
@@ -65,7 +65,7 @@ int main(void) {
         "VK_EXT_debug_utils",
     };
 
-    VkcInstanceExtension* extension = vkc_instance_extension_create();
+    VkcInstanceExtension* extension = vkc_instance_extension_create(NULL);
     VkcInstanceExtensionMatch* extension_match = vkc_instance_extension_match_create(
         extension, extension_names, 6
     );
@@ -77,7 +77,7 @@ int main(void) {
      * @{
      */
 
-    VkcInstance* instance = vkc_instance_create(layer_match, extension_match);
+    VkcInstance* instance = vkc_instance_create(NULL, layer_match, extension_match);
     if (!instance) {
         goto cleanup_properties;
     }
@@ -0,0 +1,176 @@
+/**
+ * @file examples/realloc.c
+ * @brief Realloc-heavy trace benchmark for the Vulkan host allocator.
+ *
+ * Replays the growth pattern drivers show while building pipelines and descriptor
+ * sets: a set of arrays grows one small append at a time, occasionally doubling,
+ * until each hits its cap, is released, and starts over. Every step is a realloc.
+ *
+ * The same trace runs against a single PageAllocator through page_realloc() (the
+ * previous callback path) and against vkc_allocator_callbacks(). The allocator's
+ * telemetry then reports how many reallocations kept their address.
+ *
+ * Usage: ./build/examples/realloc [steps]
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "allocator/page.h"
+#include "vk/allocator.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TRACE_ARRAYS 64
+#define TRACE_MIN_CAP (4 * 1024)
+#define TRACE_MAX_CAP (2 * 1024 * 1024)
+
+typedef enum TraceBackend {
+    TRACE_PAGE,
+    TRACE_VKC,
+} TraceBackend;
+
+typedef struct TraceArray {
+    uint8_t* data;
+    size_t size;
+    size_t cap;
+    VkSystemAllocationScope scope;
+} TraceArray;
+
+static inline uint32_t trace_next(uint32_t* state) {
+    // xorshift32: the same seed replays the same trace on both backends
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void* trace_realloc(
+    TraceBackend backend, PageAllocator* pager, TraceArray* array, size_t size
+) {
+    if (TRACE_PAGE == backend) {
+        if (!array->data) {
+            return page_malloc(pager, size, alignof(max_align_t));
+        }
+        return page_realloc(pager, array->data, size, alignof(max_align_t));
+    }
+
+    const VkAllocationCallbacks* cb = vkc_allocator_callbacks();
+    return cb->pfnReallocation(
+        cb->pUserData, array->data, size, alignof(max_align_t), array->scope
+    );
+}
+
+static void trace_release(TraceBackend backend, PageAllocator* pager, TraceArray* array) {
+    if (array->data) {
+        if (TRACE_PAGE == backend) {
+            page_free(pager, array->data);
+        } else {
+            const VkAllocationCallbacks* cb = vkc_allocator_callbacks();
+            cb->pfnFree(cb->pUserData, array->data);
+        }
+    }
+
+    array->data = NULL;
+    array->size = 0;
+}
+
+static double trace_run(TraceBackend backend, size_t steps) {
+    PageAllocator* pager = NULL;
+    if (TRACE_PAGE == backend) {
+        pager = page_allocator_create(1024);
+        if (!pager) {
+            return 0.0;
+        }
+    }
+
+    TraceArray arrays[TRACE_ARRAYS] = {0};
+    uint32_t state = 0x2545F491u;
+
+    double start = trace_now();
+    for (size_t i = 0; i < steps; i++) {
+        uint32_t r = trace_next(&state);
+        TraceArray* array = &arrays[r % TRACE_ARRAYS];
+
+        if (!array->data) {
+            array->cap = TRACE_MIN_CAP + (r >> 8) % (TRACE_MAX_CAP - TRACE_MIN_CAP);
+            array->scope = (r & 0x80000000u) ? VK_SYSTEM_ALLOCATION_SCOPE_OBJECT
+                                             : VK_SYSTEM_ALLOCATION_SCOPE_COMMAND;
+        }
+
+        // Mostly small appends, with an occasional capacity doubling.
+        size_t size = array->size + 16 + (r >> 16) % 240;
+        if (array->size && 0 == (r >> 24) % 16) {
+            size = array->size * 2;
+        }
+        if (size > array->cap) {
+            trace_release(backend, pager, array);
+            continue;
+        }
+
+        uint8_t* data = trace_realloc(backend, pager, array, size);
+        if (!data) {
+            LOG_ERROR("[Trace] Reallocation failed (size=%zu).", size);
+            break;
+        }
+
+        data[size - 1] = (uint8_t) i; // Touch the new tail
+        array->data = data;
+        array->size = size;
+    }
+    double elapsed = trace_now() - start;
+
+    for (size_t i = 0; i < TRACE_ARRAYS; i++) {
+        trace_release(backend, pager, &arrays[i]);
+    }
+    if (pager) {
+        page_allocator_free(pager);
+    }
+
+    return (double) steps / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    size_t steps = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+
+    if (!vkc_allocator_create()) {
+        LOG_ERROR("[Trace] Failed to create the Vulkan host allocator.");
+        return EXIT_FAILURE;
+    }
+
+    double page = trace_run(TRACE_PAGE, steps);
+    double vkc = trace_run(TRACE_VKC, steps);
+
+    printf("backend  steps (Mops/s)\n");
+    printf("page     %14.2f\n", page);
+    printf("vkc      %14.2f  (%.2fx)\n", vkc, vkc / page);
+
+    VkcAllocatorStats stats;
+    if (vkc_allocator_stats(&stats)) {
+        uint64_t reallocations = 0;
+        uint64_t in_place = 0;
+        for (size_t i = 0; i < VKC_ALLOCATOR_SCOPE_COUNT; i++) {
+            reallocations += stats.scopes[i].reallocations;
+            in_place += stats.scopes[i].in_place;
+        }
+        printf(
+            "\nvkc kept %llu of %llu reallocations in place (%.1f%%)\n",
+            (unsigned long long) in_place,
+            (unsigned long long) reallocations,
+            reallocations ? 100.0 * (double) in_place / (double) reallocations : 0.0
+        );
+    }
+
+    vkc_allocator_destroy();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,495 @@
+/**
+ * @file examples/replay.c
+ * @brief Offline replay of host allocation traces against allocator backends.
+ *
+ * Traces come from a VkcTrace recorder, for example by running any program with
+ * VKC_ALLOCATOR_TRACE=<path> set. The replay runs the recorded allocations,
+ * reallocations and frees in file order on a single thread, translating recorded
+ * addresses to live blocks, against libc, a single PageAllocator, and a fresh
+ * VkcAllocatorContext. No GPU is required.
+ *
+ * The capture mode records a synthetic multi-threaded workload, so the tool can be
+ * exercised without a driver.
+ *
+ * Usage:
+ *   ./build/examples/replay <trace> [libc|page|vkc]
+ *   ./build/examples/replay capture <trace> [operations-per-thread]
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "allocator/page.h"
+#include "vk/allocator.h"
+#include "vk/trace.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPLAY_CAPTURE_THREADS 4
+#define REPLAY_CAPTURE_SLOTS 256
+
+typedef enum ReplayBackend {
+    REPLAY_LIBC,
+    REPLAY_PAGE,
+    REPLAY_VKC,
+    REPLAY_BACKEND_COUNT,
+} ReplayBackend;
+
+static const char* replay_backend_names[REPLAY_BACKEND_COUNT] = {"libc", "page", "vkc"};
+
+/**
+ * @brief Recorded address to replayed block, open addressing with linear probing.
+ */
+typedef struct ReplayEntry {
+    uint64_t address; /**< Recorded address; 0 marks an empty slot. */
+    void* block;
+    size_t size;
+    size_t alignment;
+} ReplayEntry;
+
+typedef struct ReplayMap {
+    ReplayEntry* entries;
+    size_t mask;
+    size_t count;
+} ReplayMap;
+
+typedef struct ReplayContext {
+    ReplayBackend backend;
+    PageAllocator* pager;
+    VkcAllocatorContext* vkc;
+    const VkAllocationCallbacks* callbacks;
+    ReplayMap map;
+    size_t unmatched; /**< Frees or reallocations of addresses not live in the replay. */
+    size_t stale; /**< Allocations that reused an address still live in the replay. */
+    size_t failures;
+} ReplayContext;
+
+static double replay_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static inline size_t replay_hash(uint64_t address) {
+    // Fibonacci hashing; block addresses share their low bits.
+    return (size_t) ((address * 0x9E3779B97F4A7C15ull) >> 17);
+}
+
+static bool replay_map_init(ReplayMap* map, size_t capacity) {
+    map->entries = calloc(capacity, sizeof(ReplayEntry));
+    map->mask = capacity - 1;
+    map->count = 0;
+    return NULL != map->entries;
+}
+
+static ReplayEntry* replay_map_find(ReplayMap* map, uint64_t address) {
+    for (size_t i = replay_hash(address);; i++) {
+        ReplayEntry* entry = &map->entries[i & map->mask];
+        if (0 == entry->address || address == entry->address) {
+            return entry;
+        }
+    }
+}
+
+static bool replay_map_grow(ReplayMap* map) {
+    ReplayMap grown = {0};
+    if (!replay_map_init(&grown, (map->mask + 1) * 2)) {
+        return false;
+    }
+
+    for (size_t i = 0; i <= map->mask; i++) {
+        if (map->entries[i].address) {
+            *replay_map_find(&grown, map->entries[i].address) = map->entries[i];
+            grown.count++;
+        }
+    }
+
+    free(map->entries);
+    *map = grown;
+    return true;
+}
+
+static void replay_map_remove(ReplayMap* map, ReplayEntry* entry) {
+    // Backward-shift deletion keeps probe chains intact without tombstones.
+    size_t hole = (size_t) (entry - map->entries);
+    for (size_t i = (hole + 1) & map->mask; map->entries[i].address; i = (i + 1) & map->mask) {
+        size_t home = replay_hash(map->entries[i].address) & map->mask;
+        if (((i - home) & map->mask) >= ((i - hole) & map->mask)) {
+            map->entries[hole] = map->entries[i];
+            hole = i;
+        }
+    }
+
+    map->entries[hole] = (ReplayEntry) {0};
+    map->count--;
+}
+
+static void* replay_malloc(ReplayContext* context, size_t size, size_t alignment, uint32_t scope) {
+    switch (context->backend) {
+        case REPLAY_LIBC:
+            if (alignment <= alignof(max_align_t)) {
+                return malloc(size);
+            }
+            return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+        case REPLAY_PAGE:
+            return page_malloc(context->pager, size, alignment);
+        default:
+            return context->callbacks->pfnAllocation(
+                context->callbacks->pUserData, size, alignment, (VkSystemAllocationScope) scope
+            );
+    }
+}
+
+static void replay_free(ReplayContext* context, void* block) {
+    switch (context->backend) {
+        case REPLAY_LIBC:
+            free(block);
+            break;
+        case REPLAY_PAGE:
+            page_free(context->pager, block);
+            break;
+        default:
+            context->callbacks->pfnFree(context->callbacks->pUserData, block);
+            break;
+    }
+}
+
+static void* replay_realloc(ReplayContext* context, ReplayEntry* entry, const VkcTraceRecord* r) {
+    switch (context->backend) {
+        case REPLAY_LIBC:
+            if (r->alignment <= alignof(max_align_t) && entry->alignment <= alignof(max_align_t)) {
+                return realloc(entry->block, r->size);
+            }
+            break; // libc cannot keep larger alignments across realloc()
+        case REPLAY_PAGE:
+            return page_realloc(context->pager, entry->block, r->size, r->alignment);
+        default:
+            return context->callbacks->pfnReallocation(
+                context->callbacks->pUserData,
+                entry->block,
+                r->size,
+                r->alignment,
+                (VkSystemAllocationScope) r->scope
+            );
+    }
+
+    void* block = replay_malloc(context, r->size, r->alignment, r->scope);
+    if (block) {
+        memcpy(block, entry->block, entry->size < r->size ? entry->size : r->size);
+        free(entry->block);
+    }
+    return block;
+}
+
+static bool replay_insert(ReplayContext* context, const VkcTraceRecord* r, void* block) {
+    if (2 * (context->map.count + 1) > context->map.mask + 1 && !replay_map_grow(&context->map)) {
+        return false;
+    }
+
+    ReplayEntry* entry = replay_map_find(&context->map, r->address);
+    if (entry->address) {
+        // The recorded block moved and its old address was reused before the move was logged.
+        replay_free(context, entry->block);
+        context->stale++;
+    } else {
+        context->map.count++;
+    }
+
+    *entry = (ReplayEntry) {
+        .address = r->address,
+        .block = block,
+        .size = r->size,
+        .alignment = r->alignment ? r->alignment : 1,
+    };
+    *(volatile uint8_t*) block = 0; // Touch the block like its owner would
+    return true;
+}
+
+static void replay_step(ReplayContext* context, const VkcTraceRecord* r) {
+    if (VKC_TRACE_FREE == r->op) {
+        ReplayEntry* entry = replay_map_find(&context->map, r->original);
+        if (!entry->address) {
+            context->unmatched++;
+            return;
+        }
+        replay_free(context, entry->block);
+        replay_map_remove(&context->map, entry);
+        return;
+    }
+
+    if (0 == r->address) {
+        return; // The recorded request failed; nothing to replay
+    }
+
+    void* block = NULL;
+    ReplayEntry* entry = NULL;
+    if (VKC_TRACE_REALLOCATE == r->op) {
+        entry = replay_map_find(&context->map, r->original);
+        if (!entry->address) {
+            context->unmatched++;
+            entry = NULL;
+        }
+    }
+
+    if (entry) {
+        block = replay_realloc(context, entry, r);
+        if (block) {
+            replay_map_remove(&context->map, entry);
+        }
+    } else {
+        block = replay_malloc(context, r->size, r->alignment ? r->alignment : 1, r->scope);
+    }
+
+    if (!block || !replay_insert(context, r, block)) {
+        context->failures++;
+    }
+}
+
+static void replay_release(ReplayContext* context) {
+    for (size_t i = 0; i <= context->map.mask; i++) {
+        if (context->map.entries[i].address) {
+            replay_free(context, context->map.entries[i].block);
+        }
+    }
+    free(context->map.entries);
+
+    if (context->pager) {
+        page_allocator_free(context->pager);
+    }
+    vkc_allocator_context_destroy(context->vkc);
+}
+
+static bool replay_run(ReplayBackend backend, const VkcTraceRecord* records, size_t count) {
+    ReplayContext context = {.backend = backend};
+    if (!replay_map_init(&context.map, 1024)) {
+        return false;
+    }
+
+    if (REPLAY_PAGE == backend) {
+        context.pager = page_allocator_create(1024);
+    } else if (REPLAY_VKC == backend) {
+        context.vkc = vkc_allocator_context_create();
+        context.callbacks = vkc_allocator_context_callbacks(context.vkc);
+    }
+    if ((REPLAY_PAGE == backend && !context.pager) || (REPLAY_VKC == backend && !context.vkc)) {
+        LOG_ERROR("[Replay] Failed to create the %s backend.", replay_backend_names[backend]);
+        replay_release(&context);
+        return false;
+    }
+
+    double start = replay_now();
+    for (size_t i = 0; i < count; i++) {
+        replay_step(&context, &records[i]);
+    }
+    double seconds = replay_now() - start;
+
+    printf(
+        "%-7s  %9.3f  %8.2f  %9zu  %9zu  %9zu\n",
+        replay_backend_names[backend],
+        seconds * 1e3,
+        (double) count / seconds / 1e6,
+        context.unmatched,
+        context.stale,
+        context.failures
+    );
+
+    replay_release(&context);
+    return true;
+}
+
+static VkcTraceRecord* replay_load(const char* path, size_t* count) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        LOG_ERROR("[Replay] Failed to open %s.", path);
+        return NULL;
+    }
+
+    VkcTraceHeader header = {0};
+    if (1 != fread(&header, sizeof(header), 1, file)
+        || 0 != memcmp(header.magic, VKC_TRACE_MAGIC, sizeof(header.magic))
+        || VKC_TRACE_VERSION != header.version || sizeof(VkcTraceRecord) != header.record_size) {
+        LOG_ERROR("[Replay] %s is not a version %d trace.", path, VKC_TRACE_VERSION);
+        fclose(file);
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    size_t used = 0;
+    VkcTraceRecord* records = malloc(capacity * sizeof(VkcTraceRecord));
+    while (records) {
+        used += fread(records + used, sizeof(VkcTraceRecord), capacity - used, file);
+        if (used < capacity) {
+            break;
+        }
+
+        capacity *= 2;
+        VkcTraceRecord* grown = realloc(records, capacity * sizeof(VkcTraceRecord));
+        if (!grown) {
+            free(records);
+        }
+        records = grown;
+    }
+    fclose(file);
+
+    if (!records) {
+        LOG_ERROR("[Replay] Failed to load %s.", path);
+        return NULL;
+    }
+
+    *count = used;
+    return records;
+}
+
+/**
+ * @name Capture
+ * @brief Synthetic driver-like workload recorded through a VkcTrace.
+ * @{
+ */
+
+typedef struct ReplayWorker {
+    pthread_t thread;
+    const VkAllocationCallbacks* callbacks;
+    size_t operations;
+    uint32_t seed;
+} ReplayWorker;
+
+static inline uint32_t replay_next(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void* replay_capture_worker(void* arg) {
+    ReplayWorker* worker = (ReplayWorker*) arg;
+    const VkAllocationCallbacks* cb = worker->callbacks;
+    void* slots[REPLAY_CAPTURE_SLOTS] = {0};
+    size_t sizes[REPLAY_CAPTURE_SLOTS] = {0};
+
+    for (size_t i = 0; i < worker->operations; i++) {
+        uint32_t r = replay_next(&worker->seed);
+        size_t slot = r % REPLAY_CAPTURE_SLOTS;
+        VkSystemAllocationScope scope = (VkSystemAllocationScope) ((r >> 8) % 5);
+        size_t size = 16 + (r >> 12) % ((r & 0x100000u) ? 65536 : 512);
+
+        if (slots[slot] && 0 == (r >> 24) % 4) {
+            // Grow an existing block, as command and descriptor builders do
+            size_t grown = sizes[slot] + sizes[slot] / 2 + 16;
+            void* block = cb->pfnReallocation(cb->pUserData, slots[slot], grown, 16, scope);
+            if (block) {
+                slots[slot] = block;
+                sizes[slot] = grown;
+            }
+        } else {
+            cb->pfnFree(cb->pUserData, slots[slot]);
+            slots[slot] = cb->pfnAllocation(cb->pUserData, size, (size_t) 16 << (r % 3), scope);
+            sizes[slot] = size;
+        }
+    }
+
+    for (size_t i = 0; i < REPLAY_CAPTURE_SLOTS; i++) {
+        cb->pfnFree(cb->pUserData, slots[i]);
+    }
+    return NULL;
+}
+
+static int replay_capture(const char* path, size_t operations) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    VkcTrace* trace = vkc_trace_create(path, 0);
+    if (!context || !trace) {
+        vkc_trace_destroy(trace);
+        vkc_allocator_context_destroy(context);
+        return EXIT_FAILURE;
+    }
+    vkc_allocator_context_trace(context, trace);
+
+    ReplayWorker workers[REPLAY_CAPTURE_THREADS];
+    for (size_t i = 0; i < REPLAY_CAPTURE_THREADS; i++) {
+        workers[i] = (ReplayWorker) {
+            .callbacks = vkc_allocator_context_callbacks(context),
+            .operations = operations,
+            .seed = 0x9E3779B9u ^ (uint32_t) (i * 0x85EBCA6Bu),
+        };
+        pthread_create(&workers[i].thread, NULL, replay_capture_worker, &workers[i]);
+    }
+    for (size_t i = 0; i < REPLAY_CAPTURE_THREADS; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    vkc_allocator_context_trace(context, NULL);
+    printf("captured %d threads x %zu operations to %s", REPLAY_CAPTURE_THREADS, operations, path);
+    printf(" (%llu dropped)\n", (unsigned long long) vkc_trace_dropped(trace));
+    vkc_trace_destroy(trace);
+    vkc_allocator_context_destroy(context);
+    return EXIT_SUCCESS;
+}
+
+/** @} */
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        LOG_ERROR("[Replay] Usage: %s <trace> [libc|page|vkc]", argv[0]);
+        LOG_ERROR("[Replay]        %s capture <trace> [operations-per-thread]", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (0 == strcmp(argv[1], "capture")) {
+        if (argc < 3) {
+            LOG_ERROR("[Replay] Missing trace path.");
+            return EXIT_FAILURE;
+        }
+        return replay_capture(argv[2], argc > 3 ? strtoull(argv[3], NULL, 10) : 250000);
+    }
+
+    size_t count = 0;
+    VkcTraceRecord* records = replay_load(argv[1], &count);
+    if (!records) {
+        return EXIT_FAILURE;
+    }
+
+    size_t ops[3] = {0};
+    uint32_t threads = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].op < 3) {
+            ops[records[i].op]++;
+        }
+        threads = records[i].thread > threads ? records[i].thread : threads;
+    }
+    printf(
+        "%zu records from %u threads: %zu allocations, %zu reallocations, %zu frees\n\n",
+        count,
+        threads,
+        ops[VKC_TRACE_ALLOCATE],
+        ops[VKC_TRACE_REALLOCATE],
+        ops[VKC_TRACE_FREE]
+    );
+
+    printf(
+        "%-7s  %9s  %8s  %9s  %9s  %9s\n",
+        "backend",
+        "time (ms)",
+        "Mops/s",
+        "unmatched",
+        "stale",
+        "failures"
+    );
+    int status = EXIT_SUCCESS;
+    for (size_t backend = 0; backend < REPLAY_BACKEND_COUNT; backend++) {
+        if (argc > 2 && 0 != strcmp(argv[2], replay_backend_names[backend])) {
+            continue;
+        }
+
+        if (!replay_run((ReplayBackend) backend, records, count)) {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    free(records);
+    return status;
+}
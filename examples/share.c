@@ -0,0 +1,383 @@
+/**
+ * @file examples/share.c
+ * @brief Two-process buffer sharing example and benchmark: shared memory versus a pipe.
+ *
+ * A producer process fills batches that a consumer process hands to its device, the
+ * split between pre-processing and compute services. The processes are forked before
+ * either touches Vulkan and each builds its own instance and device.
+ *
+ * Shared: the producer creates two VkcShare slots and sends them over a Unix socket.
+ * The consumer opens both as VkcBuffers. For every batch the producer fills a free slot
+ * and passes its index over. The consumer then submits work that reads the slot
+ * directly, and returns the index once the fence signals. With VK_KHR_external_memory_fd
+ * the slots are exported device memory. Otherwise they are memfd pages the consumer's
+ * device imports with VK_EXT_external_memory_host, or copies when it cannot.
+ *
+ * Pipe: the producer fills a private buffer and writes the batch to the socket. The
+ * consumer reads it into a mapped upload buffer: one copy into the kernel, one out.
+ *
+ * The device's read is a vkCmdCopyBuffer of the whole batch into scratch memory plus its
+ * first word into a readback buffer, which the consumer checks against the batch
+ * number. A compute dispatch would bind `share.buffer.object` in the same place.
+ *
+ * Runs on lavapipe, which exposes both external memory extensions.
+ *
+ * Usage: ./build/examples/share [batch-MiB] [batches]
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/pool.h"
+#include "vk/buffer.h"
+#include "vk/share.h"
+#include "fixture.h"
+
+#include <vulkan/vulkan.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHARE_SLOTS 2
+#define SHARE_WINDOW (64ull * 1024 * 1024)
+#define SHARE_USAGE (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+
+typedef struct ShareContext {
+    ExampleDevice device; /**< Commands and fence for the consumer only. */
+    VkcBuffer scratch; /**< Consumer only: destination of the device read. */
+    VkcBuffer readback; /**< Consumer only: first word of the last batch read. */
+} ShareContext;
+
+static double share_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static bool share_io(int socket, void* data, size_t size, bool send) {
+    uint8_t* bytes = data;
+    while (size) {
+        ssize_t done = send ? write(socket, bytes, size) : read(socket, bytes, size);
+        if (done < 0 && EINTR == errno) {
+            continue;
+        }
+        if (done <= 0) {
+            return false;
+        }
+        bytes += done;
+        size -= (size_t) done;
+    }
+    return true;
+}
+
+static bool share_create(ShareContext* context, VkDeviceSize scratch_size) {
+    ExampleExtension extensions[] = {
+        {
+            .name = VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+            .flags = VKC_MEMORY_POOL_EXTERNAL_FD_BIT,
+        },
+        {
+            .name = VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME,
+            .flags = VKC_MEMORY_POOL_HOST_IMPORT_BIT,
+        },
+    };
+    // The producer only allocates; the consumer also records and submits.
+    ExampleDeviceInfo info = {
+        .name = "share",
+        .extensions = extensions,
+        .extension_count = 2,
+        .commands = 0 != scratch_size,
+    };
+    if (!example_device_create(&context->device, &info)) {
+        return false;
+    }
+    if (0 == scratch_size) {
+        return true;
+    }
+
+    VkcMemoryPool* pool = context->device.pool;
+    if (VK_SUCCESS
+            != vkc_buffer_create(
+                pool,
+                scratch_size,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VKC_MEMORY_USAGE_GPU_ONLY,
+                &context->scratch
+            )
+        || VK_SUCCESS
+               != vkc_buffer_create(
+                   pool,
+                   sizeof(uint32_t),
+                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                   VKC_MEMORY_USAGE_READBACK,
+                   &context->readback
+               )) {
+        LOG_ERROR("[Share] Failed to create consumer buffers.");
+        return false;
+    }
+    return true;
+}
+
+static void share_destroy(ShareContext* context) {
+    if (context->device.pool) {
+        vkc_buffer_destroy(context->device.pool, &context->readback);
+        vkc_buffer_destroy(context->device.pool, &context->scratch);
+    }
+    example_device_destroy(&context->device);
+}
+
+static void share_fill(void* data, size_t size, uint32_t batch) {
+    memset(data, (int) (batch & 0xff), size);
+    memcpy(data, &batch, sizeof(batch));
+}
+
+/**
+ * @brief Have the device read a batch and return the first word it saw.
+ */
+static bool share_read(ShareContext* context, const VkcBuffer* buffer, uint32_t* first) {
+    VkCommandBuffer command = context->device.command;
+    vkc_memory_pool_flush(context->device.pool);
+
+    VkCommandBufferBeginInfo begin = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(command, &begin);
+
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    for (VkDeviceSize offset = 0; offset < buffer->size; offset += context->scratch.size) {
+        VkDeviceSize left = buffer->size - offset;
+        VkBufferCopy region = {
+            .srcOffset = offset,
+            .size = left < context->scratch.size ? left : context->scratch.size,
+        };
+        if (offset) {
+            vkCmdPipelineBarrier(
+                command,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                1,
+                &barrier,
+                0,
+                NULL,
+                0,
+                NULL
+            );
+        }
+        vkCmdCopyBuffer(command, buffer->object, context->scratch.object, 1, &region);
+    }
+    VkBufferCopy word = {.size = sizeof(uint32_t)};
+    vkCmdCopyBuffer(command, buffer->object, context->readback.object, 1, &word);
+    vkEndCommandBuffer(command);
+
+    if (!example_device_submit(&context->device)) {
+        return false;
+    }
+
+    vkc_buffer_mark_invalidate(context->device.pool, &context->readback, 0, VK_WHOLE_SIZE);
+    vkc_memory_pool_invalidate(context->device.pool);
+    memcpy(first, context->readback.data, sizeof(*first));
+    return true;
+}
+
+static int share_producer(int socket, size_t batch, uint32_t batches) {
+    ShareContext context = {0};
+    if (!share_create(&context, 0)) {
+        share_destroy(&context);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_FAILURE;
+    VkcShare slots[SHARE_SLOTS] = {0};
+    uint8_t* private = malloc(batch);
+    if (!private) {
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < SHARE_SLOTS; i++) {
+        VkResult result = vkc_share_create(
+            context.device.pool, batch, SHARE_USAGE, VKC_MEMORY_USAGE_DEVICE_UPLOAD, &slots[i]
+        );
+        if (VK_SUCCESS != result || !slots[i].data || !vkc_share_send(socket, &slots[i])) {
+            LOG_ERROR("[Share] Failed to create or send slot %u (VkResult=%d).", i, result);
+            goto cleanup;
+        }
+    }
+
+    // Shared: fill whichever slot the consumer hands back.
+    for (uint32_t b = 0; b < batches; b++) {
+        uint8_t slot;
+        if (!share_io(socket, &slot, 1, false) || slot >= SHARE_SLOTS) {
+            goto cleanup;
+        }
+        share_fill(slots[slot].data, batch, b);
+        // Exported memory may not be coherent; memfd pages are refreshed by the consumer.
+        if (VKC_SHARE_MODE_OPAQUE_FD == slots[slot].desc.mode) {
+            vkc_share_refresh(context.device.pool, &slots[slot]);
+            vkc_memory_pool_flush(context.device.pool);
+        }
+        if (!share_io(socket, &slot, 1, true)) {
+            goto cleanup;
+        }
+    }
+
+    // Pipe: the whole batch crosses the socket.
+    for (uint32_t b = 0; b < batches; b++) {
+        share_fill(private, batch, b);
+        if (!share_io(socket, private, batch, true)) {
+            goto cleanup;
+        }
+    }
+    status = EXIT_SUCCESS;
+
+cleanup:
+    free(private);
+    for (uint32_t i = 0; i < SHARE_SLOTS; i++) {
+        vkc_share_destroy(context.device.pool, &slots[i]);
+    }
+    share_destroy(&context);
+    return status;
+}
+
+static int share_consumer(int socket, size_t batch, uint32_t batches) {
+    ShareContext context = {0};
+    if (!share_create(&context, batch < SHARE_WINDOW ? batch : SHARE_WINDOW)) {
+        share_destroy(&context);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_FAILURE;
+    VkcShare slots[SHARE_SLOTS] = {0};
+    VkcBuffer upload = {0};
+    for (uint32_t i = 0; i < SHARE_SLOTS; i++) {
+        VkcShareDesc desc;
+        int fd;
+        if (!vkc_share_receive(socket, &desc, &fd)
+            || VK_SUCCESS != vkc_share_open(context.device.pool, &desc, fd, &slots[i])) {
+            LOG_ERROR("[Share] Failed to receive or open slot %u.", i);
+            goto cleanup;
+        }
+    }
+
+    static const char* modes[] = {"opaque fd", "memfd imported", "memfd copied"};
+    uint32_t mode = slots[0].desc.mode;
+    if (VKC_SHARE_MODE_HOST_MEMFD == mode
+        && VKC_MEMORY_PLACEMENT_IMPORTED != slots[0].buffer.memory.placement) {
+        mode++;
+    }
+
+    // Both slots start out free.
+    for (uint8_t i = 0; i < SHARE_SLOTS; i++) {
+        if (!share_io(socket, &i, 1, true)) {
+            goto cleanup;
+        }
+    }
+
+    double start = share_now();
+    for (uint32_t b = 0; b < batches; b++) {
+        uint8_t slot;
+        uint32_t first = 0;
+        if (!share_io(socket, &slot, 1, false) || slot >= SHARE_SLOTS
+            || !vkc_share_refresh(context.device.pool, &slots[slot])
+            || !share_read(&context, &slots[slot].buffer, &first) || first != b) {
+            LOG_ERROR("[Share] Shared batch %u failed (read %u).", b, first);
+            goto cleanup;
+        }
+        // Hand the slot back for a later batch, unless none is left to fill it.
+        if (b + SHARE_SLOTS < batches && !share_io(socket, &slot, 1, true)) {
+            goto cleanup;
+        }
+    }
+    double shared = share_now() - start;
+
+    if (VK_SUCCESS
+        != vkc_buffer_create(
+            context.device.pool, batch, SHARE_USAGE, VKC_MEMORY_USAGE_DEVICE_UPLOAD, &upload
+        )) {
+        goto cleanup;
+    }
+
+    start = share_now();
+    for (uint32_t b = 0; b < batches; b++) {
+        uint32_t first = 0;
+        if (!share_io(socket, upload.data, batch, false)
+            || !vkc_buffer_mark_flush(context.device.pool, &upload, 0, VK_WHOLE_SIZE)
+            || !share_read(&context, &upload, &first) || first != b) {
+            LOG_ERROR("[Share] Piped batch %u failed (read %u).", b, first);
+            goto cleanup;
+        }
+    }
+    double piped = share_now() - start;
+
+    double bytes = (double) batch * batches;
+    printf("%u batches of %zu MiB, shared as %s\n\n", batches, batch >> 20, modes[mode]);
+    printf("path    total (ms)  per batch (ms)  throughput (GB/s)\n");
+    const char* row = "%-6s  %10.2f  %14.3f  %17.2f\n";
+    printf(row, "pipe", piped * 1e3, piped * 1e3 / batches, bytes / piped / 1e9);
+    printf(row, "shared", shared * 1e3, shared * 1e3 / batches, bytes / shared / 1e9);
+    printf("\nshared is %.2fx the pipe's throughput\n", piped / shared);
+    status = EXIT_SUCCESS;
+
+cleanup:
+    vkc_buffer_destroy(context.device.pool, &upload);
+    for (uint32_t i = 0; i < SHARE_SLOTS; i++) {
+        vkc_share_destroy(context.device.pool, &slots[i]);
+    }
+    share_destroy(&context);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? strtoull(argv[1], NULL, 10) : 64;
+    size_t batches = argc > 2 ? strtoull(argv[2], NULL, 10) : 16;
+    if (0 == mib || 0 == batches || batches > UINT32_MAX) {
+        LOG_ERROR("[Share] Usage: %s [batch-MiB] [batches]", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Fork first: neither process may inherit Vulkan state from the other.
+    int sockets[2];
+    if (0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets)) {
+        LOG_ERROR("[Share] Failed to create socket pair: %s.", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    pid_t producer = fork();
+    if (producer < 0) {
+        LOG_ERROR("[Share] Failed to fork: %s.", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (0 == producer) {
+        close(sockets[0]);
+        int status = share_producer(sockets[1], mib << 20, (uint32_t) batches);
+        close(sockets[1]);
+        return status;
+    }
+
+    close(sockets[1]);
+    int status = share_consumer(sockets[0], mib << 20, (uint32_t) batches);
+    // Closing the socket unblocks a producer still waiting on a failed consumer.
+    close(sockets[0]);
+
+    int producer_status = 0;
+    waitpid(producer, &producer_status, 0);
+    if (!WIFEXITED(producer_status) || EXIT_SUCCESS != WEXITSTATUS(producer_status)) {
+        LOG_ERROR("[Share] Producer failed.");
+        status = EXIT_FAILURE;
+    }
+    return status;
+}
@@ -0,0 +1,270 @@
+/**
+ * @file examples/transient.c
+ * @brief Transient buffer aliasing: a multi-stage job with and without a lifetime plan.
+ *
+ * The job is a chain of stages, each writing one intermediate from the previous one:
+ * the first half of stage s's buffer is copied from the second half of stage s-1's, and
+ * its second half is filled with the stage number. Every fourth stage also saves its
+ * second half into a skip buffer that stage s+3 copies back over its own second half,
+ * so some intermediates live for several stages. Stages are separated by barriers.
+ *
+ * The job runs twice. "fresh" creates every intermediate as a VkcBuffer of its own, as
+ * jobs do without a plan. "aliased" declares the same buffers in a VkcTransient,
+ * records the stages that use each, and builds: buffers whose lifetimes do not overlap
+ * share bytes. Both runs read back the final buffer and check every byte, so a
+ * placement that clobbered a live buffer would fail.
+ *
+ * Memory is reported as the bytes of live pool ranges while the job's buffers exist,
+ * next to the plan's own figures.
+ *
+ * Usage: ./build/examples/transient [stages] [buffer-MiB]
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/pool.h"
+#include "vk/buffer.h"
+#include "vk/transient.h"
+#include "fixture.h"
+
+#include <vulkan/vulkan.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JOB_SKIP 3
+#define JOB_USAGE (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+
+/**
+ * @brief One intermediate: its buffer and what the host expects each half to hold.
+ *
+ * Chain buffers have two halves; a skip buffer is one half long.
+ */
+typedef struct JobBuffer {
+    VkBuffer object;
+    VkDeviceSize size;
+    VkDeviceSize half;
+    uint8_t expect[2];
+} JobBuffer;
+
+static void job_barrier(VkCommandBuffer command) {
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(
+        command,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        NULL,
+        0,
+        NULL
+    );
+}
+
+static void
+job_copy(VkCommandBuffer command, JobBuffer* src, uint32_t from, JobBuffer* dst, uint32_t to) {
+    VkBufferCopy region = {
+        .srcOffset = from * src->half,
+        .dstOffset = to * dst->half,
+        .size = dst->half,
+    };
+    vkCmdCopyBuffer(command, src->object, dst->object, 1, &region);
+    dst->expect[to] = src->expect[from];
+}
+
+static void job_fill(VkCommandBuffer command, JobBuffer* dst, uint32_t to, uint8_t value) {
+    vkCmdFillBuffer(command, dst->object, to * dst->half, dst->half, value * 0x01010101u);
+    dst->expect[to] = value;
+}
+
+/**
+ * @brief Buffers the job declares: the chain first, then one skip per fourth stage.
+ */
+static uint32_t job_buffers(uint32_t stages) {
+    return stages + (stages + JOB_SKIP) / (JOB_SKIP + 1);
+}
+
+/**
+ * @brief Record and run the job over `buffers`, then check the last stage's output.
+ */
+static bool
+job_run(ExampleDevice* context, JobBuffer* buffers, uint32_t stages, VkcBuffer* readback) {
+    VkCommandBuffer command = context->command;
+    VkCommandBufferBeginInfo begin = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(command, &begin);
+
+    JobBuffer* skips = buffers + stages;
+    for (uint32_t s = 0; s < stages; s++) {
+        JobBuffer* out = &buffers[s];
+        if (s) {
+            job_barrier(command);
+            job_copy(command, &buffers[s - 1], 1, out, 0);
+        } else {
+            job_fill(command, out, 0, 0xff);
+        }
+        job_fill(command, out, 1, (uint8_t) (s + 1));
+
+        if (0 == s % (JOB_SKIP + 1)) {
+            job_barrier(command);
+            job_copy(command, out, 1, &skips[s / (JOB_SKIP + 1)], 0);
+        }
+        if (s >= JOB_SKIP && 0 == (s - JOB_SKIP) % (JOB_SKIP + 1)) {
+            job_barrier(command);
+            job_copy(command, &skips[(s - JOB_SKIP) / (JOB_SKIP + 1)], 0, out, 1);
+        }
+    }
+
+    job_barrier(command);
+    JobBuffer* last = &buffers[stages - 1];
+    VkBufferCopy region = {.size = last->size};
+    vkCmdCopyBuffer(command, last->object, readback->object, 1, &region);
+    vkEndCommandBuffer(command);
+
+    if (!example_device_submit(context)) {
+        return false;
+    }
+
+    vkc_buffer_mark_invalidate(context->pool, readback, 0, VK_WHOLE_SIZE);
+    vkc_memory_pool_invalidate(context->pool);
+    const uint8_t* data = readback->data;
+    VkDeviceSize half = last->half;
+    for (VkDeviceSize i = 0; i < last->size; i++) {
+        if (data[i] != last->expect[i / half]) {
+            LOG_ERROR(
+                "[Transient] Byte %llu is %u, not %u.",
+                (unsigned long long) i,
+                data[i],
+                last->expect[i / half]
+            );
+            return false;
+        }
+    }
+    return true;
+}
+
+static VkDeviceSize job_held(ExampleDevice* context) {
+    VkcMemoryPoolStats stats;
+    vkc_memory_pool_stats(context->pool, &stats);
+    return stats.allocated_bytes;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t stages = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 10) : 12;
+    size_t mib = argc > 2 ? strtoull(argv[2], NULL, 10) : 16;
+    if (stages < 2 || stages > 4096 || 0 == mib) {
+        LOG_ERROR("[Transient] Usage: %s [stages] [buffer-MiB]", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ExampleDevice context = {0};
+    ExampleDeviceInfo info = {.name = "transient", .commands = true};
+    int status = EXIT_FAILURE;
+    uint32_t count = job_buffers(stages);
+    JobBuffer* buffers = calloc(count, sizeof(*buffers));
+    VkcBuffer* fresh = calloc(count, sizeof(*fresh));
+    VkcBuffer readback = {0};
+    VkcTransient* plan = NULL;
+    if (!buffers || !fresh || !example_device_create(&context, &info)) {
+        goto cleanup;
+    }
+
+    // Chain buffers are `mib` MiB; skips hold the half they save.
+    VkDeviceSize size = (VkDeviceSize) mib << 20;
+    for (uint32_t i = 0; i < count; i++) {
+        buffers[i].size = i < stages ? size : size / 2;
+        buffers[i].half = size / 2;
+    }
+    if (VK_SUCCESS
+        != vkc_buffer_create(
+            context.pool,
+            size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VKC_MEMORY_USAGE_READBACK,
+            &readback
+        )) {
+        goto cleanup;
+    }
+    VkDeviceSize baseline = job_held(&context);
+
+    // Fresh: one range per intermediate, all held for the whole job.
+    for (uint32_t i = 0; i < count; i++) {
+        if (VK_SUCCESS
+            != vkc_buffer_create(
+                context.pool, buffers[i].size, JOB_USAGE, VKC_MEMORY_USAGE_GPU_ONLY, &fresh[i]
+            )) {
+            goto cleanup;
+        }
+        buffers[i].object = fresh[i].object;
+    }
+    VkDeviceSize fresh_held = job_held(&context) - baseline;
+    bool fresh_ok = job_run(&context, buffers, stages, &readback);
+    for (uint32_t i = 0; i < count; i++) {
+        vkc_buffer_destroy(context.pool, &fresh[i]);
+    }
+
+    // Aliased: the same buffers, placed by lifetime.
+    plan = vkc_transient_create(context.pool, VKC_MEMORY_USAGE_GPU_ONLY);
+    if (!plan) {
+        goto cleanup;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        vkc_transient_declare(plan, buffers[i].size, JOB_USAGE);
+    }
+    for (uint32_t s = 0; s < stages; s++) {
+        vkc_transient_use(plan, s, s);
+        if (s + 1 < stages) {
+            vkc_transient_use(plan, s, s + 1);
+        }
+        if (0 == s % (JOB_SKIP + 1)) {
+            uint32_t skip = stages + s / (JOB_SKIP + 1);
+            vkc_transient_use(plan, skip, s);
+            vkc_transient_use(plan, skip, s + JOB_SKIP < stages ? s + JOB_SKIP : s);
+        }
+    }
+    if (VK_SUCCESS != vkc_transient_build(plan)) {
+        goto cleanup;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        buffers[i].object = vkc_transient_buffer(plan, i)->object;
+    }
+    VkDeviceSize aliased_held = job_held(&context) - baseline;
+    bool aliased_ok = job_run(&context, buffers, stages, &readback);
+
+    VkcTransientStats stats;
+    vkc_transient_stats(plan, &stats);
+    printf("%u stages, %u buffers of up to %zu MiB\n\n", stats.stages, stats.buffers, mib);
+    printf("run      held (MiB)  output\n");
+    printf("fresh    %10.1f  %s\n", (double) fresh_held / (1 << 20), fresh_ok ? "ok" : "WRONG");
+    printf("aliased  %10.1f  %s\n", (double) aliased_held / (1 << 20), aliased_ok ? "ok" : "WRONG");
+    printf(
+        "\nplan: %.1f MiB unaliased, %.1f MiB aliased, %.1f MiB live at the busiest stage\n",
+        (double) stats.unaliased_bytes / (1 << 20),
+        (double) stats.aliased_bytes / (1 << 20),
+        (double) stats.live_bytes / (1 << 20)
+    );
+    status = fresh_ok && aliased_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+
+cleanup:
+    if (context.device) {
+        vkDeviceWaitIdle(context.device);
+    }
+    vkc_transient_destroy(plan);
+    for (uint32_t i = 0; fresh && i < count; i++) {
+        vkc_buffer_destroy(context.pool, &fresh[i]);
+    }
+    vkc_buffer_destroy(context.pool, &readback);
+    example_device_destroy(&context);
+    free(fresh);
+    free(buffers);
+    return status;
+}
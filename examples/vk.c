@@ -18,12 +18,20 @@
 #include "allocator/page.h"
 #include "utf8/raw.h"
 #include "numeric/lehmer.h"
+#include "vk/numa.h"
+#include "vk/pool.h"
+#include "vk/buffer.h"
+#include "vk/staging.h"
+#include "vk/sparse.h"
+#include "vk/cache.h"
+#include "vk/shader.h"
 
 #include <vulkan/vulkan.h>
 
 #include <stdalign.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 
 /**
  * @name Allocator Callbacks
@@ -86,7 +94,7 @@ void VKAPI_CALL vkc_free(void* pUserData, void* pMemory) {
 
 /** @} */
 
-int main(void) {
+int main(int argc, char* argv[]) {
     /**
      * @name Debug Environment
      * @brief Enables verbose logging when VKC_DEBUG=1 is set.
@@ -101,6 +109,70 @@ int main(void) {
 
     /** @} */
 
+    /**
+     * @name Buffer Device Address Mode
+     * @brief `--bda` passes buffer addresses as push constants instead of descriptors.
+     * @{
+     */
+
+    bool useDeviceAddress = false;
+    for (int i = 1; i < argc; i++) {
+        if (0 == utf8_raw_compare(argv[i], "--bda")) {
+            useDeviceAddress = true;
+        }
+    }
+
+    LOG_INFO("[VkCompute] Buffer binding: %s.", useDeviceAddress ? "device address" : "descriptor set");
+
+    /** @} */
+
+    /**
+     * @name Sparse Input Mode
+     * @brief `--sparse` places the input at the far end of a large virtual buffer.
+     * @{
+     */
+
+    bool useSparse = false;
+    for (int i = 1; i < argc; i++) {
+        if (0 == utf8_raw_compare(argv[i], "--sparse")) {
+            useSparse = true;
+        }
+    }
+
+    /** @} */
+
+    /**
+     * @name Cold Start Mode
+     * @brief `--cold` discards the saved pipeline cache to measure a first run.
+     * @{
+     */
+
+    bool useColdStart = false;
+    for (int i = 1; i < argc; i++) {
+        if (0 == utf8_raw_compare(argv[i], "--cold")) {
+            useColdStart = true;
+        }
+    }
+
+    /** @} */
+
+    /**
+     * @name NUMA Placement
+     * @brief Keeps host allocations, driver-side host memory and staging copies on one socket.
+     * @{
+     */
+
+    // Pages are placed on the node of the thread that first touches them, so pin before
+    // allocating anything. A no-op on single-node machines.
+    int numaNode = vkc_numa_node_current();
+    if (!vkc_numa_pin(numaNode)) {
+        LOG_ERROR("[VkCompute] Failed to pin to NUMA node %d; copies may cross sockets.", numaNode);
+    }
+
+    LOG_INFO("[VkCompute] NUMA node %d of %zu.", numaNode, vkc_numa_node_count());
+
+    /** @} */
+
     /**
      * @name Memory Allocators
      * @{
@@ -618,10 +690,32 @@ int main(void) {
 
         if (!found) {
             LOG_WARN("[DeviceCreateInfo] Extension not available: %s", vkDeviceExtensionNames[i]);
-            vkInstanceExtensionPropertyFound = false;
+            vkDeviceExtensionPropertyFound = false;
         }
     }
 
+    // Optional: probed on its own so a device without it keeps the extensions above.
+    bool vkMemoryBudgetFound = false;
+    for (uint32_t j = 0; j < vkDeviceExtensionCount; j++) {
+        if (0 == utf8_raw_compare(
+            "VK_EXT_memory_budget",
+            vkDeviceExtensionProperties[j].extensionName)) {
+            vkMemoryBudgetFound = true;
+            LOG_INFO("[DeviceCreateInfo] Enabling Extension: VK_EXT_memory_budget");
+            break;
+        }
+    }
+
+    // The list above is enabled all or none; the budget extension is appended either way.
+    uint32_t vkDeviceExtensionEnabledCount = 0;
+    char const* vkDeviceExtensionEnabled[14];
+    for (uint32_t i = 0; vkDeviceExtensionPropertyFound && i < vkDeviceExtensionNameCount; i++) {
+        vkDeviceExtensionEnabled[vkDeviceExtensionEnabledCount++] = vkDeviceExtensionNames[i];
+    }
+    if (vkMemoryBudgetFound) {
+        vkDeviceExtensionEnabled[vkDeviceExtensionEnabledCount++] = "VK_EXT_memory_budget";
+    }
+
     /** @} */
 
     /**
@@ -695,6 +789,12 @@ int main(void) {
     }
 #endif
 
+    // Core in Vulkan 1.2; the supported features above are enabled as queried.
+    if (useDeviceAddress && !deviceVulkan12.bufferDeviceAddress) {
+        LOG_WARN("[VkPhysicalDeviceFeatures2] bufferDeviceAddress is unsupported; using descriptor sets.");
+        useDeviceAddress = false;
+    }
+
     LOG_INFO("[VkPhysicalDeviceFeatures2] Enabled physical device extensions.");
 
     /** @} */
@@ -726,9 +826,9 @@ int main(void) {
         vkDeviceCreateInfo.ppEnabledLayerNames = vkDeviceLayerPropertyNames;
     }
 
-    if (vkDeviceExtensionPropertyFound) {
-        vkDeviceCreateInfo.enabledExtensionCount = vkDeviceExtensionNameCount;
-        vkDeviceCreateInfo.ppEnabledExtensionNames = vkDeviceExtensionNames;
+    if (vkDeviceExtensionEnabledCount > 0) {
+        vkDeviceCreateInfo.enabledExtensionCount = vkDeviceExtensionEnabledCount;
+        vkDeviceCreateInfo.ppEnabledExtensionNames = vkDeviceExtensionEnabled;
     }
 
     VkDevice vkDevice = VK_NULL_HANDLE;
@@ -748,63 +848,46 @@ int main(void) {
     /** @} */
 
     /**
-     * @name Read SPIR-V File
+     * @name Pipeline Cache
+     * @note Seeded from the last run's cache file when it was written by this device and driver.
      * @{
      */
 
-    const char* shaderFilePath = "build/shaders/atomic_sum.spv";
-    FILE* shaderFile = fopen(shaderFilePath, "rb");
-    if (NULL == shaderFile) {
-        LOG_ERROR("[VkShaderModule] Failed to open SPIR-V file: %s", shaderFilePath);
-        goto cleanup_device;
-    }
-
-    fseek(shaderFile, 0, SEEK_END);
-    long shaderFilelength = ftell(shaderFile);
-    rewind(shaderFile);
-    if (-1 == shaderFilelength) {
-        LOG_ERROR("[VkShaderModule] Failed to inference SPIR-V file size: %s", shaderFilePath);
-        fclose(shaderFile);
-        goto cleanup_device;
+    static const char* const vkPipelineCachePath = "build/pipeline.cache";
+    if (useColdStart) {
+        remove(vkPipelineCachePath);
     }
 
-    uint32_t shaderCodeSize = (uint32_t) shaderFilelength;
-    uint32_t* shaderCode = (uint32_t*) page_malloc(
-        pager,
-        (shaderCodeSize + 1) * sizeof(uint32_t),
-        alignof(uint32_t)
+    VkcPipelineCache* vkPipelineCache = vkc_pipeline_cache_create(
+        vkPhysicalDevice, vkDevice, &vkAllocationCallback, vkPipelineCachePath
     );
-
-    if (NULL == shaderCode) {
-        LOG_ERROR("[VkShaderModule] Failed to allocate %u bytes for SPIR-V shader", shaderCodeSize);
-        fclose(shaderFile);
+    if (!vkPipelineCache) {
+        LOG_ERROR("[VkcPipelineCache] Failed to create pipeline cache.");
         goto cleanup_device;
     }
 
-    // Assuming fread null terminates buffer for us
-    fread(shaderCode, 1, shaderCodeSize, shaderFile);
-    fclose(shaderFile);
-
-    LOG_INFO("[VkShaderModule] Read SPIR-V shader: file=%s, size=%u", shaderFilePath, shaderCodeSize);
-
     /** @} */
 
     /**
      * @name Shader Module
+     * @note The registry maps the SPIR-V and shares one module per distinct file content.
      * @{
      */
 
-    VkShaderModuleCreateInfo vkShaderInfo = {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = shaderCodeSize,
-        .pCode = shaderCode,
-    };
+    VkcShaderRegistry* vkShaderRegistry
+        = vkc_shader_registry_create(vkDevice, &vkAllocationCallback);
+    if (!vkShaderRegistry) {
+        LOG_ERROR("[VkcShaderRegistry] Failed to create shader registry.");
+        goto cleanup_pipeline_cache;
+    }
 
+    const char* shaderFilePath = useDeviceAddress ? "build/shaders/atomic_sum_bda.spv"
+                                                  : "build/shaders/atomic_sum.spv";
     VkShaderModule vkShaderModule = VK_NULL_HANDLE;
-    result = vkCreateShaderModule(vkDevice, &vkShaderInfo, &vkAllocationCallback, &vkShaderModule);
+    result = vkc_shader_registry_load(vkShaderRegistry, shaderFilePath, &vkShaderModule);
     if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkShaderModule] Failed to create shader module from %s (VkResult=%d)", shaderFilePath, result);
-        goto cleanup_device;
+        LOG_ERROR("[VkShaderModule] Failed to load %s (VkResult=%d).", shaderFilePath, result);
+        goto cleanup_shader_module;
     }
 
     LOG_INFO("[VkShaderModule] Created shader module @ %p.", vkShaderModule);
@@ -816,37 +899,40 @@ int main(void) {
      * @{
      */
 
-    VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[2] = {
-        {
-            .binding = 0,
-            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .descriptorCount = 1,
-            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-            .pImmutableSamplers = NULL,
-        },
-        {
-            .binding = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .descriptorCount = 1,
-            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-            .pImmutableSamplers = NULL,
-        },
-    };
-
-    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = 2,
-        .pBindings = descriptorSetLayoutBindings,
-    };
-
+    // Device address mode reaches buffers through push constants and needs no layout.
     VkDescriptorSetLayout vkDescriptorSetLayout = VK_NULL_HANDLE;
-    result = vkCreateDescriptorSetLayout(vkDevice, &descriptorSetLayoutCreateInfo, &vkAllocationCallback, &vkDescriptorSetLayout);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkDescriptorSetLayout] Failed to create the descriptor set layout (VkResult=%d)", result);
-        goto cleanup_shader_module;
-    }
+    if (!useDeviceAddress) {
+        VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[2] = {
+            {
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = NULL,
+            },
+            {
+                .binding = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = NULL,
+            },
+        };
+
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = 2,
+            .pBindings = descriptorSetLayoutBindings,
+        };
+
+        result = vkCreateDescriptorSetLayout(vkDevice, &descriptorSetLayoutCreateInfo, &vkAllocationCallback, &vkDescriptorSetLayout);
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkDescriptorSetLayout] Failed to create the descriptor set layout (VkResult=%d)", result);
+            goto cleanup_shader_module;
+        }
 
-    LOG_INFO("[VkDescriptorSetLayout] Created descriptor set layout @ %p.", vkDescriptorSetLayout);
+        LOG_INFO("[VkDescriptorSetLayout] Created descriptor set layout @ %p.", vkDescriptorSetLayout);
+    }
 
     /** @} */
 
@@ -854,10 +940,19 @@ int main(void) {
      * @name Pipeline Layout
      */
 
+    // Input and output addresses, in the order the shader's push constant block declares them.
+    VkPushConstantRange pushConstantRange = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = 2 * sizeof(VkDeviceAddress),
+    };
+
     VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 1,
-        .pSetLayouts = &vkDescriptorSetLayout
+        .setLayoutCount = useDeviceAddress ? 0 : 1,
+        .pSetLayouts = useDeviceAddress ? NULL : &vkDescriptorSetLayout,
+        .pushConstantRangeCount = useDeviceAddress ? 1 : 0,
+        .pPushConstantRanges = useDeviceAddress ? &pushConstantRange : NULL,
     };
 
     VkPipelineLayout vkPipelineLayout = VK_NULL_HANDLE;
@@ -901,95 +996,190 @@ int main(void) {
         .layout = vkPipelineLayout,
     };
 
+    // Timed to compare a cold cache with a warm one.
+    struct timespec pipelineStart, pipelineEnd;
+    clock_gettime(CLOCK_MONOTONIC, &pipelineStart);
+
     VkPipeline vkPipeline = VK_NULL_HANDLE;
     result = vkCreateComputePipelines(
         vkDevice,
-        NULL,
+        vkc_pipeline_cache_object(vkPipelineCache),
         1,
         &computePipelineCreateInfo,
         &vkAllocationCallback,
         &vkPipeline
     );
 
+    clock_gettime(CLOCK_MONOTONIC, &pipelineEnd);
+
     if (VK_SUCCESS != result) {
         LOG_ERROR("[VkPipeline] Failed to create compute pipeline (VkResult=%d).", result);
         goto cleanup_pipeline_layout;
     }
 
-    LOG_INFO("[VkPipeline] Created compute pipeline @ %p.", vkPipeline);
+    VkcPipelineCacheStats vkPipelineCacheStats;
+    vkc_pipeline_cache_stats(vkPipelineCache, &vkPipelineCacheStats);
+    double pipelineMilliseconds = (double) (pipelineEnd.tv_sec - pipelineStart.tv_sec) * 1e3
+                                  + (double) (pipelineEnd.tv_nsec - pipelineStart.tv_nsec) / 1e6;
+
+    LOG_INFO(
+        "[VkPipeline] Created compute pipeline @ %p in %.3f ms (%s cache).",
+        vkPipeline,
+        pipelineMilliseconds,
+        vkPipelineCacheStats.warm ? "warm" : "cold"
+    );
+
+    // Save now rather than only at exit, so a later failure still leaves a warm cache.
+    if (VK_SUCCESS != vkc_pipeline_cache_save(vkPipelineCache)) {
+        LOG_WARN("[VkcPipelineCache] Failed to save the cache; the next run starts cold.");
+    }
 
     /** @} */
 
     /**
-     * @name Input Storage Buffer
+     * @name Device Memory Pool
+     * @note Buffers share large blocks instead of one vkAllocateMemory each.
      * @{
      */
 
-    VkBufferCreateInfo inputBufferCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size = 64 * sizeof(float),
-        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-    };
-
-    VkBuffer inputBuffer = VK_NULL_HANDLE;
-    result = vkCreateBuffer(vkDevice, &inputBufferCreateInfo, &vkAllocationCallback, &inputBuffer);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkBuffer] Failed to create input storage buffer (VkResult=%d).", result);
+    VkcMemoryPool* vkMemoryPool = vkc_memory_pool_create(
+        vkPhysicalDevice,
+        vkDevice,
+        &vkAllocationCallback,
+        0,
+        (useDeviceAddress ? VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT : 0)
+            | (vkMemoryBudgetFound ? VKC_MEMORY_POOL_MEMORY_BUDGET_BIT : 0)
+    );
+    if (!vkMemoryPool) {
+        LOG_ERROR("[VkcMemoryPool] Failed to create device memory pool.");
         goto cleanup_pipeline;
     }
 
-    LOG_INFO("[VkBuffer] Created input storage buffer @ %p.", inputBuffer);
+    LOG_INFO("[VkcMemoryPool] Created device memory pool @ %p.", vkMemoryPool);
+
+    // Keep within each heap's budget: fall back to the next memory type instead of
+    // oversubscribing VRAM and letting the driver page.
+    VkcMemoryBudgetPolicy vkMemoryBudgetPolicy = {.action = VKC_MEMORY_BUDGET_SPILL};
+    vkc_memory_pool_budget_policy(vkMemoryPool, &vkMemoryBudgetPolicy);
+
+    VkcMemoryBudget vkMemoryBudget;
+    for (uint32_t heap = 0; vkc_memory_pool_budget(vkMemoryPool, heap, &vkMemoryBudget); heap++) {
+        LOG_INFO(
+            "[VkcMemoryPool] Heap %u: budget=%llu, usage=%llu (%s).",
+            heap,
+            (unsigned long long) vkMemoryBudget.budget,
+            (unsigned long long) vkMemoryBudget.usage,
+            vkMemoryBudgetFound ? "VK_EXT_memory_budget" : "estimated"
+        );
+    }
 
     /** @} */
 
     /**
-     * @name Input Storage Buffer: Allocate Memory
+     * @name Staging Ring
+     * @note Uploads are written into a persistently mapped ring and copied on the device.
      * @{
      */
 
-    VkMemoryRequirements inputMemoryRequirements = {0};
-    vkGetBufferMemoryRequirements(vkDevice, inputBuffer, &inputMemoryRequirements);
+    VkcStaging* vkStaging = vkc_staging_create(vkDevice, vkMemoryPool, &vkAllocationCallback, 0);
+    if (!vkStaging) {
+        LOG_ERROR("[VkcStaging] Failed to create staging ring.");
+        goto cleanup_memory_pool;
+    }
 
-    VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties = {0};
-    vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice, &physicalDeviceMemoryProperties);
+    LOG_INFO("[VkcStaging] Created staging ring @ %p.", vkStaging);
 
-    uint32_t memoryType = UINT32_MAX;
-    for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; ++i) {
-        if ((inputMemoryRequirements.memoryTypeBits & (1 << i)) &&
-            (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags &
-            (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) ==
-                (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-            memoryType = i;
-            break;
+    /** @} */
+
+    /**
+     * @name Input Storage Buffer
+     * @{
+     */
+
+    VkBufferUsageFlags storageBufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                            | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                            | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (useDeviceAddress) {
+        storageBufferUsage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+
+    // GPU-only: filled through the staging ring, never touched by the host.
+    VkcBuffer inputBuffer = {0};
+    VkcSparse* inputSparse = NULL;
+    VkcSparseRange inputRange = {0};
+    if (useSparse) {
+        // Residency needs a queue that can bind sparse memory; chunks need none.
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice, &queueFamilyCount, NULL);
+        VkQueueFamilyProperties* queueFamilies = page_malloc(
+            pager,
+            queueFamilyCount * sizeof(VkQueueFamilyProperties),
+            alignof(VkQueueFamilyProperties)
+        );
+        if (NULL == queueFamilies) {
+            LOG_ERROR("[VkcSparse] Failed to allocate queue families.");
+            goto cleanup_staging;
         }
-    }
 
-    if (UINT32_MAX == memoryType) {
-        LOG_ERROR("[VkMemory] Failed to find a suitable memory type for input buffer.");
-        goto cleanup_input_buffer;
-    }
+        vkGetPhysicalDeviceQueueFamilyProperties(
+            vkPhysicalDevice, &queueFamilyCount, queueFamilies
+        );
+        VkQueueFlags queueFlags = queueFamilies[vkQueueFamilyIndex].queueFlags;
+        VkQueue sparseQueue = (queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) ? vkQueue : VK_NULL_HANDLE;
+        page_free(pager, queueFamilies);
 
-    VkMemoryAllocateInfo inputAllocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = inputMemoryRequirements.size,
-        .memoryTypeIndex = memoryType,
-    };
+        // 16 GiB of address space; only the page under the input is ever backed.
+        inputSparse = vkc_sparse_create(
+            vkMemoryPool, sparseQueue, 16ull << 30, storageBufferUsage, VKC_MEMORY_USAGE_GPU_ONLY, 0
+        );
+        if (!inputSparse) {
+            LOG_ERROR("[VkcSparse] Failed to reserve sparse input buffer.");
+            goto cleanup_staging;
+        }
 
-    VkDeviceMemory inputMemory = VK_NULL_HANDLE;
-    result = vkAllocateMemory(vkDevice, &inputAllocInfo, &vkAllocationCallback, &inputMemory);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkMemory] Failed to allocate memory for input buffer (VkResult=%d).", result);
-        goto cleanup_input_buffer;
-    }
+        VkcSparseStats sparseStats;
+        vkc_sparse_stats(inputSparse, &sparseStats);
+        VkDeviceSize inputOffset = sparseStats.size - sparseStats.page_size;
+        result = vkc_sparse_commit(inputSparse, inputOffset, 64 * sizeof(float));
+        if (VK_SUCCESS != result || !vkc_sparse_resolve(inputSparse, inputOffset, &inputRange)) {
+            LOG_ERROR("[VkcSparse] Failed to commit sparse input (VkResult=%d).", result);
+            goto cleanup_input_buffer;
+        }
 
-    result = vkBindBufferMemory(vkDevice, inputBuffer, inputMemory, 0);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkMemory] Failed to bind input memory to buffer (VkResult=%d).", result);
-        goto cleanup_input_memory;
-    }
+        vkc_sparse_stats(inputSparse, &sparseStats);
+        LOG_INFO(
+            "[VkcSparse] Input at %llu of %llu virtual bytes; %llu committed (%s).",
+            (unsigned long long) inputOffset,
+            (unsigned long long) sparseStats.size,
+            (unsigned long long) sparseStats.committed_bytes,
+            VKC_SPARSE_MODE_RESIDENCY == sparseStats.mode ? "sparse residency" : "chunked"
+        );
+    } else {
+        result = vkc_buffer_create(
+            vkMemoryPool,
+            64 * sizeof(float),
+            storageBufferUsage,
+            VKC_MEMORY_USAGE_GPU_ONLY,
+            &inputBuffer
+        );
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkBuffer] Failed to create input storage buffer (VkResult=%d).", result);
+            goto cleanup_staging;
+        }
 
-    LOG_INFO("[VkMemory] Allocated and bound input buffer to device @ %p.", inputMemory);
+        inputRange = (VkcSparseRange) {
+            .buffer = inputBuffer.object,
+            .size = inputBuffer.size,
+            .address = inputBuffer.address,
+        };
+
+        LOG_INFO(
+            "[VkBuffer] Created input storage buffer @ %p bound to device memory @ %p + %llu.",
+            inputBuffer.object,
+            inputBuffer.memory.memory,
+            (unsigned long long) inputBuffer.memory.offset
+        );
+    }
 
     /** @} */
 
@@ -998,21 +1188,26 @@ int main(void) {
      * @{
      */
 
-    void* mapped = NULL;
-    result = vkMapMemory(vkDevice, inputMemory, 0, 64 * sizeof(float), 0, &mapped);
+    // Write straight into the ring; the copy is recorded with the dispatch.
+    VkcStagingRange inputStaging = {0};
+    result = vkc_staging_alloc(vkStaging, 64 * sizeof(float), alignof(float), &inputStaging);
     if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkMapMemory] Failed to map input memory (VkResult=%d).", result);
-        goto cleanup_input_memory;
+        LOG_ERROR("[VkcStaging] Failed to reserve input staging (VkResult=%d).", result);
+        goto cleanup_input_buffer;
     }
 
     lehmer_initialize(LEHMER_SEED);
-    float* data = (float*) mapped;
+    float* data = (float*) inputStaging.data;
     for (uint32_t i = 0; i < 64; i++) {
         data[i] = lehmer_generate_float();
     }
-    vkUnmapMemory(vkDevice, inputMemory);
 
-    LOG_INFO("[VkMapMemory] Mapped memory and initialized data @ %p.", mapped);
+    if (!vkc_staging_copy(vkStaging, &inputStaging, inputRange.buffer, inputRange.offset)) {
+        LOG_ERROR("[VkcStaging] Failed to queue input upload.");
+        goto cleanup_input_buffer;
+    }
+
+    LOG_INFO("[VkcStaging] Staged input data @ %p.", inputStaging.data);
 
     /** @} */
 
@@ -1022,164 +1217,127 @@ int main(void) {
      * @{
      */
 
-    VkBufferCreateInfo outputBufferCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size = sizeof(float),
-        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-    };
-
-    VkBuffer outputBuffer = VK_NULL_HANDLE;
-    result = vkCreateBuffer(vkDevice, &outputBufferCreateInfo, &vkAllocationCallback, &outputBuffer);
+    // Mapped once here; the result is read through outputBuffer.data after each sync.
+    VkcBuffer outputBuffer = {0};
+    result = vkc_buffer_create(
+        vkMemoryPool,
+        sizeof(float),
+        storageBufferUsage,
+        VKC_MEMORY_USAGE_READBACK,
+        &outputBuffer
+    );
     if (VK_SUCCESS != result) {
         LOG_ERROR("[VkBuffer] Failed to create output storage buffer (VkResult=%d).", result);
-        goto cleanup_input_memory;
+        goto cleanup_input_buffer;
     }
 
-    /** @} */
-
-    /**
-     * @name Output Storage Buffer: Allocate Memory
-     * @{
-     */
+    LOG_INFO(
+        "[VkBuffer] Created output storage buffer @ %p mapped at %p.",
+        outputBuffer.object,
+        outputBuffer.data
+    );
 
-    VkMemoryRequirements outputMemoryRequirements = {0};
-    vkGetBufferMemoryRequirements(vkDevice, outputBuffer, &outputMemoryRequirements);
+    /** @} */
 
-    memoryType = UINT32_MAX;
-    for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; ++i) {
-        if ((outputMemoryRequirements.memoryTypeBits & (1 << i)) &&
-            (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags &
-            (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) ==
-                (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-            memoryType = i;
-            break;
+    // Device address mode skips the pool, the set and its update entirely.
+    VkDescriptorPool vkDescriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet vkDescriptorSet = VK_NULL_HANDLE;
+    if (!useDeviceAddress) {
+        /**
+         * @name Descriptor Pool
+         * @{
+         */
+
+        VkDescriptorPoolSize descriptorPoolSizes[] = {
+            {
+                .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 2,
+            },
+        };
+
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .poolSizeCount = 1,
+            .pPoolSizes = descriptorPoolSizes,
+            .maxSets = 1,
+            .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+        };
+
+        result = vkCreateDescriptorPool(vkDevice, &descriptorPoolCreateInfo, &vkAllocationCallback, &vkDescriptorPool);
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkDescriptorPool] Failed to create descriptor pool (VkResult=%d)", result);
+            goto cleanup_output_buffer;
         }
-    }
-
-    if (UINT32_MAX == memoryType) {
-        LOG_ERROR("[VkMemory] Failed to find a suitable memory type for output buffer.");
-        goto cleanup_output_buffer;
-    }
 
-    VkMemoryAllocateInfo outputAllocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = outputMemoryRequirements.size,
-        .memoryTypeIndex = memoryType,
-    };
+        LOG_INFO("[VkDescriptorPool] Created descriptor pool @ %p", vkDescriptorPool);
 
-    VkDeviceMemory outputMemory = VK_NULL_HANDLE;
-    result = vkAllocateMemory(vkDevice, &outputAllocInfo, &vkAllocationCallback, &outputMemory);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkMemory] Failed to allocate memory for output buffer (VkResult=%d).", result);
-        goto cleanup_output_buffer;
-    }
+        /** @} */
 
-    result = vkBindBufferMemory(vkDevice, outputBuffer, outputMemory, 0);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkMemory] Failed to bind output memory to buffer (VkResult=%d).", result);
-        goto cleanup_output_memory;
-    }
+        /**
+         * @name Descriptor Set
+         * @{
+         */
 
-    LOG_INFO("[VkMemory] Allocated and bound output buffer to device @ %p.", outputMemory);
+        VkDescriptorSetAllocateInfo descriptorSetAllocationInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = vkDescriptorPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &vkDescriptorSetLayout,
+        };
 
-    /** @} */
+        result = vkAllocateDescriptorSets(vkDevice, &descriptorSetAllocationInfo, &vkDescriptorSet);
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkDescriptorSet] Failed to allocate descriptor set (VkResult=%d)", result);
+            goto cleanup_descriptor_pool;
+        }
 
-    /**
-     * @name Descriptor Pool
-     * @{
-     */
+        LOG_INFO("[VkDescriptorSet] Created descriptor set @ %p", vkDescriptorSet);
 
-    VkDescriptorPoolSize descriptorPoolSizes[] = {
-        {
-            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .descriptorCount = 2,
-        },
-    };
+        /** @} */
 
-    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .poolSizeCount = 1,
-        .pPoolSizes = descriptorPoolSizes,
-        .maxSets = 1,
-        .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
-    };
+        /**
+         * @name Bind Buffers to Descriptor Set
+         * @{
+         */
 
-    VkDescriptorPool vkDescriptorPool = VK_NULL_HANDLE;
-    result = vkCreateDescriptorPool(vkDevice, &descriptorPoolCreateInfo, &vkAllocationCallback, &vkDescriptorPool);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkDescriptorPool] Failed to create descriptor pool (VkResult=%d)", result);
-        goto cleanup_output_memory;
-    }
+        VkDescriptorBufferInfo inputBufferInfo = {
+            .buffer = inputRange.buffer,
+            .offset = inputRange.offset,
+            .range = 64 * sizeof(float),
+        };
 
-    LOG_INFO("[VkDescriptorPool] Created descriptor pool @ %p", vkDescriptorPool);
+        VkDescriptorBufferInfo outputBufferInfo = {
+            .buffer = outputBuffer.object,
+            .offset = 0,
+            .range = sizeof(float),
+        };
 
-    /** @} */
+        VkWriteDescriptorSet descriptorWrites[] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = vkDescriptorSet,
+                .dstBinding = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &inputBufferInfo,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = vkDescriptorSet,
+                .dstBinding = 1,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &outputBufferInfo,
+            },
+        };
 
-    /**
-     * @name Descriptor Set
-     * @{
-     */
+        vkUpdateDescriptorSets(vkDevice, 2, descriptorWrites, 0, NULL);
 
-    VkDescriptorSetAllocateInfo descriptorSetAllocationInfo = {
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-        .descriptorPool = vkDescriptorPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &vkDescriptorSetLayout,
-    };
+        LOG_INFO("[VkWriteDescriptorSets] Successfully updated descriptor sets.");
 
-    VkDescriptorSet vkDescriptorSet = VK_NULL_HANDLE;
-    result = vkAllocateDescriptorSets(vkDevice, &descriptorSetAllocationInfo, &vkDescriptorSet);
-    if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkDescriptorSet] Failed to allocate descriptor set (VkResult=%d)", result);
-        goto cleanup_descriptor_pool;
+        /** @} */
     }
 
-    LOG_INFO("[VkDescriptorSet] Created descriptor set @ %p", vkDescriptorSet);
-
-    /** @} */
-
-    /**
-     * @name Bind Buffers to Descriptor Set
-     * @{
-     */
-
-    VkDescriptorBufferInfo inputBufferInfo = {
-        .buffer = inputBuffer,
-        .offset = 0,
-        .range = 64 * sizeof(float),
-    };
-
-    VkDescriptorBufferInfo outputBufferInfo = {
-        .buffer = outputBuffer,
-        .offset = 0,
-        .range = sizeof(float),
-    };
-
-    VkWriteDescriptorSet descriptorWrites[] = {
-        {
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = vkDescriptorSet,
-            .dstBinding = 0,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .pBufferInfo = &inputBufferInfo,
-        },
-        {
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = vkDescriptorSet,
-            .dstBinding = 1,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .pBufferInfo = &outputBufferInfo,
-        },
-    };
-
-    vkUpdateDescriptorSets(vkDevice, 2, descriptorWrites, 0, NULL);
-
-    LOG_INFO("[VkWriteDescriptorSets] Successfully updated descriptor sets.");
-
-    /** @} */
 
     /**
      * @name Command Pool
@@ -1243,22 +1401,85 @@ int main(void) {
         goto cleanup_command_buffer;
     }
 
-    vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vkPipeline);
-    vkCmdBindDescriptorSets(
+    // Upload the input, then make the copy visible to the shader.
+    vkc_staging_record(vkStaging, vkCommandBuffer);
+
+    VkBufferMemoryBarrier uploadBarrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = inputRange.buffer,
+        .offset = inputRange.offset,
+        .size = 64 * sizeof(float),
+    };
+    vkCmdPipelineBarrier(
         vkCommandBuffer,
-        VK_PIPELINE_BIND_POINT_COMPUTE,
-        vkPipelineLayout,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
         0,
+        NULL,
         1,
-        &vkDescriptorSet,
+        &uploadBarrier,
         0,
         NULL
     );
 
+    vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vkPipeline);
+    if (useDeviceAddress) {
+        // Raw addresses ride along with the command buffer; nothing to allocate or update.
+        VkDeviceAddress bufferAddresses[2] = {inputRange.address, outputBuffer.address};
+        vkCmdPushConstants(
+            vkCommandBuffer,
+            vkPipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(bufferAddresses),
+            bufferAddresses
+        );
+    } else {
+        vkCmdBindDescriptorSets(
+            vkCommandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            vkPipelineLayout,
+            0,
+            1,
+            &vkDescriptorSet,
+            0,
+            NULL
+        );
+    }
+
     // You’re operating on 64 floats (1D), so dispatch with ceil(64 / local_size_x)
     // If local_size_x = 64 in shader, use 1
     vkCmdDispatch(vkCommandBuffer, 1, 1, 1);
 
+    // Make the result available to host reads once the fence signals.
+    VkBufferMemoryBarrier readbackBarrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = outputBuffer.object,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(
+        vkCommandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0,
+        NULL,
+        1,
+        &readbackBarrier,
+        0,
+        NULL
+    );
+
     result = vkEndCommandBuffer(vkCommandBuffer);
     if (VK_SUCCESS != result) {
         LOG_ERROR("[vkEndCommandBuffer] Failed to record command buffer (VkResult=%d)", result);
@@ -1280,19 +1501,34 @@ int main(void) {
         .pCommandBuffers = &vkCommandBuffer,
     };
 
-    result = vkQueueSubmit(vkQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    // The staging fence retires the ring space once the submission completes.
+    VkFence vkFence = VK_NULL_HANDLE;
+    result = vkc_staging_fence(vkStaging, &vkFence);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcStaging] Failed to close upload batch (VkResult=%d)", result);
+        goto cleanup_command_buffer;
+    }
+
+    // Non-coherent memory: one flush covers every host write marked since the last submit.
+    result = vkc_memory_pool_flush(vkMemoryPool);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcMemoryPool] Failed to flush host writes (VkResult=%d)", result);
+        goto cleanup_command_buffer;
+    }
+
+    result = vkQueueSubmit(vkQueue, 1, &submitInfo, vkFence);
     if (VK_SUCCESS != result) {
         LOG_ERROR("[vkQueueSubmit] Failed to submit command buffer (VkResult=%d)", result);
         goto cleanup_command_buffer;
     }
 
-    result = vkQueueWaitIdle(vkQueue);
+    result = vkWaitForFences(vkDevice, 1, &vkFence, VK_TRUE, UINT64_MAX);
     if (VK_SUCCESS != result) {
-        LOG_ERROR("[vkQueueWaitIdle] Failed to idle queue after submission (VkResult=%d)", result);
+        LOG_ERROR("[vkWaitForFences] Failed to wait for submission (VkResult=%d)", result);
         goto cleanup_command_buffer;
     }
 
-    LOG_INFO("[VkQueue] Compute queue submitted and idle.");
+    LOG_INFO("[VkQueue] Compute queue submitted and complete.");
 
     /** @} */
 
@@ -1301,15 +1537,20 @@ int main(void) {
      * @{
      */
 
-    float* out = NULL;
-    result = vkMapMemory(vkDevice, outputMemory, 0, sizeof(float), 0, (void**)&out);
+    // Persistently mapped: no map call, and a no-op invalidate on coherent memory.
+    if (!vkc_buffer_mark_invalidate(vkMemoryPool, &outputBuffer, 0, VK_WHOLE_SIZE)) {
+        LOG_ERROR("[VkBuffer] Failed to mark output for readback.");
+        goto cleanup_command_buffer;
+    }
+
+    result = vkc_memory_pool_invalidate(vkMemoryPool);
     if (VK_SUCCESS != result) {
-        LOG_ERROR("[VkMapMemory] Failed to map output memory.");
+        LOG_ERROR("[VkcMemoryPool] Failed to invalidate readback (VkResult=%d)", result);
         goto cleanup_command_buffer;
     }
 
-    LOG_INFO("[VkMapMemory] Output result: %.6f", (double) (*out) / 64);
-    vkUnmapMemory(vkDevice, outputMemory);
+    const float* out = (const float*) outputBuffer.data;
+    LOG_INFO("[VkBuffer] Output result: %.6f", (double) (*out) / 64);
 
     /** @} */
 
@@ -1320,16 +1561,20 @@ int main(void) {
 
     vkFreeCommandBuffers(vkDevice, vkCommandPool, 1, &vkCommandBuffer);
     vkDestroyCommandPool(vkDevice, vkCommandPool, &vkAllocationCallback);
-    vkFreeDescriptorSets(vkDevice, vkDescriptorPool, 1, &vkDescriptorSet);
+    if (vkDescriptorSet) {
+        vkFreeDescriptorSets(vkDevice, vkDescriptorPool, 1, &vkDescriptorSet);
+    }
     vkDestroyDescriptorPool(vkDevice, vkDescriptorPool, &vkAllocationCallback);
-    vkFreeMemory(vkDevice, outputMemory, &vkAllocationCallback);
-    vkDestroyBuffer(vkDevice, outputBuffer, &vkAllocationCallback);
-    vkFreeMemory(vkDevice, inputMemory, &vkAllocationCallback);
-    vkDestroyBuffer(vkDevice, inputBuffer, &vkAllocationCallback);
+    vkc_buffer_destroy(vkMemoryPool, &outputBuffer);
+    vkc_sparse_destroy(inputSparse);
+    vkc_buffer_destroy(vkMemoryPool, &inputBuffer);
+    vkc_staging_destroy(vkStaging);
+    vkc_memory_pool_destroy(vkMemoryPool);
     vkDestroyPipeline(vkDevice, vkPipeline, &vkAllocationCallback);
     vkDestroyPipelineLayout(vkDevice, vkPipelineLayout, &vkAllocationCallback);
     vkDestroyDescriptorSetLayout(vkDevice, vkDescriptorSetLayout, &vkAllocationCallback);
-    vkDestroyShaderModule(vkDevice, vkShaderModule, &vkAllocationCallback);
+    vkc_shader_registry_destroy(vkShaderRegistry);
+    vkc_pipeline_cache_destroy(vkPipelineCache);
     vkDestroyDevice(vkDevice, &vkAllocationCallback);
     vkDestroyInstance(vkInstance, &vkAllocationCallback);
     page_allocator_free(pager);
@@ -1354,17 +1599,20 @@ cleanup_command_buffer:
 cleanup_command_pool:
     vkDestroyCommandPool(vkDevice, vkCommandPool, &vkAllocationCallback);
 cleanup_descriptor_set:
-    vkFreeDescriptorSets(vkDevice, vkDescriptorPool, 1, &vkDescriptorSet);
+    if (vkDescriptorSet) {
+        vkFreeDescriptorSets(vkDevice, vkDescriptorPool, 1, &vkDescriptorSet);
+    }
 cleanup_descriptor_pool:
     vkDestroyDescriptorPool(vkDevice, vkDescriptorPool, &vkAllocationCallback);
-cleanup_output_memory:
-    vkFreeMemory(vkDevice, outputMemory, &vkAllocationCallback);
 cleanup_output_buffer:
-    vkDestroyBuffer(vkDevice, outputBuffer, &vkAllocationCallback);
-cleanup_input_memory:
-    vkFreeMemory(vkDevice, inputMemory, &vkAllocationCallback);
+    vkc_buffer_destroy(vkMemoryPool, &outputBuffer);
 cleanup_input_buffer:
-    vkDestroyBuffer(vkDevice, inputBuffer, &vkAllocationCallback);
+    vkc_sparse_destroy(inputSparse);
+    vkc_buffer_destroy(vkMemoryPool, &inputBuffer);
+cleanup_staging:
+    vkc_staging_destroy(vkStaging);
+cleanup_memory_pool:
+    vkc_memory_pool_destroy(vkMemoryPool);
 cleanup_pipeline:
     vkDestroyPipeline(vkDevice, vkPipeline, &vkAllocationCallback);
 cleanup_pipeline_layout:
@@ -1372,7 +1620,9 @@ cleanup_pipeline_layout:
 cleanup_descriptor_set_layout:
     vkDestroyDescriptorSetLayout(vkDevice, vkDescriptorSetLayout, &vkAllocationCallback);
 cleanup_shader_module:
-    vkDestroyShaderModule(vkDevice, vkShaderModule, &vkAllocationCallback);
+    vkc_shader_registry_destroy(vkShaderRegistry);
+cleanup_pipeline_cache:
+    vkc_pipeline_cache_destroy(vkPipelineCache);
 cleanup_device:
     vkDestroyDevice(vkDevice, &vkAllocationCallback);
 cleanup_instance:
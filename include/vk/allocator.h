@@ -1,29 +1,217 @@
 /**
  * @file include/vk/allocator.h
- * @brief Vulkan Host Memory Allocator using a tracked page map.
+ * @brief Vulkan Host Memory Allocator with scope-aware arenas.
  *
- * This interface manages Vulkan host memory allocations using an internal,
- * thread-safe PageAllocator. It provides a global allocation context which
- * can be safely passed to Vulkan interfaces.
+ * Vulkan host allocations are served by VkSystemAllocationScope: COMMAND blocks from
+ * bump arenas, other scopes from size-class slabs, and blocks of 128 KiB or more from
+ * mappings of their own, huge-page backed from 2 MiB. The rest falls back to the
+ * thread-safe PageAllocator. Arenas and slabs are NUMA node-local, and all of it
+ * lives in a VkcAllocatorContext that is released wholesale on destroy.
  *
+ * Use `vkc_allocator_context_create()` for a private context; NULL names the global one.
  * Use `vkc_allocator_callbacks()` to obtain a Vulkan-compatible callback struct.
  * Use `vkc_allocator_get()` to manually allocate through the internal allocator.
+ * Use `vkc_allocator_stats()` to snapshot per-scope host memory telemetry.
+ * Use `vkc_allocator_context_trim()` to return idle memory to the OS, or let a
+ * background thread do it with `vkc_allocator_context_trim_policy()`.
+ * Set VKC_ALLOCATOR_TRACE=<path> to record the global context's callbacks to a trace
+ * file, or attach a VkcTrace to any context with `vkc_allocator_context_trace()`.
  */
 
 #ifndef VKC_ALLOCATOR_H
 #define VKC_ALLOCATOR_H
 
 #include "allocator/page.h"
+#include "vk/extent.h"
+#include "vk/numa.h"
+#include "vk/trace.h"
 #include <vulkan/vulkan.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Number of VkSystemAllocationScope values tracked by the allocator.
+ */
+#define VKC_ALLOCATOR_SCOPE_COUNT (VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1)
+
+/**
+ * @brief Number of power-of-two size histogram bins.
+ *
+ * Bin 0 counts requests of at most 16 bytes, bin i counts (8 << i, 16 << i], and
+ * the last bin also absorbs everything larger.
+ */
+#define VKC_ALLOCATOR_HISTOGRAM_BINS 16
+
+/**
+ * @brief Host memory counters for one VkSystemAllocationScope.
+ *
+ * Byte counts are usable sizes: slab blocks report their size class. A reallocation
+ * that changes scope moves the block's bytes to the new scope and counts there.
+ */
+typedef struct VkcAllocatorScopeStats {
+    uint64_t live_bytes; /**< Bytes currently allocated. */
+    uint64_t peak_bytes; /**< Highest live_bytes observed, sampled every 64 KiB per thread. */
+    uint64_t allocations; /**< Successful allocations. */
+    uint64_t frees; /**< Blocks released. */
+    uint64_t reallocations; /**< Successful reallocations of an existing block. */
+    uint64_t growths; /**< Reallocations that asked for more bytes than the block held. */
+    uint64_t in_place; /**< Reallocations that kept the block's address. */
+    uint64_t histogram[VKC_ALLOCATOR_HISTOGRAM_BINS]; /**< Requested sizes by bin. */
+} VkcAllocatorScopeStats;
+
+/**
+ * @brief Snapshot of an allocation context's telemetry.
+ */
+typedef struct VkcAllocatorStats {
+    VkcAllocatorScopeStats scopes[VKC_ALLOCATOR_SCOPE_COUNT]; /**< Served by the callbacks. */
+    VkcAllocatorScopeStats internal[VKC_ALLOCATOR_SCOPE_COUNT]; /**< Reported by the driver. */
+    uint64_t trims; /**< Trim passes run, explicitly or by the background policy. */
+    uint64_t trimmed_bytes; /**< Resident bytes those passes returned to the OS. */
+} VkcAllocatorStats;
+
+/**
+ * @brief Default time between background trim passes (1 s).
+ */
+#define VKC_ALLOCATOR_TRIM_INTERVAL (1000ull * 1000 * 1000)
+
+/**
+ * @brief Background trim policy. See vkc_allocator_context_trim_policy().
+ */
+typedef struct VkcAllocatorTrimPolicy {
+    uint64_t interval_ns; /**< Time between passes; 0 selects VKC_ALLOCATOR_TRIM_INTERVAL. */
+    uint64_t idle_ns; /**< Idle time after which retained slabs and chunks are unmapped. */
+    size_t rss_limit; /**< Process RSS in bytes above which passes purge everything; 0 never. */
+} VkcAllocatorTrimPolicy;
+
+/**
+ * @brief Independent set of host allocation strategies and telemetry.
+ */
+typedef struct VkcAllocatorContext VkcAllocatorContext;
+
+/**
+ * @brief Create an allocation context.
+ *
+ * Every context owns its arenas, slabs, PageAllocator and thread caches. Contexts
+ * reserve a handful of pthread keys each, plus a few more for every NUMA node they
+ * allocate on, so create one per device or worker rather than per object.
+ *
+ * @return The context, or NULL on failure.
+ */
+VkcAllocatorContext* vkc_allocator_context_create(void);
+
+/**
+ * @brief Destroy a context and every block still allocated from it.
+ *
+ * Cost scales with the number of arena chunks, slabs and dedicated mappings, not with
+ * the number of live blocks. Objects created with the context must not be used again.
+ */
+void vkc_allocator_context_destroy(VkcAllocatorContext* context);
+
+/**
+ * @brief Get a context's PageAllocator for wrapper objects.
+ *
+ * @param context Allocation context, or NULL for the global context.
+ */
+PageAllocator* vkc_allocator_context_pager(VkcAllocatorContext* context);
+
+/**
+ * @brief Get the Vulkan-compatible allocation callbacks bound to a context.
+ *
+ * @param context Allocation context, or NULL for the global context.
+ */
+const VkAllocationCallbacks* vkc_allocator_context_callbacks(VkcAllocatorContext* context);
+
+/**
+ * @brief Snapshot a context's counters. See vkc_allocator_stats().
+ *
+ * @param context Allocation context, or NULL for the global context.
+ */
+bool vkc_allocator_context_stats(VkcAllocatorContext* context, VkcAllocatorStats* stats);
+
+/**
+ * @brief Choose the page backing for a context's blocks of 2 MiB or more.
+ *
+ * Defaults to VKC_EXTENT_PAGES_ADVISE. VKC_EXTENT_PAGES_HUGETLB needs pages reserved in
+ * /proc/sys/vm/nr_hugepages and falls back to ADVISE without them; such blocks are
+ * copied rather than remapped when they grow, as are blocks carved from huge-page
+ * arenas. Applies to blocks mapped afterwards, so set it before handing the callbacks
+ * to Vulkan.
+ *
+ * @param context Allocation context, or NULL for the global context.
+ * @return false if the context is unavailable or `pages` is invalid.
+ */
+bool vkc_allocator_context_huge_pages(VkcAllocatorContext* context, VkcExtentPages pages);
+
+/**
+ * @brief Place a context's node-local allocations on one NUMA node.
+ *
+ * By default (VKC_NUMA_NODE_ANY) every thread allocates from the node its CPU belongs
+ * to. Pinning suits a device context whose memory should sit next to the device, or a
+ * context filled by one thread and read by workers on another socket. Applies to
+ * arena chunks, slabs and mappings created afterwards.
+ *
+ * @param context Allocation context, or NULL for the global context.
+ * @param node Node id below vkc_numa_node_count(), or VKC_NUMA_NODE_ANY.
+ * @return false if the context is unavailable or the node is not known; the context
+ *         keeps its current placement.
+ */
+bool vkc_allocator_context_node(VkcAllocatorContext* context, int node);
+
+/**
+ * @brief Return a context's idle host memory to the OS.
+ *
+ * Empty slabs, rewound arena chunks and empty huge-page arenas are kept around to
+ * absorb churn. Those that have sat unused for at least `idle_ns` are unmapped. With
+ * `purge`, the rest give their pages back with MADV_DONTNEED, and so do the free pages
+ * inside slabs and huge-page arenas that still hold blocks.
+ *
+ * Live blocks are never touched, and neither are blocks cached by, or chunks being
+ * carved by, threads other than the caller. Dedicated mappings are already unmapped
+ * when they are freed. The PageAllocator is not trimmed.
+ *
+ * @param context Allocation context, or NULL for the global context.
+ * @param idle_ns Minimum idle time before retained memory is unmapped; 0 unmaps all of it.
+ * @param purge Also drop the pages of free memory that stays mapped.
+ * @return Resident bytes returned. Also added to VkcAllocatorStats::trimmed_bytes.
+ */
+size_t vkc_allocator_context_trim(VkcAllocatorContext* context, uint64_t idle_ns, bool purge);
+
+/**
+ * @brief Trim a context periodically from a background thread, or stop doing so.
+ *
+ * Every `interval_ns` the thread runs vkc_allocator_context_trim() with the policy's
+ * idle time. Passes that find the process RSS above `rss_limit` instead unmap all
+ * retained memory and purge free pages. Calling this again replaces the policy.
+ *
+ * @param context Allocation context, or NULL for the global context.
+ * @param policy Policy to apply, or NULL to stop and join the thread.
+ * @return false if the context is unavailable or the thread cannot be started.
+ */
+bool vkc_allocator_context_trim_policy(
+    VkcAllocatorContext* context, const VkcAllocatorTrimPolicy* policy
+);
+
+/**
+ * @brief Record a context's callbacks into a trace, or stop recording.
+ *
+ * The trace must outlive every callback that can observe it: detach it (NULL) and let
+ * in-flight callbacks return, for example by destroying the Vulkan objects using the
+ * context, before calling vkc_trace_destroy().
+ *
+ * @param context Allocation context, or NULL for the global context.
+ * @param trace Recorder to attach, or NULL to detach.
+ * @return false if the context is unavailable.
+ */
+bool vkc_allocator_context_trace(VkcAllocatorContext* context, VkcTrace* trace);
+
 /**
  * @brief Initialize the global Vulkan allocation context.
  *
- * Allocates and initializes the internal PageAllocator and callback bindings.
+ * Allocates and initializes the internal PageAllocator, scope arenas and slabs, and callback
+ * bindings.
  * Must be called before using vkc_allocator_get() or vkc_allocator_callbacks().
  *
  * @return true on success, false on failure
@@ -45,6 +233,23 @@ PageAllocator* vkc_allocator_get(void);
  */
 const VkAllocationCallbacks* vkc_allocator_callbacks(void);
 
+/**
+ * @brief Snapshot the allocator's counters.
+ *
+ * Each thread counts into its own shard with relaxed atomics, so allocating threads
+ * never contend on counters and reading them never blocks an allocation. Fields are
+ * read one at a time and may be mutually inconsistent by in-flight operations.
+ *
+ * @param stats Receives the snapshot.
+ * @return true on success, false if the allocator is uninitialized.
+ */
+bool vkc_allocator_stats(VkcAllocatorStats* stats);
+
+/**
+ * @brief Histogram bin for a requested size.
+ */
+size_t vkc_allocator_histogram_bin(size_t size);
+
 #ifdef __cplusplus
 }
 #endif
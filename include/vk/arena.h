@@ -0,0 +1,107 @@
+/**
+ * @file include/vk/arena.h
+ * @brief Chunked linear host arenas for COMMAND-scoped Vulkan allocations.
+ *
+ * Arenas bump-allocate blocks out of granule-aligned chunks registered in the
+ * extent map, so freeing a block resolves its chunk without a hash lookup. A chunk
+ * rewinds in bulk once its last block is freed, which suits the short lifetimes of
+ * VK_SYSTEM_ALLOCATION_SCOPE_COMMAND.
+ *
+ * Each block carries a small inline header recording its requested size.
+ *
+ * Arenas are internally synchronized and hand each thread its own chunk to bump
+ * into behind a pthread key, so the common path takes no lock. A thread's chunk
+ * returns to the arena when the thread exits.
+ */
+
+#ifndef VKC_ARENA_H
+#define VKC_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Minimum alignment of every arena block.
+ */
+#define VKC_ARENA_ALIGNMENT 16
+
+/**
+ * @brief Opaque arena handle.
+ */
+typedef struct VkcArena VkcArena;
+
+/**
+ * @brief Create an arena.
+ *
+ * @param chunk_size Bytes per chunk; rounded up to VKC_EXTENT_GRANULE.
+ * @param node NUMA node preferred for chunk pages, or VKC_NUMA_NODE_ANY for first touch.
+ * @return Arena handle, or NULL on failure.
+ */
+VkcArena* vkc_arena_create(size_t chunk_size, int node);
+
+/**
+ * @brief Destroy an arena and unmap all of its chunks.
+ *
+ * Outstanding blocks become invalid.
+ */
+void vkc_arena_destroy(VkcArena* arena);
+
+/**
+ * @brief Check whether the arena can serve a request of the given shape.
+ */
+bool vkc_arena_accepts(const VkcArena* arena, size_t size, size_t alignment);
+
+/**
+ * @brief Allocate a block.
+ *
+ * @return Block address, or NULL if the request is not accepted or memory is exhausted.
+ */
+void* vkc_arena_malloc(VkcArena* arena, size_t size, size_t alignment);
+
+/**
+ * @brief Return a block to the arena it was carved from.
+ */
+void vkc_arena_free(VkcArena* arena, void* address);
+
+/**
+ * @brief Resize a block without moving it.
+ *
+ * Shrinking always succeeds. Growing succeeds when the block is the last one the
+ * calling thread carved from its chunk and the chunk has room for the new size.
+ *
+ * @return true if the block now holds `size` bytes at the same address.
+ */
+bool vkc_arena_resize(VkcArena* arena, void* address, size_t size);
+
+/**
+ * @brief Return idle arena memory to the OS without touching live blocks.
+ *
+ * Unmaps the rewound chunks kept for reuse once they have sat unused for at least
+ * `idle_ns`. With `purge`, the calling thread also gives up its own chunk if it holds
+ * no blocks, and the remaining rewound chunks drop their pages with MADV_DONTNEED.
+ * Chunks other threads are carving are never touched.
+ *
+ * @return Resident bytes returned.
+ */
+size_t vkc_arena_trim(VkcArena* arena, uint64_t idle_ns, bool purge);
+
+/**
+ * @brief Requested size of a live block.
+ */
+size_t vkc_arena_size(const void* address);
+
+/**
+ * @brief Owning arena of an address, or NULL if no arena owns it.
+ */
+VkcArena* vkc_arena_owner(const void* address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_ARENA_H
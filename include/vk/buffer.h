@@ -0,0 +1,177 @@
+/**
+ * @file include/vk/buffer.h
+ * @brief Pool-backed buffers with persistent host pointers.
+ *
+ * A VkcBuffer is a VkBuffer bound to a range of a VkcMemoryPool. Buffers created for a
+ * host-visible usage map their block once, at creation, and hold that mapping until
+ * they are destroyed, so `data` is a stable host pointer at the buffer's offset in the
+ * block. Uploads and readbacks repeated every dispatch then touch memory directly, with
+ * no vkMapMemory/vkUnmapMemory on the per-dispatch path. Buffers that share a block
+ * share its one mapping.
+ *
+ * The memory may not be coherent. Mark host writes with vkc_buffer_mark_flush() and
+ * ranges to read back with vkc_buffer_mark_invalidate(); the pool's flush and
+ * invalidate then batch every marked buffer into one driver call.
+ *
+ * vkc_buffer_import() makes a buffer of data the host already holds. With
+ * VK_EXT_external_memory_host the caller's pages become the buffer's memory and nothing
+ * is copied; otherwise, or when the pages are not suitably aligned, the data is copied
+ * into a fresh buffer the device reads in place.
+ *
+ * vkc_buffer_export() and vkc_buffer_import_fd() put one buffer's memory in two
+ * processes: see vk/share.h for the handoff itself.
+ */
+
+#ifndef VKC_BUFFER_H
+#define VKC_BUFFER_H
+
+#include "vk/pool.h"
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Buffer and the pool range backing it.
+ */
+typedef struct VkcBuffer {
+    VkBuffer object;
+    VkcMemoryAllocation memory;
+    VkDeviceSize size; /**< Requested size in bytes. */
+    VkBufferUsageFlags usage; /**< Usage the buffer was created with. */
+    void* data; /**< Host address of the first byte; NULL for VKC_MEMORY_USAGE_GPU_ONLY. */
+    VkDeviceAddress address; /**< Shader-visible address; 0 without device address usage. */
+} VkcBuffer;
+
+/**
+ * @brief Create a buffer, bind it to pool memory and map it if the host accesses it.
+ *
+ * The buffer and its memory use the pool's device and host callbacks. Buffers with
+ * VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT need a pool created with
+ * VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT, and get their `address` filled in.
+ *
+ * @param pool Pool to allocate from.
+ * @param size Size in bytes.
+ * @param usage Vulkan buffer usage flags.
+ * @param memory How the buffer's memory is accessed.
+ * @param buffer Receives the buffer; zeroed on failure.
+ * @return VK_SUCCESS, or the creation, allocation or map error.
+ */
+VkResult vkc_buffer_create(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkcBuffer* buffer
+);
+
+/**
+ * @brief Create a buffer holding `size` bytes at `data`, importing them if possible.
+ *
+ * The memory is imported when the pool was created with VKC_MEMORY_POOL_HOST_IMPORT_BIT
+ * and both `data` and `size` are multiples of vkc_memory_pool_import_alignment(): page
+ * aligned, in practice, as mmap() returns. The buffer's `data` is then `data` itself,
+ * its placement is VKC_MEMORY_PLACEMENT_IMPORTED, and `data` must stay valid until the
+ * buffer is destroyed. Imports use coherent memory, so later host writes to it need no
+ * flush.
+ *
+ * Any other range is copied into a VKC_MEMORY_USAGE_DEVICE_UPLOAD buffer, marked for
+ * the next vkc_memory_pool_flush(); `data` may be released on return.
+ *
+ * @param usage Vulkan buffer usage flags.
+ * @param buffer Receives the buffer; zeroed on failure.
+ * @return VK_SUCCESS, or the creation, import or allocation error.
+ */
+VkResult vkc_buffer_import(
+    VkcMemoryPool* pool, void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkcBuffer* buffer
+);
+
+/**
+ * @brief Create a buffer whose memory can be exported as an opaque fd, and map it if the
+ *        host accesses it.
+ *
+ * Needs a pool created with VKC_MEMORY_POOL_EXTERNAL_FD_BIT. Export the memory with
+ * vkc_memory_pool_export_fd().
+ *
+ * @return VK_SUCCESS; VK_ERROR_FEATURE_NOT_PRESENT when buffers of this usage cannot be
+ *         exported; or the creation, allocation or map error.
+ */
+VkResult vkc_buffer_export(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkcBuffer* buffer
+);
+
+/**
+ * @brief Create a buffer over memory another process exported with vkc_buffer_export().
+ *
+ * `size` and `usage` must match the exported buffer. The memory is mapped if its type
+ * is host-visible.
+ *
+ * @param fd Exported descriptor; ownership passes to the call, which closes it on failure.
+ * @param type Memory type of the exported allocation.
+ * @param memory_size Size of the exported block.
+ * @return VK_SUCCESS; VK_ERROR_FEATURE_NOT_PRESENT when buffers of this usage cannot be
+ *         imported; or the creation, import or map error.
+ */
+VkResult vkc_buffer_import_fd(
+    VkcMemoryPool* pool,
+    int fd,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    uint32_t type,
+    VkDeviceSize memory_size,
+    VkcBuffer* buffer
+);
+
+/**
+ * @brief Destroy a buffer and return its memory to the pool.
+ *
+ * The device must be done with the buffer. Safe to call on a zeroed buffer.
+ */
+void vkc_buffer_destroy(VkcMemoryPool* pool, VkcBuffer* buffer);
+
+/**
+ * @brief Create an empty twin of a buffer in a fuller block of the pool, to move it to.
+ *
+ * The twin has the same size and usage, is mapped if the buffer is, and comes from
+ * vkc_memory_pool_relocate(). The caller copies the contents over and destroys
+ * whichever of the two it no longer needs.
+ *
+ * @param target Receives the twin; zeroed unless VK_SUCCESS.
+ * @return VK_SUCCESS; VK_INCOMPLETE when the buffer has no better place; or an error.
+ */
+VkResult vkc_buffer_relocate(VkcMemoryPool* pool, const VkcBuffer* buffer, VkcBuffer* target);
+
+/**
+ * @brief Describe the memory behind a buffer, including whether it got a dedicated block.
+ */
+bool vkc_buffer_stats(const VkcBuffer* buffer, VkcMemoryAllocationStats* stats);
+
+/**
+ * @brief Mark bytes the host wrote through `data` for the next vkc_memory_pool_flush().
+ *
+ * @param size Byte count, or VK_WHOLE_SIZE for the rest of the buffer.
+ */
+bool vkc_buffer_mark_flush(
+    VkcMemoryPool* pool, const VkcBuffer* buffer, VkDeviceSize offset, VkDeviceSize size
+);
+
+/**
+ * @brief Mark bytes the host will read through `data` for the next
+ *        vkc_memory_pool_invalidate().
+ */
+bool vkc_buffer_mark_invalidate(
+    VkcMemoryPool* pool, const VkcBuffer* buffer, VkDeviceSize offset, VkDeviceSize size
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_BUFFER_H
@@ -0,0 +1,99 @@
+/**
+ * @file include/vk/cache.h
+ * @brief A VkPipelineCache persisted on disk between runs.
+ *
+ * Without a cache every process start compiles every pipeline from SPIR-V again. Create
+ * a VkcPipelineCache right after the VkDevice, before any pipeline: it loads the blob an
+ * earlier run saved and hands the driver a VkPipelineCache seeded with it, so pipelines
+ * it has seen before are created from the driver's own compiled code.
+ *
+ * A blob is only valid for the driver build that wrote it. The file starts with a header
+ * recording the vendor, device, driver version and pipelineCacheUUID it was written
+ * with, plus the blob's size and checksum; a file that does not match the current device
+ * in every field, or whose blob fails the checksum, is ignored and the cache starts
+ * empty. The blob's own Vulkan header is checked the same way.
+ *
+ * Saving writes a temporary file next to the cache, syncs it and renames it over the
+ * old one, so a crash or a concurrent run never leaves a torn file: readers see the
+ * old cache or the new one. A save is skipped when the driver's blob has not changed
+ * since it was loaded or last saved.
+ *
+ * A cache is not synchronized: save it from one thread. The VkPipelineCache itself is
+ * internally synchronized by the driver and may be used by any thread.
+ */
+
+#ifndef VKC_CACHE_H
+#define VKC_CACHE_H
+
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What the cache loaded and saved.
+ */
+typedef struct VkcPipelineCacheStats {
+    bool warm; /**< A valid blob was loaded at creation. */
+    size_t loaded_bytes; /**< Size of the loaded blob; 0 for a cold start. */
+    size_t saved_bytes; /**< Size of the blob last written; 0 before the first save. */
+    uint32_t saves; /**< Files written; unchanged blobs are not. */
+} VkcPipelineCacheStats;
+
+/**
+ * @brief Pipeline cache of a device, backed by a file.
+ */
+typedef struct VkcPipelineCache VkcPipelineCache;
+
+/**
+ * @brief Create the device's pipeline cache, seeded from `path` when it holds a blob
+ *        written for this device and driver.
+ *
+ * A missing, foreign or corrupt file is not an error: the cache starts empty.
+ *
+ * @param physical Device the blob must have been written for.
+ * @param device Device the VkPipelineCache belongs to.
+ * @param callbacks Host callbacks for the VkPipelineCache; may be NULL.
+ * @param path File to load from and save to; NULL keeps the cache in memory only.
+ * @return The cache, or NULL if the VkPipelineCache could not be created.
+ */
+VkcPipelineCache* vkc_pipeline_cache_create(
+    VkPhysicalDevice physical,
+    VkDevice device,
+    const VkAllocationCallbacks* callbacks,
+    const char* path
+);
+
+/**
+ * @brief Save the cache, then destroy it. Pipelines created from it stay valid.
+ */
+void vkc_pipeline_cache_destroy(VkcPipelineCache* cache);
+
+/**
+ * @brief The VkPipelineCache to pass to vkCreateComputePipelines().
+ */
+VkPipelineCache vkc_pipeline_cache_object(const VkcPipelineCache* cache);
+
+/**
+ * @brief Write the driver's current blob to the cache's file, replacing it atomically.
+ *
+ * @return VK_SUCCESS, also when there is no file or nothing changed; the driver's error
+ *         reading the blob; or VK_ERROR_INITIALIZATION_FAILED if the file could not be
+ *         written, leaving the old file in place.
+ */
+VkResult vkc_pipeline_cache_save(VkcPipelineCache* cache);
+
+/**
+ * @brief Fill `stats`.
+ */
+bool vkc_pipeline_cache_stats(const VkcPipelineCache* cache, VkcPipelineCacheStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_CACHE_H
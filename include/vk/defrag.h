@@ -0,0 +1,134 @@
+/**
+ * @file include/vk/defrag.h
+ * @brief Incremental defragmentation of pool-backed buffers.
+ *
+ * A VkcDefrag packs the buffers registered with it into fewer pool blocks. Each step
+ * copies buffers out of the sparsest blocks with vkCmdCopyBuffer, on a submission of its
+ * own; a later step swaps the moved VkcBuffers over and frees their old ranges. Steps
+ * never wait on the device and are bounded in bytes copied and planning time. Give the
+ * defragmenter a low-priority queue of the family the buffers are used on.
+ *
+ * A move changes a buffer's VkBuffer and device address: rewrite descriptors in the move
+ * callback. Registered buffers need TRANSFER_SRC and TRANSFER_DST usage, must not be
+ * written by the device while a step's copies are in flight, and lose their eviction
+ * registration when they move.
+ *
+ * A defragmenter is not synchronized: step it from one thread.
+ */
+
+#ifndef VKC_DEFRAG_H
+#define VKC_DEFRAG_H
+
+#include "vk/buffer.h"
+#include "vk/pool.h"
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Default bytes a step may copy (16 MiB).
+ */
+#define VKC_DEFRAG_BYTES (16ull * 1024 * 1024)
+
+/**
+ * @brief Default host time a step may spend choosing moves (500 us).
+ */
+#define VKC_DEFRAG_TIME (500ull * 1000)
+
+/**
+ * @brief Called when a buffer has moved.
+ *
+ * `buffer` already holds the new VkBuffer, memory, host pointer and address. `previous`
+ * is the old buffer, destroyed as soon as the callback returns: before returning, point
+ * descriptors and stored addresses at the new buffer and make sure no pending work
+ * still uses the old one.
+ */
+typedef void (*VkcDefragMoveCallback)(
+    void* user_data, VkcBuffer* buffer, const VkcBuffer* previous
+);
+
+/**
+ * @brief Snapshot of a defragmenter's counters.
+ */
+typedef struct VkcDefragStats {
+    uint64_t passes; /**< Copy submissions made. */
+    uint64_t moves; /**< Buffers moved. */
+    uint64_t moved_bytes; /**< Bytes copied by those moves. */
+} VkcDefragStats;
+
+/**
+ * @brief Defragmenter for the buffers of one pool.
+ */
+typedef struct VkcDefrag VkcDefrag;
+
+/**
+ * @brief Create a defragmenter.
+ *
+ * @param pool Pool the buffers are allocated from. Its device and host callbacks are used.
+ * @param queue Queue the copies are submitted to; ideally of low priority.
+ * @param queue_family Family of `queue`, for the defragmenter's command pool.
+ * @param moved Called for every moved buffer; may be NULL if nothing refers to them.
+ * @param user_data Passed to `moved`.
+ * @return The defragmenter, or NULL on failure.
+ */
+VkcDefrag* vkc_defrag_create(
+    VkcMemoryPool* pool,
+    VkQueue queue,
+    uint32_t queue_family,
+    VkcDefragMoveCallback moved,
+    void* user_data
+);
+
+/**
+ * @brief Finish the pass in flight, if any, and free the defragmenter.
+ *
+ * Waits for the pass's copies and moves their buffers, calling the move callback.
+ */
+void vkc_defrag_destroy(VkcDefrag* defrag);
+
+/**
+ * @brief Let the defragmenter move a buffer.
+ *
+ * The VkcBuffer must stay at the same address until it is removed.
+ *
+ * @return false if the buffer lacks transfer usage or cannot be tracked.
+ */
+bool vkc_defrag_add(VkcDefrag* defrag, VkcBuffer* buffer);
+
+/**
+ * @brief Stop moving a buffer, before destroying it for example.
+ *
+ * If the buffer is part of the pass in flight, waits for the pass's copies and keeps
+ * the buffer where it was.
+ */
+void vkc_defrag_remove(VkcDefrag* defrag, VkcBuffer* buffer);
+
+/**
+ * @brief Run one bounded defragmentation step without waiting on the device.
+ *
+ * Completes the previous pass if its copies are done, then submits the next one: the
+ * buffers in the sparsest blocks are moved first, until `max_bytes` would be exceeded
+ * or `max_ns` has elapsed.
+ *
+ * @param max_bytes Bytes the pass may copy; 0 for VKC_DEFRAG_BYTES.
+ * @param max_ns Host time the step may take; 0 for VKC_DEFRAG_TIME.
+ * @return VK_SUCCESS when no registered buffer can be packed further; VK_INCOMPLETE
+ *         after progress; VK_NOT_READY while the previous pass is still copying; or a
+ *         Vulkan error.
+ */
+VkResult vkc_defrag_step(VkcDefrag* defrag, VkDeviceSize max_bytes, uint64_t max_ns);
+
+/**
+ * @brief Snapshot a defragmenter's counters.
+ */
+bool vkc_defrag_stats(VkcDefrag* defrag, VkcDefragStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_DEFRAG_H
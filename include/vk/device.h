@@ -8,12 +8,16 @@
  *   - VkcDeviceLayer        ← Optional: enumerate & match device validation layers
  *   - VkcDeviceExtension    ← Optional: enumerate & match device extensions
  *   - vkc_physical_device_select() ← Selects one based on VK_QUEUE_COMPUTE_BIT
+ *
+ * Constructors take the VkcAllocatorContext to allocate from (NULL for the global
+ * context); matches and selections inherit the context of the object they derive from.
  */
 
 #ifndef VKC_DEVICE_H
 #define VKC_DEVICE_H
 
 #include "allocator/page.h"
+#include "vk/allocator.h"
 #include "vk/instance.h"
 #include <vulkan/vulkan.h>
 
@@ -29,9 +33,10 @@ extern "C" {
 typedef struct VkcDeviceList {
     VkPhysicalDevice* devices;
     uint32_t count;
+    VkcAllocatorContext* context;
 } VkcDeviceList;
 
-VkcDeviceList* vkc_device_list_create(VkInstance instance);
+VkcDeviceList* vkc_device_list_create(VkcAllocatorContext* context, VkInstance instance);
 void vkc_device_list_free(VkcDeviceList* list);
 
 /** @} */
@@ -44,9 +49,11 @@ void vkc_device_list_free(VkcDeviceList* list);
 typedef struct VkcDeviceQueueFamily {
     VkQueueFamilyProperties* properties;
     uint32_t count;
+    VkcAllocatorContext* context;
 } VkcDeviceQueueFamily;
 
-VkcDeviceQueueFamily* vkc_device_queue_family_create(VkPhysicalDevice device);
+VkcDeviceQueueFamily*
+vkc_device_queue_family_create(VkcAllocatorContext* context, VkPhysicalDevice device);
 void vkc_device_queue_family_free(VkcDeviceQueueFamily* family);
 
 /** @} */
@@ -59,6 +66,7 @@ void vkc_device_queue_family_free(VkcDeviceQueueFamily* family);
 typedef struct VkcPhysicalDevice {
     VkPhysicalDevice object;
     uint32_t queue_family_index;
+    VkcAllocatorContext* context; /**< Inherited from the device list. */
 } VkcPhysicalDevice;
 
 VkcPhysicalDevice* vkc_device_physical_create(VkcDeviceList* list);
@@ -74,9 +82,10 @@ void vkc_device_physical_free(VkcPhysicalDevice* device);
 typedef struct VkcDeviceLayer {
     VkLayerProperties* properties;
     uint32_t count;
+    VkcAllocatorContext* context;
 } VkcDeviceLayer;
 
-VkcDeviceLayer* vkc_device_layer_create(VkPhysicalDevice device);
+VkcDeviceLayer* vkc_device_layer_create(VkcAllocatorContext* context, VkPhysicalDevice device);
 void vkc_device_layer_free(VkcDeviceLayer* layer);
 
 /** @} */
@@ -89,6 +98,7 @@ void vkc_device_layer_free(VkcDeviceLayer* layer);
 typedef struct VkcDeviceLayerMatch {
     char** names;
     uint32_t count;
+    VkcAllocatorContext* context; /**< Inherited from the layer container. */
 } VkcDeviceLayerMatch;
 
 VkcDeviceLayerMatch* vkc_device_layer_match_create(
@@ -105,9 +115,11 @@ void vkc_device_layer_match_free(VkcDeviceLayerMatch* match);
 typedef struct VkcDeviceExtension {
     VkExtensionProperties* properties;
     uint32_t count;
+    VkcAllocatorContext* context;
 } VkcDeviceExtension;
 
-VkcDeviceExtension* vkc_device_extension_create(VkPhysicalDevice device);
+VkcDeviceExtension*
+vkc_device_extension_create(VkcAllocatorContext* context, VkPhysicalDevice device);
 void vkc_device_extension_free(VkcDeviceExtension* extension);
 
 /** @} */
@@ -120,6 +132,7 @@ void vkc_device_extension_free(VkcDeviceExtension* extension);
 typedef struct VkcDeviceExtensionMatch {
     char** names;
     uint32_t count;
+    VkcAllocatorContext* context; /**< Inherited from the extension container. */
 } VkcDeviceExtensionMatch;
 
 VkcDeviceExtensionMatch* vkc_device_extension_match_create(
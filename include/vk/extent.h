@@ -0,0 +1,144 @@
+/**
+ * @file include/vk/extent.h
+ * @brief Granule-aligned virtual memory extents and an address-to-extent map.
+ *
+ * Host allocators in VkC carve blocks out of large anonymous mappings (extents).
+ * Every extent is aligned to VKC_EXTENT_GRANULE and registered in a two-level
+ * radix map keyed by address, so resolving the owner of any block is two loads:
+ * no hashing and no per-block bookkeeping.
+ *
+ * The map is process-wide and lock-free for lookups. Leaves are created on demand
+ * and live for the lifetime of the process.
+ */
+
+#ifndef VKC_EXTENT_H
+#define VKC_EXTENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Extent alignment and map resolution (64 KiB).
+ */
+#define VKC_EXTENT_SHIFT 16
+#define VKC_EXTENT_GRANULE ((size_t) 1 << VKC_EXTENT_SHIFT)
+
+/**
+ * @brief Huge page size and alignment used for huge-page backed extents (2 MiB).
+ */
+#define VKC_EXTENT_HUGE_SHIFT 21
+#define VKC_EXTENT_HUGE ((size_t) 1 << VKC_EXTENT_HUGE_SHIFT)
+
+/**
+ * @brief Page backing requested for a huge-page extent.
+ */
+typedef enum VkcExtentPages {
+    VKC_EXTENT_PAGES_BASE = 0, /**< Base pages only. */
+    VKC_EXTENT_PAGES_ADVISE, /**< Transparent huge pages through madvise(MADV_HUGEPAGE). */
+    VKC_EXTENT_PAGES_HUGETLB, /**< Reserved hugetlbfs pages (MAP_HUGETLB), else ADVISE. */
+} VkcExtentPages;
+
+/**
+ * @brief Identifies which allocator carved an extent.
+ */
+typedef enum VkcExtentKind {
+    VKC_EXTENT_NONE = 0, /**< Unregistered or foreign memory. */
+    VKC_EXTENT_ARENA, /**< Chunk owned by a VkcArena. */
+    VKC_EXTENT_SLAB, /**< Slab owned by a VkcSlab. */
+    VKC_EXTENT_LARGE, /**< Dedicated mapping for a single large block. */
+} VkcExtentKind;
+
+/**
+ * @brief A registered region of host memory.
+ *
+ * Allocators embed this as the first member of their chunk descriptors so a
+ * lookup result can be cast back to the descriptor.
+ */
+typedef struct VkcExtent {
+    void* base; /**< Granule-aligned start of the region. */
+    size_t size; /**< Region size in bytes (multiple of the granule). */
+    VkcExtentKind kind; /**< Allocator that owns the region. */
+    void* owner; /**< Owning allocator object. */
+} VkcExtent;
+
+/**
+ * @brief Map a zero-filled, granule-aligned anonymous region.
+ *
+ * @param size Requested size in bytes; rounded up to the granule.
+ * @return Base address, or NULL on failure.
+ */
+void* vkc_extent_map(size_t size);
+
+/**
+ * @brief Map a zero-filled region aligned to VKC_EXTENT_HUGE for huge page backing.
+ *
+ * HUGETLB mappings come from the reserved pool and fall back to transparent huge pages
+ * when the pool is empty. Regions obtained as HUGETLB cannot be resized with
+ * vkc_extent_resize().
+ *
+ * @param size Requested size in bytes; rounded up to VKC_EXTENT_HUGE.
+ * @param pages Requested backing; receives the backing actually obtained.
+ * @return Base address, or NULL on failure.
+ */
+void* vkc_extent_map_huge(size_t size, VkcExtentPages* pages);
+
+/**
+ * @brief Ask for transparent huge pages on a mapped region. Best effort.
+ */
+void vkc_extent_advise(void* base, size_t size);
+
+/**
+ * @brief Give a range's pages back to the OS while keeping it mapped (MADV_DONTNEED).
+ *
+ * The range must be page aligned. It reads back as zeroes afterwards.
+ */
+void vkc_extent_purge(void* base, size_t size);
+
+/**
+ * @brief Unmap a region returned by vkc_extent_map() or vkc_extent_map_huge().
+ */
+void vkc_extent_unmap(void* base, size_t size);
+
+/**
+ * @brief Resize a registered extent without copying its contents, keeping the map current.
+ *
+ * Shrinking trims the tail. Growing first extends the mapping in place and otherwise
+ * moves its pages into a fresh reservation with mremap(). Not for extents obtained as
+ * VKC_EXTENT_PAGES_HUGETLB.
+ *
+ * @param alignment Power-of-two alignment a moved region keeps, such as VKC_EXTENT_HUGE;
+ *        0 for the granule.
+ * @return true with `extent` updated, or false with the extent unchanged: still mapped
+ *         and still registered.
+ */
+bool vkc_extent_resize(VkcExtent* extent, size_t size, size_t alignment);
+
+/**
+ * @brief Publish an extent so its granules resolve through vkc_extent_lookup().
+ *
+ * @return false if the address range cannot be represented or a leaf cannot be mapped.
+ */
+bool vkc_extent_register(VkcExtent* extent);
+
+/**
+ * @brief Remove an extent from the map. Must precede unmapping it.
+ */
+void vkc_extent_deregister(const VkcExtent* extent);
+
+/**
+ * @brief Resolve the extent that contains an address.
+ *
+ * @return The registered extent, or NULL if the address is not owned by one.
+ */
+VkcExtent* vkc_extent_lookup(const void* address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_EXTENT_H
@@ -15,6 +15,7 @@
 #define VKC_INSTANCE_H
 
 #include "allocator/page.h"
+#include "vk/allocator.h"
 #include <vulkan/vulkan.h>
 
 #ifdef __cplusplus
@@ -34,14 +35,16 @@ extern "C" {
 typedef struct VkcInstanceLayer {
     VkLayerProperties* properties; /**< Array of enumerated layer properties. */
     uint32_t count; /**< Number of available layer properties. */
+    VkcAllocatorContext* context; /**< Context the container was allocated from. */
 } VkcInstanceLayer;
 
 /**
  * @brief Enumerate available Vulkan instance layers.
  *
+ * @param context Allocation context, or NULL for the global context.
  * @return Allocated layer property container, or NULL on failure.
  */
-VkcInstanceLayer* vkc_instance_layer_create(void);
+VkcInstanceLayer* vkc_instance_layer_create(VkcAllocatorContext* context);
 
 /**
  * @brief Free a previously allocated VkcInstanceLayer.
@@ -65,6 +68,7 @@ void vkc_instance_layer_free(VkcInstanceLayer* layer);
 typedef struct VkcInstanceLayerMatch {
     char** names; /**< Array of UTF-8 layer name strings. */
     uint32_t count; /**< Number of matched layer names. */
+    VkcAllocatorContext* context; /**< Inherited from the layer container. */
 } VkcInstanceLayerMatch;
 
 /**
@@ -102,14 +106,16 @@ void vkc_instance_layer_match_free(VkcInstanceLayerMatch* match);
 typedef struct VkcInstanceExtension {
     VkExtensionProperties* properties; /**< Array of enumerated extension properties. */
     uint32_t count; /**< Number of available extension properties. */
+    VkcAllocatorContext* context; /**< Context the container was allocated from. */
 } VkcInstanceExtension;
 
 /**
  * @brief Enumerate available Vulkan instance extensions.
  *
+ * @param context Allocation context, or NULL for the global context.
  * @return Allocated extension property container, or NULL on failure.
  */
-VkcInstanceExtension* vkc_instance_extension_create(void);
+VkcInstanceExtension* vkc_instance_extension_create(VkcAllocatorContext* context);
 
 /**
  * @brief Free a previously allocated VkcInstanceExtension.
@@ -133,6 +139,7 @@ void vkc_instance_extension_free(VkcInstanceExtension* extension);
 typedef struct VkcInstanceExtensionMatch {
     char** names; /**< Array of UTF-8 extension name strings. */
     uint32_t count; /**< Number of matched extension names. */
+    VkcAllocatorContext* context; /**< Inherited from the extension container. */
 } VkcInstanceExtensionMatch;
 
 /**
@@ -168,17 +175,22 @@ void vkc_instance_extension_match_free(VkcInstanceExtensionMatch* match);
 typedef struct VkcInstance {
     VkInstance object; /**< Vulkan instance handle. */
     const VkAllocationCallbacks* callbacks; /**< Allocator callbacks used for Vulkan object creation. */
+    VkcAllocatorContext* context; /**< Context backing the wrapper and the callbacks. */
 } VkcInstance;
 
 /**
  * @brief Create a Vulkan instance with the specified enabled layers and extensions.
  *
+ * @param context         Allocation context, or NULL for the global context.
  * @param layer_match     Optional matched layer list (may be NULL).
  * @param extension_match Optional matched extension list (may be NULL).
  * @return Allocated Vulkan instance wrapper, or NULL on failure.
  */
 VkcInstance* vkc_instance_create(
-    VkcInstanceLayerMatch* layer_match, VkcInstanceExtensionMatch* extension_match);
+    VkcAllocatorContext* context,
+    VkcInstanceLayerMatch* layer_match,
+    VkcInstanceExtensionMatch* extension_match
+);
 
 /**
  * @brief Destroy a Vulkan instance and free associated tracked memory.
@@ -0,0 +1,71 @@
+/**
+ * @file include/vk/numa.h
+ * @brief NUMA topology discovery and memory placement for host allocators.
+ *
+ * Topology is read once from sysfs (/sys/devices/system/node) without libnuma.
+ * Machines without that hierarchy, or with a single node, report one node and
+ * every placement call below becomes a no-op, so callers never need a separate
+ * single-socket path.
+ *
+ * Node ids are the kernel's. They may be sparse: ids below vkc_numa_node_count()
+ * that have no CPUs simply never come back from vkc_numa_node_current().
+ */
+
+#ifndef VKC_NUMA_H
+#define VKC_NUMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Highest number of nodes tracked; larger ids are folded onto node 0.
+ */
+#define VKC_NUMA_NODE_MAX 64
+
+/**
+ * @brief No explicit node: follow the CPU of the calling thread.
+ */
+#define VKC_NUMA_NODE_ANY (-1)
+
+/**
+ * @brief Number of node ids in use (highest online id plus one), at least 1.
+ */
+size_t vkc_numa_node_count(void);
+
+/**
+ * @brief Node of the CPU the calling thread runs on, or 0 when unknown.
+ *
+ * Cheap enough for allocation paths: a vDSO CPU lookup and a table load, and no
+ * lookup at all on single-node machines. The thread may migrate right after.
+ */
+int vkc_numa_node_current(void);
+
+/**
+ * @brief Prefer a node for the pages of a mapped, not yet touched region.
+ *
+ * Uses mbind(MPOL_PREFERRED): pages fall back to other nodes when the preferred one
+ * is full instead of failing. Pages already faulted in do not move.
+ *
+ * @return true if the policy was applied or placement is moot (one node, ANY).
+ */
+bool vkc_numa_bind(void* base, size_t size, int node);
+
+/**
+ * @brief Restrict the calling thread to the CPUs of a node.
+ *
+ * Keeps a submitting thread, its node-local allocations and the copies it performs
+ * on one socket. A no-op on single-node machines.
+ *
+ * @return false if the node is invalid or the affinity cannot be set.
+ */
+bool vkc_numa_pin(int node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_NUMA_H
@@ -0,0 +1,539 @@
+/**
+ * @file include/vk/pool.h
+ * @brief Device memory pool: buffers sub-allocated from large VkDeviceMemory blocks.
+ *
+ * Blocks are allocated per memory type and carved through a TLSF index; requests over
+ * half a block, or that the driver wants dedicated, get a VkDeviceMemory of their own.
+ * Callers name a VkcMemoryUsage rather than property flags, and non-coherent ranges are
+ * flushed and invalidated in batches.
+ *
+ * Pools are internally synchronized, with one lock per memory type.
+ */
+
+#ifndef VKC_POOL_H
+#define VKC_POOL_H
+
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Default size of the blocks a pool allocates (64 MiB).
+ *
+ * Blocks are capped at an eighth of their heap, so heaps smaller than 512 MiB (a BAR
+ * window, say) are not claimed by a single block.
+ */
+#define VKC_MEMORY_POOL_BLOCK_SIZE (64ull * 1024 * 1024)
+
+/**
+ * @brief Options fixed when a pool is created.
+ */
+typedef enum VkcMemoryPoolFlagBits {
+    /** Allocate every block with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, so buffers with
+     *  VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT may live in any of them. The device
+     *  needs the bufferDeviceAddress feature enabled. */
+    VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT = 0x1,
+    /** The device enabled VK_EXT_memory_budget: read heap budgets and usage from it
+     *  rather than estimating them from heap sizes. */
+    VKC_MEMORY_POOL_MEMORY_BUDGET_BIT = 0x2,
+    /** The device enabled VK_EXT_external_memory_host: vkc_memory_pool_import_host() may
+     *  wrap host memory instead of allocating it. */
+    VKC_MEMORY_POOL_HOST_IMPORT_BIT = 0x4,
+    /** The device enabled VK_KHR_external_memory_fd: vkc_memory_pool_bind_exportable()
+     *  and vkc_memory_pool_import_fd() share memory with other processes as opaque file
+     *  descriptors. Needs a Vulkan 1.1 device. */
+    VKC_MEMORY_POOL_EXTERNAL_FD_BIT = 0x8,
+} VkcMemoryPoolFlagBits;
+
+typedef uint32_t VkcMemoryPoolFlags;
+
+/**
+ * @brief How a resource lays out its memory, for bufferImageGranularity.
+ */
+typedef enum VkcMemoryResource {
+    VKC_MEMORY_RESOURCE_LINEAR = 0, /**< Buffers and VK_IMAGE_TILING_LINEAR images. */
+    VKC_MEMORY_RESOURCE_OPTIMAL, /**< VK_IMAGE_TILING_OPTIMAL images. */
+} VkcMemoryResource;
+
+/**
+ * @brief How a range is accessed, which decides the memory types it may use.
+ *
+ * Types are tried from best to worst for the usage; a type that is out of memory
+ * falls through to the next one. Protected and lazily allocated types are never used.
+ */
+typedef enum VkcMemoryUsage {
+    /** Device reads and writes; the host never maps it. Prefers DEVICE_LOCAL memory not
+     *  visible to the host, so BAR space is left for usages that need it. */
+    VKC_MEMORY_USAGE_GPU_ONLY = 0,
+    /** Host writes, device copies from it (staging). HOST_VISIBLE, preferring system
+     *  memory that is not cached, then coherent memory. */
+    VKC_MEMORY_USAGE_UPLOAD,
+    /** Device writes, host reads. HOST_VISIBLE, preferring HOST_CACHED even when it is
+     *  not coherent. */
+    VKC_MEMORY_USAGE_READBACK,
+    /** Host writes, device reads in place. HOST_VISIBLE, preferring DEVICE_LOCAL memory,
+     *  best of all a resizable BAR spanning the device heap. */
+    VKC_MEMORY_USAGE_DEVICE_UPLOAD,
+    VKC_MEMORY_USAGE_COUNT,
+} VkcMemoryUsage;
+
+/**
+ * @brief Where a range was placed, and why.
+ */
+typedef enum VkcMemoryPlacement {
+    VKC_MEMORY_PLACEMENT_POOLED = 0, /**< Shares a block with other ranges. */
+    VKC_MEMORY_PLACEMENT_DEDICATED_SIZE, /**< Own block: larger than half a pooled block. */
+    VKC_MEMORY_PLACEMENT_DEDICATED_PREFERRED, /**< Own block: the driver prefers it. */
+    VKC_MEMORY_PLACEMENT_DEDICATED_REQUIRED, /**< Own block: the driver requires it. */
+    VKC_MEMORY_PLACEMENT_IMPORTED, /**< Own block: host memory owned by the caller. */
+    VKC_MEMORY_PLACEMENT_EXPORTED, /**< Own block: exportable as an opaque fd. */
+    VKC_MEMORY_PLACEMENT_IMPORTED_FD, /**< Own block: an opaque fd another process exported. */
+} VkcMemoryPlacement;
+
+/**
+ * @brief Range of device memory handed out by a pool.
+ */
+typedef struct VkcMemoryAllocation {
+    VkDeviceMemory memory; /**< Block holding the range; bind with this. */
+    VkDeviceSize offset; /**< Start of the range in `memory`, aligned as requested. */
+    VkDeviceSize size; /**< Requested size. */
+    uint32_t type; /**< Memory type index. */
+    VkMemoryPropertyFlags flags; /**< Property flags of that type. */
+    VkcMemoryPlacement placement;
+    struct VkcMemoryRegion* region; /**< Pool bookkeeping; NULL once freed. */
+} VkcMemoryAllocation;
+
+/**
+ * @brief Snapshot of a pool's counters.
+ */
+typedef struct VkcMemoryPoolStats {
+    uint64_t blocks; /**< Live VkDeviceMemory objects, dedicated ones included. */
+    uint64_t block_bytes; /**< Bytes held by those objects. */
+    uint64_t allocations; /**< Live ranges. */
+    uint64_t allocated_bytes; /**< Bytes of those ranges, alignment slack included. */
+    uint64_t driver_allocations; /**< vkAllocateMemory calls made over the pool's life. */
+    uint64_t dedicated_blocks; /**< Live blocks holding a single range. */
+    uint64_t dedicated_bytes; /**< Bytes held by those blocks. */
+    uint64_t evictions; /**< Evict callbacks run to make room. */
+    uint64_t stalls; /**< Allocations that waited for memory to be freed. */
+    uint64_t spills; /**< Allocations placed in a lower ranked type to stay in budget. */
+} VkcMemoryPoolStats;
+
+/**
+ * @brief What one range costs and how it was placed.
+ */
+typedef struct VkcMemoryAllocationStats {
+    VkcMemoryPlacement placement;
+    uint32_t type; /**< Memory type index. */
+    VkDeviceSize size; /**< Requested size. */
+    VkDeviceSize reserved; /**< Bytes taken from the block, alignment slack included. */
+    VkDeviceSize block_size; /**< Size of the VkDeviceMemory holding the range. */
+    VkDeviceSize block_used; /**< Bytes of that block's live ranges, this one included. */
+} VkcMemoryAllocationStats;
+
+/**
+ * @brief Longest time an allocation waits under VKC_MEMORY_BUDGET_STALL by default (1 s).
+ */
+#define VKC_MEMORY_POOL_STALL (1000ull * 1000 * 1000)
+
+/**
+ * @brief Budget and usage of one memory heap.
+ */
+typedef struct VkcMemoryBudget {
+    VkDeviceSize budget; /**< Bytes the process can use before the heap is oversubscribed. */
+    VkDeviceSize usage; /**< Estimated bytes the process uses, other allocators included. */
+    VkDeviceSize pool_bytes; /**< Bytes of that usage held by this pool's blocks. */
+} VkcMemoryBudget;
+
+/**
+ * @brief What an allocation does when a new block would exceed its heap's budget.
+ */
+typedef enum VkcMemoryBudgetAction {
+    /** Allocate anyway; the driver decides, possibly paging or failing. */
+    VKC_MEMORY_BUDGET_IGNORE = 0,
+    /** Treat the heap as full, so the next ranked memory type is tried, usually
+     *  host-visible system memory. */
+    VKC_MEMORY_BUDGET_SPILL,
+    /** Evict the least recently used evictable ranges of the heap until the request
+     *  fits, then spill if it still does not. */
+    VKC_MEMORY_BUDGET_EVICT,
+    /** Wait up to `stall_ns` for other threads to free memory, then spill. */
+    VKC_MEMORY_BUDGET_STALL,
+} VkcMemoryBudgetAction;
+
+/**
+ * @brief Over-budget policy. See vkc_memory_pool_budget_policy().
+ */
+typedef struct VkcMemoryBudgetPolicy {
+    VkcMemoryBudgetAction action;
+    uint64_t stall_ns; /**< Longest wait for a stall; 0 selects VKC_MEMORY_POOL_STALL. */
+} VkcMemoryBudgetPolicy;
+
+/**
+ * @brief Drops a cached resource so its range can be reused.
+ *
+ * Called with no pool lock held. It must free the range with vkc_memory_pool_free()
+ * (destroying the resource bound to it) before returning, and must only be registered
+ * for ranges the device no longer uses. Owners that also free the range themselves must
+ * serialize that with the callback.
+ */
+typedef void (*VkcMemoryEvictCallback)(void* user_data);
+
+/**
+ * @brief Device memory sub-allocator.
+ */
+typedef struct VkcMemoryPool VkcMemoryPool;
+
+/**
+ * @brief Create a pool for a device.
+ *
+ * @param physical Physical device the memory types are read from.
+ * @param device Logical device memory is allocated on.
+ * @param callbacks Host callbacks passed to vkAllocateMemory/vkFreeMemory; copied. May be NULL.
+ * @param block_size Size of pooled blocks, 0 for VKC_MEMORY_POOL_BLOCK_SIZE.
+ * @param flags VkcMemoryPoolFlagBits.
+ * @return The pool, or NULL on failure.
+ */
+VkcMemoryPool* vkc_memory_pool_create(
+    VkPhysicalDevice physical,
+    VkDevice device,
+    const VkAllocationCallbacks* callbacks,
+    VkDeviceSize block_size,
+    VkcMemoryPoolFlags flags
+);
+
+/**
+ * @brief Free every block of a pool, and the pool.
+ *
+ * Ranges still allocated are released with their blocks. Resources bound to them must
+ * already be destroyed.
+ */
+void vkc_memory_pool_destroy(VkcMemoryPool* pool);
+
+/**
+ * @brief Allocate a range that satisfies a resource's memory requirements.
+ *
+ * Tries the memory types allowed by `requirements->memoryTypeBits` in the pool's
+ * ranking for `usage`.
+ *
+ * @param pool Pool to allocate from.
+ * @param requirements Size, alignment and memory types of the resource.
+ * @param usage How the range is accessed.
+ * @param resource Tiling of the resource bound to the range.
+ * @param allocation Receives the range.
+ * @return VK_SUCCESS, or the error of the last memory type tried.
+ */
+VkResult vkc_memory_pool_alloc(
+    VkcMemoryPool* pool,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryUsage usage,
+    VkcMemoryResource resource,
+    VkcMemoryAllocation* allocation
+);
+
+/**
+ * @brief Return a range to its pool.
+ *
+ * The device must be done with the resource bound to it, as with vkFreeMemory. Safe to
+ * call on a zeroed or already freed allocation.
+ */
+void vkc_memory_pool_free(VkcMemoryPool* pool, VkcMemoryAllocation* allocation);
+
+/**
+ * @brief Allocate memory for a buffer and bind it.
+ *
+ * On Vulkan 1.1 devices the buffer's dedicated requirements are queried, and a buffer
+ * the driver prefers or requires dedicated gets its own block.
+ *
+ * @return VK_SUCCESS, or an allocation or bind error; nothing stays allocated on failure.
+ */
+VkResult vkc_memory_pool_bind_buffer(
+    VkcMemoryPool* pool,
+    VkBuffer buffer,
+    VkcMemoryUsage usage,
+    VkcMemoryAllocation* allocation
+);
+
+/**
+ * @brief Allocate exportable memory for a buffer and bind it.
+ *
+ * The buffer must have been created with VkExternalMemoryBufferCreateInfo naming
+ * VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT. It gets a block of its own, since the
+ * importer sees all of it, placed as VKC_MEMORY_PLACEMENT_EXPORTED.
+ *
+ * @return VK_SUCCESS; VK_ERROR_FEATURE_NOT_PRESENT without
+ *         VKC_MEMORY_POOL_EXTERNAL_FD_BIT; or an allocation or bind error.
+ */
+VkResult vkc_memory_pool_bind_exportable(
+    VkcMemoryPool* pool,
+    VkBuffer buffer,
+    VkcMemoryUsage usage,
+    VkcMemoryAllocation* allocation
+);
+
+/**
+ * @brief Export memory from vkc_memory_pool_bind_exportable() as an opaque fd.
+ *
+ * Every call returns a new descriptor, which the caller owns. Pass it to the importing
+ * process with the allocation's memory type and block size (the stats' `block_size`).
+ *
+ * @param fd Receives the descriptor; -1 on failure.
+ */
+VkResult vkc_memory_pool_export_fd(
+    VkcMemoryPool* pool, const VkcMemoryAllocation* allocation, int* fd
+);
+
+/**
+ * @brief Import an opaque fd exported on the same device and bind a buffer to it.
+ *
+ * The buffer must have been created as on the exporting side. Exporter and importer
+ * must run the same driver on the same physical device (VkPhysicalDeviceIDProperties
+ * deviceUUID and driverUUID). The placement is VKC_MEMORY_PLACEMENT_IMPORTED_FD.
+ *
+ * @param fd Descriptor to import. Ownership passes to the pool in every case: the
+ *           driver keeps it on success and it is closed on failure.
+ * @param type Memory type the exporter allocated from.
+ * @param size Size of the exported block.
+ * @return VK_SUCCESS; VK_ERROR_FEATURE_NOT_PRESENT without
+ *         VKC_MEMORY_POOL_EXTERNAL_FD_BIT; VK_ERROR_INVALID_EXTERNAL_HANDLE when the
+ *         type or size cannot back the buffer; or an import or bind error.
+ */
+VkResult vkc_memory_pool_import_fd(
+    VkcMemoryPool* pool,
+    int fd,
+    VkBuffer buffer,
+    uint32_t type,
+    VkDeviceSize size,
+    VkcMemoryAllocation* allocation
+);
+
+/**
+ * @brief Alignment host pointers and sizes need to be imported.
+ *
+ * @return minImportedHostPointerAlignment, or 0 when the pool cannot import.
+ */
+VkDeviceSize vkc_memory_pool_import_alignment(VkcMemoryPool* pool);
+
+/**
+ * @brief Wrap caller-owned host memory as device memory, without copying it.
+ *
+ * The range gets a block of its own, counted against its heap's budget like any other,
+ * in a HOST_COHERENT memory type. The memory must stay valid, and must not be unmapped or
+ * freed, until the allocation is freed. The host keeps accessing it through `pointer`;
+ * vkc_memory_pool_map() is not needed, and no flush is.
+ *
+ * @param pointer Start of the range, aligned to vkc_memory_pool_import_alignment().
+ * @param size Bytes to import, a multiple of that alignment and at least
+ *             `requirements->size`.
+ * @param requirements Requirements of the resource that will be bound to the range.
+ * @param allocation Receives the range; zeroed unless VK_SUCCESS.
+ * @return VK_SUCCESS; VK_ERROR_FEATURE_NOT_PRESENT without VKC_MEMORY_POOL_HOST_IMPORT_BIT
+ *         or when no coherent memory type fits both the pointer and the resource;
+ *         VK_ERROR_INVALID_EXTERNAL_HANDLE for a misaligned or rejected pointer; or an
+ *         allocation error.
+ */
+VkResult vkc_memory_pool_import_host(
+    VkcMemoryPool* pool,
+    void* pointer,
+    VkDeviceSize size,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryAllocation* allocation
+);
+
+/**
+ * @brief Reserve a range to move an allocation into, in a block fuller than its own.
+ *
+ * For defragmentation: the caller binds a new resource to `target`, copies the contents
+ * over and frees `allocation`. Only existing blocks holding more live bytes than the
+ * allocation's are searched, fullest first, and no block is allocated, so repeated
+ * moves drain the sparsest blocks.
+ *
+ * @param requirements Requirements of the resource that will be bound to `target`.
+ * @param target Receives the new range; zeroed unless VK_SUCCESS.
+ * @return VK_SUCCESS; VK_INCOMPLETE when the range is dedicated or has no better place.
+ */
+VkResult vkc_memory_pool_relocate(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryAllocation* target
+);
+
+/**
+ * @brief Free the empty block each memory type keeps for the next burst.
+ *
+ * Call after freeing many ranges at once, as a defragmentation pass does.
+ */
+void vkc_memory_pool_trim(VkcMemoryPool* pool);
+
+/**
+ * @brief Device the pool allocates on.
+ */
+VkDevice vkc_memory_pool_device(VkcMemoryPool* pool);
+
+/**
+ * @brief Physical device the pool allocates on.
+ */
+VkPhysicalDevice vkc_memory_pool_physical(VkcMemoryPool* pool);
+
+/**
+ * @brief Flags in effect: those the pool was created with, less any the device lacks.
+ */
+VkcMemoryPoolFlags vkc_memory_pool_flags(VkcMemoryPool* pool);
+
+/**
+ * @brief Host callbacks the pool was created with, or NULL.
+ */
+const VkAllocationCallbacks* vkc_memory_pool_callbacks(VkcMemoryPool* pool);
+
+/**
+ * @brief Best memory type for a usage among `memory_type_bits`.
+ *
+ * Reads the ranking cached at creation; no driver call.
+ *
+ * @return false if no allowed type suits the usage.
+ */
+bool vkc_memory_pool_type(
+    VkcMemoryPool* pool, VkcMemoryUsage usage, uint32_t memory_type_bits, uint32_t* type
+);
+
+/**
+ * @brief Map a host-visible range.
+ *
+ * The whole block is mapped on first use and stays mapped while any of its ranges is,
+ * since Vulkan allows one mapping per VkDeviceMemory. Pair every call with
+ * vkc_memory_pool_unmap().
+ *
+ * @param data Receives the host address of the range.
+ */
+VkResult vkc_memory_pool_map(
+    VkcMemoryPool* pool, const VkcMemoryAllocation* allocation, void** data
+);
+
+/**
+ * @brief Release a mapping made with vkc_memory_pool_map().
+ *
+ * Releasing a block's last mapping flushes the writes marked in it and forgets the
+ * invalidates marked in it.
+ */
+void vkc_memory_pool_unmap(VkcMemoryPool* pool, const VkcMemoryAllocation* allocation);
+
+/**
+ * @brief Mark host writes to part of a mapped range for the next vkc_memory_pool_flush().
+ *
+ * The span is widened to nonCoherentAtomSize and merged with spans marked before it.
+ * Returns at once for HOST_COHERENT memory.
+ *
+ * @param offset Start of the written bytes, relative to the range.
+ * @param size Number of written bytes, or VK_WHOLE_SIZE for the rest of the range.
+ * @return false if the span is out of bounds, not mapped, or cannot be queued.
+ */
+bool vkc_memory_pool_mark_flush(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    VkDeviceSize offset,
+    VkDeviceSize size
+);
+
+/**
+ * @brief Mark part of a mapped range the host will read after the device writes it, for
+ *        the next vkc_memory_pool_invalidate().
+ *
+ * Same rules as vkc_memory_pool_mark_flush().
+ */
+bool vkc_memory_pool_mark_invalidate(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    VkDeviceSize offset,
+    VkDeviceSize size
+);
+
+/**
+ * @brief Make every marked host write visible to the device.
+ *
+ * Call before submitting the work that reads the writes. One vkFlushMappedMemoryRanges
+ * covers all marked spans, sorted and coalesced; nothing is called when none are marked.
+ */
+VkResult vkc_memory_pool_flush(VkcMemoryPool* pool);
+
+/**
+ * @brief Make every marked device write visible to the host.
+ *
+ * Call after waiting for the work that wrote them and before reading. One
+ * vkInvalidateMappedMemoryRanges covers all marked spans.
+ */
+VkResult vkc_memory_pool_invalidate(VkcMemoryPool* pool);
+
+/**
+ * @brief Read a heap's budget and estimated usage.
+ *
+ * Reads atomics only, so it is cheap enough for every frame and any thread. The usage
+ * is the driver's last report plus the pool's block allocations and frees since.
+ *
+ * @param heap Memory heap index.
+ * @return false if the heap does not exist.
+ */
+bool vkc_memory_pool_budget(VkcMemoryPool* pool, uint32_t heap, VkcMemoryBudget* budget);
+
+/**
+ * @brief Ask the driver for current budgets, to see other allocators' changes at once.
+ *
+ * Does nothing unless the pool was created with VKC_MEMORY_POOL_MEMORY_BUDGET_BIT.
+ */
+void vkc_memory_pool_budget_refresh(VkcMemoryPool* pool);
+
+/**
+ * @brief Choose what allocations do when a new block would exceed its heap's budget.
+ *
+ * Ranges carved from existing blocks are never affected. Dedicated ranges and new
+ * pooled blocks are checked against the budget, and a pooled block that does not fit
+ * is retried at half the size before the policy's action is taken.
+ *
+ * @param policy Policy to apply, or NULL for VKC_MEMORY_BUDGET_IGNORE.
+ */
+bool vkc_memory_pool_budget_policy(VkcMemoryPool* pool, const VkcMemoryBudgetPolicy* policy);
+
+/**
+ * @brief Let the pool evict a range under VKC_MEMORY_BUDGET_EVICT, or stop it.
+ *
+ * Evictable ranges are kept in least recently used order, newest first. Freeing the
+ * range removes it.
+ *
+ * @param evict Called to free the range, or NULL to make it unevictable again.
+ * @param user_data Passed to `evict`.
+ */
+bool vkc_memory_pool_evictable(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    VkcMemoryEvictCallback evict,
+    void* user_data
+);
+
+/**
+ * @brief Mark an evictable range as just used, so it is evicted last.
+ */
+void vkc_memory_pool_touch(VkcMemoryPool* pool, const VkcMemoryAllocation* allocation);
+
+/**
+ * @brief Snapshot a pool's counters.
+ */
+bool vkc_memory_pool_stats(VkcMemoryPool* pool, VkcMemoryPoolStats* stats);
+
+/**
+ * @brief Describe a live range: its placement, memory type and footprint.
+ *
+ * @return false for a zeroed or freed allocation.
+ */
+bool vkc_memory_pool_allocation_stats(
+    const VkcMemoryAllocation* allocation, VkcMemoryAllocationStats* stats
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_POOL_H
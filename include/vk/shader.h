@@ -1,15 +1,106 @@
 /**
  * @file include/vk/shader.h
  * @brief A wrapper for interfacing with SPIR-V Compute Shaders.
+ *
+ * shader_load_module() reads a file and creates a module every time it is called. Jobs
+ * that share kernels should use a VkcShaderRegistry instead: it maps each SPIR-V file,
+ * hashes its contents and creates one VkShaderModule per distinct content on its device.
+ * Loading a path again costs a stat() while the file is unchanged; loading another file
+ * with the same bytes costs a map and a hash, but no module.
+ *
+ * Modules handed out by a registry belong to it: do not destroy them, and destroy the
+ * registry only once no pipeline is being created from them. A registry is synchronized
+ * and may be shared by every thread using its device.
  */
 
 #ifndef SHADER_H
 #define SHADER_H
 
 #include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Read a whole SPIR-V file into a malloc()ed buffer; NULL on failure.
+ */
 char* shader_read(const char* filepath, size_t* size_out);
-VkShaderModule shader_load_module(VkDevice device, const char* filepath);
-void shader_destroy_module(VkDevice device, VkShaderModule module);
+
+/**
+ * @brief Read a SPIR-V file and create a module from it; VK_NULL_HANDLE on failure.
+ */
+VkShaderModule
+shader_load_module(VkDevice device, const VkAllocationCallbacks* callbacks, const char* filepath);
+
+void shader_destroy_module(
+    VkDevice device, const VkAllocationCallbacks* callbacks, VkShaderModule module
+);
+
+/**
+ * @brief How a registry's loads were served.
+ */
+typedef struct VkcShaderRegistryStats {
+    uint32_t modules; /**< Distinct modules created. */
+    uint32_t paths; /**< Paths known. */
+    uint64_t loads; /**< Successful loads. */
+    uint64_t path_hits; /**< Loads of an unchanged, known path: no I/O. */
+    uint64_t content_hits; /**< Loads whose contents matched an existing module. */
+    uint64_t mapped_bytes; /**< SPIR-V bytes mapped and hashed. */
+} VkcShaderRegistryStats;
+
+/**
+ * @brief Content-addressed shader modules of one device.
+ */
+typedef struct VkcShaderRegistry VkcShaderRegistry;
+
+/**
+ * @brief Create an empty registry.
+ *
+ * @param device Device the modules are created on.
+ * @param callbacks Host callbacks for the modules; may be NULL.
+ * @return The registry, or NULL on failure.
+ */
+VkcShaderRegistry*
+vkc_shader_registry_create(VkDevice device, const VkAllocationCallbacks* callbacks);
+
+/**
+ * @brief Destroy every module the registry created.
+ */
+void vkc_shader_registry_destroy(VkcShaderRegistry* registry);
+
+/**
+ * @brief The module for a SPIR-V file, created on first sight of its contents.
+ *
+ * A path is looked up again when its size, modification time or inode changes, so a
+ * rebuilt shader is picked up; the module of its old contents stays valid.
+ *
+ * @return VK_SUCCESS; VK_ERROR_INITIALIZATION_FAILED if the file cannot be read or is
+ *         not SPIR-V; or the error creating the module.
+ */
+VkResult
+vkc_shader_registry_load(VkcShaderRegistry* registry, const char* path, VkShaderModule* module);
+
+/**
+ * @brief The module for SPIR-V already in memory, deduplicated with files and other code.
+ *
+ * @param code SPIR-V words; the registry keeps a copy.
+ * @param size Size in bytes, a multiple of 4.
+ */
+VkResult vkc_shader_registry_code(
+    VkcShaderRegistry* registry, const uint32_t* code, size_t size, VkShaderModule* module
+);
+
+/**
+ * @brief Fill `stats`.
+ */
+bool vkc_shader_registry_stats(VkcShaderRegistry* registry, VkcShaderRegistryStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // SHADER_H
@@ -0,0 +1,125 @@
+/**
+ * @file include/vk/share.h
+ * @brief Buffers shared between processes through file descriptors.
+ *
+ * A producer writes through a VkcShare's `data` pointer and sends it over a Unix domain
+ * socket; the consumer opens it as a VkcBuffer its device reads directly. Only a small
+ * descriptor and the file descriptor cross the socket.
+ *
+ * VKC_SHARE_MODE_OPAQUE_FD exports device memory with VK_KHR_external_memory_fd and
+ * needs the same driver and device in both processes. VKC_SHARE_MODE_HOST_MEMFD, used
+ * otherwise, maps the pages of a memfd in both.
+ *
+ * Before a submission reads what was written through `data`, call vkc_share_refresh()
+ * and then vkc_memory_pool_flush() in both processes. The processes order their own
+ * accesses, for instance with a message on the socket after each batch.
+ */
+
+#ifndef VKC_SHARE_H
+#define VKC_SHARE_H
+
+#include "vk/buffer.h"
+#include "vk/pool.h"
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What backs a shared buffer.
+ */
+typedef enum VkcShareMode {
+    VKC_SHARE_MODE_OPAQUE_FD = 0, /**< Device memory exported as an opaque fd. */
+    VKC_SHARE_MODE_HOST_MEMFD, /**< memfd pages mapped by every process. */
+} VkcShareMode;
+
+/**
+ * @brief Everything but the file descriptor a process needs to open a share.
+ *
+ * Fixed layout: sent as is between processes built from the same tree.
+ */
+typedef struct VkcShareDesc {
+    uint64_t size; /**< Bytes of the buffer. */
+    uint64_t memory_size; /**< Bytes behind the descriptor. */
+    uint32_t mode; /**< VkcShareMode. */
+    uint32_t type; /**< Memory type of an opaque fd. */
+    uint32_t usage; /**< VkBufferUsageFlags of the buffer. */
+    uint32_t reserved; /**< Zero. */
+    uint8_t device_uuid[VK_UUID_SIZE]; /**< Exporting device, for opaque fds. */
+    uint8_t driver_uuid[VK_UUID_SIZE]; /**< Exporting driver, for opaque fds. */
+} VkcShareDesc;
+
+/**
+ * @brief One process's end of a shared buffer.
+ */
+typedef struct VkcShare {
+    VkcShareDesc desc;
+    VkcBuffer buffer; /**< This process's buffer over the shared bytes. */
+    void* data; /**< Shared bytes as the host sees them; NULL if not host-visible. */
+    void* mapping; /**< memfd mapping, in VKC_SHARE_MODE_HOST_MEMFD. */
+    int fd; /**< Descriptor vkc_share_send() passes on; -1 in an opened share. */
+} VkcShare;
+
+/**
+ * @brief Create a buffer other processes can open.
+ *
+ * Exports device memory of the given usage where the pool and device allow it, and
+ * falls back to a memfd otherwise.
+ *
+ * @param usage Buffer usage in every process that opens the share.
+ * @param memory How the producer accesses the memory, for an opaque fd; memfd shares
+ *               are always host-visible.
+ * @param share Receives the share; zeroed on failure.
+ * @return VK_SUCCESS, or the creation, export or memfd error.
+ */
+VkResult vkc_share_create(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkcShare* share
+);
+
+/**
+ * @brief Open a share another process created.
+ *
+ * @param fd Descriptor from vkc_share_receive(); ownership passes to the call.
+ * @param share Receives the share; zeroed on failure.
+ * @return VK_SUCCESS; VK_ERROR_INVALID_EXTERNAL_HANDLE for an opaque fd from another
+ *         device or driver; or the import or map error.
+ */
+VkResult vkc_share_open(VkcMemoryPool* pool, const VkcShareDesc* desc, int fd, VkcShare* share);
+
+/**
+ * @brief Make host writes to `data`, from any process, visible to this process's device.
+ *
+ * Marks the buffer for the next vkc_memory_pool_flush(), and refreshes the copy of a
+ * memfd this process's device could not import.
+ */
+bool vkc_share_refresh(VkcMemoryPool* pool, VkcShare* share);
+
+/**
+ * @brief Release this process's end of a share. Other processes keep theirs.
+ */
+void vkc_share_destroy(VkcMemoryPool* pool, VkcShare* share);
+
+/**
+ * @brief Send a share's descriptor and file descriptor over a Unix domain socket.
+ */
+bool vkc_share_send(int socket, const VkcShare* share);
+
+/**
+ * @brief Receive what vkc_share_send() sent.
+ *
+ * @param fd Receives the descriptor, which the caller owns until vkc_share_open().
+ */
+bool vkc_share_receive(int socket, VkcShareDesc* desc, int* fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_SHARE_H
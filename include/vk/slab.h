@@ -0,0 +1,105 @@
+/**
+ * @file include/vk/slab.h
+ * @brief Size-class slab allocator for small Vulkan host allocations.
+ *
+ * Requests up to VKC_SLAB_MAX bytes are rounded to jemalloc-style size classes
+ * (16-byte steps up to 128, then four classes per doubling) and carved from
+ * 64 KiB slabs. Blocks are packed back to back with no inline header.
+ *
+ * Slab metadata (size class and free bitmap) lives in an out-of-line descriptor
+ * resolved through the extent map, so freeing a block is O(1) with no hashing.
+ *
+ * Alignment is honoured by picking the smallest class whose stride is a multiple
+ * of the requested alignment: slabs are granule-aligned, so every block in such a
+ * class is aligned too. Requests no class can satisfy are rejected, and callers
+ * fall back to the tracked PageAllocator.
+ *
+ * Slab allocators are internally synchronized. Each thread keeps small per-class
+ * caches that refill and drain in batches under a per-class lock.
+ */
+
+#ifndef VKC_SLAB_H
+#define VKC_SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Largest block served by a slab allocator.
+ */
+#define VKC_SLAB_MAX 4096
+
+/**
+ * @brief Opaque slab allocator handle.
+ */
+typedef struct VkcSlab VkcSlab;
+
+/**
+ * @brief Create a slab allocator.
+ *
+ * @param node NUMA node preferred for slab pages, or VKC_NUMA_NODE_ANY for first touch.
+ * @return Slab allocator handle, or NULL on failure.
+ */
+VkcSlab* vkc_slab_create(int node);
+
+/**
+ * @brief Destroy a slab allocator and unmap all of its slabs.
+ *
+ * Outstanding blocks become invalid.
+ */
+void vkc_slab_destroy(VkcSlab* slab);
+
+/**
+ * @brief Check whether some size class can serve a request of the given shape.
+ */
+bool vkc_slab_accepts(size_t size, size_t alignment);
+
+/**
+ * @brief Allocate a block from the smallest fitting size class.
+ *
+ * @return Block address, or NULL if the request is not accepted or memory is exhausted.
+ */
+void* vkc_slab_malloc(VkcSlab* slab, size_t size, size_t alignment);
+
+/**
+ * @brief Return a block to the slab allocator that owns it.
+ */
+void vkc_slab_free(VkcSlab* slab, void* address);
+
+/**
+ * @brief Return idle slab memory to the OS without touching live blocks.
+ *
+ * Unmaps the empty slab each size class keeps once it has been empty for at least
+ * `idle_ns`. With `purge`, also drains the calling thread's caches and drops the free
+ * pages of every partly used slab with MADV_DONTNEED; they refault as zeroes on reuse.
+ * Blocks cached by other threads count as live.
+ *
+ * @return Resident bytes returned.
+ */
+size_t vkc_slab_trim(VkcSlab* slab, uint64_t idle_ns, bool purge);
+
+/**
+ * @brief Usable size (size class) a request of the given shape receives, or 0 if rejected.
+ */
+size_t vkc_slab_usable(size_t size, size_t alignment);
+
+/**
+ * @brief Usable size (size class) of a live block.
+ */
+size_t vkc_slab_size(const void* address);
+
+/**
+ * @brief Owning slab allocator of an address, or NULL if no slab owns it.
+ */
+VkcSlab* vkc_slab_owner(const void* address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_SLAB_H
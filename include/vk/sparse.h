@@ -0,0 +1,161 @@
+/**
+ * @file include/vk/sparse.h
+ * @brief Sparse virtual buffers whose pages are committed on demand.
+ *
+ * A VkcSparse reserves a virtual range far larger than any one allocation and backs it
+ * with memory a page at a time as the caller commits ranges.
+ *
+ * VKC_SPARSE_MODE_RESIDENCY binds pool memory into one sparse-residency VkBuffer with
+ * vkQueueBindSparse; it needs the sparseBinding and sparseResidencyBuffer features and a
+ * queue with VK_QUEUE_SPARSE_BINDING_BIT. VKC_SPARSE_MODE_CHUNKED, used otherwise, makes
+ * every page a VkcBuffer of its own, so a descriptor or copy reaches at most one page.
+ * vkc_sparse_resolve() maps an offset to what to record with in either mode.
+ *
+ * Commit and release wait for their binds. The device must be done with pages before
+ * they are released, and reading pages that are not committed is undefined unless the
+ * device reports residencyNonResidentStrict.
+ *
+ * A sparse buffer is not synchronized, and uses its queue: commit and release from the
+ * thread that submits to that queue.
+ */
+
+#ifndef VKC_SPARSE_H
+#define VKC_SPARSE_H
+
+#include "vk/buffer.h"
+#include "vk/pool.h"
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Default page size (1 MiB); rounded up to the sparse block size of the device.
+ */
+#define VKC_SPARSE_PAGE (1ull * 1024 * 1024)
+
+/**
+ * @brief What backs a sparse buffer.
+ */
+typedef enum VkcSparseMode {
+    VKC_SPARSE_MODE_RESIDENCY = 0, /**< One sparse-resident VkBuffer. */
+    VKC_SPARSE_MODE_CHUNKED, /**< One VkcBuffer per committed page. */
+} VkcSparseMode;
+
+/**
+ * @brief Where an offset of a sparse buffer lives.
+ */
+typedef struct VkcSparseRange {
+    VkBuffer buffer; /**< Buffer to bind or copy with. */
+    VkDeviceSize offset; /**< Offset of the requested byte in `buffer`. */
+    VkDeviceSize size; /**< Bytes from `offset` the device can reach through `buffer`. */
+    void* data; /**< Host address of the byte; NULL unless committed and host-visible. */
+    VkDeviceSize mapped; /**< Bytes from `data` on, to the end of its page. */
+    VkDeviceAddress address; /**< Device address of the byte; 0 without device address usage. */
+} VkcSparseRange;
+
+/**
+ * @brief Snapshot of a sparse buffer.
+ */
+typedef struct VkcSparseStats {
+    VkcSparseMode mode;
+    VkDeviceSize size; /**< Virtual size in bytes, a whole number of pages. */
+    VkDeviceSize page_size; /**< Commit granularity. */
+    uint64_t pages; /**< Pages in the virtual range. */
+    uint64_t committed_pages; /**< Pages backed by memory. */
+    VkDeviceSize committed_bytes; /**< Memory those pages hold. */
+    uint64_t binds; /**< vkQueueBindSparse calls made; 0 in chunked mode. */
+} VkcSparseStats;
+
+/**
+ * @brief Sparse buffer.
+ */
+typedef struct VkcSparse VkcSparse;
+
+/**
+ * @brief Reserve a virtual range. No memory is committed.
+ *
+ * @param pool Pool the pages' memory comes from; its device and host callbacks are used.
+ * @param queue Queue with VK_QUEUE_SPARSE_BINDING_BIT to bind on, or VK_NULL_HANDLE for
+ *        chunked mode.
+ * @param size Virtual size in bytes, rounded up to whole pages.
+ * @param usage Vulkan buffer usage flags.
+ * @param memory How the pages are accessed.
+ * @param page_size Commit granularity, 0 for VKC_SPARSE_PAGE.
+ * @return The sparse buffer, or NULL on failure.
+ */
+VkcSparse* vkc_sparse_create(
+    VkcMemoryPool* pool,
+    VkQueue queue,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkDeviceSize page_size
+);
+
+/**
+ * @brief Release every page and the buffer. The device must be done with them.
+ */
+void vkc_sparse_destroy(VkcSparse* sparse);
+
+/**
+ * @brief Back every page overlapping a range with memory.
+ *
+ * Pages already committed are left as they are; new pages hold undefined contents.
+ * Residency mode binds all new pages in one vkQueueBindSparse call.
+ *
+ * @param size Bytes from `offset`, or VK_WHOLE_SIZE for the rest of the buffer.
+ * @return VK_SUCCESS, or the allocation or bind error; pages this call could not bind
+ *         are left uncommitted.
+ */
+VkResult vkc_sparse_commit(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * @brief Return the memory of every page wholly inside a range.
+ *
+ * @param size Bytes from `offset`, or VK_WHOLE_SIZE for the rest of the buffer.
+ * @return VK_SUCCESS, or the unbind error; the pages then stay committed.
+ */
+VkResult vkc_sparse_release(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * @brief Whether the page holding `offset` is committed.
+ */
+bool vkc_sparse_committed(const VkcSparse* sparse, VkDeviceSize offset);
+
+/**
+ * @brief Find the buffer, offset and host pointer for a byte of the virtual range.
+ *
+ * @return false if `offset` is out of range, or falls in an uncommitted page in chunked
+ *         mode, where no buffer covers it.
+ */
+bool vkc_sparse_resolve(const VkcSparse* sparse, VkDeviceSize offset, VkcSparseRange* range);
+
+/**
+ * @brief Mark host writes to a committed range for the next vkc_memory_pool_flush().
+ *
+ * @param size Bytes from `offset`, or VK_WHOLE_SIZE for the rest of the buffer.
+ * @return false if part of the range is not committed and mapped.
+ */
+bool vkc_sparse_mark_flush(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * @brief Mark a committed range the host will read for the next vkc_memory_pool_invalidate().
+ *
+ * Same rules as vkc_sparse_mark_flush().
+ */
+bool vkc_sparse_mark_invalidate(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * @brief Fill `stats` with the buffer's mode, size and commitment.
+ */
+bool vkc_sparse_stats(const VkcSparse* sparse, VkcSparseStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_SPARSE_H
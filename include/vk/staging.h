@@ -0,0 +1,159 @@
+/**
+ * @file include/vk/staging.h
+ * @brief Persistently mapped staging ring for host-to-device uploads.
+ *
+ * A VkcStaging owns one host-visible transfer buffer, mapped once for its whole life.
+ * Callers write upload data straight into ring space and queue the copy into a
+ * device-local buffer; `vkc_staging_record()` turns every queued copy into
+ * vkCmdCopyBuffer regions, one call per destination.
+ *
+ * Space is handed out in submission order and reclaimed as submissions retire: close
+ * each batch of uploads with `vkc_staging_fence()` (a fence the ring owns and recycles)
+ * or `vkc_staging_timeline()` (a timeline semaphore value), then submit. When the ring
+ * is full, allocation first polls and then waits on the oldest batch. Uploads thus cost
+ * a memcpy and no map call, driver allocation or queue idle.
+ *
+ * Queued copies mark their ranges for the pool's next flush, so if the ring's memory
+ * is not coherent, call `vkc_memory_pool_flush()` before submitting.
+ *
+ * A ring is not synchronized: give each submitting thread or queue its own.
+ */
+
+#ifndef VKC_STAGING_H
+#define VKC_STAGING_H
+
+#include "vk/pool.h"
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Default ring size (16 MiB).
+ */
+#define VKC_STAGING_SIZE (16ull * 1024 * 1024)
+
+/**
+ * @brief Alignment of ranges handed out by `vkc_staging_upload()`.
+ */
+#define VKC_STAGING_ALIGNMENT 16
+
+/**
+ * @brief Batches that may be in flight before allocation waits on the oldest.
+ */
+#define VKC_STAGING_BATCHES 64
+
+/**
+ * @brief Ring space the caller writes upload data into.
+ */
+typedef struct VkcStagingRange {
+    void* data; /**< Host address, valid until the range's batch retires. */
+    VkDeviceSize offset; /**< Offset in the staging buffer. */
+    VkDeviceSize size;
+} VkcStagingRange;
+
+/**
+ * @brief Staging ring.
+ */
+typedef struct VkcStaging VkcStaging;
+
+/**
+ * @brief Create a staging ring.
+ *
+ * @param device Logical device.
+ * @param pool Pool the staging buffer's VKC_MEMORY_USAGE_UPLOAD memory comes from.
+ * @param callbacks Host callbacks for the ring's fences; may be NULL. The staging buffer uses
+ *        the pool's.
+ * @param size Ring size in bytes, 0 for VKC_STAGING_SIZE.
+ * @return The ring, or NULL on failure.
+ */
+VkcStaging* vkc_staging_create(
+    VkDevice device,
+    VkcMemoryPool* pool,
+    const VkAllocationCallbacks* callbacks,
+    VkDeviceSize size
+);
+
+/**
+ * @brief Free the ring and its fences.
+ *
+ * Does not wait: the device must be done with every batch, as after vkDeviceWaitIdle()
+ * or a wait on the last batch's fence or timeline value.
+ */
+void vkc_staging_destroy(VkcStaging* staging);
+
+/**
+ * @brief Staging buffer backing the ring, for callers recording their own copies.
+ */
+VkBuffer vkc_staging_buffer(VkcStaging* staging);
+
+/**
+ * @brief Reserve ring space.
+ *
+ * Blocks on the oldest batch in flight while the ring is full.
+ *
+ * @param alignment Power-of-two alignment of the range's offset; 0 for 1.
+ * @return VK_SUCCESS; VK_ERROR_OUT_OF_DEVICE_MEMORY if `size` exceeds the ring, or the
+ *         ring is full of uploads not yet closed into a batch; or a wait error.
+ */
+VkResult vkc_staging_alloc(
+    VkcStaging* staging, VkDeviceSize size, VkDeviceSize alignment, VkcStagingRange* range
+);
+
+/**
+ * @brief Queue a copy of a written range into a buffer.
+ *
+ * `dst` needs VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+ *
+ * @return false if the copy queue cannot grow.
+ */
+bool vkc_staging_copy(
+    VkcStaging* staging, const VkcStagingRange* range, VkBuffer dst, VkDeviceSize dst_offset
+);
+
+/**
+ * @brief Stage `size` bytes of `data` and queue their copy into `dst`.
+ */
+VkResult vkc_staging_upload(
+    VkcStaging* staging, VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size
+);
+
+/**
+ * @brief Record every queued copy into a command buffer and clear the queue.
+ *
+ * Adjacent copies into the same buffer are merged into one region. Record copies into
+ * the submission whose batch covers their ranges, i.e. before closing it. The caller
+ * adds the barrier between the transfer and the stage reading `dst`.
+ *
+ * @return Number of vkCmdCopyBuffer calls recorded.
+ */
+uint32_t vkc_staging_record(VkcStaging* staging, VkCommandBuffer command_buffer);
+
+/**
+ * @brief Close the current batch and get the fence to submit it with.
+ *
+ * The ring owns the fence and resets it once it has seen it signal. Callers may wait
+ * on it but must not reset or destroy it.
+ */
+VkResult vkc_staging_fence(VkcStaging* staging, VkFence* fence);
+
+/**
+ * @brief Close the current batch; it retires once `semaphore` reaches `value`.
+ *
+ * Needs the timelineSemaphore feature. Values must increase from batch to batch.
+ */
+VkResult vkc_staging_timeline(VkcStaging* staging, VkSemaphore semaphore, uint64_t value);
+
+/**
+ * @brief Reclaim the space of every batch that has completed, without waiting.
+ */
+void vkc_staging_retire(VkcStaging* staging);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_STAGING_H
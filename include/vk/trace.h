@@ -0,0 +1,119 @@
+/**
+ * @file include/vk/trace.h
+ * @brief Host allocation trace recorder.
+ *
+ * A VkcTrace captures every allocation, reallocation and free made through an
+ * allocation context's callbacks, so driver allocation patterns can be replayed
+ * offline against other allocator strategies (see examples/replay.c).
+ *
+ * Recording threads append fixed-size records to a bounded lock-free ring and never
+ * wait: when the ring is full the record is dropped and counted. A background thread
+ * drains the ring into a binary file made of one VkcTraceHeader followed by
+ * VkcTraceRecord entries in native byte order.
+ *
+ * Frees are recorded before the block is released and allocations after the block
+ * is obtained, so a reused address never shows up live twice in the file. Blocks
+ * moved by a reallocation are the exception: their old address can be reused before
+ * the reallocation is recorded, and replay tools must tolerate that.
+ */
+
+#ifndef VKC_TRACE_H
+#define VKC_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief File identification: the magic bytes and the format version.
+ */
+#define VKC_TRACE_MAGIC "VKCTRACE"
+#define VKC_TRACE_VERSION 1
+
+/**
+ * @brief Ring capacity in records used when none is given (a power of two).
+ */
+#define VKC_TRACE_CAPACITY (64 * 1024)
+
+/**
+ * @brief Traced callback.
+ */
+typedef enum VkcTraceOp {
+    VKC_TRACE_ALLOCATE = 0, /**< pfnAllocation */
+    VKC_TRACE_REALLOCATE, /**< pfnReallocation */
+    VKC_TRACE_FREE, /**< pfnFree */
+} VkcTraceOp;
+
+/**
+ * @brief Leading bytes of a trace file.
+ */
+typedef struct VkcTraceHeader {
+    char magic[8]; /**< VKC_TRACE_MAGIC, not NUL-terminated. */
+    uint32_t version; /**< VKC_TRACE_VERSION. */
+    uint32_t record_size; /**< sizeof(VkcTraceRecord). */
+} VkcTraceHeader;
+
+/**
+ * @brief One traced callback.
+ */
+typedef struct VkcTraceRecord {
+    uint64_t timestamp; /**< Nanoseconds since the trace was created. */
+    uint64_t address; /**< Block returned; 0 for frees and failed requests. */
+    uint64_t original; /**< Block passed in; 0 for allocations. */
+    uint64_t size; /**< Requested size in bytes; 0 for frees. */
+    uint32_t alignment; /**< Requested alignment in bytes; 0 for frees. */
+    uint32_t thread; /**< Recorder-assigned thread number, starting at 1. */
+    uint8_t op; /**< VkcTraceOp. */
+    uint8_t scope; /**< VkSystemAllocationScope; 0 for frees. */
+    uint8_t reserved[6];
+} VkcTraceRecord;
+
+/**
+ * @brief Opaque trace recorder handle.
+ */
+typedef struct VkcTrace VkcTrace;
+
+/**
+ * @brief Create a trace file and start its background writer.
+ *
+ * @param path File to create or truncate.
+ * @param capacity Ring capacity in records, rounded up to a power of two; 0 selects
+ *                 VKC_TRACE_CAPACITY.
+ * @return Trace handle, or NULL on failure.
+ */
+VkcTrace* vkc_trace_create(const char* path, size_t capacity);
+
+/**
+ * @brief Stop the writer, flush every pending record and close the file.
+ *
+ * No thread may record into the trace once this starts.
+ */
+void vkc_trace_destroy(VkcTrace* trace);
+
+/**
+ * @brief Append a record. Lock-free and never blocks; drops the record if the ring is full.
+ */
+void vkc_trace_record(
+    VkcTrace* trace,
+    VkcTraceOp op,
+    const void* original,
+    const void* address,
+    size_t size,
+    size_t alignment,
+    uint32_t scope
+);
+
+/**
+ * @brief Number of records dropped because the ring was full.
+ */
+uint64_t vkc_trace_dropped(VkcTrace* trace);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_TRACE_H
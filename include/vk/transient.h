@@ -0,0 +1,122 @@
+/**
+ * @file include/vk/transient.h
+ * @brief Transient buffers that share memory when their lifetimes do not overlap.
+ *
+ * A VkcTransient plans a job's intermediates up front: declare each buffer, record the
+ * stages that use it, then build. Buffers whose lifetimes, from first use to last, do
+ * not overlap are bound at overlapping offsets of one pool range, so the job holds the
+ * most bytes live together rather than the sum of every intermediate.
+ *
+ * A buffer's contents are undefined at its first use, and stages must be ordered on the
+ * device with a pipeline barrier between them.
+ *
+ * A plan is not synchronized: build it from one thread.
+ */
+
+#ifndef VKC_TRANSIENT_H
+#define VKC_TRANSIENT_H
+
+#include "vk/pool.h"
+#include <vulkan/vulkan.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Returned by vkc_transient_declare() on failure.
+ */
+#define VKC_TRANSIENT_INVALID UINT32_MAX
+
+/**
+ * @brief One planned buffer, valid once the plan is built.
+ */
+typedef struct VkcTransientBuffer {
+    VkBuffer object;
+    VkDeviceSize offset; /**< Offset in the plan's shared range. */
+    VkDeviceSize size; /**< Requested size in bytes. */
+    VkBufferUsageFlags usage;
+    uint32_t first; /**< First stage that uses the buffer. */
+    uint32_t last; /**< Last stage that uses the buffer. */
+    void* data; /**< Host address of the first byte; NULL for VKC_MEMORY_USAGE_GPU_ONLY. */
+    VkDeviceAddress address; /**< Shader-visible address; 0 without device address usage. */
+} VkcTransientBuffer;
+
+/**
+ * @brief What aliasing saved.
+ */
+typedef struct VkcTransientStats {
+    uint32_t buffers; /**< Buffers declared. */
+    uint32_t stages; /**< One past the last stage used. */
+    VkDeviceSize unaliased_bytes; /**< Peak with a range per buffer: all of them, aligned. */
+    VkDeviceSize aliased_bytes; /**< Peak with aliasing: the size of the shared range. */
+    VkDeviceSize live_bytes; /**< Most bytes in use by one stage; no placement needs less. */
+} VkcTransientStats;
+
+/**
+ * @brief Plan of a job's transient buffers.
+ */
+typedef struct VkcTransient VkcTransient;
+
+/**
+ * @brief Start an empty plan.
+ *
+ * @param pool Pool the shared range comes from; its device and host callbacks are used.
+ * @param memory How every buffer of the plan is accessed.
+ * @return The plan, or NULL on failure.
+ */
+VkcTransient* vkc_transient_create(VkcMemoryPool* pool, VkcMemoryUsage memory);
+
+/**
+ * @brief Destroy every buffer and return the shared range. The device must be done with
+ *        them.
+ */
+void vkc_transient_destroy(VkcTransient* transient);
+
+/**
+ * @brief Declare a buffer the job needs.
+ *
+ * @return The buffer's id, dense from 0 in declaration order, or VKC_TRANSIENT_INVALID
+ *         once the plan is built or on failure.
+ */
+uint32_t
+vkc_transient_declare(VkcTransient* transient, VkDeviceSize size, VkBufferUsageFlags usage);
+
+/**
+ * @brief Record that a stage reads or writes a buffer, extending its lifetime to cover it.
+ *
+ * Stages are numbered in the order the device runs them. A buffer no stage uses
+ * overlaps nothing.
+ */
+bool vkc_transient_use(VkcTransient* transient, uint32_t id, uint32_t stage);
+
+/**
+ * @brief Place every declared buffer, allocate the shared range and bind them to it.
+ *
+ * @return VK_SUCCESS; VK_ERROR_FEATURE_NOT_PRESENT if no memory type suits every buffer;
+ *         or the creation, allocation or bind error, leaving the plan unbuilt.
+ */
+VkResult vkc_transient_build(VkcTransient* transient);
+
+/**
+ * @brief A built buffer, or NULL for an unknown id or an unbuilt plan.
+ */
+const VkcTransientBuffer* vkc_transient_buffer(const VkcTransient* transient, uint32_t id);
+
+/**
+ * @brief Destroy the buffers and forget every declaration, to plan another job.
+ */
+void vkc_transient_reset(VkcTransient* transient);
+
+/**
+ * @brief Fill `stats`; the aliased and unaliased sizes are known once the plan is built.
+ */
+bool vkc_transient_stats(const VkcTransient* transient, VkcTransientStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKC_TRANSIENT_H
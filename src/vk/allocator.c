@@ -1,50 +1,983 @@
 /**
  * @file src/vk/allocator.c
- * @brief Vulkan Host Memory Allocator using a tracked page map.
+ * @brief Vulkan Host Memory Allocator with scope-aware arenas and slabs.
+ *
+ * COMMAND blocks come from bump-pointer arenas whose chunks are reset once drained.
+ * OBJECT, CACHE, DEVICE and INSTANCE blocks come from one slab allocator per scope, so
+ * long-lived blocks never pin short-lived slabs; per-thread caches refill and drain
+ * their free lists in batches. Arenas and slabs exist once per NUMA node.
+ *
+ * Blocks of 128 KiB or more get a mapping of their own that realloc grows with
+ * mremap(). From 2 MiB they are huge-page backed; up to 32 MiB they are carved from
+ * 64 MiB huge-page arenas instead, whose freed pages stay resident for the next block.
+ * Mid-sized and unusually aligned blocks take the PageAllocator's lock.
+ *
+ * Realloc keeps blocks in place when the new size fits their size class, when they
+ * sit at the tail of the caller's arena chunk, or when they shrink.
  */
 
 #include "core/posix.h"
 #include "core/memory.h"
 #include "core/logger.h"
 #include "allocator/page.h"
+#include "vk/extent.h"
+#include "vk/numa.h"
+#include "vk/arena.h"
+#include "vk/slab.h"
 #include "vk/allocator.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
 /**
  * @section Private
  * {@
  */
 
-void* VKAPI_CALL
-vkc_malloc(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
-    (void) scope;
+// Live-byte drift a thread accumulates before publishing it to the shared peak tracker.
+#define VKC_ALLOCATOR_PUBLISH (64 * 1024)
+
+// Requests at least this large get a dedicated mapping that realloc can mremap().
+#define VKC_ALLOCATOR_LARGE (128 * 1024)
+
+// Huge-page arenas are reserved 64 MiB at a time and carved into runs of 2 MiB pages.
+#define VKC_ALLOCATOR_HUGE_ARENA (64 * 1024 * 1024)
+#define VKC_ALLOCATOR_HUGE_PAGES (VKC_ALLOCATOR_HUGE_ARENA / VKC_EXTENT_HUGE)
+
+// Huge requests up to half an arena are carved; larger ones keep a mapping of their own.
+#define VKC_ALLOCATOR_HUGE_CARVE (VKC_ALLOCATOR_HUGE_ARENA / 2)
+
+// Counter tracks: callback scopes first, then driver-internal scopes.
+#define VKC_ALLOCATOR_TRACK_COUNT (2 * VKC_ALLOCATOR_SCOPE_COUNT)
+
+// Chunk size for the COMMAND arenas.
+#define VKC_ALLOCATOR_COMMAND_CHUNK (256 * 1024)
+
+/**
+ * @brief Event counters for one track. Written by a single thread, read by any.
+ */
+typedef struct VkcAllocatorCounters {
+    atomic_uint_least64_t live; /**< Unpublished live-byte delta; wraps when negative. */
+    atomic_uint_least64_t allocations;
+    atomic_uint_least64_t frees;
+    atomic_uint_least64_t reallocations;
+    atomic_uint_least64_t growths;
+    atomic_uint_least64_t in_place;
+    atomic_uint_least64_t histogram[VKC_ALLOCATOR_HISTOGRAM_BINS];
+} VkcAllocatorCounters;
+
+/**
+ * @brief Per-thread counters, so the allocation path never bounces a shared cache line.
+ */
+typedef struct VkcAllocatorShard {
+    struct VkcAllocatorContext* allocator;
+    struct VkcAllocatorShard* prev;
+    struct VkcAllocatorShard* next;
+    VkcAllocatorCounters tracks[VKC_ALLOCATOR_TRACK_COUNT];
+} VkcAllocatorShard;
+
+/**
+ * @brief Published live and peak bytes for one track.
+ */
+typedef struct VkcAllocatorTotals {
+    atomic_uint_least64_t live;
+    atomic_uint_least64_t peak;
+} VkcAllocatorTotals;
+
+/**
+ * @brief Huge-page reservation whose 2 MiB pages are handed out in runs.
+ */
+typedef struct VkcAllocatorHuge {
+    uint8_t* base; /**< VKC_EXTENT_HUGE aligned, VKC_ALLOCATOR_HUGE_ARENA bytes. */
+    uint64_t used; /**< Pages carved into live blocks, one bit per page. */
+    uint64_t resident; /**< Pages handed out since the last purge, one bit per page. */
+    uint64_t idle; /**< When the arena last became empty, in CLOCK_MONOTONIC nanoseconds. */
+    VkcExtentPages request; /**< Backing the context asked for. */
+    VkcExtentPages pages; /**< Backing obtained. */
+    int node;
+    struct VkcAllocatorHuge* next;
+} VkcAllocatorHuge;
+
+/**
+ * @brief Out-of-line descriptor for a block with its own mapping or a huge arena run.
+ */
+typedef struct VkcAllocatorLarge {
+    VkcExtent extent; /**< Must be first: extent lookups cast back to the block. */
+    size_t size; /**< Requested size in bytes. */
+    size_t scope; /**< Scope index of the block. */
+    VkcExtentPages pages; /**< Page backing of the mapping. */
+    VkcAllocatorHuge* arena; /**< Arena the block was carved from, or NULL. */
+    struct VkcAllocatorLarge* prev;
+    struct VkcAllocatorLarge* next;
+} VkcAllocatorLarge;
+
+/**
+ * @brief Node-local strategies whose pages are placed on one NUMA node.
+ */
+typedef struct VkcAllocatorNode {
+    VkcArena* command; /**< COMMAND scope: bump arena reset in bulk. */
+    VkcSlab* slabs[VKC_ALLOCATOR_SCOPE_COUNT]; /**< Other scopes: size-class slabs. */
+} VkcAllocatorNode;
+
+/**
+ * @brief Backing strategies for each VkSystemAllocationScope, plus telemetry.
+ */
+struct VkcAllocatorContext {
+    PageAllocator* pager; /**< Wrapper objects and unusually aligned requests. */
+    _Atomic(VkcAllocatorNode*) nodes[VKC_NUMA_NODE_MAX]; /**< Created on first use per node. */
+    atomic_size_t node_count; /**< Highest created node plus one. */
+    int home; /**< Node created with the context; the fallback for the others. */
+    atomic_int node; /**< Explicit node hint, or VKC_NUMA_NODE_ANY. */
+    pthread_mutex_t lock; /**< Guards node creation, shards, the retired shard and large blocks. */
+    pthread_key_t key; /**< Maps each thread to its VkcAllocatorShard. */
+    VkcAllocatorShard* shards; /**< Every live thread's counters. */
+    VkcAllocatorShard retired; /**< Counters folded in from exited threads. */
+    VkcAllocatorLarge* large; /**< Dedicated mappings, unmapped in bulk on destroy. */
+    VkcAllocatorHuge* huge; /**< Huge-page arenas; guarded by `lock`. */
+    VkcExtentPages pages; /**< Huge page backing for blocks of 2 MiB or more. */
+    _Atomic(VkcTrace*) trace; /**< Optional recorder for every callback. */
+    VkcAllocatorTotals totals[VKC_ALLOCATOR_TRACK_COUNT];
+    atomic_uint_least64_t trims; /**< Trim passes run. */
+    atomic_uint_least64_t trimmed; /**< Resident bytes those passes returned. */
+    pthread_mutex_t trim_lock; /**< Guards the trim policy and the trimmer's lifetime. */
+    pthread_cond_t trim_wake; /**< Wakes the trimmer early to stop or reload its policy. */
+    VkcAllocatorTrimPolicy trim_policy;
+    pthread_t trimmer; /**< Background trim thread, valid while `trimming` is set. */
+    bool trimming;
+    VkAllocationCallbacks callbacks; /**< Bound to this context through pUserData. */
+};
+
+/**
+ * @brief Prefix stored before pager blocks so frees can recover size and scope.
+ */
+typedef struct VkcAllocatorHeader {
+    size_t size; /**< Requested size in bytes. */
+    uint32_t scope; /**< Scope index of the block. */
+    uint32_t offset; /**< Distance from the pager block to the payload. */
+} VkcAllocatorHeader;
+
+static inline size_t vkc_allocator_offset(size_t alignment) {
+    return alignment > sizeof(VkcAllocatorHeader) ? alignment : sizeof(VkcAllocatorHeader);
+}
+
+static inline VkcAllocatorHeader* vkc_allocator_header(const void* address) {
+    return (VkcAllocatorHeader*) address - 1;
+}
+
+static inline size_t vkc_allocator_scope_index(VkSystemAllocationScope scope) {
+    return (size_t) scope < VKC_ALLOCATOR_SCOPE_COUNT ? (size_t) scope
+                                                     : VK_SYSTEM_ALLOCATION_SCOPE_OBJECT;
+}
+
+/**
+ * @brief Single-writer increment: a relaxed load and store, no locked instruction.
+ */
+static inline void vkc_allocator_add(atomic_uint_least64_t* counter, uint64_t value) {
+    uint64_t current = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, current + value, memory_order_relaxed);
+}
+
+/**
+ * @brief Move a track's pending live bytes into the shared totals and raise the peak.
+ */
+static void
+vkc_allocator_publish(VkcAllocatorContext* allocator, VkcAllocatorShard* shard, size_t track) {
+    VkcAllocatorCounters* counters = &shard->tracks[track];
+    VkcAllocatorTotals* totals = &allocator->totals[track];
+
+    uint64_t delta = atomic_load_explicit(&counters->live, memory_order_relaxed);
+    atomic_store_explicit(&counters->live, 0, memory_order_relaxed);
+    uint64_t live = atomic_fetch_add_explicit(&totals->live, delta, memory_order_relaxed) + delta;
+
+    uint64_t peak = atomic_load_explicit(&totals->peak, memory_order_relaxed);
+    while ((int64_t) live > 0 && peak < live
+           && !atomic_compare_exchange_weak_explicit(
+               &totals->peak, &peak, live, memory_order_relaxed, memory_order_relaxed
+           )) {}
+}
+
+/**
+ * @brief Apply a live-byte delta, publishing once the thread's drift is large enough.
+ */
+static void vkc_allocator_drift(
+    VkcAllocatorContext* allocator, VkcAllocatorShard* shard, size_t track, uint64_t delta
+) {
+    VkcAllocatorCounters* counters = &shard->tracks[track];
+    vkc_allocator_add(&counters->live, delta);
+
+    int64_t pending = (int64_t) atomic_load_explicit(&counters->live, memory_order_relaxed);
+    if (pending >= VKC_ALLOCATOR_PUBLISH || pending <= -VKC_ALLOCATOR_PUBLISH) {
+        vkc_allocator_publish(allocator, shard, track);
+    }
+}
+
+static void vkc_allocator_shard_exit(void* value) {
+    VkcAllocatorShard* shard = (VkcAllocatorShard*) value;
+    VkcAllocatorContext* allocator = shard->allocator;
+
+    pthread_mutex_lock(&allocator->lock);
+    for (size_t track = 0; track < VKC_ALLOCATOR_TRACK_COUNT; track++) {
+        vkc_allocator_publish(allocator, shard, track);
+
+        VkcAllocatorCounters* from = &shard->tracks[track];
+        VkcAllocatorCounters* into = &allocator->retired.tracks[track];
+        vkc_allocator_add(&into->allocations, atomic_load(&from->allocations));
+        vkc_allocator_add(&into->frees, atomic_load(&from->frees));
+        vkc_allocator_add(&into->reallocations, atomic_load(&from->reallocations));
+        vkc_allocator_add(&into->growths, atomic_load(&from->growths));
+        vkc_allocator_add(&into->in_place, atomic_load(&from->in_place));
+        for (size_t bin = 0; bin < VKC_ALLOCATOR_HISTOGRAM_BINS; bin++) {
+            vkc_allocator_add(&into->histogram[bin], atomic_load(&from->histogram[bin]));
+        }
+    }
+
+    if (shard->prev) {
+        shard->prev->next = shard->next;
+    } else {
+        allocator->shards = shard->next;
+    }
+    if (shard->next) {
+        shard->next->prev = shard->prev;
+    }
+    pthread_mutex_unlock(&allocator->lock);
+
+    free(shard);
+}
+
+static VkcAllocatorShard* vkc_allocator_shard(VkcAllocatorContext* allocator) {
+    VkcAllocatorShard* shard = pthread_getspecific(allocator->key);
+    if (shard) {
+        return shard;
+    }
+
+    shard = calloc(1, sizeof(*shard));
+    if (!shard) {
+        return NULL;
+    }
+
+    if (0 != pthread_setspecific(allocator->key, shard)) {
+        free(shard);
+        return NULL;
+    }
+
+    shard->allocator = allocator;
+    pthread_mutex_lock(&allocator->lock);
+    shard->next = allocator->shards;
+    if (allocator->shards) {
+        allocator->shards->prev = shard;
+    }
+    allocator->shards = shard;
+    pthread_mutex_unlock(&allocator->lock);
+
+    return shard;
+}
+
+typedef enum VkcAllocatorEvent {
+    VKC_ALLOCATOR_EVENT_ALLOCATE,
+    VKC_ALLOCATOR_EVENT_FREE,
+} VkcAllocatorEvent;
+
+/**
+ * @brief Count an allocation or free of `usable` bytes (`size` requested) on a track.
+ */
+static void vkc_allocator_record(
+    VkcAllocatorContext* allocator,
+    VkcAllocatorEvent event,
+    size_t track,
+    size_t usable,
+    size_t size
+) {
+    VkcAllocatorShard* shard = vkc_allocator_shard(allocator);
+    if (!shard) {
+        // No thread shard available: count on the retired shard under the lock.
+        pthread_mutex_lock(&allocator->lock);
+        shard = &allocator->retired;
+    }
+
+    VkcAllocatorCounters* counters = &shard->tracks[track];
+    if (VKC_ALLOCATOR_EVENT_ALLOCATE == event) {
+        vkc_allocator_add(&counters->allocations, 1);
+        vkc_allocator_add(&counters->histogram[vkc_allocator_histogram_bin(size)], 1);
+        vkc_allocator_drift(allocator, shard, track, usable);
+    } else {
+        vkc_allocator_add(&counters->frees, 1);
+        vkc_allocator_drift(allocator, shard, track, -(uint64_t) usable);
+    }
+
+    if (&allocator->retired == shard) {
+        pthread_mutex_unlock(&allocator->lock);
+    }
+}
 
-    PageAllocator* allocator = (PageAllocator*) pUserData;
+static void
+vkc_allocator_snapshot(VkcAllocatorContext* allocator, size_t track, VkcAllocatorScopeStats* out) {
+    *out = (VkcAllocatorScopeStats) {0};
+
+    uint64_t live = atomic_load_explicit(&allocator->totals[track].live, memory_order_relaxed);
+    for (VkcAllocatorShard* shard = allocator->shards; shard; shard = shard->next) {
+        VkcAllocatorCounters* c = &shard->tracks[track];
+        live += atomic_load_explicit(&c->live, memory_order_relaxed);
+        out->allocations += atomic_load_explicit(&c->allocations, memory_order_relaxed);
+        out->frees += atomic_load_explicit(&c->frees, memory_order_relaxed);
+        out->reallocations += atomic_load_explicit(&c->reallocations, memory_order_relaxed);
+        out->growths += atomic_load_explicit(&c->growths, memory_order_relaxed);
+        out->in_place += atomic_load_explicit(&c->in_place, memory_order_relaxed);
+        for (size_t bin = 0; bin < VKC_ALLOCATOR_HISTOGRAM_BINS; bin++) {
+            out->histogram[bin] += atomic_load_explicit(&c->histogram[bin], memory_order_relaxed);
+        }
+    }
+
+    VkcAllocatorCounters* retired = &allocator->retired.tracks[track];
+    live += atomic_load_explicit(&retired->live, memory_order_relaxed);
+    out->allocations += atomic_load_explicit(&retired->allocations, memory_order_relaxed);
+    out->frees += atomic_load_explicit(&retired->frees, memory_order_relaxed);
+    out->reallocations += atomic_load_explicit(&retired->reallocations, memory_order_relaxed);
+    out->growths += atomic_load_explicit(&retired->growths, memory_order_relaxed);
+    out->in_place += atomic_load_explicit(&retired->in_place, memory_order_relaxed);
+    for (size_t bin = 0; bin < VKC_ALLOCATOR_HISTOGRAM_BINS; bin++) {
+        out->histogram[bin] += atomic_load_explicit(&retired->histogram[bin], memory_order_relaxed);
+    }
+
+    // Transient cross-thread frees can briefly drive the sum negative.
+    out->live_bytes = (int64_t) live < 0 ? 0 : live;
+    uint64_t peak = atomic_load_explicit(&allocator->totals[track].peak, memory_order_relaxed);
+    out->peak_bytes = peak > out->live_bytes ? peak : out->live_bytes;
+}
+
+static VkcAllocatorNode* vkc_allocator_node_create(int node) {
+    VkcAllocatorNode* local = calloc(1, sizeof(*local));
+    if (!local) {
+        return NULL;
+    }
+
+    local->command = vkc_arena_create(VKC_ALLOCATOR_COMMAND_CHUNK, node);
+    bool slabs = true;
+    for (size_t scope = 0; scope < VKC_ALLOCATOR_SCOPE_COUNT; scope++) {
+        if (VK_SYSTEM_ALLOCATION_SCOPE_COMMAND != scope) {
+            local->slabs[scope] = vkc_slab_create(node);
+            slabs = slabs && local->slabs[scope];
+        }
+    }
+
+    if (!local->command || !slabs) {
+        vkc_arena_destroy(local->command);
+        for (size_t scope = 0; scope < VKC_ALLOCATOR_SCOPE_COUNT; scope++) {
+            vkc_slab_destroy(local->slabs[scope]);
+        }
+        free(local);
+        return NULL;
+    }
+
+    return local;
+}
+
+/**
+ * @brief Node the calling thread allocates from: the context's hint, else its CPU's node.
+ */
+static inline int vkc_allocator_node_index(VkcAllocatorContext* allocator) {
+    int node = atomic_load_explicit(&allocator->node, memory_order_relaxed);
+    return VKC_NUMA_NODE_ANY == node ? vkc_numa_node_current() : node;
+}
+
+/**
+ * @brief Strategies for a node, created by the node's first allocation.
+ *
+ * Falls back to the home node's strategies when a set cannot be created.
+ */
+static VkcAllocatorNode* vkc_allocator_node(VkcAllocatorContext* allocator, int node) {
+    VkcAllocatorNode* local = atomic_load_explicit(&allocator->nodes[node], memory_order_acquire);
+    if (local) {
+        return local;
+    }
+
+    pthread_mutex_lock(&allocator->lock);
+    local = atomic_load_explicit(&allocator->nodes[node], memory_order_relaxed);
+    if (!local) {
+        local = vkc_allocator_node_create(node);
+        if (local) {
+            atomic_store_explicit(&allocator->nodes[node], local, memory_order_release);
+            size_t count = atomic_load_explicit(&allocator->node_count, memory_order_relaxed);
+            if ((size_t) node >= count) {
+                atomic_store_explicit(
+                    &allocator->node_count, (size_t) node + 1, memory_order_release
+                );
+            }
+        }
+    }
+    pthread_mutex_unlock(&allocator->lock);
+
+    if (!local) {
+        LOG_ERROR(
+            "[VkcAllocator] Failed to create strategies for node %d; using node %d.",
+            node,
+            allocator->home
+        );
+        local = atomic_load_explicit(&allocator->nodes[allocator->home], memory_order_acquire);
+    }
+    return local;
+}
+
+static inline size_t vkc_allocator_granules(size_t size) {
+    return (size + VKC_EXTENT_GRANULE - 1) & ~(VKC_EXTENT_GRANULE - 1);
+}
+
+/**
+ * @brief Whether a dedicated block of `size` bytes is backed by huge pages.
+ */
+static inline bool vkc_allocator_is_huge(VkcAllocatorContext* allocator, size_t size) {
+    return size >= VKC_EXTENT_HUGE && VKC_EXTENT_PAGES_BASE != allocator->pages
+           && size <= SIZE_MAX - 2 * VKC_EXTENT_HUGE;
+}
+
+static inline size_t vkc_allocator_mapped(VkcAllocatorContext* allocator, size_t size) {
+    if (vkc_allocator_is_huge(allocator, size)) {
+        return (size + VKC_EXTENT_HUGE - 1) & ~(VKC_EXTENT_HUGE - 1);
+    }
+    return vkc_allocator_granules(size);
+}
+
+static inline bool vkc_allocator_is_large(size_t size, size_t alignment) {
+    return size >= VKC_ALLOCATOR_LARGE && alignment <= VKC_EXTENT_GRANULE
+           && size <= SIZE_MAX - VKC_EXTENT_GRANULE;
+}
+
+static inline uint64_t vkc_allocator_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief Bits of the huge pages `size` bytes starting at page `first` cover.
+ */
+static inline uint64_t vkc_allocator_huge_run(size_t first, size_t size) {
+    size_t count = size / VKC_EXTENT_HUGE;
+    return (count >= 64 ? ~0ull : ((1ull << count) - 1)) << first;
+}
+
+/**
+ * @brief Take the first free run of `mapped` bytes from an arena. Caller holds the lock.
+ */
+static uint8_t* vkc_allocator_huge_take(VkcAllocatorHuge* arena, size_t mapped) {
+    size_t count = mapped / VKC_EXTENT_HUGE;
+    for (size_t first = 0; first + count <= VKC_ALLOCATOR_HUGE_PAGES; first++) {
+        uint64_t run = vkc_allocator_huge_run(first, mapped);
+        if (0 == (arena->used & run)) {
+            arena->used |= run;
+            arena->resident |= run;
+            return arena->base + first * VKC_EXTENT_HUGE;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Carve `mapped` bytes (whole huge pages) from the node's huge arenas.
+ *
+ * Reserves a new arena when none has room. Freed runs stay resident for the next
+ * block, so a driver cache or staging buffer that is reallocated every frame does
+ * not fault its pages in again.
+ */
+static uint8_t* vkc_allocator_huge_carve(
+    VkcAllocatorContext* allocator, size_t mapped, int node, VkcAllocatorHuge** arena
+) {
+    VkcExtentPages request = allocator->pages;
+    pthread_mutex_lock(&allocator->lock);
+    for (VkcAllocatorHuge* it = allocator->huge; it; it = it->next) {
+        if (it->node != node || it->request != request) {
+            continue;
+        }
+        uint8_t* base = vkc_allocator_huge_take(it, mapped);
+        if (base) {
+            pthread_mutex_unlock(&allocator->lock);
+            *arena = it;
+            return base;
+        }
+    }
+    pthread_mutex_unlock(&allocator->lock);
+
+    VkcAllocatorHuge* fresh = calloc(1, sizeof(*fresh));
+    if (!fresh) {
+        return NULL;
+    }
+
+    fresh->request = request;
+    fresh->pages = request;
+    fresh->node = node;
+    fresh->base = vkc_extent_map_huge(VKC_ALLOCATOR_HUGE_ARENA, &fresh->pages);
+    if (!fresh->base) {
+        free(fresh);
+        return NULL;
+    }
+    vkc_numa_bind(fresh->base, VKC_ALLOCATOR_HUGE_ARENA, node);
+
+    uint8_t* base = vkc_allocator_huge_take(fresh, mapped);
+    pthread_mutex_lock(&allocator->lock);
+    fresh->next = allocator->huge;
+    allocator->huge = fresh;
+    pthread_mutex_unlock(&allocator->lock);
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcAllocatorContext] Reserved huge arena @ %p (pages=%d, node=%d).",
+        (void*) fresh->base,
+        (int) fresh->pages,
+        node
+    );
+#endif
+
+    *arena = fresh;
+    return base;
+}
+
+/**
+ * @brief Hand a carved run back to its arena; its pages stay mapped and resident.
+ */
+static void vkc_allocator_huge_release(
+    VkcAllocatorContext* allocator, VkcAllocatorHuge* arena, const VkcExtent* extent
+) {
+    size_t first = (size_t) ((uint8_t*) extent->base - arena->base) / VKC_EXTENT_HUGE;
+    pthread_mutex_lock(&allocator->lock);
+    arena->used &= ~vkc_allocator_huge_run(first, extent->size);
+    if (0 == arena->used) {
+        arena->idle = vkc_allocator_now();
+    }
+    pthread_mutex_unlock(&allocator->lock);
+}
+
+/**
+ * @brief Unmap empty arenas idle for `idle_ns`; with `purge`, drop the free pages of the rest.
+ *
+ * @return Bytes of resident pages returned.
+ */
+static size_t
+vkc_allocator_huge_trim(VkcAllocatorContext* allocator, uint64_t idle_ns, bool purge) {
+    uint64_t now = vkc_allocator_now();
+    size_t returned = 0;
+    pthread_mutex_lock(&allocator->lock);
+    VkcAllocatorHuge** link = &allocator->huge;
+    while (*link) {
+        VkcAllocatorHuge* arena = *link;
+        uint64_t spare = arena->resident & ~arena->used;
+        size_t pages = (size_t) __builtin_popcountll(spare);
+        if (0 == arena->used && now - arena->idle >= idle_ns) {
+            *link = arena->next;
+            vkc_extent_unmap(arena->base, VKC_ALLOCATOR_HUGE_ARENA);
+            free(arena);
+            returned += pages * VKC_EXTENT_HUGE;
+            continue;
+        }
+
+        for (size_t page = 0; purge && page < VKC_ALLOCATOR_HUGE_PAGES; page++) {
+            if (spare & (1ull << page)) {
+                vkc_extent_purge(arena->base + page * VKC_EXTENT_HUGE, VKC_EXTENT_HUGE);
+            }
+        }
+        if (purge) {
+            arena->resident = arena->used;
+            returned += pages * VKC_EXTENT_HUGE;
+        }
+        link = &arena->next;
+    }
+    pthread_mutex_unlock(&allocator->lock);
+    return returned;
+}
+
+static void* vkc_allocator_large_malloc(
+    VkcAllocatorContext* allocator, size_t size, size_t scope, int node
+) {
+    VkcAllocatorLarge* large = calloc(1, sizeof(*large));
+    if (!large) {
+        return NULL;
+    }
+
+    size_t mapped = vkc_allocator_mapped(allocator, size);
+    VkcExtentPages pages = VKC_EXTENT_PAGES_BASE;
+    void* base = NULL;
+    if (vkc_allocator_is_huge(allocator, size) && mapped <= VKC_ALLOCATOR_HUGE_CARVE) {
+        base = vkc_allocator_huge_carve(allocator, mapped, node, &large->arena);
+        pages = large->arena ? large->arena->pages : VKC_EXTENT_PAGES_BASE;
+    } else if (vkc_allocator_is_huge(allocator, size)) {
+        pages = allocator->pages;
+        base = vkc_extent_map_huge(mapped, &pages);
+        vkc_numa_bind(base, mapped, node);
+    } else {
+        base = vkc_extent_map(mapped);
+        vkc_numa_bind(base, mapped, node);
+    }
+
+    large->extent = (VkcExtent) {
+        .base = base,
+        .size = mapped,
+        .kind = VKC_EXTENT_LARGE,
+        .owner = allocator,
+    };
+    large->size = size;
+    large->scope = scope;
+    large->pages = pages;
+
+    if (!large->extent.base) {
+        free(large);
+        return NULL;
+    }
+
+    if (!vkc_extent_register(&large->extent)) {
+        if (large->arena) {
+            vkc_allocator_huge_release(allocator, large->arena, &large->extent);
+        } else {
+            vkc_extent_unmap(large->extent.base, large->extent.size);
+        }
+        free(large);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&allocator->lock);
+    large->next = allocator->large;
+    if (allocator->large) {
+        allocator->large->prev = large;
+    }
+    allocator->large = large;
+    pthread_mutex_unlock(&allocator->lock);
+
+    return large->extent.base;
+}
+
+static void vkc_allocator_large_free(VkcAllocatorLarge* large) {
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) large->extent.owner;
+    pthread_mutex_lock(&allocator->lock);
+    if (large->prev) {
+        large->prev->next = large->next;
+    } else {
+        allocator->large = large->next;
+    }
+    if (large->next) {
+        large->next->prev = large->prev;
+    }
+    pthread_mutex_unlock(&allocator->lock);
+
+    vkc_extent_deregister(&large->extent);
+    if (large->arena) {
+        vkc_allocator_huge_release(allocator, large->arena, &large->extent);
+    } else {
+        vkc_extent_unmap(large->extent.base, large->extent.size);
+    }
+    free(large);
+}
+
+/**
+ * @brief Resize a dedicated mapping with mremap(): in place if possible, never copying.
+ *
+ * @return The block's address, or NULL with the block left as it was, still registered.
+ */
+static void* vkc_allocator_large_realloc(VkcAllocatorLarge* large, size_t size) {
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) large->extent.owner;
+    size_t mapped = vkc_allocator_mapped(allocator, size);
+    if (mapped == large->extent.size) {
+        large->size = size;
+        return large->extent.base;
+    }
+
+    // Huge blocks keep their 2 MiB alignment if they have to move.
+    size_t alignment = vkc_allocator_is_huge(allocator, size) ? VKC_EXTENT_HUGE : 0;
+    if (!vkc_extent_resize(&large->extent, mapped, alignment)) {
+        return NULL;
+    }
+
+    large->size = size;
+    if (vkc_allocator_is_huge(allocator, size)) {
+        // Blocks that grew past the threshold start asking for huge pages here.
+        large->pages = VKC_EXTENT_PAGES_ADVISE;
+        vkc_extent_advise(large->extent.base, large->extent.size);
+    }
+    return large->extent.base;
+}
+
+/**
+ * @brief Allocate a block without touching the counters.
+ *
+ * @param usable Receives the block's usable size.
+ */
+static void* vkc_allocator_place(
+    VkcAllocatorContext* allocator,
+    size_t size,
+    size_t alignment,
+    VkSystemAllocationScope scope,
+    size_t* usable
+) {
+    void* address = NULL;
+    int node = vkc_allocator_node_index(allocator);
+    VkcAllocatorNode* local = vkc_allocator_node(allocator, node);
+    if (VK_SYSTEM_ALLOCATION_SCOPE_COMMAND == scope) {
+        if (vkc_arena_accepts(local->command, size, alignment)) {
+            address = vkc_arena_malloc(local->command, size, alignment);
+            *usable = size;
+        }
+    } else if ((size_t) scope < VKC_ALLOCATOR_SCOPE_COUNT) {
+        *usable = vkc_slab_usable(size, alignment);
+        if (*usable) {
+            address = vkc_slab_malloc(local->slabs[scope], size, alignment);
+        }
+    }
+
+    if (address) {
+        return address;
+    }
+
+    if (vkc_allocator_is_large(size, alignment)) {
+        *usable = size;
+        return vkc_allocator_large_malloc(
+            allocator, size, vkc_allocator_scope_index(scope), node
+        );
+    }
+
+    size_t offset = vkc_allocator_offset(alignment);
+    if (size > SIZE_MAX - offset) {
+        return NULL;
+    }
+
+    uint8_t* block = page_malloc(allocator->pager, size + offset, alignment);
+    if (!block) {
+        return NULL;
+    }
+
+    address = block + offset;
+    *vkc_allocator_header(address) = (VkcAllocatorHeader) {
+        .size = size,
+        .scope = (uint32_t) vkc_allocator_scope_index(scope),
+        .offset = (uint32_t) offset,
+    };
+    *usable = size;
+    return address;
+}
+
+/**
+ * @brief Release a block without touching the counters.
+ */
+static void
+vkc_allocator_discard(VkcAllocatorContext* allocator, VkcExtent* extent, void* address) {
+    if (extent && VKC_EXTENT_SLAB == extent->kind) {
+        vkc_slab_free((VkcSlab*) extent->owner, address);
+    } else if (extent && VKC_EXTENT_ARENA == extent->kind) {
+        vkc_arena_free((VkcArena*) extent->owner, address);
+    } else if (extent && VKC_EXTENT_LARGE == extent->kind) {
+        vkc_allocator_large_free((VkcAllocatorLarge*) extent);
+    } else {
+        page_free(allocator->pager, (uint8_t*) address - vkc_allocator_header(address)->offset);
+    }
+}
+
+/**
+ * @brief Usable size and scope index of a live block.
+ */
+static size_t vkc_allocator_usable(
+    VkcAllocatorContext* allocator, const VkcExtent* extent, const void* address, size_t* scope
+) {
+    if (extent && VKC_EXTENT_SLAB == extent->kind) {
+        // Usually one node set, two on a dual-socket host.
+        size_t count = atomic_load_explicit(&allocator->node_count, memory_order_acquire);
+        for (size_t node = 0; node < count; node++) {
+            VkcAllocatorNode* local
+                = atomic_load_explicit(&allocator->nodes[node], memory_order_acquire);
+            for (size_t i = 0; local && i < VKC_ALLOCATOR_SCOPE_COUNT; i++) {
+                if (local->slabs[i] == extent->owner) {
+                    *scope = i;
+                    return vkc_slab_size(address);
+                }
+            }
+        }
+        return vkc_slab_size(address);
+    }
+    if (extent && VKC_EXTENT_ARENA == extent->kind) {
+        *scope = VK_SYSTEM_ALLOCATION_SCOPE_COMMAND;
+        return vkc_arena_size(address);
+    }
+    if (extent && VKC_EXTENT_LARGE == extent->kind) {
+        *scope = ((VkcAllocatorLarge*) extent)->scope;
+        return ((VkcAllocatorLarge*) extent)->size;
+    }
+
+    VkcAllocatorHeader* header = vkc_allocator_header(address);
+    *scope = header->scope;
+    return header->size;
+}
+
+/**
+ * @brief Resize a block without moving it: size-class slack, arena tail, or a shrink.
+ *
+ * @param usable Receives the block's new usable size.
+ */
+static bool vkc_allocator_resize(
+    const VkcExtent* extent, void* address, size_t size, size_t alignment, size_t* usable
+) {
+    if (0 != ((uintptr_t) address & (alignment - 1))) {
+        return false;
+    }
+
+    if (extent && VKC_EXTENT_SLAB == extent->kind) {
+        size_t slack = vkc_slab_size(address);
+        if (vkc_slab_usable(size, alignment) == slack) {
+            *usable = slack;
+            return true;
+        }
+        return false;
+    }
+
+    if (extent && VKC_EXTENT_ARENA == extent->kind) {
+        if (vkc_arena_resize((VkcArena*) extent->owner, address, size)) {
+            *usable = size;
+            return true;
+        }
+        return false;
+    }
+
+    if (NULL == extent) {
+        // Tracked blocks can always give bytes back without moving.
+        VkcAllocatorHeader* header = vkc_allocator_header(address);
+        if (size <= header->size) {
+            header->size = size;
+            *usable = size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void* VKAPI_CALL
+vkc_malloc(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) pUserData;
     if (NULL == allocator) {
-        LOG_ERROR("[VK_ALLOC] Missing allocation context (PageAllocator)");
+        LOG_ERROR("[VK_ALLOC] Missing allocation context (VkcAllocatorContext)");
         return NULL;
     }
 
-    void* address = page_malloc(allocator, size, alignment);
+    if (0 == size) {
+        return NULL;
+    }
+
+    size_t usable = 0;
+    void* address = vkc_allocator_place(allocator, size, alignment, scope, &usable);
+    VkcTrace* trace = atomic_load_explicit(&allocator->trace, memory_order_acquire);
+    if (trace) {
+        vkc_trace_record(trace, VKC_TRACE_ALLOCATE, NULL, address, size, alignment, scope);
+    }
     if (NULL == address) {
-        LOG_ERROR("[VK_ALLOC] Allocation failed (size=%zu, align=%zu)", size, alignment);
+        LOG_ERROR(
+            "[VK_ALLOC] Allocation failed (size=%zu, align=%zu, scope=%d)",
+            size,
+            alignment,
+            (int) scope
+        );
         return NULL;
     }
 
+    size_t index = vkc_allocator_scope_index(scope);
+    vkc_allocator_record(allocator, VKC_ALLOCATOR_EVENT_ALLOCATE, index, usable, size);
     return address;
 }
 
-void* VKAPI_CALL vkc_realloc(
+static void VKAPI_CALL vkc_free(void* pUserData, void* pMemory) {
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) pUserData;
+    if (NULL == allocator || NULL == pMemory) {
+        return;
+    }
+
+    // Record before releasing, so the address cannot be handed out again first.
+    VkcTrace* trace = atomic_load_explicit(&allocator->trace, memory_order_acquire);
+    if (trace) {
+        vkc_trace_record(trace, VKC_TRACE_FREE, pMemory, NULL, 0, 0, 0);
+    }
+
+    size_t index = 0;
+    VkcExtent* extent = vkc_extent_lookup(pMemory);
+    size_t usable = vkc_allocator_usable(allocator, extent, pMemory, &index);
+    vkc_allocator_record(allocator, VKC_ALLOCATOR_EVENT_FREE, index, usable, usable);
+    vkc_allocator_discard(allocator, extent, pMemory);
+}
+
+static void* VKAPI_CALL vkc_realloc(
     void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope
 ) {
-    (void) scope;
-
-    PageAllocator* allocator = (PageAllocator*) pUserData;
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) pUserData;
     if (NULL == allocator) {
-        LOG_ERROR("[VK_REALLOC] Missing allocation context (PageAllocator)");
+        LOG_ERROR("[VK_REALLOC] Missing allocation context (VkcAllocatorContext)");
         return NULL;
     }
 
-    void* address = page_realloc(allocator, pOriginal, size, alignment);
+    if (NULL == pOriginal) {
+        return vkc_malloc(pUserData, size, alignment, scope);
+    }
+
+    if (0 == size) {
+        vkc_free(pUserData, pOriginal);
+        return NULL;
+    }
+
+    size_t old_scope = 0;
+    VkcExtent* extent = vkc_extent_lookup(pOriginal);
+    size_t old_size = vkc_allocator_usable(allocator, extent, pOriginal, &old_scope);
+
+    if (0 == alignment) {
+        alignment = 1;
+    }
+
+    void* address = NULL;
+    size_t new_size = size;
+    size_t new_scope = old_scope; // Blocks that stay put keep their scope
+    VkcAllocatorHeader* header = vkc_allocator_header(pOriginal);
+    // Blocks growing past the slab range tend to keep growing: give them a mapping of their
+    // own so the next growths stay in place or are remapped instead of copied.
+    bool dedicated = size > VKC_SLAB_MAX && alignment <= VKC_EXTENT_GRANULE
+                     && size <= SIZE_MAX - VKC_EXTENT_GRANULE;
+
+    bool copy = false;
+    if (vkc_allocator_resize(extent, pOriginal, size, alignment, &new_size)) {
+        address = pOriginal;
+    } else if (extent && VKC_EXTENT_LARGE == extent->kind && dedicated
+               && !((VkcAllocatorLarge*) extent)->arena
+               && VKC_EXTENT_PAGES_HUGETLB != ((VkcAllocatorLarge*) extent)->pages) {
+        // hugetlbfs mappings skip this: mremap() cannot move them, so they are copied below.
+        // So do runs carved from a huge arena, and blocks mremap() could not grow; they
+        // are left intact for the copy.
+        address = vkc_allocator_large_realloc((VkcAllocatorLarge*) extent, size);
+        copy = !address;
+    } else if (NULL == extent && !dedicated && vkc_allocator_offset(alignment) == header->offset) {
+        // Tracked blocks know their own size; let the pager move them, header included.
+        size_t offset = header->offset;
+        uint8_t* block = page_realloc(
+            allocator->pager, (uint8_t*) pOriginal - offset, size + offset, alignment
+        );
+        if (block) {
+            address = block + offset;
+            vkc_allocator_header(address)->size = size;
+        }
+    } else {
+        copy = true;
+    }
+
+    if (copy) {
+        new_scope = vkc_allocator_scope_index(scope);
+        if (dedicated && size > old_size) {
+            int node = vkc_allocator_node_index(allocator);
+            address = vkc_allocator_large_malloc(allocator, size, new_scope, node);
+        } else {
+            address = vkc_allocator_place(allocator, size, alignment, scope, &new_size);
+        }
+        if (address) {
+            memcpy(address, pOriginal, old_size < size ? old_size : size);
+            vkc_allocator_discard(allocator, extent, pOriginal);
+        }
+    }
+
+    VkcTrace* trace = atomic_load_explicit(&allocator->trace, memory_order_acquire);
+    if (trace) {
+        vkc_trace_record(trace, VKC_TRACE_REALLOCATE, pOriginal, address, size, alignment, scope);
+    }
+
     if (!address) {
         LOG_ERROR(
             "[VK_REALLOC] Allocation failed (pOriginal=%p, size=%zu, align=%zu)",
@@ -52,19 +985,122 @@ void* VKAPI_CALL vkc_realloc(
             size,
             alignment
         );
-        return NULL;
+        return NULL; // The original block remains valid
+    }
+
+    VkcAllocatorShard* shard = vkc_allocator_shard(allocator);
+    if (!shard) {
+        pthread_mutex_lock(&allocator->lock);
+        shard = &allocator->retired;
+    }
+    vkc_allocator_drift(allocator, shard, old_scope, -(uint64_t) old_size);
+    vkc_allocator_drift(allocator, shard, new_scope, new_size);
+    vkc_allocator_add(&shard->tracks[new_scope].reallocations, 1);
+    if (size > old_size) {
+        vkc_allocator_add(&shard->tracks[new_scope].growths, 1);
+    }
+    if (address == pOriginal) {
+        vkc_allocator_add(&shard->tracks[new_scope].in_place, 1);
+    }
+    if (&allocator->retired == shard) {
+        pthread_mutex_unlock(&allocator->lock);
     }
 
     return address;
 }
 
-void VKAPI_CALL vkc_free(void* pUserData, void* pMemory) {
-    PageAllocator* allocator = (PageAllocator*) pUserData;
-    if (NULL == allocator || NULL == pMemory) {
-        return;
+static void VKAPI_CALL vkc_internal_malloc(
+    void* pUserData,
+    size_t size,
+    VkInternalAllocationType allocationType,
+    VkSystemAllocationScope allocationScope
+) {
+    (void) allocationType;
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) pUserData;
+    if (allocator) {
+        size_t track = VKC_ALLOCATOR_SCOPE_COUNT + vkc_allocator_scope_index(allocationScope);
+        vkc_allocator_record(allocator, VKC_ALLOCATOR_EVENT_ALLOCATE, track, size, size);
+    }
+}
+
+static void VKAPI_CALL vkc_internal_free(
+    void* pUserData,
+    size_t size,
+    VkInternalAllocationType allocationType,
+    VkSystemAllocationScope allocationScope
+) {
+    (void) allocationType;
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) pUserData;
+    if (allocator) {
+        size_t track = VKC_ALLOCATOR_SCOPE_COUNT + vkc_allocator_scope_index(allocationScope);
+        vkc_allocator_record(allocator, VKC_ALLOCATOR_EVENT_FREE, track, size, size);
+    }
+}
+
+/**
+ * @brief Resident set size of the process in bytes, or 0 when unknown.
+ */
+static size_t vkc_allocator_rss(void) {
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+
+    unsigned long pages = 0;
+    unsigned long resident = 0;
+    if (2 != fscanf(file, "%lu %lu", &pages, &resident)) {
+        resident = 0;
+    }
+    fclose(file);
+    return (size_t) resident * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+static void* vkc_allocator_trimmer(void* arg) {
+    VkcAllocatorContext* allocator = (VkcAllocatorContext*) arg;
+
+    pthread_mutex_lock(&allocator->trim_lock);
+    while (allocator->trimming) {
+        uint64_t interval = allocator->trim_policy.interval_ns;
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t) (interval / 1000000000ull);
+        deadline.tv_nsec += (long) (interval % 1000000000ull);
+        if (deadline.tv_nsec >= 1000000000l) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000l;
+        }
+
+        int waited
+            = pthread_cond_timedwait(&allocator->trim_wake, &allocator->trim_lock, &deadline);
+        if (ETIMEDOUT != waited) {
+            continue; // Signaled: stop, or restart the interval under a new policy
+        }
+
+        VkcAllocatorTrimPolicy policy = allocator->trim_policy;
+        pthread_mutex_unlock(&allocator->trim_lock);
+
+        // Under memory pressure drop everything idle now, including free slab pages.
+        bool pressure = policy.rss_limit && vkc_allocator_rss() > policy.rss_limit;
+        vkc_allocator_context_trim(allocator, pressure ? 0 : policy.idle_ns, pressure);
+
+        pthread_mutex_lock(&allocator->trim_lock);
     }
+    pthread_mutex_unlock(&allocator->trim_lock);
 
-    page_free(allocator, pMemory);
+    return NULL;
+}
+
+static void vkc_allocator_trimmer_stop(VkcAllocatorContext* allocator) {
+    pthread_mutex_lock(&allocator->trim_lock);
+    bool running = allocator->trimming;
+    pthread_t trimmer = allocator->trimmer;
+    allocator->trimming = false;
+    pthread_cond_signal(&allocator->trim_wake);
+    pthread_mutex_unlock(&allocator->trim_lock);
+
+    if (running) {
+        pthread_join(trimmer, NULL);
+    }
 }
 
 /** @} */
@@ -74,29 +1110,302 @@ void VKAPI_CALL vkc_free(void* pUserData, void* pMemory) {
  * {@
  */
 
-static PageAllocator* _vkc_allocator = NULL;
-static VkAllocationCallbacks _vkc_callbacks = {0};
+static VkcAllocatorContext* _vkc_allocator = NULL;
+static VkcTrace* _vkc_trace = NULL; /**< Recorder requested through VKC_ALLOCATOR_TRACE. */
 
-bool vkc_allocator_create(void) {
-    if (_vkc_allocator) {
-        return true; // Already initialized
+static void vkc_allocator_release(VkcAllocatorContext* allocator) {
+    vkc_allocator_trimmer_stop(allocator);
+    pthread_cond_destroy(&allocator->trim_wake);
+    pthread_mutex_destroy(&allocator->trim_lock);
+
+    // Deleting the key first keeps exiting threads from touching a dead allocator.
+    pthread_key_delete(allocator->key);
+    while (allocator->shards) {
+        VkcAllocatorShard* shard = allocator->shards;
+        allocator->shards = shard->next;
+        free(shard);
+    }
+    pthread_mutex_destroy(&allocator->lock);
+
+    // One unmap per dedicated mapping or huge arena; small blocks go away with their
+    // arena chunk or slab.
+    while (allocator->large) {
+        VkcAllocatorLarge* large = allocator->large;
+        allocator->large = large->next;
+        vkc_extent_deregister(&large->extent);
+        if (!large->arena) {
+            vkc_extent_unmap(large->extent.base, large->extent.size);
+        }
+        free(large);
+    }
+    while (allocator->huge) {
+        VkcAllocatorHuge* arena = allocator->huge;
+        allocator->huge = arena->next;
+        vkc_extent_unmap(arena->base, VKC_ALLOCATOR_HUGE_ARENA);
+        free(arena);
+    }
+
+    for (size_t node = 0; node < VKC_NUMA_NODE_MAX; node++) {
+        VkcAllocatorNode* local = atomic_load(&allocator->nodes[node]);
+        if (local) {
+            vkc_arena_destroy(local->command);
+            for (size_t scope = 0; scope < VKC_ALLOCATOR_SCOPE_COUNT; scope++) {
+                vkc_slab_destroy(local->slabs[scope]);
+            }
+            free(local);
+        }
+    }
+    if (allocator->pager) {
+        page_allocator_free(allocator->pager);
+    }
+    free(allocator);
+}
+
+/**
+ * @brief Resolve NULL to the global context.
+ */
+static VkcAllocatorContext* vkc_allocator_context_resolve(VkcAllocatorContext* context) {
+    if (context) {
+        return context;
     }
 
-    _vkc_allocator = page_allocator_create(1);
     if (!_vkc_allocator) {
-        LOG_ERROR("[VkcAllocator] Failed to create global PageAllocator.");
-        return false;
+        LOG_ERROR("[VkcAllocator] Global Vulkan allocator is unintialized!");
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        LOG_DEBUG("[VkcAllocator] Use `vkc_allocator_create()` to initialize the allocator.");
+#endif
     }
 
-    _vkc_callbacks = (VkAllocationCallbacks) {
-        .pUserData = _vkc_allocator,
+    return _vkc_allocator;
+}
+
+VkcAllocatorContext* vkc_allocator_context_create(void) {
+    VkcAllocatorContext* context = calloc(1, sizeof(*context));
+    if (!context) {
+        LOG_ERROR("[VkcAllocatorContext] Failed to allocate context.");
+        return NULL;
+    }
+
+    if (0 != pthread_mutex_init(&context->lock, NULL)) {
+        LOG_ERROR("[VkcAllocatorContext] Failed to initialize telemetry lock.");
+        free(context);
+        return NULL;
+    }
+
+    if (0 != pthread_key_create(&context->key, vkc_allocator_shard_exit)) {
+        LOG_ERROR("[VkcAllocatorContext] Failed to create telemetry key.");
+        pthread_mutex_destroy(&context->lock);
+        free(context);
+        return NULL;
+    }
+
+    // The trimmer sleeps on a monotonic clock so wall-clock jumps cannot stall it.
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    int wake = pthread_cond_init(&context->trim_wake, &attributes);
+    pthread_condattr_destroy(&attributes);
+    if (0 != wake || 0 != pthread_mutex_init(&context->trim_lock, NULL)) {
+        LOG_ERROR("[VkcAllocatorContext] Failed to initialize the trimmer.");
+        if (0 == wake) {
+            pthread_cond_destroy(&context->trim_wake);
+        }
+        pthread_key_delete(context->key);
+        pthread_mutex_destroy(&context->lock);
+        free(context);
+        return NULL;
+    }
+
+    context->pages = VKC_EXTENT_PAGES_ADVISE;
+    context->pager = page_allocator_create(1);
+    // Other nodes get their strategies when a thread there first allocates.
+    context->home = vkc_numa_node_current();
+    atomic_init(&context->node, VKC_NUMA_NODE_ANY);
+    VkcAllocatorNode* home = vkc_allocator_node_create(context->home);
+    if (home) {
+        atomic_init(&context->nodes[context->home], home);
+        atomic_init(&context->node_count, (size_t) context->home + 1);
+    }
+    if (!context->pager || !home) {
+        LOG_ERROR("[VkcAllocatorContext] Failed to create allocation strategies.");
+        vkc_allocator_release(context);
+        return NULL;
+    }
+
+    context->callbacks = (VkAllocationCallbacks) {
+        .pUserData = context,
         .pfnAllocation = vkc_malloc,
         .pfnReallocation = vkc_realloc,
         .pfnFree = vkc_free,
-        .pfnInternalAllocation = NULL,
-        .pfnInternalFree = NULL,
+        .pfnInternalAllocation = vkc_internal_malloc,
+        .pfnInternalFree = vkc_internal_free,
     };
 
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcAllocatorContext] Created allocation context @ %p.", (void*) context);
+#endif
+
+    return context;
+}
+
+void vkc_allocator_context_destroy(VkcAllocatorContext* context) {
+    if (context) {
+        vkc_allocator_release(context);
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        LOG_DEBUG("[VkcAllocatorContext] Destroyed allocation context @ %p.", (void*) context);
+#endif
+    }
+}
+
+PageAllocator* vkc_allocator_context_pager(VkcAllocatorContext* context) {
+    context = vkc_allocator_context_resolve(context);
+    return context ? context->pager : NULL;
+}
+
+const VkAllocationCallbacks* vkc_allocator_context_callbacks(VkcAllocatorContext* context) {
+    context = vkc_allocator_context_resolve(context);
+    return context ? &context->callbacks : NULL;
+}
+
+bool vkc_allocator_context_stats(VkcAllocatorContext* context, VkcAllocatorStats* stats) {
+    context = vkc_allocator_context_resolve(context);
+    if (!context || !stats) {
+        return false;
+    }
+
+    // The lock only excludes thread arrival and exit; allocating threads never wait on it.
+    pthread_mutex_lock(&context->lock);
+    for (size_t i = 0; i < VKC_ALLOCATOR_SCOPE_COUNT; i++) {
+        vkc_allocator_snapshot(context, i, &stats->scopes[i]);
+        vkc_allocator_snapshot(context, VKC_ALLOCATOR_SCOPE_COUNT + i, &stats->internal[i]);
+    }
+    pthread_mutex_unlock(&context->lock);
+
+    stats->trims = atomic_load_explicit(&context->trims, memory_order_relaxed);
+    stats->trimmed_bytes = atomic_load_explicit(&context->trimmed, memory_order_relaxed);
+    return true;
+}
+
+bool vkc_allocator_context_huge_pages(VkcAllocatorContext* context, VkcExtentPages pages) {
+    context = vkc_allocator_context_resolve(context);
+    if (!context || (size_t) pages > VKC_EXTENT_PAGES_HUGETLB) {
+        return false;
+    }
+
+    context->pages = pages;
+    return true;
+}
+
+bool vkc_allocator_context_node(VkcAllocatorContext* context, int node) {
+    context = vkc_allocator_context_resolve(context);
+    if (!context) {
+        return false;
+    }
+
+    if (VKC_NUMA_NODE_ANY != node && (node < 0 || (size_t) node >= vkc_numa_node_count())) {
+        return false;
+    }
+
+    atomic_store_explicit(&context->node, node, memory_order_relaxed);
+    return true;
+}
+
+size_t vkc_allocator_context_trim(VkcAllocatorContext* context, uint64_t idle_ns, bool purge) {
+    context = vkc_allocator_context_resolve(context);
+    if (!context) {
+        return 0;
+    }
+
+    size_t returned = 0;
+    size_t count = atomic_load_explicit(&context->node_count, memory_order_acquire);
+    for (size_t node = 0; node < count; node++) {
+        VkcAllocatorNode* local = atomic_load_explicit(&context->nodes[node], memory_order_acquire);
+        if (!local) {
+            continue;
+        }
+
+        returned += vkc_arena_trim(local->command, idle_ns, purge);
+        for (size_t scope = 0; scope < VKC_ALLOCATOR_SCOPE_COUNT; scope++) {
+            returned += vkc_slab_trim(local->slabs[scope], idle_ns, purge);
+        }
+    }
+    returned += vkc_allocator_huge_trim(context, idle_ns, purge);
+
+    atomic_fetch_add_explicit(&context->trims, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&context->trimmed, returned, memory_order_relaxed);
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcAllocatorContext] Trimmed %zu bytes (purge=%d).", returned, (int) purge);
+#endif
+
+    return returned;
+}
+
+bool vkc_allocator_context_trim_policy(
+    VkcAllocatorContext* context, const VkcAllocatorTrimPolicy* policy
+) {
+    context = vkc_allocator_context_resolve(context);
+    if (!context) {
+        return false;
+    }
+
+    if (!policy) {
+        vkc_allocator_trimmer_stop(context);
+        return true;
+    }
+
+    pthread_mutex_lock(&context->trim_lock);
+    context->trim_policy = *policy;
+    if (0 == context->trim_policy.interval_ns) {
+        context->trim_policy.interval_ns = VKC_ALLOCATOR_TRIM_INTERVAL;
+    }
+
+    bool started = true;
+    if (context->trimming) {
+        pthread_cond_signal(&context->trim_wake);
+    } else {
+        context->trimming = true;
+        if (0 != pthread_create(&context->trimmer, NULL, vkc_allocator_trimmer, context)) {
+            LOG_ERROR("[VkcAllocatorContext] Failed to start the trimmer thread.");
+            context->trimming = false;
+            started = false;
+        }
+    }
+    pthread_mutex_unlock(&context->trim_lock);
+
+    return started;
+}
+
+bool vkc_allocator_context_trace(VkcAllocatorContext* context, VkcTrace* trace) {
+    context = vkc_allocator_context_resolve(context);
+    if (!context) {
+        return false;
+    }
+
+    atomic_store_explicit(&context->trace, trace, memory_order_release);
+    return true;
+}
+
+bool vkc_allocator_create(void) {
+    if (_vkc_allocator) {
+        return true; // Already initialized
+    }
+
+    _vkc_allocator = vkc_allocator_context_create();
+    if (!_vkc_allocator) {
+        LOG_ERROR("[VkcAllocator] Failed to create global allocator.");
+        return false;
+    }
+
+    // Opt-in capture of the global context for offline replay.
+    const char* path = getenv("VKC_ALLOCATOR_TRACE");
+    if (path && *path) {
+        _vkc_trace = vkc_trace_create(path, 0);
+        vkc_allocator_context_trace(_vkc_allocator, _vkc_trace);
+    }
+
 #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
     LOG_DEBUG("[VkcAllocator] Initialized global Vulkan allocator.");
 #endif
@@ -106,9 +1415,10 @@ bool vkc_allocator_create(void) {
 
 bool vkc_allocator_destroy(void) {
     if (_vkc_allocator) {
-        page_allocator_free(_vkc_allocator);
+        vkc_allocator_context_destroy(_vkc_allocator);
         _vkc_allocator = NULL;
-        memset(&_vkc_callbacks, 0, sizeof(_vkc_callbacks));
+        vkc_trace_destroy(_vkc_trace);
+        _vkc_trace = NULL;
 
 #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
         LOG_DEBUG("[VkcAllocator] Global Vulkan allocator destroyed.");
@@ -125,21 +1435,25 @@ bool vkc_allocator_destroy(void) {
 }
 
 PageAllocator* vkc_allocator_get(void) {
-    if (!_vkc_allocator) {
-        LOG_ERROR("[VkcAllocator] Global Vulkan allocator is unintialized!");
-
-#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
-        LOG_DEBUG("[VkcAllocator] Use `vkc_allocator_create()` to initialize the allocator.");
-#endif
+    return vkc_allocator_context_pager(NULL);
+}
 
-        return NULL;
-    }
+const VkAllocationCallbacks* vkc_allocator_callbacks(void) {
+    return _vkc_allocator ? &_vkc_allocator->callbacks : NULL;
+}
 
-    return _vkc_allocator;
+bool vkc_allocator_stats(VkcAllocatorStats* stats) {
+    return _vkc_allocator ? vkc_allocator_context_stats(_vkc_allocator, stats) : false;
 }
 
-const VkAllocationCallbacks* vkc_allocator_callbacks(void) {
-    return _vkc_allocator ? &_vkc_callbacks : NULL;
+size_t vkc_allocator_histogram_bin(size_t size) {
+    if (size <= 16) {
+        return 0;
+    }
+
+    // Bin i holds (8 << i, 16 << i]: i == floor(log2(size - 1)) - 3.
+    size_t bin = 63 - (size_t) __builtin_clzll((unsigned long long) (size - 1)) - 3;
+    return bin < VKC_ALLOCATOR_HISTOGRAM_BINS ? bin : VKC_ALLOCATOR_HISTOGRAM_BINS - 1;
 }
 
 /** @} */
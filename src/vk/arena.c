@@ -0,0 +1,492 @@
+/**
+ * @file src/vk/arena.c
+ * @brief Chunked host arenas for scope-aware Vulkan allocations.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/extent.h"
+#include "vk/numa.h"
+#include "vk/arena.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+#define VKC_ARENA_SPARE_MAX 4 // Rewound linear chunks kept for reuse
+
+/**
+ * @brief Inline header stored immediately before each block.
+ */
+typedef struct VkcArenaBlock {
+    size_t size; /**< Requested size in bytes. */
+} VkcArenaBlock;
+
+typedef struct VkcArenaChunk {
+    VkcExtent extent; /**< Must be first: extent lookups cast back to the chunk. */
+    struct VkcArenaChunk* prev;
+    struct VkcArenaChunk* next;
+    struct VkcArenaChunk* spare; /**< Next rewound chunk. */
+    size_t offset; /**< Bump cursor relative to extent.base. */
+    size_t touched; /**< Highest offset carved since the chunk was last purged. */
+    uint64_t idle; /**< When the chunk was last rewound, in CLOCK_MONOTONIC nanoseconds. */
+    atomic_size_t live; /**< Outstanding blocks plus one while a thread carves it. */
+} VkcArenaChunk;
+
+/**
+ * @brief Per-thread arena state. Touched without locks by its thread only.
+ */
+typedef struct VkcArenaThread {
+    VkcArena* arena;
+    struct VkcArenaThread* prev;
+    struct VkcArenaThread* next;
+    VkcArenaChunk* current; /**< Chunk this thread bumps into. */
+} VkcArenaThread;
+
+struct VkcArena {
+    pthread_mutex_t lock; /**< Guards chunks, spares, and the thread list. */
+    pthread_key_t key; /**< Maps each thread to its VkcArenaThread. */
+    size_t chunk_size;
+    int node; /**< NUMA node preferred for chunk pages. */
+    VkcArenaChunk* chunks; /**< Every mapped chunk. */
+    VkcArenaChunk* spare; /**< Rewound chunks kept for reuse. */
+    size_t spare_count;
+    VkcArenaThread* threads; /**< Every thread that touched the arena. */
+};
+
+static inline size_t vkc_arena_align(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline uint64_t vkc_arena_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief Move a chunk's bump cursor, tracking how far into it pages have been touched.
+ */
+static inline void vkc_arena_advance(VkcArenaChunk* chunk, size_t offset) {
+    chunk->offset = offset;
+    if (offset > chunk->touched) {
+        chunk->touched = offset;
+    }
+}
+
+static inline VkcArenaBlock* vkc_arena_block(const void* address) {
+    return (VkcArenaBlock*) address - 1;
+}
+
+static VkcArenaChunk* vkc_arena_chunk(const void* address) {
+    VkcExtent* extent = vkc_extent_lookup(address);
+    if (!extent || VKC_EXTENT_ARENA != extent->kind) {
+        return NULL;
+    }
+    return (VkcArenaChunk*) extent;
+}
+
+/**
+ * @brief Map and register a new chunk. Caller holds the arena lock.
+ */
+static VkcArenaChunk* vkc_arena_chunk_create(VkcArena* arena) {
+    VkcArenaChunk* chunk = calloc(1, sizeof(*chunk));
+    if (!chunk) {
+        LOG_ERROR("[VkcArena] Failed to allocate chunk descriptor.");
+        return NULL;
+    }
+
+    chunk->extent = (VkcExtent) {
+        .base = vkc_extent_map(arena->chunk_size),
+        .size = arena->chunk_size,
+        .kind = VKC_EXTENT_ARENA,
+        .owner = arena,
+    };
+
+    if (!chunk->extent.base) {
+        free(chunk);
+        return NULL;
+    }
+
+    // Place the pages before anything touches them.
+    vkc_numa_bind(chunk->extent.base, chunk->extent.size, arena->node);
+
+    if (!vkc_extent_register(&chunk->extent)) {
+        vkc_extent_unmap(chunk->extent.base, chunk->extent.size);
+        free(chunk);
+        return NULL;
+    }
+
+    chunk->next = arena->chunks;
+    if (arena->chunks) {
+        arena->chunks->prev = chunk;
+    }
+    arena->chunks = chunk;
+
+    return chunk;
+}
+
+/**
+ * @brief Deregister and unmap a chunk. Caller holds the arena lock.
+ */
+static void vkc_arena_chunk_destroy(VkcArena* arena, VkcArenaChunk* chunk) {
+    if (chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        arena->chunks = chunk->next;
+    }
+    if (chunk->next) {
+        chunk->next->prev = chunk->prev;
+    }
+
+    vkc_extent_deregister(&chunk->extent);
+    vkc_extent_unmap(chunk->extent.base, chunk->extent.size);
+    free(chunk);
+}
+
+/**
+ * @brief Bump [header | payload] out of a chunk, or return NULL if it does not fit.
+ */
+static VkcArenaBlock*
+vkc_arena_bump(VkcArenaChunk* chunk, size_t size, size_t alignment) {
+    uintptr_t base = (uintptr_t) chunk->extent.base;
+    uintptr_t payload = vkc_arena_align(base + chunk->offset + sizeof(VkcArenaBlock), alignment);
+    if (payload + size > base + chunk->extent.size) {
+        return NULL;
+    }
+
+    vkc_arena_advance(chunk, vkc_arena_align(payload + size - base, VKC_ARENA_ALIGNMENT));
+    return vkc_arena_block((void*) payload);
+}
+
+/**
+ * @brief Recycle a drained chunk: keep a few rewound, unmap the rest.
+ */
+static void vkc_arena_chunk_recycle(VkcArena* arena, VkcArenaChunk* chunk) {
+    pthread_mutex_lock(&arena->lock);
+    if (arena->spare_count < VKC_ARENA_SPARE_MAX) {
+        chunk->offset = 0;
+        chunk->idle = vkc_arena_now();
+        chunk->spare = arena->spare;
+        arena->spare = chunk;
+        arena->spare_count++;
+    } else {
+        vkc_arena_chunk_destroy(arena, chunk);
+    }
+    pthread_mutex_unlock(&arena->lock);
+}
+
+/**
+ * @brief Drop one reference to a chunk, recycling it on the last one.
+ */
+static void vkc_arena_chunk_release(VkcArena* arena, VkcArenaChunk* chunk) {
+    if (1 == atomic_fetch_sub_explicit(&chunk->live, 1, memory_order_acq_rel)) {
+        vkc_arena_chunk_recycle(arena, chunk);
+    }
+}
+
+/**
+ * @brief Hand a thread a fresh chunk, holding one reference for the carver.
+ */
+static VkcArenaChunk* vkc_arena_chunk_acquire(VkcArena* arena) {
+    pthread_mutex_lock(&arena->lock);
+    VkcArenaChunk* chunk = arena->spare;
+    if (chunk) {
+        arena->spare = chunk->spare;
+        arena->spare_count--;
+        chunk->spare = NULL;
+    } else {
+        chunk = vkc_arena_chunk_create(arena);
+    }
+    pthread_mutex_unlock(&arena->lock);
+
+    if (chunk) {
+        chunk->offset = 0;
+        atomic_store_explicit(&chunk->live, 1, memory_order_relaxed);
+    }
+    return chunk;
+}
+
+/**
+ * @brief pthread key destructor: runs when a thread that used the arena exits.
+ */
+static void vkc_arena_thread_exit(void* value) {
+    VkcArenaThread* thread = (VkcArenaThread*) value;
+    VkcArena* arena = thread->arena;
+
+    pthread_mutex_lock(&arena->lock);
+    if (thread->prev) {
+        thread->prev->next = thread->next;
+    } else {
+        arena->threads = thread->next;
+    }
+    if (thread->next) {
+        thread->next->prev = thread->prev;
+    }
+    pthread_mutex_unlock(&arena->lock);
+
+    if (thread->current) {
+        vkc_arena_chunk_release(arena, thread->current);
+    }
+    free(thread);
+}
+
+static VkcArenaThread* vkc_arena_thread(VkcArena* arena) {
+    VkcArenaThread* thread = pthread_getspecific(arena->key);
+    if (thread) {
+        return thread;
+    }
+
+    thread = calloc(1, sizeof(*thread));
+    if (!thread) {
+        LOG_ERROR("[VkcArena] Failed to allocate thread cache.");
+        return NULL;
+    }
+
+    if (0 != pthread_setspecific(arena->key, thread)) {
+        LOG_ERROR("[VkcArena] Failed to bind thread cache.");
+        free(thread);
+        return NULL;
+    }
+
+    thread->arena = arena;
+    pthread_mutex_lock(&arena->lock);
+    thread->next = arena->threads;
+    if (arena->threads) {
+        arena->threads->prev = thread;
+    }
+    arena->threads = thread;
+    pthread_mutex_unlock(&arena->lock);
+
+    return thread;
+}
+
+static void* vkc_arena_linear_malloc(
+    VkcArena* arena, VkcArenaThread* thread, size_t size, size_t alignment
+) {
+    VkcArenaChunk* chunk = thread->current;
+    if (chunk) {
+        // Only the carver's reference is left: nothing else lives here, rewind in bulk.
+        if (1 == atomic_load_explicit(&chunk->live, memory_order_acquire)) {
+            chunk->offset = 0;
+        }
+
+        VkcArenaBlock* header = vkc_arena_bump(chunk, size, alignment);
+        if (header) {
+            atomic_fetch_add_explicit(&chunk->live, 1, memory_order_relaxed);
+            header->size = size;
+            return header + 1;
+        }
+
+        thread->current = NULL;
+        vkc_arena_chunk_release(arena, chunk);
+    }
+
+    chunk = vkc_arena_chunk_acquire(arena);
+    if (!chunk) {
+        return NULL;
+    }
+    thread->current = chunk;
+
+    VkcArenaBlock* header = vkc_arena_bump(chunk, size, alignment);
+    if (!header) {
+        return NULL; // Unreachable: vkc_arena_accepts() bounds the request
+    }
+
+    atomic_fetch_add_explicit(&chunk->live, 1, memory_order_relaxed);
+    header->size = size;
+    return header + 1;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcArena* vkc_arena_create(size_t chunk_size, int node) {
+    VkcArena* arena = calloc(1, sizeof(*arena));
+    if (!arena) {
+        LOG_ERROR("[VkcArena] Failed to allocate arena.");
+        return NULL;
+    }
+
+    if (0 != pthread_mutex_init(&arena->lock, NULL)) {
+        LOG_ERROR("[VkcArena] Failed to initialize arena lock.");
+        free(arena);
+        return NULL;
+    }
+
+    if (0 != pthread_key_create(&arena->key, vkc_arena_thread_exit)) {
+        LOG_ERROR("[VkcArena] Failed to create thread cache key.");
+        pthread_mutex_destroy(&arena->lock);
+        free(arena);
+        return NULL;
+    }
+
+    arena->chunk_size = vkc_arena_align(chunk_size ? chunk_size : 1, VKC_EXTENT_GRANULE);
+    arena->node = node;
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcArena] Created arena (chunk=%zu, node=%d).", arena->chunk_size, node);
+#endif
+
+    return arena;
+}
+
+void vkc_arena_destroy(VkcArena* arena) {
+    if (!arena) {
+        return;
+    }
+
+    // Deleting the key first keeps exiting threads from touching a dead arena.
+    pthread_key_delete(arena->key);
+
+    while (arena->threads) {
+        VkcArenaThread* thread = arena->threads;
+        arena->threads = thread->next;
+        free(thread);
+    }
+
+    while (arena->chunks) {
+        vkc_arena_chunk_destroy(arena, arena->chunks);
+    }
+
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+bool vkc_arena_accepts(const VkcArena* arena, size_t size, size_t alignment) {
+    if (!arena || 0 == size) {
+        return false;
+    }
+
+    // Keep linear requests small enough that a chunk always fits several of them.
+    return size + alignment <= arena->chunk_size / 4;
+}
+
+void* vkc_arena_malloc(VkcArena* arena, size_t size, size_t alignment) {
+    if (!vkc_arena_accepts(arena, size, alignment)) {
+        return NULL;
+    }
+
+    VkcArenaThread* thread = vkc_arena_thread(arena);
+    if (!thread) {
+        return NULL;
+    }
+
+    if (alignment < VKC_ARENA_ALIGNMENT) {
+        alignment = VKC_ARENA_ALIGNMENT;
+    }
+    return vkc_arena_linear_malloc(arena, thread, size, alignment);
+}
+
+void vkc_arena_free(VkcArena* arena, void* address) {
+    if (!arena || !address) {
+        return;
+    }
+
+    VkcArenaChunk* chunk = vkc_arena_chunk(address);
+    if (!chunk || arena != chunk->extent.owner) {
+        LOG_ERROR("[VkcArena] Address %p is not owned by this arena.", address);
+        return;
+    }
+
+    vkc_arena_chunk_release(arena, chunk);
+}
+
+bool vkc_arena_resize(VkcArena* arena, void* address, size_t size) {
+    if (!arena || !address || 0 == size) {
+        return false;
+    }
+
+    VkcArenaBlock* header = vkc_arena_block(address);
+    VkcArenaChunk* chunk = vkc_arena_chunk(address);
+    VkcArenaThread* thread = pthread_getspecific(arena->key);
+
+    // Only the tail of the calling thread's own chunk can move the bump cursor.
+    uintptr_t base = chunk ? (uintptr_t) chunk->extent.base : 0;
+    uintptr_t payload = (uintptr_t) address;
+    bool tail = thread && chunk && thread->current == chunk
+                && vkc_arena_align(payload + header->size - base, VKC_ARENA_ALIGNMENT)
+                       == chunk->offset;
+
+    if (tail && vkc_arena_accepts(arena, size, VKC_ARENA_ALIGNMENT)
+        && payload + size <= base + chunk->extent.size) {
+        vkc_arena_advance(chunk, vkc_arena_align(payload + size - base, VKC_ARENA_ALIGNMENT));
+        header->size = size;
+        return true;
+    }
+
+    if (size <= header->size) {
+        header->size = size;
+        return true;
+    }
+
+    return false;
+}
+
+size_t vkc_arena_trim(VkcArena* arena, uint64_t idle_ns, bool purge) {
+    if (!arena) {
+        return 0;
+    }
+
+    // The calling thread may give up its own chunk once nothing lives in it.
+    VkcArenaThread* thread = purge ? pthread_getspecific(arena->key) : NULL;
+    VkcArenaChunk* current = thread ? thread->current : NULL;
+    if (current && 1 == atomic_load_explicit(&current->live, memory_order_acquire)) {
+        thread->current = NULL;
+        vkc_arena_chunk_release(arena, current);
+    }
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    uint64_t now = vkc_arena_now();
+    size_t returned = 0;
+
+    pthread_mutex_lock(&arena->lock);
+    VkcArenaChunk** link = &arena->spare;
+    while (*link) {
+        VkcArenaChunk* chunk = *link;
+        size_t resident = vkc_arena_align(chunk->touched, page);
+        if (resident > chunk->extent.size) {
+            resident = chunk->extent.size;
+        }
+
+        if (now - chunk->idle >= idle_ns) {
+            *link = chunk->spare;
+            arena->spare_count--;
+            vkc_arena_chunk_destroy(arena, chunk);
+            returned += resident;
+            continue;
+        }
+
+        if (purge && resident) {
+            vkc_extent_purge(chunk->extent.base, resident);
+            chunk->touched = 0;
+            returned += resident;
+        }
+        link = &chunk->spare;
+    }
+    pthread_mutex_unlock(&arena->lock);
+
+    return returned;
+}
+
+size_t vkc_arena_size(const void* address) {
+    return address ? vkc_arena_block(address)->size : 0;
+}
+
+VkcArena* vkc_arena_owner(const void* address) {
+    VkcArenaChunk* chunk = vkc_arena_chunk(address);
+    return chunk ? (VkcArena*) chunk->extent.owner : NULL;
+}
+
+/** @} */
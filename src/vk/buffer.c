@@ -0,0 +1,426 @@
+/**
+ * @file src/vk/buffer.c
+ * @brief Pool-backed buffers with persistent host pointers.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/buffer.h"
+
+#include <unistd.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+/**
+ * @brief Map a bound buffer if the host accesses it and query its device address.
+ *        Frees the buffer's memory and VkBuffer on failure.
+ */
+static VkResult vkc_buffer_finish(VkcMemoryPool* pool, bool host, VkcBuffer* buffer) {
+    VkDevice device = vkc_memory_pool_device(pool);
+
+    // Held until destroy: the pointer stays valid and later accesses skip the driver.
+    if (host) {
+        VkResult result = vkc_memory_pool_map(pool, &buffer->memory, &buffer->data);
+        if (VK_SUCCESS != result) {
+            vkDestroyBuffer(device, buffer->object, vkc_memory_pool_callbacks(pool));
+            vkc_memory_pool_free(pool, &buffer->memory);
+            *buffer = (VkcBuffer) {0};
+            return result;
+        }
+    }
+
+    // Queried once: shaders reach the buffer through this instead of a descriptor.
+    if (buffer->usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        VkBufferDeviceAddressInfo address = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = buffer->object,
+        };
+        buffer->address = vkGetBufferDeviceAddress(device, &address);
+    }
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Create an unbound buffer whose memory will be imported or exported as `handle`.
+ */
+static VkResult vkc_buffer_external(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkExternalMemoryHandleTypeFlagBits handle,
+    VkcBuffer* buffer
+) {
+    VkExternalMemoryBufferCreateInfo external = {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+        .handleTypes = handle,
+    };
+    VkBufferCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = &external,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VkResult result = vkCreateBuffer(
+        vkc_memory_pool_device(pool), &info, vkc_memory_pool_callbacks(pool), &buffer->object
+    );
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcBuffer] Failed to create buffer: %d.", result);
+        buffer->object = VK_NULL_HANDLE;
+    }
+    return result;
+}
+
+/**
+ * @brief Whether buffers with `usage` support `feature` for opaque fds.
+ */
+static bool vkc_buffer_opaque_fd(
+    VkcMemoryPool* pool, VkBufferUsageFlags usage, VkExternalMemoryFeatureFlags feature
+) {
+    VkPhysicalDeviceExternalBufferInfo info = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_BUFFER_INFO,
+        .usage = usage,
+        .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,
+    };
+    VkExternalBufferProperties properties = {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_BUFFER_PROPERTIES,
+    };
+    vkGetPhysicalDeviceExternalBufferProperties(vkc_memory_pool_physical(pool), &info, &properties);
+    return feature == (properties.externalMemoryProperties.externalMemoryFeatures & feature);
+}
+
+/**
+ * @brief Create a buffer over caller-owned host memory imported into the pool.
+ *
+ * @return VK_ERROR_FEATURE_NOT_PRESENT or VK_ERROR_INVALID_EXTERNAL_HANDLE when the
+ *         memory cannot be imported; the buffer is zeroed on any failure.
+ */
+static VkResult vkc_buffer_wrap(
+    VkcMemoryPool* pool, void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkcBuffer* buffer
+) {
+    // Rejected before any driver call: these fall back to a copy.
+    VkDeviceSize alignment = vkc_memory_pool_import_alignment(pool);
+    if (0 == alignment) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    if (0 != (uintptr_t) data % alignment || 0 != size % alignment) {
+        return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+    }
+
+    VkDevice device = vkc_memory_pool_device(pool);
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(pool);
+
+    VkResult result = vkc_buffer_external(
+        pool, size, usage, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, buffer
+    );
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, buffer->object, &requirements);
+    result = vkc_memory_pool_import_host(pool, data, size, &requirements, &buffer->memory);
+    if (VK_SUCCESS == result) {
+        result = vkBindBufferMemory(
+            device, buffer->object, buffer->memory.memory, buffer->memory.offset
+        );
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkcBuffer] Failed to bind buffer memory: %d.", result);
+            vkc_memory_pool_free(pool, &buffer->memory);
+        }
+    }
+    if (VK_SUCCESS != result) {
+        vkDestroyBuffer(device, buffer->object, callbacks);
+        *buffer = (VkcBuffer) {0};
+        return result;
+    }
+
+    buffer->size = size;
+    buffer->usage = usage;
+    result = vkc_buffer_finish(pool, false, buffer);
+    if (VK_SUCCESS == result) {
+        buffer->data = data;
+    }
+    return result;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkResult vkc_buffer_create(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkcBuffer* buffer
+) {
+    if (!pool || !buffer || 0 == size) {
+        LOG_ERROR("[VkcBuffer] Invalid buffer request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *buffer = (VkcBuffer) {0};
+
+    VkDevice device = vkc_memory_pool_device(pool);
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(pool);
+
+    VkBufferCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VkResult result = vkCreateBuffer(device, &info, callbacks, &buffer->object);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcBuffer] Failed to create buffer: %d.", result);
+        return result;
+    }
+
+    result = vkc_memory_pool_bind_buffer(pool, buffer->object, memory, &buffer->memory);
+    if (VK_SUCCESS != result) {
+        vkDestroyBuffer(device, buffer->object, callbacks);
+        *buffer = (VkcBuffer) {0};
+        return result;
+    }
+
+    buffer->size = size;
+    buffer->usage = usage;
+    result = vkc_buffer_finish(pool, VKC_MEMORY_USAGE_GPU_ONLY != memory, buffer);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcBuffer] Created %llu byte buffer @ %p (type=%u, placement=%u, offset=%llu, "
+        "data=%p, address=0x%llx).",
+        (unsigned long long) size,
+        (void*) buffer->object,
+        buffer->memory.type,
+        (unsigned) buffer->memory.placement,
+        (unsigned long long) buffer->memory.offset,
+        buffer->data,
+        (unsigned long long) buffer->address
+    );
+#endif
+
+    return VK_SUCCESS;
+}
+
+VkResult vkc_buffer_import(
+    VkcMemoryPool* pool, void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkcBuffer* buffer
+) {
+    if (!pool || !data || !buffer || 0 == size) {
+        LOG_ERROR("[VkcBuffer] Invalid import request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *buffer = (VkcBuffer) {0};
+
+    VkResult result = vkc_buffer_wrap(pool, data, size, usage, buffer);
+    if (VK_ERROR_FEATURE_NOT_PRESENT != result && VK_ERROR_INVALID_EXTERNAL_HANDLE != result) {
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        if (VK_SUCCESS == result) {
+            LOG_DEBUG(
+                "[VkcBuffer] Imported %llu bytes @ %p as buffer %p (type=%u).",
+                (unsigned long long) size,
+                data,
+                (void*) buffer->object,
+                buffer->memory.type
+            );
+        }
+#endif
+        return result;
+    }
+
+    // Not importable: the device reads a copy in place instead.
+    result = vkc_buffer_create(pool, size, usage, VKC_MEMORY_USAGE_DEVICE_UPLOAD, buffer);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+    memcpy(buffer->data, data, size);
+    vkc_buffer_mark_flush(pool, buffer, 0, VK_WHOLE_SIZE);
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcBuffer] Copied %llu bytes @ %p into buffer %p; the range is not importable.",
+        (unsigned long long) size,
+        data,
+        (void*) buffer->object
+    );
+#endif
+
+    return VK_SUCCESS;
+}
+
+VkResult vkc_buffer_export(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkcBuffer* buffer
+) {
+    if (!pool || !buffer || 0 == size) {
+        LOG_ERROR("[VkcBuffer] Invalid export request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *buffer = (VkcBuffer) {0};
+    if (!(vkc_memory_pool_flags(pool) & VKC_MEMORY_POOL_EXTERNAL_FD_BIT)
+        || !vkc_buffer_opaque_fd(pool, usage, VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkResult result = vkc_buffer_external(
+        pool, size, usage, VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT, buffer
+    );
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    result = vkc_memory_pool_bind_exportable(pool, buffer->object, memory, &buffer->memory);
+    if (VK_SUCCESS != result) {
+        VkDevice device = vkc_memory_pool_device(pool);
+        vkDestroyBuffer(device, buffer->object, vkc_memory_pool_callbacks(pool));
+        *buffer = (VkcBuffer) {0};
+        return result;
+    }
+
+    buffer->size = size;
+    buffer->usage = usage;
+    return vkc_buffer_finish(pool, VKC_MEMORY_USAGE_GPU_ONLY != memory, buffer);
+}
+
+VkResult vkc_buffer_import_fd(
+    VkcMemoryPool* pool,
+    int fd,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    uint32_t type,
+    VkDeviceSize memory_size,
+    VkcBuffer* buffer
+) {
+    if (!pool || fd < 0 || !buffer || 0 == size) {
+        LOG_ERROR("[VkcBuffer] Invalid import request.");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *buffer = (VkcBuffer) {0};
+    if (!(vkc_memory_pool_flags(pool) & VKC_MEMORY_POOL_EXTERNAL_FD_BIT)
+        || !vkc_buffer_opaque_fd(pool, usage, VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT)) {
+        close(fd);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkResult result = vkc_buffer_external(
+        pool, size, usage, VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT, buffer
+    );
+    if (VK_SUCCESS != result) {
+        close(fd);
+        return result;
+    }
+
+    result = vkc_memory_pool_import_fd(
+        pool, fd, buffer->object, type, memory_size, &buffer->memory
+    );
+    if (VK_SUCCESS != result) {
+        VkDevice device = vkc_memory_pool_device(pool);
+        vkDestroyBuffer(device, buffer->object, vkc_memory_pool_callbacks(pool));
+        *buffer = (VkcBuffer) {0};
+        return result;
+    }
+
+    buffer->size = size;
+    buffer->usage = usage;
+    bool host = buffer->memory.flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    return vkc_buffer_finish(pool, host, buffer);
+}
+
+void vkc_buffer_destroy(VkcMemoryPool* pool, VkcBuffer* buffer) {
+    if (!pool || !buffer || !buffer->object) {
+        return;
+    }
+
+    // Imported memory was never mapped: `data` is the caller's own pointer.
+    if (buffer->data && VKC_MEMORY_PLACEMENT_IMPORTED != buffer->memory.placement) {
+        vkc_memory_pool_unmap(pool, &buffer->memory);
+    }
+    vkDestroyBuffer(vkc_memory_pool_device(pool), buffer->object, vkc_memory_pool_callbacks(pool));
+    vkc_memory_pool_free(pool, &buffer->memory);
+    *buffer = (VkcBuffer) {0};
+}
+
+VkResult vkc_buffer_relocate(VkcMemoryPool* pool, const VkcBuffer* buffer, VkcBuffer* target) {
+    if (!pool || !buffer || !buffer->object || !target) {
+        LOG_ERROR("[VkcBuffer] Invalid relocation request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *target = (VkcBuffer) {0};
+
+    VkDevice device = vkc_memory_pool_device(pool);
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(pool);
+
+    VkBufferCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = buffer->size,
+        .usage = buffer->usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VkResult result = vkCreateBuffer(device, &info, callbacks, &target->object);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcBuffer] Failed to create buffer: %d.", result);
+        return result;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, target->object, &requirements);
+    result = vkc_memory_pool_relocate(pool, &buffer->memory, &requirements, &target->memory);
+    if (VK_SUCCESS == result) {
+        result = vkBindBufferMemory(
+            device, target->object, target->memory.memory, target->memory.offset
+        );
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkcBuffer] Failed to bind buffer memory: %d.", result);
+            vkc_memory_pool_free(pool, &target->memory);
+        }
+    }
+    if (VK_SUCCESS != result) {
+        vkDestroyBuffer(device, target->object, callbacks);
+        *target = (VkcBuffer) {0};
+        return result;
+    }
+
+    target->size = buffer->size;
+    target->usage = buffer->usage;
+    return vkc_buffer_finish(pool, NULL != buffer->data, target);
+}
+
+bool vkc_buffer_stats(const VkcBuffer* buffer, VkcMemoryAllocationStats* stats) {
+    return buffer && vkc_memory_pool_allocation_stats(&buffer->memory, stats);
+}
+
+bool vkc_buffer_mark_flush(
+    VkcMemoryPool* pool, const VkcBuffer* buffer, VkDeviceSize offset, VkDeviceSize size
+) {
+    return buffer && vkc_memory_pool_mark_flush(pool, &buffer->memory, offset, size);
+}
+
+bool vkc_buffer_mark_invalidate(
+    VkcMemoryPool* pool, const VkcBuffer* buffer, VkDeviceSize offset, VkDeviceSize size
+) {
+    return buffer && vkc_memory_pool_mark_invalidate(pool, &buffer->memory, offset, size);
+}
+
+/** @} */
@@ -0,0 +1,341 @@
+/**
+ * @file src/vk/cache.c
+ * @brief A VkPipelineCache persisted on disk between runs.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief "VKCP", the first bytes of every cache file.
+ */
+#define VKC_PIPELINE_CACHE_MAGIC 0x50434b56u
+#define VKC_PIPELINE_CACHE_VERSION 1u
+
+/**
+ * @brief Header of a cache file; the driver's blob follows it.
+ */
+typedef struct VkcPipelineCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t uuid[VK_UUID_SIZE];
+    uint32_t reserved; /**< Zero; keeps the 64-bit fields aligned. */
+    uint64_t data_size;
+    uint64_t checksum; /**< FNV-1a of the blob. */
+} VkcPipelineCacheHeader;
+
+struct VkcPipelineCache {
+    VkDevice device;
+    const VkAllocationCallbacks* callbacks;
+    VkPipelineCache object;
+    char* path; /**< NULL for a cache kept in memory only. */
+    VkcPipelineCacheHeader identity; /**< Header fields of this device and driver. */
+    uint64_t checksum; /**< Of the blob on disk, to skip unchanged saves. */
+    size_t size; /**< Of the blob on disk. */
+    VkcPipelineCacheStats stats;
+};
+
+/**
+ * @name Private
+ * @{
+ */
+
+static uint64_t vkc_pipeline_cache_checksum(const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Why a file's blob cannot seed this device's cache, or NULL if it can.
+ */
+static const char* vkc_pipeline_cache_reject(
+    const VkcPipelineCache* cache, const VkcPipelineCacheHeader* header, const void* data
+) {
+    const VkcPipelineCacheHeader* identity = &cache->identity;
+    if (identity->vendor_id != header->vendor_id || identity->device_id != header->device_id) {
+        return "written for another device";
+    }
+    if (identity->driver_version != header->driver_version) {
+        return "written by another driver version";
+    }
+    if (0 != memcmp(identity->uuid, header->uuid, VK_UUID_SIZE)) {
+        return "written for another pipelineCacheUUID";
+    }
+    if (header->checksum != vkc_pipeline_cache_checksum(data, header->data_size)) {
+        return "checksum mismatch";
+    }
+
+    // The driver checks its own header too, but a mismatch there is silently ignored.
+    VkPipelineCacheHeaderVersionOne blob;
+    if (header->data_size < sizeof(blob)) {
+        return "blob too short";
+    }
+    memcpy(&blob, data, sizeof(blob));
+    if (VK_PIPELINE_CACHE_HEADER_VERSION_ONE != blob.headerVersion
+        || blob.headerSize < sizeof(blob) || blob.headerSize > header->data_size
+        || blob.vendorID != identity->vendor_id || blob.deviceID != identity->device_id
+        || 0 != memcmp(blob.pipelineCacheUUID, identity->uuid, VK_UUID_SIZE)) {
+        return "blob header does not match the device";
+    }
+    return NULL;
+}
+
+/**
+ * @brief Read the cache file into a malloc()ed blob if it is valid for this device.
+ */
+static void* vkc_pipeline_cache_load(VkcPipelineCache* cache, size_t* size) {
+    FILE* file = fopen(cache->path, "rb");
+    if (!file) {
+        if (ENOENT != errno) {
+            LOG_WARN("[VkcPipelineCache] Failed to open %s: %s.", cache->path, strerror(errno));
+        }
+        return NULL;
+    }
+
+    VkcPipelineCacheHeader header;
+    void* data = NULL;
+    const char* reason = NULL;
+    struct stat status;
+    if (1 != fread(&header, sizeof(header), 1, file) || 0 != fstat(fileno(file), &status)) {
+        reason = "truncated header";
+    } else if (VKC_PIPELINE_CACHE_MAGIC != header.magic
+               || VKC_PIPELINE_CACHE_VERSION != header.version) {
+        reason = "not a cache file";
+    } else if (header.data_size != (uint64_t) status.st_size - sizeof(header)) {
+        reason = "truncated blob";
+    } else if (!(data = malloc(header.data_size ? header.data_size : 1))) {
+        reason = "out of memory";
+    } else if (1 != fread(data, header.data_size, 1, file)) {
+        reason = "truncated blob";
+    } else {
+        reason = vkc_pipeline_cache_reject(cache, &header, data);
+    }
+    fclose(file);
+
+    if (reason) {
+        LOG_WARN("[VkcPipelineCache] Ignoring %s: %s.", cache->path, reason);
+        free(data);
+        return NULL;
+    }
+
+    cache->checksum = header.checksum;
+    cache->size = header.data_size;
+    *size = header.data_size;
+    return data;
+}
+
+/**
+ * @brief Write the whole buffer, retrying short writes.
+ */
+static bool vkc_pipeline_cache_write(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    while (size) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= (size_t) written;
+    }
+    return true;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcPipelineCache* vkc_pipeline_cache_create(
+    VkPhysicalDevice physical,
+    VkDevice device,
+    const VkAllocationCallbacks* callbacks,
+    const char* path
+) {
+    if (!physical || !device) {
+        LOG_ERROR("[VkcPipelineCache] Invalid arguments.");
+        return NULL;
+    }
+
+    VkcPipelineCache* cache = calloc(1, sizeof(*cache));
+    if (!cache) {
+        LOG_ERROR("[VkcPipelineCache] Failed to allocate cache.");
+        return NULL;
+    }
+    cache->device = device;
+    cache->callbacks = callbacks;
+    if (path && !(cache->path = strdup(path))) {
+        LOG_ERROR("[VkcPipelineCache] Failed to copy path.");
+        free(cache);
+        return NULL;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical, &properties);
+    cache->identity = (VkcPipelineCacheHeader) {
+        .magic = VKC_PIPELINE_CACHE_MAGIC,
+        .version = VKC_PIPELINE_CACHE_VERSION,
+        .vendor_id = properties.vendorID,
+        .device_id = properties.deviceID,
+        .driver_version = properties.driverVersion,
+    };
+    memcpy(cache->identity.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    size_t size = 0;
+    void* data = cache->path ? vkc_pipeline_cache_load(cache, &size) : NULL;
+
+    VkPipelineCacheCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = size,
+        .pInitialData = data,
+    };
+    VkResult result = vkCreatePipelineCache(device, &info, callbacks, &cache->object);
+    if (VK_SUCCESS != result && data) {
+        // A blob that passed every check can still upset a driver: start cold instead.
+        LOG_WARN("[VkcPipelineCache] Driver rejected %s (VkResult=%d).", cache->path, result);
+        info.initialDataSize = 0;
+        info.pInitialData = NULL;
+        cache->checksum = 0;
+        cache->size = 0;
+        size = 0;
+        result = vkCreatePipelineCache(device, &info, callbacks, &cache->object);
+    }
+    free(data);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcPipelineCache] Failed to create pipeline cache (VkResult=%d).", result);
+        free(cache->path);
+        free(cache);
+        return NULL;
+    }
+
+    cache->stats.warm = size > 0;
+    cache->stats.loaded_bytes = size;
+    LOG_INFO(
+        "[VkcPipelineCache] Created %s cache @ %p (%zu bytes from %s).",
+        cache->stats.warm ? "warm" : "cold",
+        (void*) cache->object,
+        size,
+        cache->path ? cache->path : "memory"
+    );
+    return cache;
+}
+
+void vkc_pipeline_cache_destroy(VkcPipelineCache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    vkc_pipeline_cache_save(cache);
+    vkDestroyPipelineCache(cache->device, cache->object, cache->callbacks);
+    free(cache->path);
+    free(cache);
+}
+
+VkPipelineCache vkc_pipeline_cache_object(const VkcPipelineCache* cache) {
+    return cache ? cache->object : VK_NULL_HANDLE;
+}
+
+VkResult vkc_pipeline_cache_save(VkcPipelineCache* cache) {
+    if (!cache) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (!cache->path) {
+        return VK_SUCCESS;
+    }
+
+    // The blob can grow between the two calls: retry until it fits.
+    size_t size = 0;
+    void* data = NULL;
+    VkResult result;
+    do {
+        result = vkGetPipelineCacheData(cache->device, cache->object, &size, NULL);
+        if (VK_SUCCESS != result) {
+            break;
+        }
+        free(data);
+        if (!(data = malloc(size ? size : 1))) {
+            LOG_ERROR("[VkcPipelineCache] Failed to allocate %zu bytes for the blob.", size);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        result = vkGetPipelineCacheData(cache->device, cache->object, &size, data);
+    } while (VK_INCOMPLETE == result);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcPipelineCache] Failed to read pipeline cache (VkResult=%d).", result);
+        free(data);
+        return result;
+    }
+
+    VkcPipelineCacheHeader header = cache->identity;
+    header.data_size = size;
+    header.checksum = vkc_pipeline_cache_checksum(data, size);
+    if (size == cache->size && header.checksum == cache->checksum) {
+        free(data);
+        return VK_SUCCESS;
+    }
+
+    // Same directory as the cache, so the rename cannot cross filesystems.
+    size_t length = strlen(cache->path) + sizeof(".XXXXXX");
+    char* temporary = malloc(length);
+    int fd = -1;
+    if (temporary) {
+        snprintf(temporary, length, "%s.XXXXXX", cache->path);
+        fd = mkstemp(temporary);
+    }
+    bool written = fd >= 0 && vkc_pipeline_cache_write(fd, &header, sizeof(header))
+                   && vkc_pipeline_cache_write(fd, data, size) && 0 == fsync(fd);
+    if (fd >= 0) {
+        written = 0 == close(fd) && written;
+    }
+    written = written && 0 == rename(temporary, cache->path);
+    if (!written) {
+        LOG_ERROR("[VkcPipelineCache] Failed to save %s: %s.", cache->path, strerror(errno));
+        if (fd >= 0) {
+            unlink(temporary);
+        }
+        free(temporary);
+        free(data);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    cache->checksum = header.checksum;
+    cache->size = size;
+    cache->stats.saved_bytes = size;
+    cache->stats.saves++;
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcPipelineCache] Saved %zu bytes to %s.", size, cache->path);
+#endif
+    free(temporary);
+    free(data);
+    return VK_SUCCESS;
+}
+
+bool vkc_pipeline_cache_stats(const VkcPipelineCache* cache, VkcPipelineCacheStats* stats) {
+    if (!cache || !stats) {
+        return false;
+    }
+
+    *stats = cache->stats;
+    return true;
+}
+
+/** @} */
@@ -0,0 +1,441 @@
+/**
+ * @file src/vk/defrag.c
+ * @brief Incremental defragmentation of pool-backed buffers.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/defrag.h"
+
+#include <time.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Initial capacity of the buffer and move lists.
+#define VKC_DEFRAG_BUFFERS 16
+
+/**
+ * @brief Buffer being copied to a new range by the pass in flight.
+ */
+typedef struct VkcDefragMove {
+    VkcBuffer* buffer;
+    VkcBuffer target; /**< Receives the contents; swapped into `buffer` on completion. */
+} VkcDefragMove;
+
+/**
+ * @brief Registered buffer and how full its block was when the step began.
+ */
+typedef struct VkcDefragCandidate {
+    VkcBuffer* buffer;
+    VkDeviceSize block_used;
+} VkcDefragCandidate;
+
+struct VkcDefrag {
+    VkcMemoryPool* pool;
+    VkDevice device;
+    VkQueue queue;
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffer;
+    VkFence fence;
+    VkcDefragMoveCallback moved;
+    void* user_data;
+    VkcBuffer** buffers;
+    VkcDefragCandidate* candidates; /**< Scratch, as long as `buffers`. */
+    uint32_t buffer_count;
+    uint32_t buffer_capacity;
+    VkcDefragMove* moves;
+    uint32_t move_count;
+    uint32_t move_capacity;
+    bool pending; /**< `moves` were submitted and `fence` has not been seen to signal. */
+    VkcDefragStats stats;
+};
+
+static uint64_t vkc_defrag_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+static int vkc_defrag_compare(const void* a, const void* b) {
+    const VkcDefragCandidate* x = a;
+    const VkcDefragCandidate* y = b;
+    return (x->block_used > y->block_used) - (x->block_used < y->block_used);
+}
+
+/**
+ * @brief Swap every moved buffer over to its copy and free the old ranges. The pass's
+ *        fence has signaled.
+ */
+static void vkc_defrag_commit(VkcDefrag* defrag) {
+    for (uint32_t i = 0; i < defrag->move_count; i++) {
+        VkcDefragMove* move = &defrag->moves[i];
+        VkcBuffer previous = *move->buffer;
+        *move->buffer = move->target;
+
+        // The copy wrote device memory behind the host's back.
+        if (move->buffer->data) {
+            vkc_buffer_mark_invalidate(defrag->pool, move->buffer, 0, VK_WHOLE_SIZE);
+        }
+        if (defrag->moved) {
+            defrag->moved(defrag->user_data, move->buffer, &previous);
+        }
+        vkc_buffer_destroy(defrag->pool, &previous);
+
+        defrag->stats.moves++;
+        defrag->stats.moved_bytes += move->buffer->size;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcDefrag] Moved %u buffers.", defrag->move_count);
+#endif
+
+    defrag->move_count = 0;
+    defrag->pending = false;
+
+    // Moves drain blocks; do not keep the last one for a burst that is not coming.
+    vkc_memory_pool_trim(defrag->pool);
+}
+
+/**
+ * @brief Plan one move and record its copy, opening the command buffer on the first.
+ *
+ * @return VK_SUCCESS if the buffer will move, VK_INCOMPLETE if it has no better place.
+ */
+static VkResult vkc_defrag_move(VkcDefrag* defrag, VkcBuffer* buffer) {
+    if (defrag->move_count == defrag->move_capacity) {
+        uint32_t capacity = defrag->move_capacity ? defrag->move_capacity * 2
+                                                  : VKC_DEFRAG_BUFFERS;
+        VkcDefragMove* moves = realloc(defrag->moves, capacity * sizeof(*moves));
+        if (!moves) {
+            LOG_ERROR("[VkcDefrag] Failed to grow the move list.");
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        defrag->moves = moves;
+        defrag->move_capacity = capacity;
+    }
+
+    VkcDefragMove* move = &defrag->moves[defrag->move_count];
+    VkResult result = vkc_buffer_relocate(defrag->pool, buffer, &move->target);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    if (0 == defrag->move_count) {
+        vkResetCommandBuffer(defrag->command_buffer, 0);
+        VkCommandBufferBeginInfo begin = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        result = vkBeginCommandBuffer(defrag->command_buffer, &begin);
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkcDefrag] Failed to begin the command buffer: %d.", result);
+            vkc_buffer_destroy(defrag->pool, &move->target);
+            return result;
+        }
+    }
+
+    VkBufferCopy region = {.size = buffer->size};
+    vkCmdCopyBuffer(defrag->command_buffer, buffer->object, move->target.object, 1, &region);
+    move->buffer = buffer;
+    defrag->move_count++;
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Close the pass's command buffer and submit it on the defragmenter's queue.
+ */
+static VkResult vkc_defrag_submit(VkcDefrag* defrag) {
+    // Later work on any queue, and the host, see the copies once the fence signals.
+    VkMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+                         | VK_ACCESS_HOST_READ_BIT,
+    };
+    vkCmdPipelineBarrier(
+        defrag->command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        NULL,
+        0,
+        NULL
+    );
+
+    VkResult result = vkEndCommandBuffer(defrag->command_buffer);
+    if (VK_SUCCESS == result) {
+        // Host writes the old buffers still hold must reach the device before the copy.
+        result = vkc_memory_pool_flush(defrag->pool);
+    }
+    if (VK_SUCCESS == result) {
+        VkSubmitInfo submit = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &defrag->command_buffer,
+        };
+        result = vkQueueSubmit(defrag->queue, 1, &submit, defrag->fence);
+    }
+
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcDefrag] Failed to submit %u moves: %d.", defrag->move_count, result);
+        for (uint32_t i = 0; i < defrag->move_count; i++) {
+            vkc_buffer_destroy(defrag->pool, &defrag->moves[i].target);
+        }
+        defrag->move_count = 0;
+        return result;
+    }
+
+    defrag->pending = true;
+    defrag->stats.passes++;
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Wait for the pass in flight. Its fence stays signaled for the next step to see.
+ */
+static VkResult vkc_defrag_wait(VkcDefrag* defrag) {
+    VkResult result = vkWaitForFences(defrag->device, 1, &defrag->fence, VK_TRUE, UINT64_MAX);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcDefrag] Failed to wait for the pass in flight: %d.", result);
+    }
+    return result;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcDefrag* vkc_defrag_create(
+    VkcMemoryPool* pool,
+    VkQueue queue,
+    uint32_t queue_family,
+    VkcDefragMoveCallback moved,
+    void* user_data
+) {
+    if (!pool || !queue) {
+        LOG_ERROR("[VkcDefrag] Missing memory pool or queue.");
+        return NULL;
+    }
+
+    VkcDefrag* defrag = calloc(1, sizeof(*defrag));
+    if (!defrag) {
+        LOG_ERROR("[VkcDefrag] Failed to allocate defragmenter.");
+        return NULL;
+    }
+
+    defrag->pool = pool;
+    defrag->device = vkc_memory_pool_device(pool);
+    defrag->queue = queue;
+    defrag->moved = moved;
+    defrag->user_data = user_data;
+
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(pool);
+    VkCommandPoolCreateInfo command_pool = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queue_family,
+    };
+    VkResult result
+        = vkCreateCommandPool(defrag->device, &command_pool, callbacks, &defrag->command_pool);
+    if (VK_SUCCESS == result) {
+        VkCommandBufferAllocateInfo command_buffer = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = defrag->command_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        result = vkAllocateCommandBuffers(defrag->device, &command_buffer, &defrag->command_buffer);
+    }
+    if (VK_SUCCESS == result) {
+        VkFenceCreateInfo fence = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        result = vkCreateFence(defrag->device, &fence, callbacks, &defrag->fence);
+    }
+
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcDefrag] Failed to create command objects: %d.", result);
+        if (defrag->command_pool) {
+            vkDestroyCommandPool(defrag->device, defrag->command_pool, callbacks);
+        }
+        free(defrag);
+        return NULL;
+    }
+
+    return defrag;
+}
+
+void vkc_defrag_destroy(VkcDefrag* defrag) {
+    if (!defrag) {
+        return;
+    }
+
+    if (defrag->pending) {
+        if (VK_SUCCESS == vkc_defrag_wait(defrag)) {
+            vkc_defrag_commit(defrag);
+        } else {
+            // The device is lost: the copies never matter again, only their ranges.
+            for (uint32_t i = 0; i < defrag->move_count; i++) {
+                vkc_buffer_destroy(defrag->pool, &defrag->moves[i].target);
+            }
+        }
+    }
+
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(defrag->pool);
+    vkDestroyFence(defrag->device, defrag->fence, callbacks);
+    vkDestroyCommandPool(defrag->device, defrag->command_pool, callbacks);
+    free(defrag->buffers);
+    free(defrag->candidates);
+    free(defrag->moves);
+    free(defrag);
+}
+
+bool vkc_defrag_add(VkcDefrag* defrag, VkcBuffer* buffer) {
+    if (!defrag || !buffer || !buffer->object) {
+        return false;
+    }
+
+    VkBufferUsageFlags transfer
+        = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if ((buffer->usage & transfer) != transfer) {
+        LOG_ERROR("[VkcDefrag] Buffer @ %p lacks transfer usage.", (void*) buffer->object);
+        return false;
+    }
+
+    if (defrag->buffer_count == defrag->buffer_capacity) {
+        uint32_t capacity = defrag->buffer_capacity ? defrag->buffer_capacity * 2
+                                                    : VKC_DEFRAG_BUFFERS;
+        VkcBuffer** buffers = realloc(defrag->buffers, capacity * sizeof(*buffers));
+        if (!buffers) {
+            LOG_ERROR("[VkcDefrag] Failed to grow the buffer list.");
+            return false;
+        }
+        defrag->buffers = buffers;
+
+        VkcDefragCandidate* candidates
+            = realloc(defrag->candidates, capacity * sizeof(*candidates));
+        if (!candidates) {
+            LOG_ERROR("[VkcDefrag] Failed to grow the buffer list.");
+            return false;
+        }
+        defrag->candidates = candidates;
+        defrag->buffer_capacity = capacity;
+    }
+
+    defrag->buffers[defrag->buffer_count++] = buffer;
+    return true;
+}
+
+void vkc_defrag_remove(VkcDefrag* defrag, VkcBuffer* buffer) {
+    if (!defrag || !buffer) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < defrag->buffer_count; i++) {
+        if (defrag->buffers[i] == buffer) {
+            defrag->buffers[i] = defrag->buffers[--defrag->buffer_count];
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < defrag->move_count; i++) {
+        if (defrag->moves[i].buffer != buffer) {
+            continue;
+        }
+
+        // The copy may still be writing the target; it can only be freed once done.
+        if (VK_SUCCESS != vkc_defrag_wait(defrag)) {
+            break;
+        }
+        vkc_buffer_destroy(defrag->pool, &defrag->moves[i].target);
+        defrag->moves[i] = defrag->moves[--defrag->move_count];
+
+        // The rest of the pass is complete too; the next step commits it.
+        if (0 == defrag->move_count) {
+            defrag->pending = false;
+            vkResetFences(defrag->device, 1, &defrag->fence);
+        }
+        break;
+    }
+}
+
+VkResult vkc_defrag_step(VkcDefrag* defrag, VkDeviceSize max_bytes, uint64_t max_ns) {
+    if (!defrag) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    uint64_t deadline = vkc_defrag_now() + (max_ns ? max_ns : VKC_DEFRAG_TIME);
+    max_bytes = max_bytes ? max_bytes : VKC_DEFRAG_BYTES;
+
+    bool committed = false;
+    if (defrag->pending) {
+        VkResult result = vkGetFenceStatus(defrag->device, defrag->fence);
+        if (VK_SUCCESS != result) {
+            return result; // VK_NOT_READY while copying: never wait here
+        }
+        vkResetFences(defrag->device, 1, &defrag->fence);
+        vkc_defrag_commit(defrag);
+        committed = true;
+    }
+
+    // Emptiest blocks first: their buffers are the fewest moves away from a free block.
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < defrag->buffer_count; i++) {
+        VkcMemoryAllocationStats stats;
+        if (vkc_buffer_stats(defrag->buffers[i], &stats)
+            && VKC_MEMORY_PLACEMENT_POOLED == stats.placement) {
+            defrag->candidates[count++] = (VkcDefragCandidate) {
+                .buffer = defrag->buffers[i],
+                .block_used = stats.block_used,
+            };
+        }
+    }
+    qsort(defrag->candidates, count, sizeof(*defrag->candidates), vkc_defrag_compare);
+
+    VkDeviceSize bytes = 0;
+    for (uint32_t i = 0; i < count && vkc_defrag_now() < deadline; i++) {
+        VkcBuffer* buffer = defrag->candidates[i].buffer;
+        if (bytes + buffer->size > max_bytes) {
+            continue; // A smaller buffer may still fit the pass
+        }
+
+        VkResult result = vkc_defrag_move(defrag, buffer);
+        if (VK_SUCCESS == result) {
+            bytes += buffer->size;
+        } else if (VK_INCOMPLETE != result) {
+            if (defrag->move_count) {
+                vkEndCommandBuffer(defrag->command_buffer);
+                for (uint32_t j = 0; j < defrag->move_count; j++) {
+                    vkc_buffer_destroy(defrag->pool, &defrag->moves[j].target);
+                }
+                defrag->move_count = 0;
+            }
+            return result;
+        }
+    }
+
+    if (defrag->move_count) {
+        VkResult result = vkc_defrag_submit(defrag);
+        return VK_SUCCESS == result ? VK_INCOMPLETE : result;
+    }
+    return committed ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+bool vkc_defrag_stats(VkcDefrag* defrag, VkcDefragStats* stats) {
+    if (!defrag || !stats) {
+        return false;
+    }
+
+    *stats = defrag->stats;
+    return true;
+}
+
+/** @} */
@@ -24,10 +24,10 @@
  * @{
  */
 
-VkcDeviceList* vkc_device_list_create(VkInstance instance) {
-    PageAllocator* allocator = vkc_allocator_get();
+VkcDeviceList* vkc_device_list_create(VkcAllocatorContext* context, VkInstance instance) {
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcDeviceList] Failed to get global allocator.");
+        LOG_ERROR("[VkcDeviceList] Failed to get context allocator.");
         return NULL;
     }
 
@@ -40,6 +40,7 @@ VkcDeviceList* vkc_device_list_create(VkInstance instance) {
     *list = (VkcDeviceList) {
         .devices = NULL,
         .count = 0,
+        .context = context,
     };
 
     VkResult result = vkEnumeratePhysicalDevices(instance, &list->count, NULL);
@@ -90,7 +91,7 @@ VkcDeviceList* vkc_device_list_create(VkInstance instance) {
 
 void vkc_device_list_free(VkcDeviceList* list) {
     if (list && list->devices) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(list->context);
         page_free(allocator, list->devices);
         page_free(allocator, list);
     }
@@ -103,15 +104,16 @@ void vkc_device_list_free(VkcDeviceList* list) {
  * @{
  */
 
-VkcDeviceQueueFamily* vkc_device_queue_family_create(VkPhysicalDevice device) {
+VkcDeviceQueueFamily*
+vkc_device_queue_family_create(VkcAllocatorContext* context, VkPhysicalDevice device) {
     if (!device) {
         LOG_ERROR("[VkcDeviceQueueFamily] Invalid physical device.");
         return NULL;
     }
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcDeviceQueueFamily] Failed to get global allocator.");
+        LOG_ERROR("[VkcDeviceQueueFamily] Failed to get context allocator.");
         return NULL;
     }
 
@@ -124,6 +126,7 @@ VkcDeviceQueueFamily* vkc_device_queue_family_create(VkPhysicalDevice device) {
     *family = (VkcDeviceQueueFamily) {
         .properties = NULL,
         .count = 0,
+        .context = context,
     };
 
     vkGetPhysicalDeviceQueueFamilyProperties(device, &family->count, NULL);
@@ -151,7 +154,7 @@ VkcDeviceQueueFamily* vkc_device_queue_family_create(VkPhysicalDevice device) {
 
 void vkc_device_queue_family_free(VkcDeviceQueueFamily* family) {
     if (family && family->properties) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(family->context);
         page_free(allocator, family->properties);
         page_free(allocator, family);
     }
@@ -170,9 +173,9 @@ VkcPhysicalDevice* vkc_device_physical_create(VkcDeviceList* list) {
         return VK_NULL_HANDLE;
     }
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(list->context);
     if (!allocator) {
-        LOG_ERROR("[VkcPhysicalDevice] Failed to get global allocator.");
+        LOG_ERROR("[VkcPhysicalDevice] Failed to get context allocator.");
         return NULL;
     }
 
@@ -185,6 +188,7 @@ VkcPhysicalDevice* vkc_device_physical_create(VkcDeviceList* list) {
     *device = (VkcPhysicalDevice) {
         .object = VK_NULL_HANDLE,
         .queue_family_index = 0,
+        .context = list->context,
     };
 
     static const VkPhysicalDeviceType types[] = {
@@ -201,7 +205,7 @@ VkcPhysicalDevice* vkc_device_physical_create(VkcDeviceList* list) {
             VkPhysicalDeviceProperties properties = {0};
             vkGetPhysicalDeviceProperties(candidate, &properties);
 
-            VkcDeviceQueueFamily* family = vkc_device_queue_family_create(candidate);
+            VkcDeviceQueueFamily* family = vkc_device_queue_family_create(list->context, candidate);
             if (!family) {
                 page_free(allocator, device);
                 return NULL;
@@ -246,7 +250,7 @@ VkcPhysicalDevice* vkc_device_physical_create(VkcDeviceList* list) {
 
 void vkc_device_physical_free(VkcPhysicalDevice* device) {
     if (device && device->object) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(device->context);
         page_free(allocator, device->object);
         page_free(allocator, device);
     }
@@ -259,10 +263,10 @@ void vkc_device_physical_free(VkcPhysicalDevice* device) {
  * @{
  */
 
-VkcDeviceLayer* vkc_device_layer_create(VkPhysicalDevice device) {
-    PageAllocator* allocator = vkc_allocator_get();
+VkcDeviceLayer* vkc_device_layer_create(VkcAllocatorContext* context, VkPhysicalDevice device) {
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcDeviceLayer] Failed to get global allocator.");
+        LOG_ERROR("[VkcDeviceLayer] Failed to get context allocator.");
         return NULL;
     } 
 
@@ -275,6 +279,7 @@ VkcDeviceLayer* vkc_device_layer_create(VkPhysicalDevice device) {
     *layer = (VkcDeviceLayer) {
         .properties = NULL,
         .count = 0,
+        .context = context,
     };
 
     VkResult result = vkEnumerateDeviceLayerProperties(device, &layer->count, NULL);
@@ -324,7 +329,7 @@ VkcDeviceLayer* vkc_device_layer_create(VkPhysicalDevice device) {
 
 void vkc_device_layer_free(VkcDeviceLayer* layer) {
     if (layer && layer->properties) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(layer->context);
         page_free(allocator, layer->properties);
         page_free(allocator, layer);
     }
@@ -342,9 +347,9 @@ VkcDeviceLayerMatch* vkc_device_layer_match_create(
 ) {
     if (!layer || !names || name_count == 0) return NULL;
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(layer->context);
     if (!allocator) {
-        LOG_ERROR("[VkcDeviceLayerMatch] Failed to get global allocator.");
+        LOG_ERROR("[VkcDeviceLayerMatch] Failed to get context allocator.");
         return NULL;
     }
 
@@ -357,6 +362,7 @@ VkcDeviceLayerMatch* vkc_device_layer_match_create(
     *match = (VkcDeviceLayerMatch){
         .names = NULL,
         .count = 0,
+        .context = layer->context,
     };
 
     // First pass: count matching layers
@@ -420,7 +426,7 @@ VkcDeviceLayerMatch* vkc_device_layer_match_create(
 
 void vkc_device_layer_match_free(VkcDeviceLayerMatch* match) {
     if (match && match->names) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(match->context);
         page_free(allocator, match->names);
         page_free(allocator, match);
     }
@@ -433,10 +439,11 @@ void vkc_device_layer_match_free(VkcDeviceLayerMatch* match) {
  * @{
  */
 
-VkcDeviceExtension* vkc_device_extension_create(VkPhysicalDevice device) {
-    PageAllocator* allocator = vkc_allocator_get();
+VkcDeviceExtension*
+vkc_device_extension_create(VkcAllocatorContext* context, VkPhysicalDevice device) {
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcDeviceExtension] Failed to get global allocator.");
+        LOG_ERROR("[VkcDeviceExtension] Failed to get context allocator.");
         return NULL;
     }
 
@@ -449,6 +456,7 @@ VkcDeviceExtension* vkc_device_extension_create(VkPhysicalDevice device) {
     *extension = (VkcDeviceExtension) {
         .properties = NULL,
         .count = 0,
+        .context = context,
     };
 
     VkResult result = vkEnumerateDeviceExtensionProperties(device, NULL, &extension->count, NULL);
@@ -492,7 +500,7 @@ VkcDeviceExtension* vkc_device_extension_create(VkPhysicalDevice device) {
 
 void vkc_device_extension_free(VkcDeviceExtension* extension) {
     if (extension && extension->properties) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(extension->context);
         page_free(allocator, extension->properties);
         page_free(allocator, extension);
     }
@@ -510,9 +518,9 @@ VkcDeviceExtensionMatch* vkc_device_extension_match_create(
 ) {
     if (!extension || !names || name_count == 0) return NULL;
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(extension->context);
     if (!allocator) {
-        LOG_ERROR("[VkcDeviceExtensionMatch] Failed to get global allocator.");
+        LOG_ERROR("[VkcDeviceExtensionMatch] Failed to get context allocator.");
         return NULL;
     }
 
@@ -525,6 +533,7 @@ VkcDeviceExtensionMatch* vkc_device_extension_match_create(
     *match = (VkcDeviceExtensionMatch){
         .names = NULL,
         .count = 0,
+        .context = extension->context,
     };
 
     // First pass: count matching extensions
@@ -588,7 +597,7 @@ VkcDeviceExtensionMatch* vkc_device_extension_match_create(
 
 void vkc_device_extension_match_free(VkcDeviceExtensionMatch* match) {
     if (match && match->names) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(match->context);
         page_free(allocator, match->names);
         page_free(allocator, match);
     }
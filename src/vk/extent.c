@@ -0,0 +1,302 @@
+/**
+ * @file src/vk/extent.c
+ * @brief Granule-aligned virtual memory extents and an address-to-extent map.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/extent.h"
+
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Keys cover a 48-bit virtual address space: 16 root bits, 16 leaf bits.
+#define VKC_EXTENT_ADDRESS_BITS 48
+#define VKC_EXTENT_LEAF_BITS 16
+#define VKC_EXTENT_ROOT_BITS (VKC_EXTENT_ADDRESS_BITS - VKC_EXTENT_SHIFT - VKC_EXTENT_LEAF_BITS)
+#define VKC_EXTENT_LEAF_COUNT ((size_t) 1 << VKC_EXTENT_LEAF_BITS)
+#define VKC_EXTENT_ROOT_COUNT ((size_t) 1 << VKC_EXTENT_ROOT_BITS)
+
+typedef struct VkcExtentLeaf {
+    _Atomic(VkcExtent*) slots[VKC_EXTENT_LEAF_COUNT];
+} VkcExtentLeaf;
+
+static _Atomic(VkcExtentLeaf*) _vkc_extent_root[VKC_EXTENT_ROOT_COUNT];
+
+static inline size_t vkc_extent_round(size_t size) {
+    return (size + VKC_EXTENT_GRANULE - 1) & ~(VKC_EXTENT_GRANULE - 1);
+}
+
+static VkcExtentLeaf* vkc_extent_leaf(uintptr_t key, bool create) {
+    _Atomic(VkcExtentLeaf*)* root = &_vkc_extent_root[key >> VKC_EXTENT_LEAF_BITS];
+    VkcExtentLeaf* leaf = atomic_load_explicit(root, memory_order_acquire);
+    if (leaf || !create) {
+        return leaf;
+    }
+
+    // Anonymous mappings are zeroed, which is a valid empty leaf.
+    void* fresh = mmap(
+        NULL, sizeof(VkcExtentLeaf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+    );
+    if (MAP_FAILED == fresh) {
+        LOG_ERROR("[VkcExtent] Failed to map radix leaf.");
+        return NULL;
+    }
+
+    VkcExtentLeaf* expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(
+            root, &expected, fresh, memory_order_acq_rel, memory_order_acquire
+        )) {
+        // Another thread installed the leaf first.
+        munmap(fresh, sizeof(VkcExtentLeaf));
+        return expected;
+    }
+
+    return fresh;
+}
+
+static void vkc_extent_store(const VkcExtent* extent, VkcExtent* value) {
+    uintptr_t first = (uintptr_t) extent->base >> VKC_EXTENT_SHIFT;
+    uintptr_t last = ((uintptr_t) extent->base + extent->size - 1) >> VKC_EXTENT_SHIFT;
+    for (uintptr_t key = first; key <= last; key++) {
+        VkcExtentLeaf* leaf = vkc_extent_leaf(key, false);
+        if (leaf) {
+            atomic_store_explicit(
+                &leaf->slots[key & (VKC_EXTENT_LEAF_COUNT - 1)], value, memory_order_release
+            );
+        }
+    }
+}
+
+/**
+ * @brief Create every leaf a range needs, so publishing it cannot fail halfway through.
+ */
+static bool vkc_extent_prepare(const void* base, size_t size) {
+    uintptr_t end = (uintptr_t) base + size - 1;
+    if (end >> VKC_EXTENT_ADDRESS_BITS) {
+        LOG_ERROR("[VkcExtent] Address %p is outside the mapped range.", base);
+        return false;
+    }
+
+    uintptr_t first = (uintptr_t) base >> VKC_EXTENT_SHIFT;
+    uintptr_t last = end >> VKC_EXTENT_SHIFT;
+    for (uintptr_t key = first; key <= last; key += VKC_EXTENT_LEAF_COUNT) {
+        if (!vkc_extent_leaf(key, true)) {
+            return false;
+        }
+    }
+    return NULL != vkc_extent_leaf(last, true);
+}
+
+/**
+ * @brief Map `size` bytes (a multiple of `alignment`) at an `alignment`-aligned address.
+ */
+static void* vkc_extent_reserve(size_t size, size_t alignment) {
+    // Over-reserve by one alignment unit, then trim the unaligned head and tail.
+    size_t reserve = size + alignment;
+    uint8_t* raw
+        = mmap(NULL, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == (void*) raw) {
+        LOG_ERROR("[VkcExtent] Failed to map %zu bytes.", size);
+        return NULL;
+    }
+
+    uintptr_t aligned = ((uintptr_t) raw + alignment - 1) & ~(alignment - 1);
+    size_t head = aligned - (uintptr_t) raw;
+    size_t tail = reserve - head - size;
+    if (head) {
+        munmap(raw, head);
+    }
+    if (tail) {
+        munmap((uint8_t*) aligned + size, tail);
+    }
+
+    return (void*) aligned;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+void* vkc_extent_map(size_t size) {
+    if (0 == size) {
+        return NULL;
+    }
+
+    return vkc_extent_reserve(vkc_extent_round(size), VKC_EXTENT_GRANULE);
+}
+
+void* vkc_extent_map_huge(size_t size, VkcExtentPages* pages) {
+    if (0 == size || size > SIZE_MAX - 2 * VKC_EXTENT_HUGE) {
+        return NULL;
+    }
+
+    size = (size + VKC_EXTENT_HUGE - 1) & ~(VKC_EXTENT_HUGE - 1);
+
+#if defined(MAP_HUGETLB)
+    if (VKC_EXTENT_PAGES_HUGETLB == *pages) {
+        // hugetlbfs mappings are aligned to the huge page size by the kernel.
+        void* base = mmap(
+            NULL,
+            size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            -1,
+            0
+        );
+        if (MAP_FAILED != base) {
+            return base;
+        }
+
+    #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        LOG_DEBUG("[VkcExtent] No reserved huge pages for %zu bytes; using THP.", size);
+    #endif
+    }
+#endif
+
+    if (VKC_EXTENT_PAGES_BASE != *pages) {
+        *pages = VKC_EXTENT_PAGES_ADVISE;
+    }
+
+    void* base = vkc_extent_reserve(size, VKC_EXTENT_HUGE);
+    if (!base) {
+        return NULL;
+    }
+
+    if (VKC_EXTENT_PAGES_ADVISE == *pages) {
+        vkc_extent_advise(base, size);
+    }
+
+    return base;
+}
+
+void vkc_extent_advise(void* base, size_t size) {
+#if defined(MADV_HUGEPAGE)
+    if (base && size && 0 != madvise(base, size, MADV_HUGEPAGE)) {
+    #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        LOG_DEBUG("[VkcExtent] Transparent huge pages unavailable for %p.", base);
+    #endif
+    }
+#else
+    (void) base;
+    (void) size;
+#endif
+}
+
+void vkc_extent_purge(void* base, size_t size) {
+    if (base && size && 0 != madvise(base, size, MADV_DONTNEED)) {
+        LOG_ERROR("[VkcExtent] Failed to purge %zu bytes at %p.", size, base);
+    }
+}
+
+void vkc_extent_unmap(void* base, size_t size) {
+    if (base && size) {
+        munmap(base, vkc_extent_round(size));
+    }
+}
+
+bool vkc_extent_resize(VkcExtent* extent, size_t size, size_t alignment) {
+    if (!extent || !extent->base || 0 == extent->size || 0 == size
+        || 0 != (alignment & (alignment - 1))) {
+        return false;
+    }
+
+    uint8_t* base = extent->base;
+    size_t old_size = vkc_extent_round(extent->size);
+    size = vkc_extent_round(size);
+    if (size <= old_size) {
+        if (size < old_size) {
+            // Withdraw the tail before releasing it; the head stays published.
+            VkcExtent tail = {.base = base + size, .size = old_size - size};
+            vkc_extent_store(&tail, NULL);
+            munmap(tail.base, tail.size);
+        }
+        extent->size = size;
+        return true;
+    }
+
+    // Grow in place when the address space after the region is free.
+    if (vkc_extent_prepare(base, size) && MAP_FAILED != mremap(base, old_size, size, 0)) {
+        extent->size = size;
+        vkc_extent_store(extent, extent);
+        return true;
+    }
+
+    // Otherwise move the pages, not their contents, into an aligned reservation. The
+    // target's leaves exist before the old range is withdrawn, so the map cannot be left
+    // without the block.
+    uint8_t* target = vkc_extent_reserve(
+        size, alignment > VKC_EXTENT_GRANULE ? alignment : VKC_EXTENT_GRANULE
+    );
+    if (!target) {
+        return false;
+    }
+    if (!vkc_extent_prepare(target, size)) {
+        vkc_extent_unmap(target, size);
+        return false;
+    }
+
+    // Withdrawn first: once the old range is released another thread may map it.
+    vkc_extent_deregister(extent);
+    if (MAP_FAILED == mremap(base, old_size, size, MREMAP_MAYMOVE | MREMAP_FIXED, target)) {
+        LOG_ERROR("[VkcExtent] Failed to remap %zu bytes to %zu bytes.", old_size, size);
+        vkc_extent_unmap(target, size);
+        vkc_extent_store(extent, extent);
+        return false;
+    }
+
+    extent->base = target;
+    extent->size = size;
+    vkc_extent_store(extent, extent);
+    return true;
+}
+
+bool vkc_extent_register(VkcExtent* extent) {
+    if (!extent || !extent->base || 0 == extent->size) {
+        return false;
+    }
+
+    if (!vkc_extent_prepare(extent->base, extent->size)) {
+        return false;
+    }
+
+    vkc_extent_store(extent, extent);
+    return true;
+}
+
+void vkc_extent_deregister(const VkcExtent* extent) {
+    if (extent && extent->base && extent->size) {
+        vkc_extent_store(extent, NULL);
+    }
+}
+
+VkcExtent* vkc_extent_lookup(const void* address) {
+    uintptr_t key = (uintptr_t) address >> VKC_EXTENT_SHIFT;
+    if (!address || (key >> (VKC_EXTENT_ROOT_BITS + VKC_EXTENT_LEAF_BITS))) {
+        return NULL;
+    }
+
+    VkcExtentLeaf* leaf = vkc_extent_leaf(key, false);
+    if (!leaf) {
+        return NULL;
+    }
+
+    return atomic_load_explicit(
+        &leaf->slots[key & (VKC_EXTENT_LEAF_COUNT - 1)], memory_order_acquire
+    );
+}
+
+/** @} */
@@ -15,10 +15,10 @@
  * @{
  */
 
-VkcInstanceLayer* vkc_instance_layer_create(void) {
-    PageAllocator* allocator = vkc_allocator_get();
+VkcInstanceLayer* vkc_instance_layer_create(VkcAllocatorContext* context) {
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcInstanceLayer] Failed to get global allocator.");
+        LOG_ERROR("[VkcInstanceLayer] Failed to get context allocator.");
         return NULL;
     }
 
@@ -31,6 +31,7 @@ VkcInstanceLayer* vkc_instance_layer_create(void) {
     *layer = (VkcInstanceLayer){
         .properties = NULL,
         .count = 0,
+        .context = context,
     };
 
     VkResult result = vkEnumerateInstanceLayerProperties(&layer->count, NULL);
@@ -71,7 +72,7 @@ VkcInstanceLayer* vkc_instance_layer_create(void) {
 
 void vkc_instance_layer_free(VkcInstanceLayer* layer) {
     if (layer && layer->properties) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(layer->context);
         page_free(allocator, layer->properties);
         page_free(allocator, layer);
     }
@@ -89,9 +90,9 @@ VkcInstanceLayerMatch* vkc_instance_layer_match_create(
 ) {
     if (!layer || !names || name_count == 0) return NULL;
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(layer->context);
     if (!allocator) {
-        LOG_ERROR("[VkcInstanceLayerMatch] Failed to get global allocator.");
+        LOG_ERROR("[VkcInstanceLayerMatch] Failed to get context allocator.");
         return NULL;
     }
 
@@ -104,6 +105,7 @@ VkcInstanceLayerMatch* vkc_instance_layer_match_create(
     *match = (VkcInstanceLayerMatch){
         .names = NULL,
         .count = 0,
+        .context = layer->context,
     };
 
     // First pass: count matching layers
@@ -167,7 +169,7 @@ VkcInstanceLayerMatch* vkc_instance_layer_match_create(
 
 void vkc_instance_layer_match_free(VkcInstanceLayerMatch* match) {
     if (match && match->names) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(match->context);
         page_free(allocator, match->names);
         page_free(allocator, match);
     }
@@ -180,10 +182,10 @@ void vkc_instance_layer_match_free(VkcInstanceLayerMatch* match) {
  * @{
  */
 
-VkcInstanceExtension* vkc_instance_extension_create(void) {
-    PageAllocator* allocator = vkc_allocator_get();
+VkcInstanceExtension* vkc_instance_extension_create(VkcAllocatorContext* context) {
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcInstanceExtension] Failed to get global allocator.");
+        LOG_ERROR("[VkcInstanceExtension] Failed to get context allocator.");
         return NULL;
     }
 
@@ -196,6 +198,7 @@ VkcInstanceExtension* vkc_instance_extension_create(void) {
     *extension = (VkcInstanceExtension){
         .properties = NULL,
         .count = 0,
+        .context = context,
     };
 
     VkResult result = vkEnumerateInstanceExtensionProperties(NULL, &extension->count, NULL);
@@ -234,7 +237,7 @@ VkcInstanceExtension* vkc_instance_extension_create(void) {
 
 void vkc_instance_extension_free(VkcInstanceExtension* extension) {
     if (extension && extension->properties) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(extension->context);
         page_free(allocator, extension->properties);
         page_free(allocator, extension);
     }
@@ -252,9 +255,9 @@ VkcInstanceExtensionMatch* vkc_instance_extension_match_create(
 ) {
     if (!extension || !names || name_count == 0) return NULL;
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(extension->context);
     if (!allocator) {
-        LOG_ERROR("[VkcInstanceExtensionMatch] Failed to get global allocator.");
+        LOG_ERROR("[VkcInstanceExtensionMatch] Failed to get context allocator.");
         return NULL;
     }
 
@@ -267,6 +270,7 @@ VkcInstanceExtensionMatch* vkc_instance_extension_match_create(
     *match = (VkcInstanceExtensionMatch){
         .names = NULL,
         .count = 0,
+        .context = extension->context,
     };
 
     // First pass: count matching extensions
@@ -330,7 +334,7 @@ VkcInstanceExtensionMatch* vkc_instance_extension_match_create(
 
 void vkc_instance_extension_match_free(VkcInstanceExtensionMatch* match) {
     if (match && match->names) {
-        PageAllocator* allocator = vkc_allocator_get();
+        PageAllocator* allocator = vkc_allocator_context_pager(match->context);
         page_free(allocator, match->names);
         page_free(allocator, match);
     }
@@ -344,6 +348,7 @@ void vkc_instance_extension_match_free(VkcInstanceExtensionMatch* match) {
  */
 
 VkcInstance* vkc_instance_create(
+    VkcAllocatorContext* context,
     VkcInstanceLayerMatch* layer_match,
     VkcInstanceExtensionMatch* extension_match
 ) {
@@ -401,9 +406,9 @@ VkcInstance* vkc_instance_create(
         create_info.ppEnabledExtensionNames = (const char* const*) extension_match->names;
     }
 
-    PageAllocator* allocator = vkc_allocator_get();
+    PageAllocator* allocator = vkc_allocator_context_pager(context);
     if (!allocator) {
-        LOG_ERROR("[VkcInstance] Failed to get global allocator.");
+        LOG_ERROR("[VkcInstance] Failed to get context allocator.");
         return NULL;
     }
 
@@ -415,7 +420,8 @@ VkcInstance* vkc_instance_create(
 
     *instance = (VkcInstance){
         .object = VK_NULL_HANDLE,
-        .callbacks = vkc_allocator_callbacks(),
+        .callbacks = vkc_allocator_context_callbacks(context),
+        .context = context,
     };
 
     result = vkCreateInstance(&create_info, instance->callbacks, &instance->object);
@@ -435,7 +441,7 @@ VkcInstance* vkc_instance_create(
 void vkc_instance_free(VkcInstance* instance) {
     if (instance && instance->object) {
         vkDestroyInstance(instance->object, instance->callbacks);
-        page_free(vkc_allocator_get(), instance);
+        page_free(vkc_allocator_context_pager(instance->context), instance);
     }
 }
 
@@ -0,0 +1,221 @@
+/**
+ * @file src/vk/numa.c
+ * @brief NUMA topology discovery and memory placement for host allocators.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Memory policy mode from <linux/mempolicy.h>.
+#define VKC_NUMA_MPOL_PREFERRED 1
+
+// Bits per word of an mbind() node mask.
+#define VKC_NUMA_WORD_BITS (8 * sizeof(unsigned long))
+
+static pthread_once_t _vkc_numa_once = PTHREAD_ONCE_INIT;
+static size_t _vkc_numa_nodes = 1;
+static size_t _vkc_numa_cpus = 0; /**< Entries in the CPU table. */
+static uint8_t* _vkc_numa_cpu_node = NULL; /**< Node of each possible CPU. */
+
+/**
+ * @brief Read the first line of a sysfs file.
+ */
+static bool vkc_numa_read(const char* path, char* line, size_t size) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    bool read = NULL != fgets(line, (int) size, file);
+    fclose(file);
+    return read;
+}
+
+/**
+ * @brief Parse the next range of a sysfs list such as "0-3,8-11".
+ */
+static bool vkc_numa_range(const char** cursor, size_t* first, size_t* last) {
+    char* end = NULL;
+    unsigned long from = strtoul(*cursor, &end, 10);
+    if (end == *cursor) {
+        return false;
+    }
+
+    unsigned long to = from;
+    if ('-' == *end) {
+        const char* start = end + 1;
+        to = strtoul(start, &end, 10);
+        if (end == start || to < from) {
+            return false;
+        }
+    }
+
+    *first = from;
+    *last = to;
+    *cursor = ',' == *end ? end + 1 : end;
+    return true;
+}
+
+static void vkc_numa_discover(void) {
+    char line[4096];
+    if (!vkc_numa_read("/sys/devices/system/node/online", line, sizeof(line))) {
+        return; // Not a NUMA kernel: one node
+    }
+
+    size_t nodes = 0;
+    size_t first = 0;
+    size_t last = 0;
+    for (const char* cursor = line; vkc_numa_range(&cursor, &first, &last);) {
+        nodes = last + 1;
+    }
+    if (nodes > VKC_NUMA_NODE_MAX) {
+        LOG_ERROR("[VkcNuma] %zu nodes online; tracking the first %d.", nodes, VKC_NUMA_NODE_MAX);
+        nodes = VKC_NUMA_NODE_MAX;
+    }
+    if (nodes <= 1) {
+        return;
+    }
+
+    size_t cpus = 0;
+    if (!vkc_numa_read("/sys/devices/system/cpu/possible", line, sizeof(line))) {
+        return;
+    }
+    for (const char* cursor = line; vkc_numa_range(&cursor, &first, &last);) {
+        cpus = last + 1;
+    }
+
+    uint8_t* table = calloc(cpus ? cpus : 1, sizeof(*table));
+    if (!table) {
+        LOG_ERROR("[VkcNuma] Failed to allocate the CPU table; assuming one node.");
+        return;
+    }
+
+    for (size_t node = 0; node < nodes; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+        if (!vkc_numa_read(path, line, sizeof(line))) {
+            continue; // Offline or memory-only node
+        }
+
+        for (const char* cursor = line; vkc_numa_range(&cursor, &first, &last);) {
+            for (size_t cpu = first; cpu <= last && cpu < cpus; cpu++) {
+                table[cpu] = (uint8_t) node;
+            }
+        }
+    }
+
+    _vkc_numa_cpu_node = table;
+    _vkc_numa_cpus = cpus;
+    _vkc_numa_nodes = nodes;
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcNuma] Discovered %zu nodes over %zu CPUs.", nodes, cpus);
+#endif
+}
+
+static inline size_t vkc_numa_nodes(void) {
+    pthread_once(&_vkc_numa_once, vkc_numa_discover);
+    return _vkc_numa_nodes;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+size_t vkc_numa_node_count(void) {
+    return vkc_numa_nodes();
+}
+
+int vkc_numa_node_current(void) {
+    if (1 == vkc_numa_nodes()) {
+        return 0;
+    }
+
+    int cpu = sched_getcpu();
+    if (cpu < 0 || (size_t) cpu >= _vkc_numa_cpus) {
+        return 0;
+    }
+    return _vkc_numa_cpu_node[cpu];
+}
+
+bool vkc_numa_bind(void* base, size_t size, int node) {
+    if (1 == vkc_numa_nodes() || VKC_NUMA_NODE_ANY == node) {
+        return true;
+    }
+    if (!base || 0 == size || node < 0 || (size_t) node >= _vkc_numa_nodes) {
+        return false;
+    }
+
+#if defined(SYS_mbind)
+    unsigned long mask[VKC_NUMA_NODE_MAX / VKC_NUMA_WORD_BITS] = {0};
+    mask[node / VKC_NUMA_WORD_BITS] = 1ul << (node % VKC_NUMA_WORD_BITS);
+    // The kernel reads maxnode - 1 bits of the mask.
+    long bound = syscall(
+        SYS_mbind, base, size, VKC_NUMA_MPOL_PREFERRED, mask, VKC_NUMA_NODE_MAX + 1, 0
+    );
+    if (0 == bound) {
+        return true;
+    }
+
+    #if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcNuma] Failed to prefer node %d for %p.", node, base);
+    #endif
+#endif
+
+    return false;
+}
+
+bool vkc_numa_pin(int node) {
+    if (1 == vkc_numa_nodes()) {
+        return true;
+    }
+    if (node < 0 || (size_t) node >= _vkc_numa_nodes) {
+        LOG_ERROR("[VkcNuma] Invalid node %d.", node);
+        return false;
+    }
+
+    cpu_set_t* set = CPU_ALLOC(_vkc_numa_cpus);
+    if (!set) {
+        return false;
+    }
+
+    size_t set_size = CPU_ALLOC_SIZE(_vkc_numa_cpus);
+    size_t count = 0;
+    CPU_ZERO_S(set_size, set);
+    for (size_t cpu = 0; cpu < _vkc_numa_cpus; cpu++) {
+        if (node == _vkc_numa_cpu_node[cpu]) {
+            CPU_SET_S(cpu, set_size, set);
+            count++;
+        }
+    }
+
+    // Memory-only nodes have no CPUs to run on.
+    bool pinned = count && 0 == sched_setaffinity(0, set_size, set);
+    CPU_FREE(set);
+    if (!pinned) {
+        LOG_ERROR("[VkcNuma] Failed to pin thread to node %d.", node);
+    }
+    return pinned;
+}
+
+/** @} */
@@ -0,0 +1,2208 @@
+/**
+ * @file src/vk/pool.c
+ * @brief Device memory pool: TLSF sub-allocation within large VkDeviceMemory blocks.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/pool.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Second-level classes per power of two.
+#define VKC_POOL_SL_LOG2 4
+#define VKC_POOL_SL_COUNT (1u << VKC_POOL_SL_LOG2)
+
+// Ranges below this size share first level 0, in linear steps of SMALL / SL_COUNT.
+#define VKC_POOL_SMALL_LOG2 8
+#define VKC_POOL_SMALL (1ull << VKC_POOL_SMALL_LOG2)
+
+// First level 0 for small ranges, then one per power of two up to 2^63.
+#define VKC_POOL_FL_COUNT (64 - VKC_POOL_SMALL_LOG2 + 1)
+
+// Leftovers shorter than this stay with the range they trail instead of being split off.
+#define VKC_POOL_MIN_SPLIT 64
+
+// Region records allocated at once when a memory type runs out of them.
+#define VKC_POOL_BATCH 256
+
+// Device-local heaps reachable through a BAR larger than this are resizable BARs.
+#define VKC_POOL_BAR_SIZE (256ull * 1024 * 1024)
+
+// Block allocations and frees between two reads of VK_EXT_memory_budget.
+#define VKC_POOL_BUDGET_REFRESH 32
+
+// Stalled allocations re-read the budget this often, to see other processes' frees.
+#define VKC_POOL_STALL_POLL (2ull * 1000 * 1000)
+
+/**
+ * @brief One VkDeviceMemory object.
+ */
+typedef struct VkcMemoryBlock {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    atomic_uint_least64_t used; /**< Bytes of allocated ranges; read without the lock. */
+    struct VkcMemoryRegion* first; /**< Range at offset 0; the same record for the block's life. */
+    uint32_t heap;
+    void* mapped; /**< Host address of the whole block while mapped. */
+    uint32_t maps; /**< Outstanding vkc_memory_pool_map() calls. */
+    bool dedicated; /**< Holds a single range and is freed with it. */
+    struct VkcMemoryBlock* prev;
+    struct VkcMemoryBlock* next;
+} VkcMemoryBlock;
+
+/**
+ * @brief Free or allocated range of a block. Ranges tile their block without gaps.
+ */
+typedef struct VkcMemoryRegion {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    VkcMemoryBlock* block;
+    struct VkcMemoryRegion* prev; /**< Range just below, or NULL at the block start. */
+    struct VkcMemoryRegion* next; /**< Range just above, or NULL at the block end. */
+    struct VkcMemoryRegion* prev_free;
+    struct VkcMemoryRegion* next_free; /**< Also links unused records. */
+    VkcMemoryEvictCallback evict; /**< Set while on the eviction list. */
+    void* evict_data;
+    struct VkcMemoryRegion* lru_prev; /**< More recently used. */
+    struct VkcMemoryRegion* lru_next; /**< Less recently used. */
+    bool free;
+} VkcMemoryRegion;
+
+typedef struct VkcMemoryBatch {
+    struct VkcMemoryBatch* next;
+    VkcMemoryRegion regions[VKC_POOL_BATCH];
+} VkcMemoryBatch;
+
+/**
+ * @brief Blocks and TLSF index of one memory type.
+ */
+typedef struct VkcMemoryTypePool {
+    pthread_mutex_t lock;
+    uint32_t index;
+    VkDeviceSize block_size; /**< Pooled block size; larger than half of it is dedicated. */
+    VkcMemoryBlock* blocks;
+    VkcMemoryBlock* spare; /**< Empty pooled block kept for the next burst. */
+    VkcMemoryRegion* records; /**< Unused region records. */
+    VkcMemoryBatch* batches;
+    uint64_t fl_bitmap; /**< First levels with a non-empty second level. */
+    uint32_t sl_bitmap[VKC_POOL_FL_COUNT]; /**< Non-empty free lists per first level. */
+    VkcMemoryRegion* heads[VKC_POOL_FL_COUNT][VKC_POOL_SL_COUNT];
+} VkcMemoryTypePool;
+
+/**
+ * @brief Atom-aligned span of a mapped block waiting for a flush or an invalidate.
+ */
+typedef struct VkcMemoryRange {
+    VkcMemoryBlock* block;
+    VkDeviceSize begin;
+    VkDeviceSize end;
+} VkcMemoryRange;
+
+/**
+ * @brief Spans batched for one vkFlushMappedMemoryRanges/vkInvalidateMappedMemoryRanges.
+ *
+ * Spans only ever refer to mapped blocks: unmapping a block flushes or drops its spans.
+ */
+typedef struct VkcMemoryRangeList {
+    VkcMemoryRange* items;
+    uint32_t count;
+    uint32_t capacity;
+} VkcMemoryRangeList;
+
+/**
+ * @brief Memory a block shares with the host or another process.
+ */
+typedef struct VkcMemoryExternal {
+    void* host; /**< Host range to import, or NULL. */
+    int fd; /**< Opaque fd to import, or -1. */
+    bool exportable; /**< Allocate for export as an opaque fd. */
+} VkcMemoryExternal;
+
+/**
+ * @brief Budget of one heap. Read without locks; the usage estimate tolerates tearing.
+ */
+typedef struct VkcMemoryHeapBudget {
+    atomic_uint_least64_t bytes; /**< Held by this pool's blocks. */
+    atomic_uint_least64_t budget; /**< Bytes the heap can take, as of the last refresh. */
+    atomic_uint_least64_t usage; /**< Process usage reported by the last refresh. */
+    atomic_uint_least64_t base; /**< `bytes` when `usage` was read. */
+} VkcMemoryHeapBudget;
+
+struct VkcMemoryPool {
+    VkPhysicalDevice physical;
+    VkDevice device;
+    VkAllocationCallbacks callbacks;
+    const VkAllocationCallbacks* host; /**< `&callbacks`, or NULL for the driver's own. */
+    VkPhysicalDeviceMemoryProperties properties;
+    VkDeviceSize granularity; /**< bufferImageGranularity. */
+    VkDeviceSize block_size;
+    uint32_t max_allocations; /**< maxMemoryAllocationCount. */
+    bool requirements2; /**< Device is Vulkan 1.1: dedicated requirements can be queried. */
+    VkcMemoryPoolFlags flags;
+    VkDeviceSize atom; /**< nonCoherentAtomSize. */
+    VkDeviceSize import_alignment; /**< minImportedHostPointerAlignment; 0 when unsupported. */
+    PFN_vkGetMemoryHostPointerPropertiesEXT host_pointer_properties;
+    PFN_vkGetMemoryFdKHR memory_fd; /**< Set with VKC_MEMORY_POOL_EXTERNAL_FD_BIT. */
+    uint32_t ranking[VKC_MEMORY_USAGE_COUNT][VK_MAX_MEMORY_TYPES]; /**< Best type first. */
+    uint32_t ranked[VKC_MEMORY_USAGE_COUNT]; /**< Types usable for each usage. */
+    pthread_mutex_t lock; /**< Guards creation of `types`. */
+    _Atomic(VkcMemoryTypePool*) types[VK_MAX_MEMORY_TYPES];
+    pthread_mutex_t ranges_lock; /**< Guards the lists below; taken after a type lock. */
+    VkcMemoryRangeList flushes;
+    VkcMemoryRangeList invalidates;
+    VkMappedMemoryRange* mapped_ranges; /**< Scratch for the driver call. */
+    uint32_t mapped_capacity;
+    atomic_uint_least64_t blocks;
+    atomic_uint_least64_t block_bytes;
+    atomic_uint_least64_t allocations;
+    atomic_uint_least64_t allocated_bytes;
+    atomic_uint_least64_t driver_allocations;
+    atomic_uint_least64_t dedicated_blocks;
+    atomic_uint_least64_t dedicated_bytes;
+    VkcMemoryHeapBudget heaps[VK_MAX_MEMORY_HEAPS];
+    atomic_uint budget_ops; /**< Block allocations and frees since the last refresh. */
+    atomic_int budget_action; /**< VkcMemoryBudgetAction. */
+    atomic_uint_least64_t stall_ns;
+    pthread_mutex_t budget_lock; /**< Guards refreshes, stalls and the eviction list. */
+    pthread_cond_t budget_wake; /**< Broadcast on frees while allocations are stalled. */
+    atomic_uint stalled; /**< Allocations waiting on `budget_wake`. */
+    atomic_uint evictables; /**< Ranges on the eviction list. */
+    VkcMemoryRegion* lru_head; /**< Most recently used evictable range. */
+    VkcMemoryRegion* lru_tail;
+    atomic_uint_least64_t evictions;
+    atomic_uint_least64_t stalls;
+    atomic_uint_least64_t spills;
+};
+
+static inline VkDeviceSize vkc_pool_align(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Free list holding ranges of `size` bytes.
+ */
+static inline void vkc_pool_mapping(VkDeviceSize size, uint32_t* fl, uint32_t* sl) {
+    if (size < VKC_POOL_SMALL) {
+        *fl = 0;
+        *sl = (uint32_t) (size >> (VKC_POOL_SMALL_LOG2 - VKC_POOL_SL_LOG2));
+        return;
+    }
+
+    uint32_t log2 = 63 - (uint32_t) __builtin_clzll((unsigned long long) size);
+    *fl = log2 - VKC_POOL_SMALL_LOG2 + 1;
+    *sl = (uint32_t) (size >> (log2 - VKC_POOL_SL_LOG2)) ^ VKC_POOL_SL_COUNT;
+}
+
+static void vkc_pool_insert(VkcMemoryTypePool* type, VkcMemoryRegion* region) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    vkc_pool_mapping(region->size, &fl, &sl);
+
+    VkcMemoryRegion* head = type->heads[fl][sl];
+    region->free = true;
+    region->prev_free = NULL;
+    region->next_free = head;
+    if (head) {
+        head->prev_free = region;
+    }
+
+    type->heads[fl][sl] = region;
+    type->fl_bitmap |= 1ull << fl;
+    type->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void vkc_pool_remove(VkcMemoryTypePool* type, VkcMemoryRegion* region) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    vkc_pool_mapping(region->size, &fl, &sl);
+
+    if (region->next_free) {
+        region->next_free->prev_free = region->prev_free;
+    }
+    if (region->prev_free) {
+        region->prev_free->next_free = region->next_free;
+    } else {
+        type->heads[fl][sl] = region->next_free;
+        if (!region->next_free) {
+            type->sl_bitmap[fl] &= ~(1u << sl);
+            if (!type->sl_bitmap[fl]) {
+                type->fl_bitmap &= ~(1ull << fl);
+            }
+        }
+    }
+
+    region->free = false;
+    region->prev_free = NULL;
+    region->next_free = NULL;
+}
+
+/**
+ * @brief Find a free range of at least `size` bytes with two bitmap scans.
+ *
+ * The size is rounded up to the next class boundary first, so any range in the class
+ * found fits without walking its list.
+ */
+static VkcMemoryRegion* vkc_pool_find(VkcMemoryTypePool* type, VkDeviceSize size) {
+    if (size < VKC_POOL_SMALL) {
+        size += (VKC_POOL_SMALL >> VKC_POOL_SL_LOG2) - 1;
+    } else {
+        uint32_t log2 = 63 - (uint32_t) __builtin_clzll((unsigned long long) size);
+        size += (1ull << (log2 - VKC_POOL_SL_LOG2)) - 1;
+    }
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    vkc_pool_mapping(size, &fl, &sl);
+
+    uint32_t sl_map = type->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint64_t fl_map = fl + 1 < VKC_POOL_FL_COUNT ? type->fl_bitmap & (~0ull << (fl + 1)) : 0;
+        if (!fl_map) {
+            return NULL;
+        }
+        fl = (uint32_t) __builtin_ctzll(fl_map);
+        sl_map = type->sl_bitmap[fl];
+    }
+
+    return type->heads[fl][__builtin_ctz(sl_map)];
+}
+
+/**
+ * @brief Make sure two records are on hand, enough for one carve.
+ */
+static bool vkc_pool_reserve(VkcMemoryTypePool* type) {
+    if (type->records && type->records->next_free) {
+        return true;
+    }
+
+    VkcMemoryBatch* batch = malloc(sizeof(*batch));
+    if (!batch) {
+        LOG_ERROR("[VkcMemoryPool] Failed to allocate region records.");
+        return false;
+    }
+
+    batch->next = type->batches;
+    type->batches = batch;
+    for (size_t i = 0; i < VKC_POOL_BATCH; i++) {
+        batch->regions[i].next_free = type->records;
+        type->records = &batch->regions[i];
+    }
+    return true;
+}
+
+static VkcMemoryRegion* vkc_pool_record(VkcMemoryTypePool* type) {
+    VkcMemoryRegion* region = type->records;
+    type->records = region->next_free;
+    *region = (VkcMemoryRegion) {0};
+    return region;
+}
+
+static void vkc_pool_recycle(VkcMemoryTypePool* type, VkcMemoryRegion* region) {
+    region->next_free = type->records;
+    type->records = region;
+}
+
+/**
+ * @brief Cut a range `offset` bytes in and return the upper part.
+ */
+static VkcMemoryRegion*
+vkc_pool_split(VkcMemoryTypePool* type, VkcMemoryRegion* region, VkDeviceSize offset) {
+    VkcMemoryRegion* upper = vkc_pool_record(type);
+    upper->block = region->block;
+    upper->offset = region->offset + offset;
+    upper->size = region->size - offset;
+    upper->prev = region;
+    upper->next = region->next;
+    if (region->next) {
+        region->next->prev = upper;
+    }
+
+    region->next = upper;
+    region->size = offset;
+    return upper;
+}
+
+static uint64_t vkc_pool_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * @brief Estimated process usage of a heap: the last report plus the pool's changes since.
+ */
+static VkDeviceSize vkc_pool_heap_usage(VkcMemoryPool* pool, uint32_t heap) {
+    VkcMemoryHeapBudget* budget = &pool->heaps[heap];
+    uint64_t usage = atomic_load_explicit(&budget->usage, memory_order_relaxed);
+    uint64_t bytes = atomic_load_explicit(&budget->bytes, memory_order_relaxed);
+    uint64_t base = atomic_load_explicit(&budget->base, memory_order_relaxed);
+    if (bytes >= base) {
+        return usage + (bytes - base);
+    }
+    return usage > base - bytes ? usage - (base - bytes) : 0;
+}
+
+static bool vkc_pool_heap_fits(VkcMemoryPool* pool, uint32_t heap, VkDeviceSize size) {
+    uint64_t budget = atomic_load_explicit(&pool->heaps[heap].budget, memory_order_relaxed);
+    VkDeviceSize usage = vkc_pool_heap_usage(pool, heap);
+    return usage <= budget && size <= budget - usage;
+}
+
+/**
+ * @brief Read every heap's budget and usage from VK_EXT_memory_budget. Caller holds the
+ *        budget lock.
+ */
+static void vkc_pool_budget_read(VkcMemoryPool* pool) {
+    atomic_store_explicit(&pool->budget_ops, 0, memory_order_relaxed);
+    if (!(pool->flags & VKC_MEMORY_POOL_MEMORY_BUDGET_BIT)) {
+        return;
+    }
+
+    // Blocks created during the query may or may not be in the report; either way the
+    // error is one block and lasts until the next read.
+    uint64_t bytes[VK_MAX_MEMORY_HEAPS];
+    for (uint32_t heap = 0; heap < pool->properties.memoryHeapCount; heap++) {
+        bytes[heap] = atomic_load_explicit(&pool->heaps[heap].bytes, memory_order_relaxed);
+    }
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+    };
+    VkPhysicalDeviceMemoryProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+        .pNext = &budget,
+    };
+    vkGetPhysicalDeviceMemoryProperties2(pool->physical, &properties);
+
+    for (uint32_t heap = 0; heap < pool->properties.memoryHeapCount; heap++) {
+        VkcMemoryHeapBudget* entry = &pool->heaps[heap];
+        atomic_store_explicit(&entry->budget, budget.heapBudget[heap], memory_order_relaxed);
+        atomic_store_explicit(&entry->usage, budget.heapUsage[heap], memory_order_relaxed);
+        atomic_store_explicit(&entry->base, bytes[heap], memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Account a block allocation or free against its heap, re-reading the budget
+ *        every VKC_POOL_BUDGET_REFRESH of them.
+ */
+static void
+vkc_pool_budget_track(VkcMemoryPool* pool, uint32_t heap, VkDeviceSize size, bool add) {
+    if (add) {
+        atomic_fetch_add_explicit(&pool->heaps[heap].bytes, size, memory_order_relaxed);
+    } else {
+        atomic_fetch_sub_explicit(&pool->heaps[heap].bytes, size, memory_order_relaxed);
+    }
+
+    if ((pool->flags & VKC_MEMORY_POOL_MEMORY_BUDGET_BIT)
+        && atomic_fetch_add_explicit(&pool->budget_ops, 1, memory_order_relaxed) + 1
+               >= VKC_POOL_BUDGET_REFRESH) {
+        pthread_mutex_lock(&pool->budget_lock);
+        vkc_pool_budget_read(pool);
+        pthread_mutex_unlock(&pool->budget_lock);
+    }
+}
+
+/**
+ * @brief Detach a range from the eviction list. Caller holds the budget lock.
+ */
+static void vkc_pool_lru_unlink(VkcMemoryPool* pool, VkcMemoryRegion* region) {
+    if (region->lru_prev) {
+        region->lru_prev->lru_next = region->lru_next;
+    } else {
+        pool->lru_head = region->lru_next;
+    }
+    if (region->lru_next) {
+        region->lru_next->lru_prev = region->lru_prev;
+    } else {
+        pool->lru_tail = region->lru_prev;
+    }
+    region->lru_prev = NULL;
+    region->lru_next = NULL;
+}
+
+/**
+ * @brief Take a range off the eviction list for good. Caller holds the budget lock.
+ */
+static void vkc_pool_lru_remove(VkcMemoryPool* pool, VkcMemoryRegion* region) {
+    vkc_pool_lru_unlink(pool, region);
+    region->evict = NULL;
+    region->evict_data = NULL;
+    atomic_fetch_sub_explicit(&pool->evictables, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Put a range at the most recently used end of the eviction list. Caller holds
+ *        the budget lock.
+ */
+static void vkc_pool_lru_push(VkcMemoryPool* pool, VkcMemoryRegion* region) {
+    region->lru_prev = NULL;
+    region->lru_next = pool->lru_head;
+    if (pool->lru_head) {
+        pool->lru_head->lru_prev = region;
+    } else {
+        pool->lru_tail = region;
+    }
+    pool->lru_head = region;
+}
+
+/**
+ * @brief Evict the heap's least recently used ranges until `size` bytes fit in its
+ *        budget, or ranges of that size were freed for reuse.
+ *
+ * @return true if anything was evicted.
+ */
+static bool vkc_pool_evict(VkcMemoryPool* pool, uint32_t heap, VkDeviceSize size) {
+    VkDeviceSize freed = 0;
+    bool evicted = false;
+    while (freed < size && !vkc_pool_heap_fits(pool, heap, size)) {
+        pthread_mutex_lock(&pool->budget_lock);
+        VkcMemoryRegion* region = pool->lru_tail;
+        while (region && region->block->heap != heap) {
+            region = region->lru_prev;
+        }
+        if (!region) {
+            pthread_mutex_unlock(&pool->budget_lock);
+            break;
+        }
+
+        VkcMemoryEvictCallback evict = region->evict;
+        void* user_data = region->evict_data;
+        freed += region->size;
+        vkc_pool_lru_remove(pool, region);
+        pthread_mutex_unlock(&pool->budget_lock);
+
+        // The owner frees the range, which takes the type lock; none may be held here.
+        evict(user_data);
+        atomic_fetch_add_explicit(&pool->evictions, 1, memory_order_relaxed);
+        evicted = true;
+    }
+    return evicted;
+}
+
+/**
+ * @brief Wait until a range is freed or the heap's budget grows to fit `size` bytes.
+ *
+ * @param deadline Monotonic time to give up at; set on the first stall of an allocation.
+ * @return false once the deadline has passed.
+ */
+static bool
+vkc_pool_stall(VkcMemoryPool* pool, uint32_t heap, VkDeviceSize size, uint64_t* deadline) {
+    uint64_t now = vkc_pool_now();
+    if (0 == *deadline) {
+        uint64_t stall = atomic_load_explicit(&pool->stall_ns, memory_order_relaxed);
+        *deadline = now + (stall ? stall : VKC_MEMORY_POOL_STALL);
+        atomic_fetch_add_explicit(&pool->stalls, 1, memory_order_relaxed);
+    }
+
+    bool woken = false;
+    pthread_mutex_lock(&pool->budget_lock);
+    atomic_fetch_add_explicit(&pool->stalled, 1, memory_order_relaxed);
+    while (!woken && now < *deadline) {
+        // Other processes free memory without signalling, so poll their usage too.
+        uint64_t until = *deadline - now > VKC_POOL_STALL_POLL ? now + VKC_POOL_STALL_POLL
+                                                                : *deadline;
+        struct timespec wake = {
+            .tv_sec = (time_t) (until / 1000000000ull),
+            .tv_nsec = (long) (until % 1000000000ull),
+        };
+        int waited = pthread_cond_timedwait(&pool->budget_wake, &pool->budget_lock, &wake);
+        woken = ETIMEDOUT != waited;
+
+        vkc_pool_budget_read(pool);
+        woken = woken || vkc_pool_heap_fits(pool, heap, size);
+        now = vkc_pool_now();
+    }
+    atomic_fetch_sub_explicit(&pool->stalled, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&pool->budget_lock);
+
+    return woken;
+}
+
+/**
+ * @brief Allocate a block and return one range spanning it. Caller holds the type lock.
+ *
+ * @param external Memory to import or make exportable, or NULL.
+ */
+static VkResult vkc_pool_block_create(
+    VkcMemoryPool* pool,
+    VkcMemoryTypePool* type,
+    VkDeviceSize size,
+    bool dedicated,
+    VkBuffer buffer,
+    const VkcMemoryExternal* external,
+    VkcMemoryRegion** region
+) {
+    if (atomic_load_explicit(&pool->blocks, memory_order_relaxed) >= pool->max_allocations) {
+        LOG_ERROR(
+            "[VkcMemoryPool] maxMemoryAllocationCount (%u) reached.", pool->max_allocations
+        );
+        return VK_ERROR_TOO_MANY_OBJECTS;
+    }
+
+    // Over budget is reported as a full heap, so callers spill to the next memory type.
+    uint32_t heap = pool->properties.memoryTypes[type->index].heapIndex;
+    int action = atomic_load_explicit(&pool->budget_action, memory_order_relaxed);
+    if (VKC_MEMORY_BUDGET_IGNORE != action && !vkc_pool_heap_fits(pool, heap, size)) {
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        LOG_DEBUG(
+            "[VkcMemoryPool] Block of %llu bytes exceeds the budget of heap %u.",
+            (unsigned long long) size,
+            heap
+        );
+#endif
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+
+    VkcMemoryBlock* block = calloc(1, sizeof(*block));
+    if (!block) {
+        LOG_ERROR("[VkcMemoryPool] Failed to allocate block.");
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    // Tells the driver the block backs this buffer alone, so it can place it as such.
+    VkMemoryDedicatedAllocateInfo dedicated_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .buffer = buffer,
+    };
+    const void* next = (dedicated && buffer && pool->requirements2) ? &dedicated_info : NULL;
+
+    VkMemoryAllocateFlagsInfo flags_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .pNext = next,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    };
+    if (pool->flags & VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT) {
+        next = &flags_info;
+    }
+
+    VkImportMemoryHostPointerInfoEXT host_info = {
+        .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+        .pNext = next,
+        .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+    };
+    VkImportMemoryFdInfoKHR fd_info = {
+        .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+        .pNext = next,
+        .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,
+        .fd = -1,
+    };
+    VkExportMemoryAllocateInfo export_info = {
+        .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+        .pNext = next,
+        .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,
+    };
+    if (external && external->host) {
+        host_info.pHostPointer = external->host;
+        next = &host_info;
+    } else if (external && external->fd >= 0) {
+        fd_info.fd = external->fd;
+        next = &fd_info;
+    } else if (external && external->exportable) {
+        next = &export_info;
+    }
+
+    VkMemoryAllocateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = next,
+        .allocationSize = size,
+        .memoryTypeIndex = type->index,
+    };
+    atomic_fetch_add_explicit(&pool->driver_allocations, 1, memory_order_relaxed);
+    VkResult result = vkAllocateMemory(pool->device, &info, pool->host, &block->memory);
+    if (VK_SUCCESS != result) {
+        free(block);
+        return result;
+    }
+
+    block->size = size;
+    block->heap = heap;
+    block->dedicated = dedicated;
+    block->next = type->blocks;
+    if (type->blocks) {
+        type->blocks->prev = block;
+    }
+    type->blocks = block;
+
+    atomic_fetch_add_explicit(&pool->blocks, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->block_bytes, size, memory_order_relaxed);
+    if (dedicated) {
+        atomic_fetch_add_explicit(&pool->dedicated_blocks, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&pool->dedicated_bytes, size, memory_order_relaxed);
+    }
+    vkc_pool_budget_track(pool, heap, size, true);
+
+    *region = vkc_pool_record(type);
+    (*region)->block = block;
+    (*region)->size = size;
+    block->first = *region;
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcMemoryPool] Allocated %s block of %llu bytes (type=%u).",
+        external ? "external" : dedicated ? "dedicated" : "pooled",
+        (unsigned long long) size,
+        type->index
+    );
+#endif
+
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Queue a span, merging it into the last one when they touch. Caller holds
+ *        the ranges lock.
+ */
+static bool vkc_pool_ranges_push(
+    VkcMemoryRangeList* list, VkcMemoryBlock* block, VkDeviceSize begin, VkDeviceSize end
+) {
+    // Writes usually land in order, so most spans extend the previous one.
+    if (list->count) {
+        VkcMemoryRange* last = &list->items[list->count - 1];
+        if (last->block == block && begin <= last->end && end >= last->begin) {
+            last->begin = begin < last->begin ? begin : last->begin;
+            last->end = end > last->end ? end : last->end;
+            return true;
+        }
+    }
+
+    if (list->count == list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 16;
+        VkcMemoryRange* items = realloc(list->items, capacity * sizeof(*items));
+        if (!items) {
+            LOG_ERROR("[VkcMemoryPool] Failed to grow mapped range list.");
+            return false;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    list->items[list->count++] = (VkcMemoryRange) {block, begin, end};
+    return true;
+}
+
+/**
+ * @brief Forget every span of a block. Caller holds the ranges lock.
+ */
+static void vkc_pool_ranges_drop(VkcMemoryRangeList* list, const VkcMemoryBlock* block) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < list->count; i++) {
+        if (list->items[i].block != block) {
+            list->items[kept++] = list->items[i];
+        }
+    }
+    list->count = kept;
+}
+
+static int vkc_pool_ranges_compare(const void* a, const void* b) {
+    const VkcMemoryRange* x = a;
+    const VkcMemoryRange* y = b;
+    if (x->block != y->block) {
+        return (uintptr_t) x->block < (uintptr_t) y->block ? -1 : 1;
+    }
+    return (x->begin > y->begin) - (x->begin < y->begin);
+}
+
+/**
+ * @brief Flush or invalidate every queued span in one driver call and clear the list.
+ *        Caller holds the ranges lock.
+ */
+static VkResult
+vkc_pool_ranges_submit(VkcMemoryPool* pool, VkcMemoryRangeList* list, bool invalidate) {
+    if (0 == list->count) {
+        return VK_SUCCESS;
+    }
+
+    // Sort and coalesce, so a block written in scattered pieces costs one range per run.
+    qsort(list->items, list->count, sizeof(*list->items), vkc_pool_ranges_compare);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < list->count; i++) {
+        VkcMemoryRange* range = &list->items[i];
+        VkcMemoryRange* last = count ? &list->items[count - 1] : NULL;
+        if (last && last->block == range->block && range->begin <= last->end) {
+            last->end = range->end > last->end ? range->end : last->end;
+        } else {
+            list->items[count++] = *range;
+        }
+    }
+
+    if (count > pool->mapped_capacity) {
+        VkMappedMemoryRange* ranges
+            = realloc(pool->mapped_ranges, list->capacity * sizeof(*ranges));
+        if (!ranges) {
+            LOG_ERROR("[VkcMemoryPool] Failed to allocate mapped ranges.");
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        pool->mapped_ranges = ranges;
+        pool->mapped_capacity = list->capacity;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        pool->mapped_ranges[i] = (VkMappedMemoryRange) {
+            .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .memory = list->items[i].block->memory,
+            .offset = list->items[i].begin,
+            .size = list->items[i].end - list->items[i].begin,
+        };
+    }
+
+    VkResult result = invalidate
+                          ? vkInvalidateMappedMemoryRanges(pool->device, count, pool->mapped_ranges)
+                          : vkFlushMappedMemoryRanges(pool->device, count, pool->mapped_ranges);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR(
+            "[VkcMemoryPool] Failed to %s %u mapped ranges: %d.",
+            invalidate ? "invalidate" : "flush",
+            count,
+            result
+        );
+        list->count = count;
+        return result;
+    }
+
+    list->count = 0;
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Queue the atom-aligned span covering part of a mapped allocation.
+ */
+static bool vkc_pool_mark(
+    VkcMemoryPool* pool,
+    VkcMemoryRangeList* list,
+    const VkcMemoryAllocation* allocation,
+    VkDeviceSize offset,
+    VkDeviceSize size
+) {
+    if (!pool || !allocation || !allocation->region || offset > allocation->size) {
+        LOG_ERROR("[VkcMemoryPool] Invalid mapped range.");
+        return false;
+    }
+
+    // Coherent memory needs neither call; this is the whole cost on most devices.
+    if (allocation->flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+        return true;
+    }
+
+    if (VK_WHOLE_SIZE == size) {
+        size = allocation->size - offset;
+    }
+    if (size > allocation->size - offset) {
+        LOG_ERROR("[VkcMemoryPool] Mapped range exceeds its allocation.");
+        return false;
+    }
+    if (0 == size) {
+        return true;
+    }
+
+    VkcMemoryTypePool* type
+        = atomic_load_explicit(&pool->types[allocation->type], memory_order_acquire);
+    VkcMemoryBlock* block = allocation->region->block;
+    bool queued = false;
+
+    pthread_mutex_lock(&type->lock);
+    if (block->mapped) {
+        // Non-coherent ranges are atom-aligned at allocation, so this never reaches a
+        // neighbour's bytes; only the block end can cut the last atom short.
+        VkDeviceSize start = allocation->offset + offset;
+        VkDeviceSize begin = start - start % pool->atom;
+        VkDeviceSize end = vkc_pool_align(start + size, pool->atom);
+        end = end < block->size ? end : block->size;
+
+        pthread_mutex_lock(&pool->ranges_lock);
+        queued = vkc_pool_ranges_push(list, block, begin, end);
+        pthread_mutex_unlock(&pool->ranges_lock);
+    } else {
+        LOG_ERROR("[VkcMemoryPool] Marked range is not mapped.");
+    }
+    pthread_mutex_unlock(&type->lock);
+
+    return queued;
+}
+
+/**
+ * @brief Free a block whose only range is `region`. Caller holds the type lock.
+ */
+static void
+vkc_pool_block_release(VkcMemoryPool* pool, VkcMemoryTypePool* type, VkcMemoryRegion* region) {
+    VkcMemoryBlock* block = region->block;
+    if (block->mapped) {
+        // Whatever was queued for the block died with its last range.
+        pthread_mutex_lock(&pool->ranges_lock);
+        vkc_pool_ranges_drop(&pool->flushes, block);
+        vkc_pool_ranges_drop(&pool->invalidates, block);
+        pthread_mutex_unlock(&pool->ranges_lock);
+        vkUnmapMemory(pool->device, block->memory);
+    }
+    vkFreeMemory(pool->device, block->memory, pool->host);
+
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        type->blocks = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+
+    atomic_fetch_sub_explicit(&pool->blocks, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&pool->block_bytes, block->size, memory_order_relaxed);
+    if (block->dedicated) {
+        atomic_fetch_sub_explicit(&pool->dedicated_blocks, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&pool->dedicated_bytes, block->size, memory_order_relaxed);
+    }
+    vkc_pool_budget_track(pool, block->heap, block->size, false);
+
+    vkc_pool_recycle(type, region);
+    free(block);
+}
+
+/**
+ * @brief Cut an aligned range of `size` bytes out of a free range already off the free
+ *        lists, returning the padding and the tail to them.
+ *
+ * Needs the two records vkc_pool_reserve() guarantees.
+ */
+static VkcMemoryRegion* vkc_pool_take(
+    VkcMemoryTypePool* type, VkcMemoryRegion* region, VkDeviceSize size, VkDeviceSize alignment
+) {
+    VkDeviceSize padding = vkc_pool_align(region->offset, alignment) - region->offset;
+    if (padding) {
+        VkcMemoryRegion* lower = region;
+        region = vkc_pool_split(type, lower, padding);
+        vkc_pool_insert(type, lower);
+    }
+    if (region->size - size >= VKC_POOL_MIN_SPLIT) {
+        vkc_pool_insert(type, vkc_pool_split(type, region, size));
+    }
+    return region;
+}
+
+/**
+ * @brief Take a range from the free lists, a new pooled block, or a dedicated block.
+ *        Caller holds the type lock.
+ *
+ * @param buffer Buffer a dedicated block is for, or VK_NULL_HANDLE.
+ * @param external External memory of a dedicated block, or NULL.
+ */
+static VkResult vkc_pool_carve(
+    VkcMemoryPool* pool,
+    VkcMemoryTypePool* type,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    bool dedicated,
+    VkBuffer buffer,
+    const VkcMemoryExternal* external,
+    VkcMemoryRegion** out
+) {
+    if (!vkc_pool_reserve(type)) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkcMemoryRegion* region = NULL;
+    if (dedicated) {
+        VkResult result = vkc_pool_block_create(pool, type, size, true, buffer, external, &region);
+        if (VK_SUCCESS == result) {
+            *out = region;
+        }
+        return result;
+    }
+
+    // Room for the worst-case padding, so whatever range comes back fits.
+    VkDeviceSize needed = size + alignment - 1;
+    region = vkc_pool_find(type, needed);
+    if (region) {
+        vkc_pool_remove(type, region);
+        if (region->block == type->spare) {
+            type->spare = NULL;
+        }
+    } else {
+        // Retry with smaller blocks when the heap is too fragmented or full for a whole one.
+        VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        for (VkDeviceSize block_size = type->block_size; block_size >= needed; block_size /= 2) {
+            result = vkc_pool_block_create(pool, type, block_size, false, NULL, NULL, &region);
+            if (VK_ERROR_OUT_OF_DEVICE_MEMORY != result) {
+                break;
+            }
+        }
+        if (VK_SUCCESS != result) {
+            return result;
+        }
+    }
+
+    *out = vkc_pool_take(type, region, size, alignment);
+    return VK_SUCCESS;
+}
+
+static void
+vkc_pool_release(VkcMemoryPool* pool, VkcMemoryTypePool* type, VkcMemoryRegion* region) {
+    if (region->block->dedicated) {
+        vkc_pool_block_release(pool, type, region);
+        return;
+    }
+
+    VkcMemoryRegion* prev = region->prev;
+    if (prev && prev->free) {
+        vkc_pool_remove(type, prev);
+        prev->size += region->size;
+        prev->next = region->next;
+        if (region->next) {
+            region->next->prev = prev;
+        }
+        vkc_pool_recycle(type, region);
+        region = prev;
+    }
+
+    VkcMemoryRegion* next = region->next;
+    if (next && next->free) {
+        vkc_pool_remove(type, next);
+        region->size += next->size;
+        region->next = next->next;
+        if (next->next) {
+            next->next->prev = region;
+        }
+        vkc_pool_recycle(type, next);
+    }
+
+    if (!region->prev && !region->next) {
+        // The block drained: keep one empty block per type, free the rest.
+        if (type->spare) {
+            vkc_pool_block_release(pool, type, region);
+            return;
+        }
+        type->spare = region->block;
+    }
+
+    vkc_pool_insert(type, region);
+}
+
+/**
+ * @brief How well a memory type suits a usage; higher is better, negative is unusable.
+ */
+static int vkc_pool_score(
+    const VkPhysicalDeviceMemoryProperties* properties, uint32_t index, VkcMemoryUsage usage
+) {
+    VkMemoryPropertyFlags flags = properties->memoryTypes[index].propertyFlags;
+    if (flags & (VK_MEMORY_PROPERTY_PROTECTED_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+        return -1;
+    }
+
+    bool device = flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    bool host = flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    bool coherent = flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bool cached = flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    if (VKC_MEMORY_USAGE_GPU_ONLY != usage && !host) {
+        return -1;
+    }
+
+    // AMD's uncached device-coherent types are meant for debug markers, not data.
+    VkMemoryPropertyFlags amd = VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD
+                                | VK_MEMORY_PROPERTY_DEVICE_UNCACHED_BIT_AMD;
+    int score = (flags & amd) ? 0 : 1;
+
+    switch (usage) {
+        case VKC_MEMORY_USAGE_GPU_ONLY:
+            score += (device ? 8 : 0) + (host ? 0 : 4);
+            break;
+        case VKC_MEMORY_USAGE_UPLOAD:
+            // Write-combined system memory streams best and keeps the BAR free.
+            score += (device ? 0 : 8) + (cached ? 0 : 4) + (coherent ? 2 : 0);
+            break;
+        case VKC_MEMORY_USAGE_READBACK:
+            // Cached reads beat uncached ones by far more than an invalidate costs.
+            score += (cached ? 8 : 0) + (device ? 0 : 4) + (coherent ? 2 : 0);
+            break;
+        case VKC_MEMORY_USAGE_DEVICE_UPLOAD: {
+            uint32_t heap = properties->memoryTypes[index].heapIndex;
+            bool rebar = device
+                         && (properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                         && properties->memoryHeaps[heap].size > VKC_POOL_BAR_SIZE;
+            score += (device ? 16 : 0) + (rebar ? 8 : 0) + (cached ? 0 : 4) + (coherent ? 2 : 0);
+            break;
+        }
+        default:
+            return -1;
+    }
+
+    return score;
+}
+
+/**
+ * @brief Order the memory types for every usage, best first. Ties keep index order.
+ */
+static void vkc_pool_rank(VkcMemoryPool* pool) {
+    for (uint32_t usage = 0; usage < VKC_MEMORY_USAGE_COUNT; usage++) {
+        int scores[VK_MAX_MEMORY_TYPES];
+        uint32_t* ranking = pool->ranking[usage];
+        uint32_t count = 0;
+
+        for (uint32_t index = 0; index < pool->properties.memoryTypeCount; index++) {
+            int score = vkc_pool_score(&pool->properties, index, (VkcMemoryUsage) usage);
+            if (score < 0) {
+                continue;
+            }
+
+            // Insertion sort: at most 32 types.
+            uint32_t slot = count++;
+            while (slot && scores[slot - 1] < score) {
+                scores[slot] = scores[slot - 1];
+                ranking[slot] = ranking[slot - 1];
+                slot--;
+            }
+            scores[slot] = score;
+            ranking[slot] = index;
+        }
+
+        pool->ranked[usage] = count;
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+        if (count) {
+            LOG_DEBUG(
+                "[VkcMemoryPool] Usage %u: best of %u types is %u (flags=0x%x).",
+                usage,
+                count,
+                ranking[0],
+                pool->properties.memoryTypes[ranking[0]].propertyFlags
+            );
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Query what VK_EXT_external_memory_host needs, dropping the import flag if the
+ *        device cannot honour it.
+ */
+static void vkc_pool_import_setup(VkcMemoryPool* pool) {
+    if (!(pool->flags & VKC_MEMORY_POOL_HOST_IMPORT_BIT)) {
+        return;
+    }
+
+    VkPhysicalDeviceExternalMemoryHostPropertiesEXT host = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT,
+    };
+    VkPhysicalDeviceProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &host,
+    };
+    vkGetPhysicalDeviceProperties2(pool->physical, &properties);
+
+    // Extension commands are not exported by the loader; fetch it from the device.
+    pool->host_pointer_properties = (PFN_vkGetMemoryHostPointerPropertiesEXT)
+        vkGetDeviceProcAddr(pool->device, "vkGetMemoryHostPointerPropertiesEXT");
+    if (!pool->host_pointer_properties || 0 == host.minImportedHostPointerAlignment) {
+        LOG_WARN("[VkcMemoryPool] VK_EXT_external_memory_host unavailable; imports disabled.");
+        pool->flags &= ~(VkcMemoryPoolFlags) VKC_MEMORY_POOL_HOST_IMPORT_BIT;
+        pool->host_pointer_properties = NULL;
+        return;
+    }
+    pool->import_alignment = host.minImportedHostPointerAlignment;
+}
+
+/**
+ * @brief Load vkGetMemoryFdKHR, dropping the external fd flag if the device lacks it.
+ */
+static void vkc_pool_external_setup(VkcMemoryPool* pool) {
+    if (!(pool->flags & VKC_MEMORY_POOL_EXTERNAL_FD_BIT)) {
+        return;
+    }
+
+    // Exports are dedicated allocations named to the driver, which takes Vulkan 1.1.
+    pool->memory_fd = (PFN_vkGetMemoryFdKHR) vkGetDeviceProcAddr(pool->device, "vkGetMemoryFdKHR");
+    if (!pool->memory_fd || !pool->requirements2) {
+        LOG_WARN("[VkcMemoryPool] VK_KHR_external_memory_fd unavailable; fd sharing disabled.");
+        pool->flags &= ~(VkcMemoryPoolFlags) VKC_MEMORY_POOL_EXTERNAL_FD_BIT;
+        pool->memory_fd = NULL;
+    }
+}
+
+static VkcMemoryTypePool* vkc_pool_type(VkcMemoryPool* pool, uint32_t index) {
+    VkcMemoryTypePool* type = atomic_load_explicit(&pool->types[index], memory_order_acquire);
+    if (type) {
+        return type;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    type = atomic_load_explicit(&pool->types[index], memory_order_relaxed);
+    if (!type) {
+        type = calloc(1, sizeof(*type));
+        if (type && 0 != pthread_mutex_init(&type->lock, NULL)) {
+            free(type);
+            type = NULL;
+        }
+
+        if (type) {
+            uint32_t heap = pool->properties.memoryTypes[index].heapIndex;
+            VkDeviceSize heap_size = pool->properties.memoryHeaps[heap].size;
+            type->index = index;
+            type->block_size = pool->block_size;
+            if (heap_size && type->block_size > heap_size / 8) {
+                type->block_size = heap_size / 8;
+            }
+            atomic_store_explicit(&pool->types[index], type, memory_order_release);
+        } else {
+            LOG_ERROR("[VkcMemoryPool] Failed to set up memory type %u.", index);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return type;
+}
+
+/**
+ * @brief Widen a pooled range in non-coherent memory to whole atoms, so flushing or
+ *        invalidating it never touches bytes of its neighbours.
+ */
+static void vkc_pool_atoms(
+    const VkcMemoryPool* pool,
+    VkMemoryPropertyFlags flags,
+    VkDeviceSize* size,
+    VkDeviceSize* alignment
+) {
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        *alignment = *alignment > pool->atom ? *alignment : pool->atom;
+        *size = vkc_pool_align(*size, pool->atom);
+    }
+}
+
+/**
+ * @brief Free range of a block fuller than `source` that best fits `size` bytes. Caller
+ *        holds the type lock.
+ *
+ * Fuller blocks win over tighter fits, so ranges drain toward the densest blocks and
+ * `source` can empty. Walks the ranges of every candidate block; meant for
+ * defragmentation passes, not the allocation path.
+ */
+static VkcMemoryRegion* vkc_pool_denser(
+    VkcMemoryTypePool* type,
+    const VkcMemoryBlock* source,
+    VkDeviceSize size,
+    VkDeviceSize alignment
+) {
+    uint64_t floor = atomic_load_explicit(&source->used, memory_order_relaxed);
+    VkcMemoryRegion* best = NULL;
+    uint64_t best_used = 0;
+
+    for (VkcMemoryBlock* block = type->blocks; block; block = block->next) {
+        uint64_t used = atomic_load_explicit(&block->used, memory_order_relaxed);
+        if (block == source || block->dedicated || used <= floor || used < best_used) {
+            continue;
+        }
+
+        for (VkcMemoryRegion* region = block->first; region; region = region->next) {
+            VkDeviceSize padding = vkc_pool_align(region->offset, alignment) - region->offset;
+            if (!region->free || region->size < size + padding) {
+                continue;
+            }
+            if (!best || used > best_used || region->size < best->size) {
+                best = region;
+                best_used = used;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Allocate a range, dedicated when `placement` asks for it or the size calls for it.
+ *
+ * @param buffer Buffer the range is for, named to the driver when it gets its own block.
+ */
+static VkResult vkc_pool_alloc(
+    VkcMemoryPool* pool,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryUsage usage,
+    VkcMemoryResource resource,
+    VkBuffer buffer,
+    VkcMemoryPlacement placement,
+    const VkcMemoryExternal* external,
+    VkcMemoryAllocation* allocation
+) {
+    if (!pool || !requirements || !allocation || 0 == requirements->size
+        || usage >= VKC_MEMORY_USAGE_COUNT) {
+        LOG_ERROR("[VkcMemoryPool] Invalid allocation request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *allocation = (VkcMemoryAllocation) {0};
+
+    VkDeviceSize size = requirements->size;
+    VkDeviceSize alignment = requirements->alignment ? requirements->alignment : 1;
+    if (VKC_MEMORY_RESOURCE_OPTIMAL == resource && pool->granularity > 1) {
+        // Whole granularity pages: no linear resource can share one with this image.
+        alignment = alignment > pool->granularity ? alignment : pool->granularity;
+        size = vkc_pool_align(size, pool->granularity);
+    }
+
+    VkcMemoryBudgetAction action
+        = (VkcMemoryBudgetAction) atomic_load_explicit(&pool->budget_action, memory_order_relaxed);
+    uint64_t deadline = 0;
+    bool spilled = false;
+
+    VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+    for (uint32_t rank = 0; rank < pool->ranked[usage]; rank++) {
+        uint32_t index = pool->ranking[usage][rank];
+        if (!(requirements->memoryTypeBits & (1u << index))) {
+            continue;
+        }
+
+        VkcMemoryTypePool* type = vkc_pool_type(pool, index);
+        if (!type) {
+            result = VK_ERROR_OUT_OF_HOST_MEMORY;
+            break;
+        }
+
+        VkDeviceSize type_size = size;
+        VkDeviceSize type_alignment = alignment;
+        VkMemoryPropertyFlags flags = pool->properties.memoryTypes[index].propertyFlags;
+        vkc_pool_atoms(pool, flags, &type_size, &type_alignment);
+
+        // Ranges larger than half a block, counting the worst-case alignment padding
+        // vkc_pool_carve() reserves, would waste the rest of it; they get their own.
+        bool dedicated = VKC_MEMORY_PLACEMENT_POOLED != placement
+                         || type_size > type->block_size / 2
+                         || type_alignment - 1 > type->block_size / 2 - type_size;
+        VkcMemoryPlacement taken = placement;
+        if (dedicated && VKC_MEMORY_PLACEMENT_POOLED == placement) {
+            taken = VKC_MEMORY_PLACEMENT_DEDICATED_SIZE;
+        }
+
+        // A dedicated block has no neighbours, and must match the resource's size exactly
+        // when the driver is told what it backs.
+        if (dedicated) {
+            type_size = requirements->size;
+            type_alignment = alignment;
+        }
+
+        // Retry the same type while evicting or waiting makes progress.
+        for (;;) {
+            VkcMemoryRegion* region = NULL;
+            pthread_mutex_lock(&type->lock);
+            result = vkc_pool_carve(
+                pool, type, type_size, type_alignment, dedicated, buffer, external, &region
+            );
+            if (VK_SUCCESS == result) {
+                *allocation = (VkcMemoryAllocation) {
+                    .memory = region->block->memory,
+                    .offset = region->offset,
+                    .size = requirements->size,
+                    .type = index,
+                    .flags = flags,
+                    .placement = taken,
+                    .region = region,
+                };
+                atomic_fetch_add_explicit(&pool->allocations, 1, memory_order_relaxed);
+                atomic_fetch_add_explicit(
+                    &pool->allocated_bytes, region->size, memory_order_relaxed
+                );
+                atomic_fetch_add_explicit(&region->block->used, region->size, memory_order_relaxed);
+                if (spilled) {
+                    atomic_fetch_add_explicit(&pool->spills, 1, memory_order_relaxed);
+                }
+            }
+            pthread_mutex_unlock(&type->lock);
+
+            if (VK_ERROR_OUT_OF_DEVICE_MEMORY != result || VKC_MEMORY_BUDGET_IGNORE == action) {
+                break;
+            }
+
+            // Room for the smallest block vkc_pool_carve() would settle for.
+            uint32_t heap = pool->properties.memoryTypes[index].heapIndex;
+            VkDeviceSize needed = type_size;
+            if (!dedicated) {
+                needed = type->block_size;
+                while (needed / 2 >= type_size + type_alignment - 1) {
+                    needed /= 2;
+                }
+            }
+
+            bool retry = false;
+            if (VKC_MEMORY_BUDGET_EVICT == action) {
+                retry = vkc_pool_evict(pool, heap, needed);
+            } else if (VKC_MEMORY_BUDGET_STALL == action) {
+                retry = vkc_pool_stall(pool, heap, needed, &deadline);
+            }
+            if (!retry) {
+                spilled = true;
+                break;
+            }
+        }
+
+        // Only a full heap is worth trying the next memory type for.
+        if (VK_ERROR_OUT_OF_DEVICE_MEMORY != result) {
+            break;
+        }
+    }
+
+    if (VK_SUCCESS != result) {
+        LOG_ERROR(
+            "[VkcMemoryPool] Failed to allocate %llu bytes (types=0x%x, usage=%u): %d.",
+            (unsigned long long) requirements->size,
+            requirements->memoryTypeBits,
+            (unsigned) usage,
+            result
+        );
+    }
+    return result;
+}
+
+/**
+ * @brief Give external memory a block of its own in a given memory type.
+ *
+ * @param size Bytes to allocate or import.
+ * @param buffer Buffer the block is dedicated to, or VK_NULL_HANDLE.
+ */
+static VkResult vkc_pool_adopt(
+    VkcMemoryPool* pool,
+    uint32_t index,
+    VkDeviceSize size,
+    const VkMemoryRequirements* requirements,
+    VkBuffer buffer,
+    const VkcMemoryExternal* external,
+    VkcMemoryPlacement placement,
+    VkcMemoryAllocation* allocation
+) {
+    VkcMemoryTypePool* type = vkc_pool_type(pool, index);
+    if (!type) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkcMemoryRegion* region = NULL;
+    VkResult result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    pthread_mutex_lock(&type->lock);
+    if (vkc_pool_reserve(type)) {
+        result = vkc_pool_block_create(pool, type, size, true, buffer, external, &region);
+    }
+    if (VK_SUCCESS == result) {
+        *allocation = (VkcMemoryAllocation) {
+            .memory = region->block->memory,
+            .offset = 0,
+            .size = requirements->size,
+            .type = index,
+            .flags = pool->properties.memoryTypes[index].propertyFlags,
+            .placement = placement,
+            .region = region,
+        };
+        atomic_fetch_add_explicit(&pool->allocations, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&pool->allocated_bytes, region->size, memory_order_relaxed);
+        atomic_fetch_add_explicit(&region->block->used, region->size, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&type->lock);
+    return result;
+}
+
+/**
+ * @brief Allocate memory for a buffer, dedicated if the driver asks, and bind it.
+ *
+ * @param external Set to make the memory exportable, or NULL.
+ */
+static VkResult vkc_pool_bind(
+    VkcMemoryPool* pool,
+    VkBuffer buffer,
+    VkcMemoryUsage usage,
+    const VkcMemoryExternal* external,
+    VkcMemoryAllocation* allocation
+) {
+    VkMemoryRequirements requirements;
+    VkcMemoryPlacement placement = VKC_MEMORY_PLACEMENT_POOLED;
+    if (pool->requirements2) {
+        VkMemoryDedicatedRequirements dedicated = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        };
+        VkMemoryRequirements2 requirements2 = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+            .pNext = &dedicated,
+        };
+        VkBufferMemoryRequirementsInfo2 info = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+            .buffer = buffer,
+        };
+        vkGetBufferMemoryRequirements2(pool->device, &info, &requirements2);
+
+        requirements = requirements2.memoryRequirements;
+        if (dedicated.requiresDedicatedAllocation) {
+            placement = VKC_MEMORY_PLACEMENT_DEDICATED_REQUIRED;
+        } else if (dedicated.prefersDedicatedAllocation) {
+            placement = VKC_MEMORY_PLACEMENT_DEDICATED_PREFERRED;
+        }
+    } else {
+        vkGetBufferMemoryRequirements(pool->device, buffer, &requirements);
+    }
+
+    // Exported memory is visible to another process in full: it never shares a block.
+    if (external) {
+        placement = VKC_MEMORY_PLACEMENT_EXPORTED;
+    }
+
+    VkResult result = vkc_pool_alloc(
+        pool,
+        &requirements,
+        usage,
+        VKC_MEMORY_RESOURCE_LINEAR,
+        buffer,
+        placement,
+        external,
+        allocation
+    );
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    result = vkBindBufferMemory(pool->device, buffer, allocation->memory, allocation->offset);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcMemoryPool] Failed to bind buffer memory: %d.", result);
+        vkc_memory_pool_free(pool, allocation);
+    }
+    return result;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcMemoryPool* vkc_memory_pool_create(
+    VkPhysicalDevice physical,
+    VkDevice device,
+    const VkAllocationCallbacks* callbacks,
+    VkDeviceSize block_size,
+    VkcMemoryPoolFlags flags
+) {
+    if (!physical || !device) {
+        LOG_ERROR("[VkcMemoryPool] Missing device.");
+        return NULL;
+    }
+
+    VkcMemoryPool* pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        LOG_ERROR("[VkcMemoryPool] Failed to allocate pool.");
+        return NULL;
+    }
+
+    if (0 != pthread_mutex_init(&pool->lock, NULL)) {
+        LOG_ERROR("[VkcMemoryPool] Failed to initialize pool mutex.");
+        free(pool);
+        return NULL;
+    }
+
+    if (0 != pthread_mutex_init(&pool->ranges_lock, NULL)) {
+        LOG_ERROR("[VkcMemoryPool] Failed to initialize range mutex.");
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        return NULL;
+    }
+
+    // Stalled allocations wait on a monotonic clock so wall-clock jumps cannot extend them.
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    int wake = pthread_cond_init(&pool->budget_wake, &attributes);
+    pthread_condattr_destroy(&attributes);
+    if (0 != wake || 0 != pthread_mutex_init(&pool->budget_lock, NULL)) {
+        LOG_ERROR("[VkcMemoryPool] Failed to initialize budget tracking.");
+        if (0 == wake) {
+            pthread_cond_destroy(&pool->budget_wake);
+        }
+        pthread_mutex_destroy(&pool->ranges_lock);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        return NULL;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical, &properties);
+    vkGetPhysicalDeviceMemoryProperties(physical, &pool->properties);
+
+    pool->physical = physical;
+    pool->device = device;
+    pool->granularity = properties.limits.bufferImageGranularity;
+    pool->max_allocations = properties.limits.maxMemoryAllocationCount;
+    if (0 == pool->max_allocations) {
+        pool->max_allocations = UINT32_MAX;
+    }
+    pool->requirements2 = properties.apiVersion >= VK_API_VERSION_1_1;
+    pool->atom = properties.limits.nonCoherentAtomSize;
+    if (0 == pool->atom) {
+        pool->atom = 1;
+    }
+    pool->block_size = block_size ? block_size : VKC_MEMORY_POOL_BLOCK_SIZE;
+    pool->flags = flags;
+    if (callbacks) {
+        pool->callbacks = *callbacks;
+        pool->host = &pool->callbacks;
+    }
+    vkc_pool_rank(pool);
+    vkc_pool_import_setup(pool);
+    vkc_pool_external_setup(pool);
+
+    // Without the extension, leave a fifth of each heap to the rest of the system.
+    for (uint32_t heap = 0; heap < pool->properties.memoryHeapCount; heap++) {
+        VkDeviceSize size = pool->properties.memoryHeaps[heap].size;
+        atomic_init(&pool->heaps[heap].budget, size / 10 * 8);
+    }
+    vkc_pool_budget_read(pool);
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcMemoryPool] Created pool (block=%llu, granularity=%llu, types=%u, flags=0x%x).",
+        (unsigned long long) pool->block_size,
+        (unsigned long long) pool->granularity,
+        pool->properties.memoryTypeCount,
+        pool->flags
+    );
+#endif
+
+    return pool;
+}
+
+void vkc_memory_pool_destroy(VkcMemoryPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    uint64_t live = atomic_load_explicit(&pool->allocations, memory_order_relaxed);
+    if (live) {
+        LOG_DEBUG(
+            "[VkcMemoryPool] Destroying pool with %llu live ranges.", (unsigned long long) live
+        );
+    }
+#endif
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+        VkcMemoryTypePool* type = atomic_load_explicit(&pool->types[i], memory_order_acquire);
+        if (!type) {
+            continue;
+        }
+
+        VkcMemoryBlock* block = type->blocks;
+        while (block) {
+            VkcMemoryBlock* next = block->next;
+            if (block->mapped) {
+                vkUnmapMemory(pool->device, block->memory);
+            }
+            vkFreeMemory(pool->device, block->memory, pool->host);
+            free(block);
+            block = next;
+        }
+
+        VkcMemoryBatch* batch = type->batches;
+        while (batch) {
+            VkcMemoryBatch* next = batch->next;
+            free(batch);
+            batch = next;
+        }
+
+        pthread_mutex_destroy(&type->lock);
+        free(type);
+    }
+
+    free(pool->flushes.items);
+    free(pool->invalidates.items);
+    free(pool->mapped_ranges);
+    pthread_cond_destroy(&pool->budget_wake);
+    pthread_mutex_destroy(&pool->budget_lock);
+    pthread_mutex_destroy(&pool->ranges_lock);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+VkResult vkc_memory_pool_alloc(
+    VkcMemoryPool* pool,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryUsage usage,
+    VkcMemoryResource resource,
+    VkcMemoryAllocation* allocation
+) {
+    return vkc_pool_alloc(
+        pool,
+        requirements,
+        usage,
+        resource,
+        VK_NULL_HANDLE,
+        VKC_MEMORY_PLACEMENT_POOLED,
+        NULL,
+        allocation
+    );
+}
+
+void vkc_memory_pool_free(VkcMemoryPool* pool, VkcMemoryAllocation* allocation) {
+    if (!pool || !allocation || !allocation->region) {
+        return;
+    }
+
+    VkcMemoryTypePool* type
+        = atomic_load_explicit(&pool->types[allocation->type], memory_order_acquire);
+    VkcMemoryRegion* region = allocation->region;
+
+    pthread_mutex_lock(&type->lock);
+    if (atomic_load_explicit(&pool->evictables, memory_order_relaxed)) {
+        pthread_mutex_lock(&pool->budget_lock);
+        if (region->evict) {
+            vkc_pool_lru_remove(pool, region);
+        }
+        pthread_mutex_unlock(&pool->budget_lock);
+    }
+    atomic_fetch_sub_explicit(&pool->allocations, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&pool->allocated_bytes, region->size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&region->block->used, region->size, memory_order_relaxed);
+    vkc_pool_release(pool, type, region);
+    pthread_mutex_unlock(&type->lock);
+
+    // Stalled allocations retry on any free: the range may be reused as it is.
+    if (atomic_load_explicit(&pool->stalled, memory_order_relaxed)) {
+        pthread_mutex_lock(&pool->budget_lock);
+        pthread_cond_broadcast(&pool->budget_wake);
+        pthread_mutex_unlock(&pool->budget_lock);
+    }
+
+    *allocation = (VkcMemoryAllocation) {0};
+}
+
+VkResult vkc_memory_pool_bind_buffer(
+    VkcMemoryPool* pool,
+    VkBuffer buffer,
+    VkcMemoryUsage usage,
+    VkcMemoryAllocation* allocation
+) {
+    if (!pool || !buffer || !allocation) {
+        LOG_ERROR("[VkcMemoryPool] Invalid buffer binding.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    return vkc_pool_bind(pool, buffer, usage, NULL, allocation);
+}
+
+VkResult vkc_memory_pool_bind_exportable(
+    VkcMemoryPool* pool,
+    VkBuffer buffer,
+    VkcMemoryUsage usage,
+    VkcMemoryAllocation* allocation
+) {
+    if (!pool || !buffer || !allocation) {
+        LOG_ERROR("[VkcMemoryPool] Invalid buffer binding.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *allocation = (VkcMemoryAllocation) {0};
+    if (!(pool->flags & VKC_MEMORY_POOL_EXTERNAL_FD_BIT)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkcMemoryExternal external = {.fd = -1, .exportable = true};
+    return vkc_pool_bind(pool, buffer, usage, &external, allocation);
+}
+
+VkResult vkc_memory_pool_export_fd(
+    VkcMemoryPool* pool, const VkcMemoryAllocation* allocation, int* fd
+) {
+    if (!pool || !allocation || !allocation->region || !fd) {
+        LOG_ERROR("[VkcMemoryPool] Invalid export request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *fd = -1;
+    if (VKC_MEMORY_PLACEMENT_EXPORTED != allocation->placement) {
+        LOG_ERROR("[VkcMemoryPool] Memory @ %p is not exportable.", (void*) allocation->memory);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkMemoryGetFdInfoKHR info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+        .memory = allocation->memory,
+        .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,
+    };
+    VkResult result = pool->memory_fd(pool->device, &info, fd);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcMemoryPool] Failed to export memory @ %p: %d.", (void*) info.memory, result);
+        *fd = -1;
+    }
+    return result;
+}
+
+VkResult vkc_memory_pool_import_fd(
+    VkcMemoryPool* pool,
+    int fd,
+    VkBuffer buffer,
+    uint32_t type,
+    VkDeviceSize size,
+    VkcMemoryAllocation* allocation
+) {
+    if (!pool || fd < 0 || !buffer || !allocation || 0 == size) {
+        LOG_ERROR("[VkcMemoryPool] Invalid import request.");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *allocation = (VkcMemoryAllocation) {0};
+    if (!(pool->flags & VKC_MEMORY_POOL_EXTERNAL_FD_BIT)) {
+        close(fd);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    // The exporter chose the type; an importer on the same device must use it as is.
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(pool->device, buffer, &requirements);
+    if (type >= pool->properties.memoryTypeCount || !(requirements.memoryTypeBits & (1u << type))
+        || size < requirements.size) {
+        LOG_ERROR(
+            "[VkcMemoryPool] fd %d (type=%u, %llu bytes) cannot back the buffer.",
+            fd,
+            type,
+            (unsigned long long) size
+        );
+        close(fd);
+        return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+    }
+
+    VkcMemoryExternal external = {.fd = fd};
+    VkResult result = vkc_pool_adopt(
+        pool,
+        type,
+        size,
+        &requirements,
+        buffer,
+        &external,
+        VKC_MEMORY_PLACEMENT_IMPORTED_FD,
+        allocation
+    );
+    if (VK_SUCCESS != result) {
+        // A successful import hands the fd to the driver; a failed one leaves it here.
+        LOG_ERROR("[VkcMemoryPool] Failed to import fd %d: %d.", fd, result);
+        close(fd);
+        return result;
+    }
+
+    result = vkBindBufferMemory(pool->device, buffer, allocation->memory, allocation->offset);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcMemoryPool] Failed to bind buffer memory: %d.", result);
+        vkc_memory_pool_free(pool, allocation);
+    }
+    return result;
+}
+
+VkDeviceSize vkc_memory_pool_import_alignment(VkcMemoryPool* pool) {
+    return pool ? pool->import_alignment : 0;
+}
+
+VkResult vkc_memory_pool_import_host(
+    VkcMemoryPool* pool,
+    void* pointer,
+    VkDeviceSize size,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryAllocation* allocation
+) {
+    if (!pool || !pointer || !requirements || !allocation || 0 == requirements->size) {
+        LOG_ERROR("[VkcMemoryPool] Invalid import request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *allocation = (VkcMemoryAllocation) {0};
+
+    if (!(pool->flags & VKC_MEMORY_POOL_HOST_IMPORT_BIT)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    // The import maps the caller's pages into the device: nothing may be cut short.
+    VkDeviceSize alignment = pool->import_alignment;
+    if (0 != (uintptr_t) pointer % alignment || 0 != size % alignment
+        || size < requirements->size) {
+        return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+    }
+
+    VkMemoryHostPointerPropertiesEXT properties = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT,
+    };
+    VkResult result = pool->host_pointer_properties(
+        pool->device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, pointer, &properties
+    );
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcMemoryPool] Host pointer %p cannot be imported: %d.", pointer, result);
+        return result;
+    }
+
+    // The device reads the pages in place, like a staging buffer. The pool never maps
+    // them, so only coherent types spare the caller flushes it could not make.
+    uint32_t bits = properties.memoryTypeBits & requirements->memoryTypeBits;
+    for (uint32_t i = 0; i < pool->properties.memoryTypeCount; i++) {
+        VkMemoryPropertyFlags flags = pool->properties.memoryTypes[i].propertyFlags;
+        if (!(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            bits &= ~(1u << i);
+        }
+    }
+    uint32_t index = 0;
+    if (!vkc_memory_pool_type(pool, VKC_MEMORY_USAGE_UPLOAD, bits, &index)) {
+        LOG_ERROR(
+            "[VkcMemoryPool] No memory type can import %p (types=0x%x, resource=0x%x).",
+            pointer,
+            properties.memoryTypeBits,
+            requirements->memoryTypeBits
+        );
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkcMemoryExternal external = {.host = pointer, .fd = -1};
+    result = vkc_pool_adopt(
+        pool,
+        index,
+        size,
+        requirements,
+        VK_NULL_HANDLE,
+        &external,
+        VKC_MEMORY_PLACEMENT_IMPORTED,
+        allocation
+    );
+    if (VK_SUCCESS != result) {
+        LOG_ERROR(
+            "[VkcMemoryPool] Failed to import %llu bytes @ %p: %d.",
+            (unsigned long long) size,
+            pointer,
+            result
+        );
+    }
+    return result;
+}
+
+VkResult vkc_memory_pool_relocate(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    const VkMemoryRequirements* requirements,
+    VkcMemoryAllocation* target
+) {
+    if (!pool || !allocation || !allocation->region || !requirements || !target
+        || 0 == requirements->size) {
+        LOG_ERROR("[VkcMemoryPool] Invalid relocation request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *target = (VkcMemoryAllocation) {0};
+
+    // Dedicated ranges have their block to themselves; there is nothing to pack.
+    if (VKC_MEMORY_PLACEMENT_POOLED != allocation->placement
+        || !(requirements->memoryTypeBits & (1u << allocation->type))) {
+        return VK_INCOMPLETE;
+    }
+
+    VkDeviceSize size = requirements->size;
+    VkDeviceSize alignment = requirements->alignment ? requirements->alignment : 1;
+    vkc_pool_atoms(pool, allocation->flags, &size, &alignment);
+
+    VkcMemoryTypePool* type
+        = atomic_load_explicit(&pool->types[allocation->type], memory_order_acquire);
+    VkResult result = VK_INCOMPLETE;
+
+    pthread_mutex_lock(&type->lock);
+    VkcMemoryRegion* region = NULL;
+    if (vkc_pool_reserve(type)) {
+        region = vkc_pool_denser(type, allocation->region->block, size, alignment);
+    } else {
+        result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    if (region) {
+        vkc_pool_remove(type, region);
+        region = vkc_pool_take(type, region, size, alignment);
+        *target = (VkcMemoryAllocation) {
+            .memory = region->block->memory,
+            .offset = region->offset,
+            .size = requirements->size,
+            .type = allocation->type,
+            .flags = allocation->flags,
+            .placement = VKC_MEMORY_PLACEMENT_POOLED,
+            .region = region,
+        };
+        atomic_fetch_add_explicit(&pool->allocations, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&pool->allocated_bytes, region->size, memory_order_relaxed);
+        atomic_fetch_add_explicit(&region->block->used, region->size, memory_order_relaxed);
+        result = VK_SUCCESS;
+    }
+    pthread_mutex_unlock(&type->lock);
+
+    return result;
+}
+
+void vkc_memory_pool_trim(VkcMemoryPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+        VkcMemoryTypePool* type = atomic_load_explicit(&pool->types[i], memory_order_acquire);
+        if (!type) {
+            continue;
+        }
+
+        pthread_mutex_lock(&type->lock);
+        VkcMemoryBlock* spare = type->spare;
+        if (spare) {
+            // A drained block is one free range.
+            type->spare = NULL;
+            vkc_pool_remove(type, spare->first);
+            vkc_pool_block_release(pool, type, spare->first);
+        }
+        pthread_mutex_unlock(&type->lock);
+    }
+}
+
+VkDevice vkc_memory_pool_device(VkcMemoryPool* pool) {
+    return pool ? pool->device : VK_NULL_HANDLE;
+}
+
+VkPhysicalDevice vkc_memory_pool_physical(VkcMemoryPool* pool) {
+    return pool ? pool->physical : VK_NULL_HANDLE;
+}
+
+VkcMemoryPoolFlags vkc_memory_pool_flags(VkcMemoryPool* pool) {
+    return pool ? pool->flags : 0;
+}
+
+const VkAllocationCallbacks* vkc_memory_pool_callbacks(VkcMemoryPool* pool) {
+    return pool ? pool->host : NULL;
+}
+
+bool vkc_memory_pool_type(
+    VkcMemoryPool* pool, VkcMemoryUsage usage, uint32_t memory_type_bits, uint32_t* type
+) {
+    if (!pool || !type || usage >= VKC_MEMORY_USAGE_COUNT) {
+        return false;
+    }
+
+    for (uint32_t rank = 0; rank < pool->ranked[usage]; rank++) {
+        if (memory_type_bits & (1u << pool->ranking[usage][rank])) {
+            *type = pool->ranking[usage][rank];
+            return true;
+        }
+    }
+    return false;
+}
+
+VkResult vkc_memory_pool_map(
+    VkcMemoryPool* pool, const VkcMemoryAllocation* allocation, void** data
+) {
+    if (!pool || !allocation || !allocation->region || !data) {
+        LOG_ERROR("[VkcMemoryPool] Invalid map request.");
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+
+    VkcMemoryTypePool* type
+        = atomic_load_explicit(&pool->types[allocation->type], memory_order_acquire);
+    VkcMemoryBlock* block = allocation->region->block;
+    VkResult result = VK_SUCCESS;
+
+    pthread_mutex_lock(&type->lock);
+    if (!block->mapped) {
+        result = vkMapMemory(pool->device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped);
+    }
+    if (VK_SUCCESS == result) {
+        block->maps++;
+        *data = (uint8_t*) block->mapped + allocation->offset;
+    } else {
+        block->mapped = NULL;
+        LOG_ERROR("[VkcMemoryPool] Failed to map memory: %d.", result);
+    }
+    pthread_mutex_unlock(&type->lock);
+
+    return result;
+}
+
+void vkc_memory_pool_unmap(VkcMemoryPool* pool, const VkcMemoryAllocation* allocation) {
+    if (!pool || !allocation || !allocation->region) {
+        return;
+    }
+
+    VkcMemoryTypePool* type
+        = atomic_load_explicit(&pool->types[allocation->type], memory_order_acquire);
+    VkcMemoryBlock* block = allocation->region->block;
+
+    pthread_mutex_lock(&type->lock);
+    if (block->maps && 0 == --block->maps) {
+        // Queued writes must reach the device before the mapping goes; queued
+        // invalidates have no one left to read them.
+        pthread_mutex_lock(&pool->ranges_lock);
+        for (uint32_t i = 0; i < pool->flushes.count; i++) {
+            if (pool->flushes.items[i].block == block) {
+                vkc_pool_ranges_submit(pool, &pool->flushes, false);
+                break;
+            }
+        }
+        vkc_pool_ranges_drop(&pool->flushes, block);
+        vkc_pool_ranges_drop(&pool->invalidates, block);
+        pthread_mutex_unlock(&pool->ranges_lock);
+
+        vkUnmapMemory(pool->device, block->memory);
+        block->mapped = NULL;
+    }
+    pthread_mutex_unlock(&type->lock);
+}
+
+bool vkc_memory_pool_mark_flush(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    VkDeviceSize offset,
+    VkDeviceSize size
+) {
+    return vkc_pool_mark(pool, pool ? &pool->flushes : NULL, allocation, offset, size);
+}
+
+bool vkc_memory_pool_mark_invalidate(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    VkDeviceSize offset,
+    VkDeviceSize size
+) {
+    return vkc_pool_mark(pool, pool ? &pool->invalidates : NULL, allocation, offset, size);
+}
+
+VkResult vkc_memory_pool_flush(VkcMemoryPool* pool) {
+    if (!pool) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    pthread_mutex_lock(&pool->ranges_lock);
+    VkResult result = vkc_pool_ranges_submit(pool, &pool->flushes, false);
+    pthread_mutex_unlock(&pool->ranges_lock);
+    return result;
+}
+
+VkResult vkc_memory_pool_invalidate(VkcMemoryPool* pool) {
+    if (!pool) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    pthread_mutex_lock(&pool->ranges_lock);
+    VkResult result = vkc_pool_ranges_submit(pool, &pool->invalidates, true);
+    pthread_mutex_unlock(&pool->ranges_lock);
+    return result;
+}
+
+bool vkc_memory_pool_budget(VkcMemoryPool* pool, uint32_t heap, VkcMemoryBudget* budget) {
+    if (!pool || !budget || heap >= pool->properties.memoryHeapCount) {
+        return false;
+    }
+
+    *budget = (VkcMemoryBudget) {
+        .budget = atomic_load_explicit(&pool->heaps[heap].budget, memory_order_relaxed),
+        .usage = vkc_pool_heap_usage(pool, heap),
+        .pool_bytes = atomic_load_explicit(&pool->heaps[heap].bytes, memory_order_relaxed),
+    };
+    return true;
+}
+
+void vkc_memory_pool_budget_refresh(VkcMemoryPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->budget_lock);
+    vkc_pool_budget_read(pool);
+    pthread_mutex_unlock(&pool->budget_lock);
+}
+
+bool vkc_memory_pool_budget_policy(VkcMemoryPool* pool, const VkcMemoryBudgetPolicy* policy) {
+    if (!pool || (policy && policy->action > VKC_MEMORY_BUDGET_STALL)) {
+        LOG_ERROR("[VkcMemoryPool] Invalid budget policy.");
+        return false;
+    }
+
+    VkcMemoryBudgetPolicy applied = policy ? *policy : (VkcMemoryBudgetPolicy) {0};
+    atomic_store_explicit(&pool->stall_ns, applied.stall_ns, memory_order_relaxed);
+    atomic_store_explicit(&pool->budget_action, (int) applied.action, memory_order_relaxed);
+    return true;
+}
+
+bool vkc_memory_pool_evictable(
+    VkcMemoryPool* pool,
+    const VkcMemoryAllocation* allocation,
+    VkcMemoryEvictCallback evict,
+    void* user_data
+) {
+    if (!pool || !allocation || !allocation->region) {
+        LOG_ERROR("[VkcMemoryPool] Invalid evictable range.");
+        return false;
+    }
+
+    VkcMemoryRegion* region = allocation->region;
+    pthread_mutex_lock(&pool->budget_lock);
+    if (region->evict) {
+        vkc_pool_lru_remove(pool, region);
+    }
+    if (evict) {
+        region->evict = evict;
+        region->evict_data = user_data;
+        vkc_pool_lru_push(pool, region);
+        atomic_fetch_add_explicit(&pool->evictables, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&pool->budget_lock);
+    return true;
+}
+
+void vkc_memory_pool_touch(VkcMemoryPool* pool, const VkcMemoryAllocation* allocation) {
+    if (!pool || !allocation || !allocation->region) {
+        return;
+    }
+
+    VkcMemoryRegion* region = allocation->region;
+    pthread_mutex_lock(&pool->budget_lock);
+    if (region->evict && pool->lru_head != region) {
+        vkc_pool_lru_unlink(pool, region);
+        vkc_pool_lru_push(pool, region);
+    }
+    pthread_mutex_unlock(&pool->budget_lock);
+}
+
+bool vkc_memory_pool_stats(VkcMemoryPool* pool, VkcMemoryPoolStats* stats) {
+    if (!pool || !stats) {
+        return false;
+    }
+
+    *stats = (VkcMemoryPoolStats) {
+        .blocks = atomic_load_explicit(&pool->blocks, memory_order_relaxed),
+        .block_bytes = atomic_load_explicit(&pool->block_bytes, memory_order_relaxed),
+        .allocations = atomic_load_explicit(&pool->allocations, memory_order_relaxed),
+        .allocated_bytes = atomic_load_explicit(&pool->allocated_bytes, memory_order_relaxed),
+        .driver_allocations
+        = atomic_load_explicit(&pool->driver_allocations, memory_order_relaxed),
+        .dedicated_blocks = atomic_load_explicit(&pool->dedicated_blocks, memory_order_relaxed),
+        .dedicated_bytes = atomic_load_explicit(&pool->dedicated_bytes, memory_order_relaxed),
+        .evictions = atomic_load_explicit(&pool->evictions, memory_order_relaxed),
+        .stalls = atomic_load_explicit(&pool->stalls, memory_order_relaxed),
+        .spills = atomic_load_explicit(&pool->spills, memory_order_relaxed),
+    };
+    return true;
+}
+
+bool vkc_memory_pool_allocation_stats(
+    const VkcMemoryAllocation* allocation, VkcMemoryAllocationStats* stats
+) {
+    if (!allocation || !allocation->region || !stats) {
+        return false;
+    }
+
+    // A live range's record and block do not change until it is freed.
+    *stats = (VkcMemoryAllocationStats) {
+        .placement = allocation->placement,
+        .type = allocation->type,
+        .size = allocation->size,
+        .reserved = allocation->region->size,
+        .block_size = allocation->region->block->size,
+        .block_used = atomic_load_explicit(&allocation->region->block->used, memory_order_relaxed),
+    };
+    return true;
+}
+
+/** @} */
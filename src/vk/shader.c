@@ -3,11 +3,248 @@
  * @brief A wrapper for interfacing with SPIR-V Compute Shaders.
  */
 
+#include "core/posix.h"
+#include "core/memory.h"
 #include "core/logger.h"
 #include "vk/shader.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief First word of every SPIR-V module in the host's byte order.
+ */
+#define VKC_SHADER_MAGIC 0x07230203u
+
+/**
+ * @brief Words in a SPIR-V header; no module is shorter.
+ */
+#define VKC_SHADER_HEADER_WORDS 5
+
+#define VKC_SHADER_REGISTRY_ENTRIES 16
+
+/**
+ * @brief One distinct SPIR-V content and its module.
+ */
+typedef struct VkcShaderEntry {
+    uint64_t hash;
+    size_t size;
+    uint32_t* code; /**< Copy of the contents, to confirm a hash match. */
+    VkShaderModule module;
+} VkcShaderEntry;
+
+/**
+ * @brief A path loaded before and the file it named then.
+ */
+typedef struct VkcShaderPath {
+    char* path;
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modified;
+    uint32_t entry; /**< Index in the registry's entries. */
+} VkcShaderPath;
+
+struct VkcShaderRegistry {
+    VkDevice device;
+    const VkAllocationCallbacks* callbacks;
+    pthread_mutex_t lock; /**< Guards everything below. */
+
+    VkcShaderEntry* entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+
+    VkcShaderPath* paths;
+    uint32_t path_count;
+    uint32_t path_capacity;
+
+    VkcShaderRegistryStats stats;
+};
+
+/**
+ * @name Private
+ * @{
+ */
+
+/**
+ * @brief FNV-1a over the module's words.
+ */
+static uint64_t vkc_shader_hash(const uint32_t* code, size_t size) {
+    const uint8_t* bytes = (const uint8_t*) code;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static bool vkc_shader_valid(const uint32_t* code, size_t size) {
+    return size >= VKC_SHADER_HEADER_WORDS * sizeof(uint32_t) && 0 == size % sizeof(uint32_t)
+           && VKC_SHADER_MAGIC == code[0];
+}
+
+static bool vkc_shader_path_current(const VkcShaderPath* known, const struct stat* status) {
+    return known->device == status->st_dev && known->inode == status->st_ino
+           && known->size == status->st_size
+           && known->modified.tv_sec == status->st_mtim.tv_sec
+           && known->modified.tv_nsec == status->st_mtim.tv_nsec;
+}
+
+static VkcShaderPath* vkc_shader_path_find(VkcShaderRegistry* registry, const char* path) {
+    for (uint32_t i = 0; i < registry->path_count; i++) {
+        if (0 == strcmp(registry->paths[i].path, path)) {
+            return &registry->paths[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Index of the entry holding `code`, or UINT32_MAX. Called with the lock held.
+ */
+static uint32_t vkc_shader_registry_find(
+    const VkcShaderRegistry* registry, const uint32_t* code, size_t size, uint64_t hash
+) {
+    for (uint32_t i = 0; i < registry->entry_count; i++) {
+        const VkcShaderEntry* entry = &registry->entries[i];
+        if (entry->hash == hash && entry->size == size && 0 == memcmp(entry->code, code, size)) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief The entry holding `code`, created with its module if the contents are new.
+ *
+ * Called with the lock held. The lock is dropped while a new module is created, so
+ * another thread may intern the same contents meanwhile; the first module in wins.
+ *
+ * @param hash vkc_shader_hash() of `code`, computed before locking.
+ */
+static VkResult vkc_shader_registry_intern(
+    VkcShaderRegistry* registry, const uint32_t* code, size_t size, uint64_t hash, uint32_t* index
+) {
+    *index = vkc_shader_registry_find(registry, code, size, hash);
+    if (UINT32_MAX != *index) {
+        registry->stats.content_hits++;
+        return VK_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&registry->lock);
+    VkcShaderEntry entry = {.hash = hash, .size = size, .code = malloc(size)};
+    VkResult result = VK_ERROR_OUT_OF_HOST_MEMORY;
+    if (entry.code) {
+        memcpy(entry.code, code, size);
+        VkShaderModuleCreateInfo info = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = size,
+            .pCode = entry.code,
+        };
+        result = vkCreateShaderModule(registry->device, &info, registry->callbacks, &entry.module);
+    }
+    pthread_mutex_lock(&registry->lock);
+
+    if (VK_SUCCESS != result) {
+        if (entry.code) {
+            LOG_ERROR("[VkcShaderRegistry] Failed to create shader module (VkResult=%d).", result);
+        } else {
+            LOG_ERROR("[VkcShaderRegistry] Failed to copy %zu bytes of SPIR-V.", size);
+        }
+        free(entry.code);
+        return result;
+    }
+
+    *index = vkc_shader_registry_find(registry, code, size, hash);
+    if (UINT32_MAX != *index) {
+        // Lost the race: keep the module other pipelines may already use.
+        vkDestroyShaderModule(registry->device, entry.module, registry->callbacks);
+        free(entry.code);
+        registry->stats.content_hits++;
+        return VK_SUCCESS;
+    }
+
+    if (registry->entry_count == registry->entry_capacity) {
+        uint32_t capacity = registry->entry_capacity ? registry->entry_capacity * 2
+                                                     : VKC_SHADER_REGISTRY_ENTRIES;
+        VkcShaderEntry* entries = realloc(registry->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            LOG_ERROR("[VkcShaderRegistry] Failed to grow entries to %u.", capacity);
+            vkDestroyShaderModule(registry->device, entry.module, registry->callbacks);
+            free(entry.code);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        registry->entries = entries;
+        registry->entry_capacity = capacity;
+    }
+
+    *index = registry->entry_count;
+    registry->entries[registry->entry_count++] = entry;
+    registry->stats.modules = registry->entry_count;
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcShaderRegistry] Created module @ %p (%zu bytes, hash=%016llx).",
+        (void*) entry.module,
+        size,
+        (unsigned long long) hash
+    );
+#endif
+
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Point `path` at entry `index` as of `status`. Called with the lock held.
+ */
+static VkResult vkc_shader_registry_remember(
+    VkcShaderRegistry* registry, const char* path, const struct stat* status, uint32_t index
+) {
+    VkcShaderPath* known = vkc_shader_path_find(registry, path);
+    if (!known) {
+        if (registry->path_count == registry->path_capacity) {
+            uint32_t capacity = registry->path_capacity ? registry->path_capacity * 2
+                                                        : VKC_SHADER_REGISTRY_ENTRIES;
+            VkcShaderPath* paths = realloc(registry->paths, capacity * sizeof(*paths));
+            if (!paths) {
+                LOG_ERROR("[VkcShaderRegistry] Failed to grow paths to %u.", capacity);
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
+            }
+            registry->paths = paths;
+            registry->path_capacity = capacity;
+        }
+
+        known = &registry->paths[registry->path_count];
+        *known = (VkcShaderPath) {.path = strdup(path)};
+        if (!known->path) {
+            LOG_ERROR("[VkcShaderRegistry] Failed to copy path %s.", path);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        registry->path_count++;
+        registry->stats.paths = registry->path_count;
+    }
+
+    known->device = status->st_dev;
+    known->inode = status->st_ino;
+    known->size = status->st_size;
+    known->modified = status->st_mtim;
+    known->entry = index;
+    return VK_SUCCESS;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
 
 char* shader_read(const char* filepath, size_t* size_out) {
     FILE* file = fopen(filepath, "rb");
@@ -16,25 +253,38 @@ char* shader_read(const char* filepath, size_t* size_out) {
         return NULL;
     }
 
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    rewind(file);
+    long length = -1;
+    if (0 == fseek(file, 0, SEEK_END)) {
+        length = ftell(file);
+        rewind(file);
+    }
+    if (length < 0) {
+        fclose(file);
+        LOG_ERROR("Failed to get the size of SPIR-V file: %s", filepath);
+        return NULL;
+    }
 
-    char* buffer = malloc(length);
+    char* buffer = malloc(length ? (size_t) length : 1);
     if (!buffer) {
         fclose(file);
         LOG_ERROR("Failed to allocate memory for shader file");
         return NULL;
     }
 
-    fread(buffer, 1, length, file);
+    size_t read = fread(buffer, 1, (size_t) length, file);
     fclose(file);
+    if (read != (size_t) length) {
+        LOG_ERROR("Read %zu of %ld bytes from SPIR-V file: %s", read, length, filepath);
+        free(buffer);
+        return NULL;
+    }
 
-    *size_out = length;
+    *size_out = (size_t) length;
     return buffer;
 }
 
-VkShaderModule shader_load_module(VkDevice device, const char* filepath) {
+VkShaderModule
+shader_load_module(VkDevice device, const VkAllocationCallbacks* callbacks, const char* filepath) {
     size_t code_size;
     char* code = shader_read(filepath, &code_size);
     if (!code) return VK_NULL_HANDLE;
@@ -46,7 +296,7 @@ VkShaderModule shader_load_module(VkDevice device, const char* filepath) {
     };
 
     VkShaderModule shader_module;
-    VkResult result = vkCreateShaderModule(device, &create_info, NULL, &shader_module);
+    VkResult result = vkCreateShaderModule(device, &create_info, callbacks, &shader_module);
     free(code);
 
     if (result != VK_SUCCESS) {
@@ -57,8 +307,166 @@ VkShaderModule shader_load_module(VkDevice device, const char* filepath) {
     return shader_module;
 }
 
-void shader_destroy_module(VkDevice device, VkShaderModule module) {
+void shader_destroy_module(
+    VkDevice device, const VkAllocationCallbacks* callbacks, VkShaderModule module
+) {
     if (module != VK_NULL_HANDLE) {
-        vkDestroyShaderModule(device, module, NULL);
+        vkDestroyShaderModule(device, module, callbacks);
+    }
+}
+
+VkcShaderRegistry*
+vkc_shader_registry_create(VkDevice device, const VkAllocationCallbacks* callbacks) {
+    if (!device) {
+        LOG_ERROR("[VkcShaderRegistry] Invalid device.");
+        return NULL;
+    }
+
+    VkcShaderRegistry* registry = calloc(1, sizeof(*registry));
+    if (!registry) {
+        LOG_ERROR("[VkcShaderRegistry] Failed to allocate registry.");
+        return NULL;
+    }
+
+    registry->device = device;
+    registry->callbacks = callbacks;
+    if (0 != pthread_mutex_init(&registry->lock, NULL)) {
+        LOG_ERROR("[VkcShaderRegistry] Failed to initialize lock.");
+        free(registry);
+        return NULL;
+    }
+    return registry;
+}
+
+void vkc_shader_registry_destroy(VkcShaderRegistry* registry) {
+    if (!registry) {
+        return;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcShaderRegistry] %u modules for %llu loads (%llu path hits, %llu content hits).",
+        registry->entry_count,
+        (unsigned long long) registry->stats.loads,
+        (unsigned long long) registry->stats.path_hits,
+        (unsigned long long) registry->stats.content_hits
+    );
+#endif
+
+    for (uint32_t i = 0; i < registry->entry_count; i++) {
+        vkDestroyShaderModule(registry->device, registry->entries[i].module, registry->callbacks);
+        free(registry->entries[i].code);
+    }
+    for (uint32_t i = 0; i < registry->path_count; i++) {
+        free(registry->paths[i].path);
+    }
+    pthread_mutex_destroy(&registry->lock);
+    free(registry->entries);
+    free(registry->paths);
+    free(registry);
+}
+
+VkResult
+vkc_shader_registry_load(VkcShaderRegistry* registry, const char* path, VkShaderModule* module) {
+    if (!registry || !path || !module) {
+        LOG_ERROR("[VkcShaderRegistry] Invalid load request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    *module = VK_NULL_HANDLE;
+
+    // A known path whose file is unchanged needs no I/O beyond the stat().
+    struct stat status;
+    if (0 != stat(path, &status)) {
+        LOG_ERROR("[VkcShaderRegistry] Failed to stat %s: %s.", path, strerror(errno));
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    pthread_mutex_lock(&registry->lock);
+    const VkcShaderPath* known = vkc_shader_path_find(registry, path);
+    if (known && vkc_shader_path_current(known, &status)) {
+        *module = registry->entries[known->entry].module;
+        registry->stats.loads++;
+        registry->stats.path_hits++;
+        pthread_mutex_unlock(&registry->lock);
+        return VK_SUCCESS;
+    }
+    pthread_mutex_unlock(&registry->lock);
+
+    // Map and hash outside the lock; the stat of the open file is what gets remembered.
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || 0 != fstat(fd, &status)) {
+        LOG_ERROR("[VkcShaderRegistry] Failed to open %s: %s.", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    size_t size = (size_t) status.st_size;
+    const uint32_t* code = NULL;
+    if (size > 0) {
+        void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        code = MAP_FAILED != mapping ? mapping : NULL;
+    }
+    close(fd);
+    if (!code || !vkc_shader_valid(code, size)) {
+        LOG_ERROR("[VkcShaderRegistry] %s is not a readable SPIR-V module.", path);
+        if (code) {
+            munmap((void*) code, size);
+        }
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    uint64_t hash = vkc_shader_hash(code, size);
+    pthread_mutex_lock(&registry->lock);
+    uint32_t index;
+    VkResult result = vkc_shader_registry_intern(registry, code, size, hash, &index);
+    if (VK_SUCCESS == result) {
+        result = vkc_shader_registry_remember(registry, path, &status, index);
+    }
+    if (VK_SUCCESS == result) {
+        *module = registry->entries[index].module;
+        registry->stats.loads++;
+        registry->stats.mapped_bytes += size;
+    }
+    pthread_mutex_unlock(&registry->lock);
+
+    munmap((void*) code, size);
+    return result;
+}
+
+VkResult vkc_shader_registry_code(
+    VkcShaderRegistry* registry, const uint32_t* code, size_t size, VkShaderModule* module
+) {
+    if (!registry || !code || !module) {
+        LOG_ERROR("[VkcShaderRegistry] Invalid code request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    *module = VK_NULL_HANDLE;
+    if (!vkc_shader_valid(code, size)) {
+        LOG_ERROR("[VkcShaderRegistry] %zu bytes are not a SPIR-V module.", size);
+        return VK_ERROR_INITIALIZATION_FAILED;
     }
+
+    uint64_t hash = vkc_shader_hash(code, size);
+    pthread_mutex_lock(&registry->lock);
+    uint32_t index;
+    VkResult result = vkc_shader_registry_intern(registry, code, size, hash, &index);
+    if (VK_SUCCESS == result) {
+        *module = registry->entries[index].module;
+        registry->stats.loads++;
+    }
+    pthread_mutex_unlock(&registry->lock);
+    return result;
 }
+
+bool vkc_shader_registry_stats(VkcShaderRegistry* registry, VkcShaderRegistryStats* stats) {
+    if (!registry || !stats) {
+        return false;
+    }
+
+    pthread_mutex_lock(&registry->lock);
+    *stats = registry->stats;
+    pthread_mutex_unlock(&registry->lock);
+    return true;
+}
+
+/** @} */
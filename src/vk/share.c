@@ -0,0 +1,289 @@
+/**
+ * @file src/vk/share.c
+ * @brief Buffers shared between processes through file descriptors.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/share.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+/**
+ * @brief Read the UUIDs opaque fds are only valid between.
+ */
+static void vkc_share_identify(VkcMemoryPool* pool, VkcShareDesc* desc) {
+    VkPhysicalDeviceIDProperties id = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &id,
+    };
+    vkGetPhysicalDeviceProperties2(vkc_memory_pool_physical(pool), &properties);
+    memcpy(desc->device_uuid, id.deviceUUID, VK_UUID_SIZE);
+    memcpy(desc->driver_uuid, id.driverUUID, VK_UUID_SIZE);
+}
+
+/**
+ * @brief Map a memfd and give this process's device a buffer over it.
+ */
+static VkResult vkc_share_map(VkcMemoryPool* pool, VkcShare* share) {
+    share->mapping = mmap(
+        NULL, share->desc.memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, share->fd, 0
+    );
+    if (MAP_FAILED == share->mapping) {
+        LOG_ERROR("[VkcShare] Failed to map memfd %d: %s.", share->fd, strerror(errno));
+        share->mapping = NULL;
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+    share->data = share->mapping;
+
+    // Imported where the device can, otherwise a copy vkc_share_refresh() keeps current.
+    return vkc_buffer_import(
+        pool, share->mapping, share->desc.memory_size, share->desc.usage, &share->buffer
+    );
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkResult vkc_share_create(
+    VkcMemoryPool* pool,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkcShare* share
+) {
+    if (!pool || !share || 0 == size) {
+        LOG_ERROR("[VkcShare] Invalid share request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *share = (VkcShare) {.fd = -1};
+    share->desc.size = size;
+    share->desc.usage = usage;
+    vkc_share_identify(pool, &share->desc);
+
+    VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+    if (vkc_memory_pool_flags(pool) & VKC_MEMORY_POOL_EXTERNAL_FD_BIT) {
+        result = vkc_buffer_export(pool, size, usage, memory, &share->buffer);
+    }
+    if (VK_SUCCESS == result) {
+        VkcMemoryAllocationStats stats;
+        vkc_buffer_stats(&share->buffer, &stats);
+        share->desc.mode = VKC_SHARE_MODE_OPAQUE_FD;
+        share->desc.type = share->buffer.memory.type;
+        share->desc.memory_size = stats.block_size;
+        share->data = share->buffer.data;
+
+        result = vkc_memory_pool_export_fd(pool, &share->buffer.memory, &share->fd);
+        if (VK_SUCCESS != result) {
+            vkc_share_destroy(pool, share);
+        }
+        return result;
+    }
+    if (VK_ERROR_FEATURE_NOT_PRESENT != result) {
+        *share = (VkcShare) {.fd = -1};
+        return result;
+    }
+
+    // Whole pages, so every process can import them.
+    VkDeviceSize page = (VkDeviceSize) sysconf(_SC_PAGESIZE);
+    VkDeviceSize alignment = vkc_memory_pool_import_alignment(pool);
+    alignment = alignment > page ? alignment : page;
+    share->desc.mode = VKC_SHARE_MODE_HOST_MEMFD;
+    share->desc.memory_size = (size + alignment - 1) / alignment * alignment;
+
+    share->fd = memfd_create("vkc-share", MFD_CLOEXEC);
+    if (share->fd < 0 || 0 != ftruncate(share->fd, (off_t) share->desc.memory_size)) {
+        LOG_ERROR(
+            "[VkcShare] Failed to create a %llu byte memfd: %s.",
+            (unsigned long long) share->desc.memory_size,
+            strerror(errno)
+        );
+        vkc_share_destroy(pool, share);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    result = vkc_share_map(pool, share);
+    if (VK_SUCCESS != result) {
+        vkc_share_destroy(pool, share);
+    }
+    return result;
+}
+
+VkResult vkc_share_open(VkcMemoryPool* pool, const VkcShareDesc* desc, int fd, VkcShare* share) {
+    if (!pool || !desc || fd < 0 || !share || 0 == desc->size || desc->memory_size < desc->size) {
+        LOG_ERROR("[VkcShare] Invalid share to open.");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    *share = (VkcShare) {.desc = *desc, .fd = -1};
+
+    if (VKC_SHARE_MODE_HOST_MEMFD == desc->mode) {
+        // The mapping keeps the memfd alive; the descriptor is not needed past it.
+        share->fd = fd;
+        VkResult result = vkc_share_map(pool, share);
+        close(share->fd);
+        share->fd = -1;
+        if (VK_SUCCESS != result) {
+            vkc_share_destroy(pool, share);
+        }
+        return result;
+    }
+
+    // Opaque fds carry driver-private layouts: only the exporting driver can read them.
+    VkcShareDesc local = {0};
+    vkc_share_identify(pool, &local);
+    if (VKC_SHARE_MODE_OPAQUE_FD != desc->mode
+        || 0 != memcmp(local.device_uuid, desc->device_uuid, VK_UUID_SIZE)
+        || 0 != memcmp(local.driver_uuid, desc->driver_uuid, VK_UUID_SIZE)) {
+        LOG_ERROR("[VkcShare] Share (mode=%u) was exported by another device.", desc->mode);
+        close(fd);
+        *share = (VkcShare) {.fd = -1};
+        return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+    }
+
+    VkResult result = vkc_buffer_import_fd(
+        pool, fd, desc->size, desc->usage, desc->type, desc->memory_size, &share->buffer
+    );
+    if (VK_SUCCESS != result) {
+        *share = (VkcShare) {.fd = -1};
+        return result;
+    }
+    share->data = share->buffer.data;
+    return VK_SUCCESS;
+}
+
+bool vkc_share_refresh(VkcMemoryPool* pool, VkcShare* share) {
+    if (!pool || !share || !share->buffer.object) {
+        return false;
+    }
+
+    // Device-only memory has no host writes to publish.
+    if (!share->buffer.data) {
+        return true;
+    }
+    if (share->mapping && VKC_MEMORY_PLACEMENT_IMPORTED != share->buffer.memory.placement) {
+        memcpy(share->buffer.data, share->mapping, share->desc.size);
+    }
+    return vkc_buffer_mark_flush(pool, &share->buffer, 0, VK_WHOLE_SIZE);
+}
+
+void vkc_share_destroy(VkcMemoryPool* pool, VkcShare* share) {
+    if (!share) {
+        return;
+    }
+
+    vkc_buffer_destroy(pool, &share->buffer);
+    if (share->mapping) {
+        munmap(share->mapping, share->desc.memory_size);
+    }
+    if (share->fd >= 0) {
+        close(share->fd);
+    }
+    *share = (VkcShare) {.fd = -1};
+}
+
+bool vkc_share_send(int socket, const VkcShare* share) {
+    if (!share || share->fd < 0) {
+        LOG_ERROR("[VkcShare] Nothing to send.");
+        return false;
+    }
+
+    VkcShareDesc desc = share->desc;
+    struct iovec payload = {.iov_base = &desc, .iov_len = sizeof(desc)};
+    union {
+        struct cmsghdr header;
+        char bytes[CMSG_SPACE(sizeof(int))];
+    } control = {0};
+    struct msghdr message = {
+        .msg_iov = &payload,
+        .msg_iovlen = 1,
+        .msg_control = control.bytes,
+        .msg_controllen = sizeof(control.bytes),
+    };
+
+    // The kernel installs a duplicate of the fd in the receiving process.
+    struct cmsghdr* rights = CMSG_FIRSTHDR(&message);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(rights), &share->fd, sizeof(int));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && EINTR == errno);
+    if (sent != (ssize_t) sizeof(desc)) {
+        LOG_ERROR("[VkcShare] Failed to send share: %s.", sent < 0 ? strerror(errno) : "short");
+        return false;
+    }
+    return true;
+}
+
+bool vkc_share_receive(int socket, VkcShareDesc* desc, int* fd) {
+    if (!desc || !fd) {
+        return false;
+    }
+
+    *fd = -1;
+    struct iovec payload = {.iov_base = desc, .iov_len = sizeof(*desc)};
+    union {
+        struct cmsghdr header;
+        char bytes[CMSG_SPACE(sizeof(int))];
+    } control = {0};
+    struct msghdr message = {
+        .msg_iov = &payload,
+        .msg_iovlen = 1,
+        .msg_control = control.bytes,
+        .msg_controllen = sizeof(control.bytes),
+    };
+
+    ssize_t received;
+    do {
+        received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    } while (received < 0 && EINTR == errno);
+
+    struct cmsghdr* rights = CMSG_FIRSTHDR(&message);
+    if (rights && SOL_SOCKET == rights->cmsg_level && SCM_RIGHTS == rights->cmsg_type
+        && CMSG_LEN(sizeof(int)) == rights->cmsg_len) {
+        memcpy(fd, CMSG_DATA(rights), sizeof(int));
+    }
+
+    if (received != (ssize_t) sizeof(*desc) || *fd < 0 || (message.msg_flags & MSG_CTRUNC)) {
+        // A peer that closed the socket has nothing more to share.
+        if (0 != received) {
+            LOG_ERROR("[VkcShare] Failed to receive share.");
+        }
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+        return false;
+    }
+    return true;
+}
+
+/** @} */
@@ -0,0 +1,572 @@
+/**
+ * @file src/vk/slab.c
+ * @brief Size-class slab allocator for small Vulkan host allocations.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/extent.h"
+#include "vk/numa.h"
+#include "vk/slab.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+#define VKC_SLAB_SIZE VKC_EXTENT_GRANULE
+#define VKC_SLAB_QUANTUM 16
+#define VKC_SLAB_BITMAP_WORDS (VKC_SLAB_SIZE / VKC_SLAB_QUANTUM / 64)
+#define VKC_SLAB_CACHE_MAX 64 // Blocks cached per class per thread
+
+/**
+ * @brief jemalloc-style size classes: 16-byte steps to 128, then four per doubling.
+ */
+static const size_t vkc_slab_classes[] = {
+    16,   32,   48,   64,   80,   96,   112,  128,  160,  192,  224,  256,  320,  384,
+    448,  512,  640,  768,  896,  1024, 1280, 1536, 1792, 2048, 2560, 3072, 3584, 4096,
+};
+
+#define VKC_SLAB_CLASS_COUNT (sizeof(vkc_slab_classes) / sizeof(vkc_slab_classes[0]))
+
+/**
+ * @brief Out-of-line slab descriptor. Nothing is stored inside the slab itself.
+ */
+typedef struct VkcSlabSpan {
+    VkcExtent extent; /**< Must be first: extent lookups cast back to the span. */
+    struct VkcSlabSpan* prev;
+    struct VkcSlabSpan* next;
+    size_t class_index;
+    size_t capacity; /**< Blocks per slab for this class. */
+    size_t available; /**< Free blocks not held by any thread cache. */
+    uint32_t resident; /**< Pages handed out since the last purge, one bit per page. */
+    uint64_t idle; /**< When the span last became empty, in CLOCK_MONOTONIC nanoseconds. */
+    uint64_t bitmap[VKC_SLAB_BITMAP_WORDS]; /**< 1 = free. */
+} VkcSlabSpan;
+
+typedef struct VkcSlabClass {
+    pthread_mutex_t lock;
+    VkcSlabSpan* partial; /**< Spans with at least one free block. */
+    VkcSlabSpan* empty; /**< One fully free span kept to absorb churn. */
+    VkcSlabSpan* full; /**< Spans with no free blocks; kept for teardown. */
+} VkcSlabClass;
+
+/**
+ * @brief Per-thread caches: pointer stacks, so free blocks are never written to.
+ */
+typedef struct VkcSlabThread {
+    VkcSlab* slab;
+    struct VkcSlabThread* prev;
+    struct VkcSlabThread* next;
+    size_t counts[VKC_SLAB_CLASS_COUNT];
+    void* blocks[VKC_SLAB_CLASS_COUNT][VKC_SLAB_CACHE_MAX];
+} VkcSlabThread;
+
+struct VkcSlab {
+    pthread_mutex_t lock; /**< Guards the thread list. */
+    pthread_key_t key; /**< Maps each thread to its VkcSlabThread. */
+    VkcSlabThread* threads;
+    int node; /**< NUMA node preferred for slab pages. */
+    size_t page_shift; /**< log2 of the system page size. */
+    VkcSlabClass classes[VKC_SLAB_CLASS_COUNT];
+};
+
+/**
+ * @brief Blocks moved between a thread cache and the shared class at once.
+ */
+static inline size_t vkc_slab_batch(size_t class_index) {
+    size_t batch = 2048 / vkc_slab_classes[class_index];
+    if (batch < 2) {
+        return 2;
+    }
+    return batch > VKC_SLAB_CACHE_MAX / 2 ? VKC_SLAB_CACHE_MAX / 2 : batch;
+}
+
+static size_t vkc_slab_class(size_t size, size_t alignment) {
+    size_t index = 0;
+    if (size > 128) {
+        // Four classes per doubling above 128: skip ahead by the exponent.
+        size_t exponent = 63 - (size_t) __builtin_clzll((unsigned long long) (size - 1));
+        index = 8 + (exponent - 7) * 4;
+    }
+
+    while (index < VKC_SLAB_CLASS_COUNT) {
+        size_t stride = vkc_slab_classes[index];
+        if (stride >= size && 0 == (stride & (alignment - 1))) {
+            return index;
+        }
+        index++;
+    }
+
+    return VKC_SLAB_CLASS_COUNT;
+}
+
+static inline uint64_t vkc_slab_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static VkcSlabSpan* vkc_slab_span(const void* address) {
+    VkcExtent* extent = vkc_extent_lookup(address);
+    if (!extent || VKC_EXTENT_SLAB != extent->kind) {
+        return NULL;
+    }
+    return (VkcSlabSpan*) extent;
+}
+
+static void vkc_slab_unlink(VkcSlabSpan** list, VkcSlabSpan* span) {
+    if (span->prev) {
+        span->prev->next = span->next;
+    } else {
+        *list = span->next;
+    }
+    if (span->next) {
+        span->next->prev = span->prev;
+    }
+    span->prev = span->next = NULL;
+}
+
+static void vkc_slab_link(VkcSlabSpan** list, VkcSlabSpan* span) {
+    span->prev = NULL;
+    span->next = *list;
+    if (*list) {
+        (*list)->prev = span;
+    }
+    *list = span;
+}
+
+static VkcSlabSpan* vkc_slab_span_create(VkcSlab* slab, size_t class_index) {
+    VkcSlabSpan* span = calloc(1, sizeof(*span));
+    if (!span) {
+        LOG_ERROR("[VkcSlab] Failed to allocate slab descriptor.");
+        return NULL;
+    }
+
+    span->extent = (VkcExtent) {
+        .base = vkc_extent_map(VKC_SLAB_SIZE),
+        .size = VKC_SLAB_SIZE,
+        .kind = VKC_EXTENT_SLAB,
+        .owner = slab,
+    };
+
+    if (!span->extent.base) {
+        free(span);
+        return NULL;
+    }
+
+    vkc_numa_bind(span->extent.base, span->extent.size, slab->node);
+
+    if (!vkc_extent_register(&span->extent)) {
+        vkc_extent_unmap(span->extent.base, span->extent.size);
+        free(span);
+        return NULL;
+    }
+
+    span->class_index = class_index;
+    span->capacity = VKC_SLAB_SIZE / vkc_slab_classes[class_index];
+    span->available = span->capacity;
+    for (size_t i = 0; i < span->capacity; i++) {
+        span->bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+    }
+
+    return span;
+}
+
+static void vkc_slab_span_destroy(VkcSlabSpan* span) {
+    vkc_extent_deregister(&span->extent);
+    vkc_extent_unmap(span->extent.base, span->extent.size);
+    free(span);
+}
+
+/**
+ * @brief Take one free block out of a span. Caller holds the class lock.
+ */
+static void* vkc_slab_span_take(VkcSlab* slab, VkcSlabSpan* span) {
+    for (size_t word = 0; word < VKC_SLAB_BITMAP_WORDS; word++) {
+        if (span->bitmap[word]) {
+            size_t bit = (size_t) __builtin_ctzll(span->bitmap[word]);
+            span->bitmap[word] &= span->bitmap[word] - 1;
+            span->available--;
+
+            size_t stride = vkc_slab_classes[span->class_index];
+            size_t offset = (word * 64 + bit) * stride;
+            size_t first = offset >> slab->page_shift;
+            size_t last = (offset + stride - 1) >> slab->page_shift;
+            span->resident |= (uint32_t) (((uint64_t) 2 << last) - ((uint64_t) 1 << first));
+            return (uint8_t*) span->extent.base + offset;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Whether every block overlapping page `page` of a span is free.
+ */
+static bool vkc_slab_page_free(const VkcSlab* slab, const VkcSlabSpan* span, size_t page) {
+    size_t stride = vkc_slab_classes[span->class_index];
+    size_t first = (page << slab->page_shift) / stride;
+    size_t last = (((page + 1) << slab->page_shift) - 1) / stride;
+    for (size_t i = first; i <= last && i < span->capacity; i++) {
+        if (!(span->bitmap[i / 64] & ((uint64_t) 1 << (i % 64)))) {
+            return false;
+        }
+    }
+    return true; // Slack past the last block counts as free
+}
+
+/**
+ * @brief Give back the resident pages of a span that hold no live block. Caller holds
+ *        the class lock.
+ *
+ * Free blocks carry no metadata, so their pages can be dropped and refault as zeroes.
+ *
+ * @return Bytes returned.
+ */
+static size_t vkc_slab_span_purge(VkcSlab* slab, VkcSlabSpan* span) {
+    size_t pages = VKC_SLAB_SIZE >> slab->page_shift;
+    size_t returned = 0;
+    size_t run = 0; // Length of the purgeable run ending before `page`
+
+    for (size_t page = 0; page <= pages; page++) {
+        bool purge = page < pages && (span->resident & ((uint32_t) 1 << page))
+                     && vkc_slab_page_free(slab, span, page);
+        if (purge) {
+            span->resident &= ~((uint32_t) 1 << page);
+            run++;
+            continue;
+        }
+
+        if (run) {
+            uint8_t* start = (uint8_t*) span->extent.base + ((page - run) << slab->page_shift);
+            vkc_extent_purge(start, run << slab->page_shift);
+            returned += run << slab->page_shift;
+            run = 0;
+        }
+    }
+
+    return returned;
+}
+
+static inline size_t vkc_slab_resident(const VkcSlab* slab, const VkcSlabSpan* span) {
+    return (size_t) __builtin_popcount(span->resident) << slab->page_shift;
+}
+
+/**
+ * @brief Move up to `count` blocks from the shared class into a thread cache.
+ */
+static void
+vkc_slab_refill(VkcSlab* slab, VkcSlabThread* thread, size_t class_index, size_t count) {
+    VkcSlabClass* size_class = &slab->classes[class_index];
+
+    pthread_mutex_lock(&size_class->lock);
+    while (count > 0) {
+        VkcSlabSpan* span = size_class->partial;
+        if (!span) {
+            span = size_class->empty;
+            size_class->empty = NULL;
+            if (!span) {
+                span = vkc_slab_span_create(slab, class_index);
+            }
+            if (!span) {
+                break;
+            }
+            vkc_slab_link(&size_class->partial, span);
+        }
+
+        while (count > 0 && span->available > 0) {
+            thread->blocks[class_index][thread->counts[class_index]++]
+                = vkc_slab_span_take(slab, span);
+            count--;
+        }
+
+        if (0 == span->available) {
+            vkc_slab_unlink(&size_class->partial, span);
+            vkc_slab_link(&size_class->full, span);
+        }
+    }
+    pthread_mutex_unlock(&size_class->lock);
+}
+
+/**
+ * @brief Return one block to its span. Caller holds the class lock.
+ */
+static void vkc_slab_release(VkcSlabClass* size_class, void* address) {
+    VkcSlabSpan* span = vkc_slab_span(address);
+    size_t index = (size_t) ((uint8_t*) address - (uint8_t*) span->extent.base)
+                   / vkc_slab_classes[span->class_index];
+    span->bitmap[index / 64] |= (uint64_t) 1 << (index % 64);
+    span->available++;
+
+    if (1 == span->available) {
+        vkc_slab_unlink(&size_class->full, span);
+        vkc_slab_link(&size_class->partial, span);
+    }
+
+    if (span->capacity == span->available) {
+        // Keep one empty slab per class; unmap the rest.
+        vkc_slab_unlink(&size_class->partial, span);
+        if (size_class->empty) {
+            vkc_slab_span_destroy(span);
+        } else {
+            span->idle = vkc_slab_now();
+            size_class->empty = span;
+        }
+    }
+}
+
+/**
+ * @brief Move up to `count` blocks from a thread cache back to their spans.
+ */
+static void vkc_slab_drain(VkcSlab* slab, VkcSlabThread* thread, size_t class_index, size_t count) {
+    VkcSlabClass* size_class = &slab->classes[class_index];
+
+    pthread_mutex_lock(&size_class->lock);
+    while (count > 0 && thread->counts[class_index] > 0) {
+        vkc_slab_release(size_class, thread->blocks[class_index][--thread->counts[class_index]]);
+        count--;
+    }
+    pthread_mutex_unlock(&size_class->lock);
+}
+
+static void vkc_slab_thread_exit(void* value) {
+    VkcSlabThread* thread = (VkcSlabThread*) value;
+    VkcSlab* slab = thread->slab;
+
+    for (size_t i = 0; i < VKC_SLAB_CLASS_COUNT; i++) {
+        vkc_slab_drain(slab, thread, i, thread->counts[i]);
+    }
+
+    pthread_mutex_lock(&slab->lock);
+    if (thread->prev) {
+        thread->prev->next = thread->next;
+    } else {
+        slab->threads = thread->next;
+    }
+    if (thread->next) {
+        thread->next->prev = thread->prev;
+    }
+    pthread_mutex_unlock(&slab->lock);
+
+    free(thread);
+}
+
+static VkcSlabThread* vkc_slab_thread(VkcSlab* slab) {
+    VkcSlabThread* thread = pthread_getspecific(slab->key);
+    if (thread) {
+        return thread;
+    }
+
+    thread = calloc(1, sizeof(*thread));
+    if (!thread) {
+        LOG_ERROR("[VkcSlab] Failed to allocate thread cache.");
+        return NULL;
+    }
+
+    if (0 != pthread_setspecific(slab->key, thread)) {
+        LOG_ERROR("[VkcSlab] Failed to bind thread cache.");
+        free(thread);
+        return NULL;
+    }
+
+    thread->slab = slab;
+    pthread_mutex_lock(&slab->lock);
+    thread->next = slab->threads;
+    if (slab->threads) {
+        slab->threads->prev = thread;
+    }
+    slab->threads = thread;
+    pthread_mutex_unlock(&slab->lock);
+
+    return thread;
+}
+
+static void vkc_slab_list_destroy(VkcSlabSpan* span) {
+    while (span) {
+        VkcSlabSpan* next = span->next;
+        vkc_slab_span_destroy(span);
+        span = next;
+    }
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcSlab* vkc_slab_create(int node) {
+    VkcSlab* slab = calloc(1, sizeof(*slab));
+    if (!slab) {
+        LOG_ERROR("[VkcSlab] Failed to allocate slab allocator.");
+        return NULL;
+    }
+
+    if (0 != pthread_mutex_init(&slab->lock, NULL)) {
+        LOG_ERROR("[VkcSlab] Failed to initialize slab lock.");
+        free(slab);
+        return NULL;
+    }
+
+    if (0 != pthread_key_create(&slab->key, vkc_slab_thread_exit)) {
+        LOG_ERROR("[VkcSlab] Failed to create thread cache key.");
+        pthread_mutex_destroy(&slab->lock);
+        free(slab);
+        return NULL;
+    }
+
+    slab->node = node;
+    long page = sysconf(_SC_PAGESIZE);
+    slab->page_shift = page >= 4096 ? (size_t) __builtin_ctzl((unsigned long) page) : 12;
+    for (size_t i = 0; i < VKC_SLAB_CLASS_COUNT; i++) {
+        pthread_mutex_init(&slab->classes[i].lock, NULL);
+    }
+
+    return slab;
+}
+
+void vkc_slab_destroy(VkcSlab* slab) {
+    if (!slab) {
+        return;
+    }
+
+    // Deleting the key first keeps exiting threads from touching a dead allocator.
+    pthread_key_delete(slab->key);
+
+    while (slab->threads) {
+        VkcSlabThread* thread = slab->threads;
+        slab->threads = thread->next;
+        free(thread);
+    }
+
+    for (size_t i = 0; i < VKC_SLAB_CLASS_COUNT; i++) {
+        VkcSlabClass* size_class = &slab->classes[i];
+        vkc_slab_list_destroy(size_class->partial);
+        vkc_slab_list_destroy(size_class->full);
+        if (size_class->empty) {
+            vkc_slab_span_destroy(size_class->empty);
+        }
+        pthread_mutex_destroy(&size_class->lock);
+    }
+
+    pthread_mutex_destroy(&slab->lock);
+    free(slab);
+}
+
+bool vkc_slab_accepts(size_t size, size_t alignment) {
+    if (0 == size || size > VKC_SLAB_MAX || alignment > VKC_SLAB_MAX) {
+        return false;
+    }
+    return vkc_slab_class(size, alignment ? alignment : 1) < VKC_SLAB_CLASS_COUNT;
+}
+
+void* vkc_slab_malloc(VkcSlab* slab, size_t size, size_t alignment) {
+    if (!slab || !vkc_slab_accepts(size, alignment)) {
+        return NULL;
+    }
+
+    size_t class_index = vkc_slab_class(size, alignment ? alignment : 1);
+    VkcSlabThread* thread = vkc_slab_thread(slab);
+    if (!thread) {
+        return NULL;
+    }
+
+    if (0 == thread->counts[class_index]) {
+        vkc_slab_refill(slab, thread, class_index, vkc_slab_batch(class_index));
+        if (0 == thread->counts[class_index]) {
+            return NULL;
+        }
+    }
+
+    return thread->blocks[class_index][--thread->counts[class_index]];
+}
+
+void vkc_slab_free(VkcSlab* slab, void* address) {
+    if (!slab || !address) {
+        return;
+    }
+
+    VkcSlabSpan* span = vkc_slab_span(address);
+    if (!span || slab != span->extent.owner) {
+        LOG_ERROR("[VkcSlab] Address %p is not owned by this slab allocator.", address);
+        return;
+    }
+
+    size_t class_index = span->class_index;
+    VkcSlabThread* thread = vkc_slab_thread(slab);
+    if (!thread) {
+        // No thread cache available: return the block straight to its span.
+        VkcSlabClass* size_class = &slab->classes[class_index];
+        pthread_mutex_lock(&size_class->lock);
+        vkc_slab_release(size_class, address);
+        pthread_mutex_unlock(&size_class->lock);
+        return;
+    }
+
+    if (VKC_SLAB_CACHE_MAX == thread->counts[class_index]) {
+        vkc_slab_drain(slab, thread, class_index, vkc_slab_batch(class_index));
+    }
+
+    thread->blocks[class_index][thread->counts[class_index]++] = address;
+}
+
+size_t vkc_slab_trim(VkcSlab* slab, uint64_t idle_ns, bool purge) {
+    if (!slab) {
+        return 0;
+    }
+
+    // Other threads' caches are touched without locks; only the caller's can be drained.
+    VkcSlabThread* thread = purge ? pthread_getspecific(slab->key) : NULL;
+    for (size_t i = 0; thread && i < VKC_SLAB_CLASS_COUNT; i++) {
+        vkc_slab_drain(slab, thread, i, thread->counts[i]);
+    }
+
+    uint64_t now = vkc_slab_now();
+    size_t returned = 0;
+    for (size_t i = 0; i < VKC_SLAB_CLASS_COUNT; i++) {
+        VkcSlabClass* size_class = &slab->classes[i];
+        pthread_mutex_lock(&size_class->lock);
+
+        VkcSlabSpan* empty = size_class->empty;
+        if (empty && now - empty->idle >= idle_ns) {
+            returned += vkc_slab_resident(slab, empty);
+            vkc_slab_span_destroy(empty);
+            size_class->empty = NULL;
+        } else if (empty && purge) {
+            returned += vkc_slab_span_purge(slab, empty);
+        }
+
+        for (VkcSlabSpan* span = size_class->partial; purge && span; span = span->next) {
+            returned += vkc_slab_span_purge(slab, span);
+        }
+
+        pthread_mutex_unlock(&size_class->lock);
+    }
+
+    return returned;
+}
+
+size_t vkc_slab_usable(size_t size, size_t alignment) {
+    if (!vkc_slab_accepts(size, alignment)) {
+        return 0;
+    }
+    return vkc_slab_classes[vkc_slab_class(size, alignment ? alignment : 1)];
+}
+
+size_t vkc_slab_size(const void* address) {
+    VkcSlabSpan* span = vkc_slab_span(address);
+    return span ? vkc_slab_classes[span->class_index] : 0;
+}
+
+VkcSlab* vkc_slab_owner(const void* address) {
+    VkcSlabSpan* span = vkc_slab_span(address);
+    return span ? (VkcSlab*) span->extent.owner : NULL;
+}
+
+/** @} */
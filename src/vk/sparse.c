@@ -0,0 +1,522 @@
+/**
+ * @file src/vk/sparse.c
+ * @brief Sparse virtual buffers whose pages are committed on demand.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/sparse.h"
+
+/**
+ * @name Private
+ * @{
+ */
+
+/**
+ * @brief Memory behind one committed page.
+ */
+typedef struct VkcSparsePage {
+    VkcMemoryAllocation memory; /**< Residency mode: the range bound at the page. */
+    VkcBuffer chunk; /**< Chunked mode: the page's own buffer. */
+    void* data; /**< Host address of the page's first byte, if mapped. */
+} VkcSparsePage;
+
+struct VkcSparse {
+    VkcMemoryPool* pool;
+    VkDevice device;
+    VkQueue queue;
+    VkFence fence; /**< Residency mode: signaled by each bind. */
+    VkBuffer buffer; /**< Residency mode: the sparse buffer. */
+    VkDeviceAddress address; /**< Residency mode: address of byte 0. */
+    VkMemoryRequirements requirements; /**< Residency mode: one page's requirements. */
+    VkBufferUsageFlags usage;
+    VkcMemoryUsage memory;
+    VkcSparsePage** pages; /**< One slot per page; NULL while uncommitted. */
+    VkcSparseStats stats;
+};
+
+/**
+ * @brief Clamp a range to the buffer; false if it is empty or starts past the end.
+ */
+static bool vkc_sparse_span(const VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize* size) {
+    if (offset >= sparse->stats.size || 0 == *size) {
+        return false;
+    }
+    VkDeviceSize left = sparse->stats.size - offset;
+    if (VK_WHOLE_SIZE == *size || *size > left) {
+        *size = left;
+    }
+    return true;
+}
+
+static const VkcMemoryAllocation* vkc_sparse_page_memory(const VkcSparsePage* page) {
+    return page->chunk.object ? &page->chunk.memory : &page->memory;
+}
+
+/**
+ * @brief Bind or unbind pages and wait for the queue to finish doing so.
+ */
+static VkResult
+vkc_sparse_bind(VkcSparse* sparse, const VkSparseMemoryBind* binds, uint32_t count) {
+    VkSparseBufferMemoryBindInfo buffer = {
+        .buffer = sparse->buffer,
+        .bindCount = count,
+        .pBinds = binds,
+    };
+    VkBindSparseInfo info = {
+        .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+        .bufferBindCount = 1,
+        .pBufferBinds = &buffer,
+    };
+
+    VkResult result = vkQueueBindSparse(sparse->queue, 1, &info, sparse->fence);
+    if (VK_SUCCESS == result) {
+        result = vkWaitForFences(sparse->device, 1, &sparse->fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(sparse->device, 1, &sparse->fence);
+    }
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcSparse] Failed to bind %u pages: %d.", count, result);
+        return result;
+    }
+
+    sparse->stats.binds++;
+    return VK_SUCCESS;
+}
+
+static void vkc_sparse_page_free(VkcSparse* sparse, VkcSparsePage* page) {
+    if (page->chunk.object) {
+        vkc_buffer_destroy(sparse->pool, &page->chunk);
+    } else {
+        if (page->data) {
+            vkc_memory_pool_unmap(sparse->pool, &page->memory);
+        }
+        vkc_memory_pool_free(sparse->pool, &page->memory);
+    }
+    free(page);
+}
+
+/**
+ * @brief Allocate, and map if the host accesses it, the memory of one page.
+ */
+static VkResult vkc_sparse_page_create(VkcSparse* sparse, uint64_t index, VkcSparsePage** out) {
+    VkcSparsePage* page = calloc(1, sizeof(*page));
+    if (!page) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkDeviceSize size = sparse->stats.page_size;
+    VkResult result;
+    if (VKC_SPARSE_MODE_CHUNKED == sparse->stats.mode) {
+        result = vkc_buffer_create(sparse->pool, size, sparse->usage, sparse->memory, &page->chunk);
+        page->data = page->chunk.data;
+    } else {
+        result = vkc_memory_pool_alloc(
+            sparse->pool,
+            &sparse->requirements,
+            sparse->memory,
+            VKC_MEMORY_RESOURCE_LINEAR,
+            &page->memory
+        );
+        if (VK_SUCCESS == result && VKC_MEMORY_USAGE_GPU_ONLY != sparse->memory) {
+            result = vkc_memory_pool_map(sparse->pool, &page->memory, &page->data);
+            if (VK_SUCCESS != result) {
+                page->data = NULL;
+            }
+        }
+    }
+
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcSparse] Failed to back page %llu: %d.", (unsigned long long) index, result);
+        vkc_sparse_page_free(sparse, page);
+        return result;
+    }
+
+    *out = page;
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Create the sparse-resident buffer and settle the page size around its block size.
+ *
+ * @return false if the device, queue or size rule residency out.
+ */
+static bool
+vkc_sparse_residency(VkcSparse* sparse, VkQueue queue, VkDeviceSize size, VkDeviceSize page_size) {
+    VkPhysicalDevice physical = vkc_memory_pool_physical(sparse->pool);
+    VkPhysicalDeviceFeatures features = {0};
+    VkPhysicalDeviceProperties properties = {0};
+    vkGetPhysicalDeviceFeatures(physical, &features);
+    vkGetPhysicalDeviceProperties(physical, &properties);
+
+    if (!queue || !features.sparseBinding || !features.sparseResidencyBuffer
+        || sparse->stats.size > properties.limits.sparseAddressSpaceSize) {
+        return false;
+    }
+
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(sparse->pool);
+    VkBufferCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .flags = VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT,
+        .size = sparse->stats.size,
+        .usage = sparse->usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+
+    // Pages are whole sparse blocks, and the range whole pages: at most one retry.
+    for (uint32_t attempt = 0; attempt < 2; attempt++) {
+        if (VK_SUCCESS != vkCreateBuffer(sparse->device, &info, callbacks, &sparse->buffer)) {
+            sparse->buffer = VK_NULL_HANDLE;
+            return false;
+        }
+
+        vkGetBufferMemoryRequirements(sparse->device, sparse->buffer, &sparse->requirements);
+        VkDeviceSize block = sparse->requirements.alignment;
+        page_size = (page_size + block - 1) / block * block;
+        VkDeviceSize rounded = (size + page_size - 1) / page_size * page_size;
+        if (rounded == info.size) {
+            sparse->stats.page_size = page_size;
+            sparse->requirements.size = page_size;
+            return true;
+        }
+
+        vkDestroyBuffer(sparse->device, sparse->buffer, callbacks);
+        sparse->buffer = VK_NULL_HANDLE;
+        info.size = rounded;
+        sparse->stats.size = rounded;
+    }
+    return false;
+}
+
+/**
+ * @brief Mark the pages under a range for flush or invalidate.
+ */
+static bool vkc_sparse_mark(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size, bool flush) {
+    if (!sparse || !vkc_sparse_span(sparse, offset, &size)) {
+        return false;
+    }
+
+    VkDeviceSize page_size = sparse->stats.page_size;
+    VkDeviceSize end = offset + size;
+    while (offset < end) {
+        const VkcSparsePage* page = sparse->pages[offset / page_size];
+        VkDeviceSize within = offset % page_size;
+        VkDeviceSize span = page_size - within < end - offset ? page_size - within : end - offset;
+        if (!page || !page->data) {
+            return false;
+        }
+
+        const VkcMemoryAllocation* memory = vkc_sparse_page_memory(page);
+        bool marked = flush ? vkc_memory_pool_mark_flush(sparse->pool, memory, within, span)
+                            : vkc_memory_pool_mark_invalidate(sparse->pool, memory, within, span);
+        if (!marked) {
+            return false;
+        }
+        offset += span;
+    }
+    return true;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcSparse* vkc_sparse_create(
+    VkcMemoryPool* pool,
+    VkQueue queue,
+    VkDeviceSize size,
+    VkBufferUsageFlags usage,
+    VkcMemoryUsage memory,
+    VkDeviceSize page_size
+) {
+    if (!pool || 0 == size || memory >= VKC_MEMORY_USAGE_COUNT) {
+        LOG_ERROR("[VkcSparse] Invalid sparse buffer request.");
+        return NULL;
+    }
+    if ((usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+        && !(vkc_memory_pool_flags(pool) & VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT)) {
+        LOG_ERROR("[VkcSparse] Device address usage needs VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT.");
+        return NULL;
+    }
+
+    VkcSparse* sparse = calloc(1, sizeof(*sparse));
+    if (!sparse) {
+        LOG_ERROR("[VkcSparse] Failed to allocate sparse buffer.");
+        return NULL;
+    }
+
+    page_size = page_size ? page_size : VKC_SPARSE_PAGE;
+    sparse->pool = pool;
+    sparse->device = vkc_memory_pool_device(pool);
+    sparse->queue = queue;
+    sparse->usage = usage;
+    sparse->memory = memory;
+    sparse->stats.size = (size + page_size - 1) / page_size * page_size;
+    sparse->stats.page_size = page_size;
+
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(pool);
+    if (vkc_sparse_residency(sparse, queue, size, page_size)) {
+        VkFenceCreateInfo fence = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        if (VK_SUCCESS != vkCreateFence(sparse->device, &fence, callbacks, &sparse->fence)) {
+            LOG_ERROR("[VkcSparse] Failed to create bind fence.");
+            vkDestroyBuffer(sparse->device, sparse->buffer, callbacks);
+            free(sparse);
+            return NULL;
+        }
+        if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+            VkBufferDeviceAddressInfo address = {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+                .buffer = sparse->buffer,
+            };
+            sparse->address = vkGetBufferDeviceAddress(sparse->device, &address);
+        }
+        sparse->stats.mode = VKC_SPARSE_MODE_RESIDENCY;
+    } else {
+        if (queue) {
+            LOG_WARN("[VkcSparse] Sparse residency unavailable; committing chunked buffers.");
+        }
+        sparse->stats.mode = VKC_SPARSE_MODE_CHUNKED;
+        sparse->stats.size = (size + page_size - 1) / page_size * page_size;
+        sparse->stats.page_size = page_size;
+    }
+
+    sparse->stats.pages = sparse->stats.size / sparse->stats.page_size;
+    sparse->pages = calloc(sparse->stats.pages, sizeof(*sparse->pages));
+    if (!sparse->pages) {
+        LOG_ERROR(
+            "[VkcSparse] Failed to allocate %llu page slots.",
+            (unsigned long long) sparse->stats.pages
+        );
+        vkc_sparse_destroy(sparse);
+        return NULL;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcSparse] Reserved %llu bytes as %llu pages of %llu (mode=%u).",
+        (unsigned long long) sparse->stats.size,
+        (unsigned long long) sparse->stats.pages,
+        (unsigned long long) sparse->stats.page_size,
+        (unsigned) sparse->stats.mode
+    );
+#endif
+
+    return sparse;
+}
+
+void vkc_sparse_destroy(VkcSparse* sparse) {
+    if (!sparse) {
+        return;
+    }
+
+    // Destroying the buffer unbinds its pages; their memory can go after it.
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(sparse->pool);
+    if (sparse->buffer) {
+        vkDestroyBuffer(sparse->device, sparse->buffer, callbacks);
+    }
+    if (sparse->fence) {
+        vkDestroyFence(sparse->device, sparse->fence, callbacks);
+    }
+    for (uint64_t i = 0; sparse->pages && i < sparse->stats.pages; i++) {
+        if (sparse->pages[i]) {
+            vkc_sparse_page_free(sparse, sparse->pages[i]);
+        }
+    }
+    free(sparse->pages);
+    free(sparse);
+}
+
+VkResult vkc_sparse_commit(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size) {
+    if (!sparse || !vkc_sparse_span(sparse, offset, &size)) {
+        LOG_ERROR("[VkcSparse] Invalid commit range.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkDeviceSize page_size = sparse->stats.page_size;
+    uint64_t first = offset / page_size;
+    uint64_t last = (offset + size - 1) / page_size;
+    uint64_t missing = 0;
+    for (uint64_t i = first; i <= last; i++) {
+        missing += !sparse->pages[i];
+    }
+    if (0 == missing) {
+        return VK_SUCCESS;
+    }
+
+    // Chunks are complete buffers the moment they exist.
+    if (VKC_SPARSE_MODE_CHUNKED == sparse->stats.mode) {
+        for (uint64_t i = first; i <= last; i++) {
+            if (!sparse->pages[i]) {
+                VkResult result = vkc_sparse_page_create(sparse, i, &sparse->pages[i]);
+                if (VK_SUCCESS != result) {
+                    return result;
+                }
+                sparse->stats.committed_pages++;
+                sparse->stats.committed_bytes += page_size;
+            }
+        }
+        return VK_SUCCESS;
+    }
+
+    if (missing > UINT32_MAX) {
+        LOG_ERROR("[VkcSparse] Cannot bind %llu pages at once.", (unsigned long long) missing);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkSparseMemoryBind* binds = calloc(missing, sizeof(*binds));
+    if (!binds) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    // New pages wait in their slots; they count as committed once the bind lands.
+    VkResult result = VK_SUCCESS;
+    uint32_t count = 0;
+    for (uint64_t i = first; i <= last && VK_SUCCESS == result; i++) {
+        VkcSparsePage* page = NULL;
+        if (sparse->pages[i]) {
+            continue;
+        }
+        result = vkc_sparse_page_create(sparse, i, &page);
+        if (VK_SUCCESS == result) {
+            binds[count++] = (VkSparseMemoryBind) {
+                .resourceOffset = i * page_size,
+                .size = page_size,
+                .memory = page->memory.memory,
+                .memoryOffset = page->memory.offset,
+            };
+            sparse->pages[i] = page;
+        }
+    }
+
+    if (VK_SUCCESS == result) {
+        result = vkc_sparse_bind(sparse, binds, count);
+    }
+
+    for (uint32_t j = 0; j < count; j++) {
+        uint64_t index = binds[j].resourceOffset / page_size;
+        if (VK_SUCCESS == result) {
+            sparse->stats.committed_pages++;
+            sparse->stats.committed_bytes += page_size;
+        } else {
+            vkc_sparse_page_free(sparse, sparse->pages[index]);
+            sparse->pages[index] = NULL;
+        }
+    }
+    free(binds);
+    return result;
+}
+
+VkResult vkc_sparse_release(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size) {
+    if (!sparse || !vkc_sparse_span(sparse, offset, &size)) {
+        LOG_ERROR("[VkcSparse] Invalid release range.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // Only pages the range covers completely.
+    VkDeviceSize page_size = sparse->stats.page_size;
+    uint64_t first = (offset + page_size - 1) / page_size;
+    uint64_t end = (offset + size) / page_size;
+    uint64_t count = 0;
+    for (uint64_t i = first; i < end; i++) {
+        count += !!sparse->pages[i];
+    }
+    if (0 == count) {
+        return VK_SUCCESS;
+    }
+
+    if (VKC_SPARSE_MODE_RESIDENCY == sparse->stats.mode) {
+        if (count > UINT32_MAX) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        VkSparseMemoryBind* binds = calloc(count, sizeof(*binds));
+        if (!binds) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
+        // A bind with no memory makes the page non-resident again.
+        uint32_t n = 0;
+        for (uint64_t i = first; i < end; i++) {
+            if (sparse->pages[i]) {
+                binds[n++] = (VkSparseMemoryBind) {
+                    .resourceOffset = i * page_size,
+                    .size = page_size,
+                    .memory = VK_NULL_HANDLE,
+                };
+            }
+        }
+        VkResult result = vkc_sparse_bind(sparse, binds, n);
+        free(binds);
+        if (VK_SUCCESS != result) {
+            return result;
+        }
+    }
+
+    for (uint64_t i = first; i < end; i++) {
+        if (sparse->pages[i]) {
+            vkc_sparse_page_free(sparse, sparse->pages[i]);
+            sparse->pages[i] = NULL;
+            sparse->stats.committed_pages--;
+            sparse->stats.committed_bytes -= page_size;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+bool vkc_sparse_committed(const VkcSparse* sparse, VkDeviceSize offset) {
+    return sparse && offset < sparse->stats.size
+           && sparse->pages[offset / sparse->stats.page_size];
+}
+
+bool vkc_sparse_resolve(const VkcSparse* sparse, VkDeviceSize offset, VkcSparseRange* range) {
+    if (!sparse || !range || offset >= sparse->stats.size) {
+        return false;
+    }
+
+    VkDeviceSize page_size = sparse->stats.page_size;
+    VkDeviceSize within = offset % page_size;
+    const VkcSparsePage* page = sparse->pages[offset / page_size];
+    *range = (VkcSparseRange) {0};
+
+    if (VKC_SPARSE_MODE_CHUNKED == sparse->stats.mode) {
+        if (!page) {
+            return false;
+        }
+        range->buffer = page->chunk.object;
+        range->offset = within;
+        range->size = page_size - within;
+        range->address = page->chunk.address ? page->chunk.address + within : 0;
+    } else {
+        range->buffer = sparse->buffer;
+        range->offset = offset;
+        range->size = sparse->stats.size - offset;
+        range->address = sparse->address ? sparse->address + offset : 0;
+    }
+
+    if (page && page->data) {
+        range->data = (uint8_t*) page->data + within;
+        range->mapped = page_size - within;
+    }
+    return true;
+}
+
+bool vkc_sparse_mark_flush(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size) {
+    return vkc_sparse_mark(sparse, offset, size, true);
+}
+
+bool vkc_sparse_mark_invalidate(VkcSparse* sparse, VkDeviceSize offset, VkDeviceSize size) {
+    return vkc_sparse_mark(sparse, offset, size, false);
+}
+
+bool vkc_sparse_stats(const VkcSparse* sparse, VkcSparseStats* stats) {
+    if (!sparse || !stats) {
+        return false;
+    }
+
+    *stats = sparse->stats;
+    return true;
+}
+
+/** @} */
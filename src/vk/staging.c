@@ -0,0 +1,414 @@
+/**
+ * @file src/vk/staging.c
+ * @brief Persistently mapped staging ring for host-to-device uploads.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/buffer.h"
+#include "vk/staging.h"
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Initial capacity of the copy queue.
+#define VKC_STAGING_COPIES 16
+
+/**
+ * @brief Ring space closed by one submission, and what signals its completion.
+ */
+typedef struct VkcStagingBatch {
+    uint64_t end; /**< Ring position the batch's space ends at. */
+    VkFence fence; /**< Ring-owned fence, or VK_NULL_HANDLE for a timeline batch. */
+    VkSemaphore semaphore;
+    uint64_t value;
+} VkcStagingBatch;
+
+struct VkcStaging {
+    VkDevice device;
+    VkcMemoryPool* pool;
+    VkAllocationCallbacks callbacks;
+    const VkAllocationCallbacks* host; /**< `&callbacks`, or NULL for the driver's own. */
+    VkcBuffer buffer; /**< Mapped for the ring's life. */
+    VkDeviceSize size;
+    uint64_t head; /**< Next free position; positions only grow, offsets are modulo size. */
+    uint64_t tail; /**< Start of the oldest space still in flight. */
+    VkcStagingBatch batches[VKC_STAGING_BATCHES];
+    uint32_t first; /**< Oldest batch in flight. */
+    uint32_t count; /**< Batches in flight. */
+    VkFence fences[VKC_STAGING_BATCHES]; /**< Retired fences, already reset. */
+    uint32_t fence_count;
+    VkBuffer* dsts; /**< Destination of each queued copy. */
+    VkBufferCopy* copies;
+    uint32_t copy_count;
+    uint32_t copy_capacity;
+};
+
+static inline VkDeviceSize vkc_staging_align(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Reclaim the oldest batch's space once the device is done with it.
+ *
+ * @param wait Block until it completes instead of returning VK_NOT_READY.
+ */
+static VkResult vkc_staging_retire_batch(VkcStaging* staging, bool wait) {
+    VkcStagingBatch* batch = &staging->batches[staging->first];
+    VkResult result = VK_SUCCESS;
+
+    if (batch->fence) {
+        result = wait ? vkWaitForFences(staging->device, 1, &batch->fence, VK_TRUE, UINT64_MAX)
+                      : vkGetFenceStatus(staging->device, batch->fence);
+        if (VK_SUCCESS != result) {
+            return result;
+        }
+
+        vkResetFences(staging->device, 1, &batch->fence);
+        staging->fences[staging->fence_count++] = batch->fence;
+    } else if (wait) {
+        VkSemaphoreWaitInfo info = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores = &batch->semaphore,
+            .pValues = &batch->value,
+        };
+        result = vkWaitSemaphores(staging->device, &info, UINT64_MAX);
+        if (VK_SUCCESS != result) {
+            return result;
+        }
+    } else {
+        uint64_t value = 0;
+        result = vkGetSemaphoreCounterValue(staging->device, batch->semaphore, &value);
+        if (VK_SUCCESS != result) {
+            return result;
+        }
+        if (value < batch->value) {
+            return VK_NOT_READY;
+        }
+    }
+
+    staging->tail = batch->end;
+    staging->first = (staging->first + 1) % VKC_STAGING_BATCHES;
+    staging->count--;
+    return VK_SUCCESS;
+}
+
+/**
+ * @brief Make room for one more batch, waiting on the oldest if all slots are in flight.
+ */
+static VkResult vkc_staging_reserve_batch(VkcStaging* staging) {
+    if (VKC_STAGING_BATCHES > staging->count) {
+        return VK_SUCCESS;
+    }
+
+    VkResult result = vkc_staging_retire_batch(staging, true);
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcStaging] Failed to wait for the oldest batch: %d.", result);
+    }
+    return result;
+}
+
+static void vkc_staging_close(
+    VkcStaging* staging, VkFence fence, VkSemaphore semaphore, uint64_t value
+) {
+    uint32_t slot = (staging->first + staging->count) % VKC_STAGING_BATCHES;
+    staging->batches[slot] = (VkcStagingBatch) {
+        .end = staging->head,
+        .fence = fence,
+        .semaphore = semaphore,
+        .value = value,
+    };
+    staging->count++;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcStaging* vkc_staging_create(
+    VkDevice device,
+    VkcMemoryPool* pool,
+    const VkAllocationCallbacks* callbacks,
+    VkDeviceSize size
+) {
+    if (!device || !pool) {
+        LOG_ERROR("[VkcStaging] Missing device or memory pool.");
+        return NULL;
+    }
+
+    VkcStaging* staging = calloc(1, sizeof(*staging));
+    if (!staging) {
+        LOG_ERROR("[VkcStaging] Failed to allocate ring.");
+        return NULL;
+    }
+
+    staging->device = device;
+    staging->pool = pool;
+    staging->size = size ? size : VKC_STAGING_SIZE;
+    if (callbacks) {
+        staging->callbacks = *callbacks;
+        staging->host = &staging->callbacks;
+    }
+
+    VkResult result = vkc_buffer_create(
+        pool,
+        staging->size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VKC_MEMORY_USAGE_UPLOAD,
+        &staging->buffer
+    );
+    if (VK_SUCCESS != result) {
+        LOG_ERROR("[VkcStaging] Failed to create staging buffer: %d.", result);
+        free(staging);
+        return NULL;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcStaging] Created ring of %llu bytes @ %p.",
+        (unsigned long long) staging->size,
+        staging->buffer.data
+    );
+#endif
+
+    return staging;
+}
+
+void vkc_staging_destroy(VkcStaging* staging) {
+    if (!staging) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < staging->count; i++) {
+        VkcStagingBatch* batch = &staging->batches[(staging->first + i) % VKC_STAGING_BATCHES];
+        if (batch->fence) {
+            vkDestroyFence(staging->device, batch->fence, staging->host);
+        }
+    }
+
+    for (uint32_t i = 0; i < staging->fence_count; i++) {
+        vkDestroyFence(staging->device, staging->fences[i], staging->host);
+    }
+
+    vkc_buffer_destroy(staging->pool, &staging->buffer);
+    free(staging->dsts);
+    free(staging->copies);
+    free(staging);
+}
+
+VkBuffer vkc_staging_buffer(VkcStaging* staging) {
+    return staging ? staging->buffer.object : VK_NULL_HANDLE;
+}
+
+VkResult vkc_staging_alloc(
+    VkcStaging* staging, VkDeviceSize size, VkDeviceSize alignment, VkcStagingRange* range
+) {
+    if (!staging || !range || 0 == size) {
+        LOG_ERROR("[VkcStaging] Invalid staging request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (size > staging->size) {
+        LOG_ERROR(
+            "[VkcStaging] %llu bytes exceed the %llu byte ring.",
+            (unsigned long long) size,
+            (unsigned long long) staging->size
+        );
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+
+    if (0 == alignment) {
+        alignment = 1;
+    }
+
+    for (;;) {
+        VkDeviceSize offset = staging->head % staging->size;
+        VkDeviceSize aligned = vkc_staging_align(offset, alignment);
+        uint64_t start = staging->head + (aligned - offset);
+        if (aligned + size > staging->size) {
+            // Never split a range across the end: skip to the start of the next lap.
+            start = staging->head + (staging->size - offset);
+        }
+
+        if (start + size - staging->tail <= staging->size) {
+            staging->head = start + size;
+            *range = (VkcStagingRange) {
+                .data = (uint8_t*) staging->buffer.data + start % staging->size,
+                .offset = start % staging->size,
+                .size = size,
+            };
+            return VK_SUCCESS;
+        }
+
+        if (0 == staging->count) {
+            LOG_ERROR("[VkcStaging] Ring is full of uploads that were never submitted.");
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+
+        // Poll first; block on the oldest batch only when none has completed.
+        VkResult result = vkc_staging_retire_batch(staging, false);
+        if (VK_NOT_READY == result) {
+            result = vkc_staging_retire_batch(staging, true);
+        }
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkcStaging] Failed to retire a batch: %d.", result);
+            return result;
+        }
+    }
+}
+
+bool vkc_staging_copy(
+    VkcStaging* staging, const VkcStagingRange* range, VkBuffer dst, VkDeviceSize dst_offset
+) {
+    if (!staging || !range || !dst) {
+        return false;
+    }
+
+    // A no-op unless the ring landed in non-coherent memory.
+    if (!vkc_buffer_mark_flush(staging->pool, &staging->buffer, range->offset, range->size)) {
+        return false;
+    }
+
+    if (staging->copy_count) {
+        // Extend the previous region when this copy continues it on both sides.
+        VkBufferCopy* last = &staging->copies[staging->copy_count - 1];
+        if (dst == staging->dsts[staging->copy_count - 1]
+            && last->srcOffset + last->size == range->offset
+            && last->dstOffset + last->size == dst_offset) {
+            last->size += range->size;
+            return true;
+        }
+    }
+
+    if (staging->copy_count == staging->copy_capacity) {
+        uint32_t capacity = staging->copy_capacity ? staging->copy_capacity * 2
+                                                   : VKC_STAGING_COPIES;
+        VkBuffer* dsts = realloc(staging->dsts, capacity * sizeof(*dsts));
+        if (!dsts) {
+            LOG_ERROR("[VkcStaging] Failed to grow the copy queue.");
+            return false;
+        }
+        staging->dsts = dsts;
+
+        VkBufferCopy* copies = realloc(staging->copies, capacity * sizeof(*copies));
+        if (!copies) {
+            LOG_ERROR("[VkcStaging] Failed to grow the copy queue.");
+            return false;
+        }
+        staging->copies = copies;
+        staging->copy_capacity = capacity;
+    }
+
+    staging->dsts[staging->copy_count] = dst;
+    staging->copies[staging->copy_count] = (VkBufferCopy) {
+        .srcOffset = range->offset,
+        .dstOffset = dst_offset,
+        .size = range->size,
+    };
+    staging->copy_count++;
+    return true;
+}
+
+VkResult vkc_staging_upload(
+    VkcStaging* staging, VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size
+) {
+    if (!data) {
+        LOG_ERROR("[VkcStaging] Missing upload data.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkcStagingRange range;
+    VkResult result = vkc_staging_alloc(staging, size, VKC_STAGING_ALIGNMENT, &range);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    memcpy(range.data, data, size);
+    return vkc_staging_copy(staging, &range, dst, dst_offset) ? VK_SUCCESS
+                                                              : VK_ERROR_OUT_OF_HOST_MEMORY;
+}
+
+uint32_t vkc_staging_record(VkcStaging* staging, VkCommandBuffer command_buffer) {
+    if (!staging || !command_buffer) {
+        return 0;
+    }
+
+    uint32_t calls = 0;
+    for (uint32_t i = 0; i < staging->copy_count;) {
+        uint32_t run = i + 1;
+        while (run < staging->copy_count && staging->dsts[run] == staging->dsts[i]) {
+            run++;
+        }
+
+        vkCmdCopyBuffer(
+            command_buffer, staging->buffer.object, staging->dsts[i], run - i, &staging->copies[i]
+        );
+        calls++;
+        i = run;
+    }
+
+    staging->copy_count = 0;
+    return calls;
+}
+
+VkResult vkc_staging_fence(VkcStaging* staging, VkFence* fence) {
+    if (!staging || !fence) {
+        LOG_ERROR("[VkcStaging] Invalid fence request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkResult result = vkc_staging_reserve_batch(staging);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    vkc_staging_retire(staging);
+
+    VkFence handle = VK_NULL_HANDLE;
+    if (staging->fence_count) {
+        handle = staging->fences[--staging->fence_count];
+    } else {
+        VkFenceCreateInfo info = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        result = vkCreateFence(staging->device, &info, staging->host, &handle);
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkcStaging] Failed to create fence: %d.", result);
+            return result;
+        }
+    }
+
+    vkc_staging_close(staging, handle, VK_NULL_HANDLE, 0);
+    *fence = handle;
+    return VK_SUCCESS;
+}
+
+VkResult vkc_staging_timeline(VkcStaging* staging, VkSemaphore semaphore, uint64_t value) {
+    if (!staging || !semaphore) {
+        LOG_ERROR("[VkcStaging] Invalid timeline request.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkResult result = vkc_staging_reserve_batch(staging);
+    if (VK_SUCCESS != result) {
+        return result;
+    }
+
+    vkc_staging_close(staging, VK_NULL_HANDLE, semaphore, value);
+    return VK_SUCCESS;
+}
+
+void vkc_staging_retire(VkcStaging* staging) {
+    if (!staging) {
+        return;
+    }
+
+    while (staging->count && VK_SUCCESS == vkc_staging_retire_batch(staging, false)) {}
+}
+
+/** @} */
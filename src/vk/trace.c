@@ -0,0 +1,280 @@
+/**
+ * @file src/vk/trace.c
+ * @brief Host allocation trace recorder.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/trace.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Records the writer moves from the ring to the file per fwrite().
+#define VKC_TRACE_BATCH 1024
+
+// Writer sleep between drains when the ring is empty.
+#define VKC_TRACE_IDLE_NS (1000 * 1000)
+
+/**
+ * @brief Ring slot. The sequence tells producers and the writer whose turn it is.
+ */
+typedef struct VkcTraceCell {
+    atomic_size_t sequence;
+    VkcTraceRecord record;
+} VkcTraceCell;
+
+struct VkcTrace {
+    VkcTraceCell* cells;
+    size_t mask; /**< Capacity - 1. */
+    alignas(64) atomic_size_t tail; /**< Next position producers claim. */
+    alignas(64) size_t head; /**< Next position the writer drains; writer-only. */
+    atomic_uint_least64_t dropped;
+    atomic_uint_least32_t threads; /**< Last thread number handed out. */
+    atomic_bool stop;
+    pthread_key_t key; /**< Maps each thread to its number. */
+    pthread_t writer;
+    FILE* file;
+    uint64_t epoch; /**< CLOCK_MONOTONIC at creation, in nanoseconds. */
+};
+
+static inline uint64_t vkc_trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static uint32_t vkc_trace_thread(VkcTrace* trace) {
+    // Numbers are stored off by one so a NULL slot means "not assigned yet".
+    uintptr_t number = (uintptr_t) pthread_getspecific(trace->key);
+    if (number) {
+        return (uint32_t) number;
+    }
+
+    number = atomic_fetch_add_explicit(&trace->threads, 1, memory_order_relaxed) + 1;
+    pthread_setspecific(trace->key, (void*) number);
+    return (uint32_t) number;
+}
+
+/**
+ * @brief Move every published record to the file. Only the writer thread calls this.
+ *
+ * @return Number of records written.
+ */
+static size_t vkc_trace_drain(VkcTrace* trace) {
+    VkcTraceRecord batch[VKC_TRACE_BATCH];
+    size_t total = 0;
+
+    for (;;) {
+        size_t count = 0;
+        while (count < VKC_TRACE_BATCH) {
+            VkcTraceCell* cell = &trace->cells[trace->head & trace->mask];
+            size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+            if (sequence != trace->head + 1) {
+                break; // Empty, or a producer is still filling this cell
+            }
+
+            batch[count++] = cell->record;
+            // Hand the cell back to producers one lap ahead.
+            atomic_store_explicit(
+                &cell->sequence, trace->head + trace->mask + 1, memory_order_release
+            );
+            trace->head++;
+        }
+
+        if (0 == count) {
+            return total;
+        }
+
+        if (count != fwrite(batch, sizeof(VkcTraceRecord), count, trace->file)) {
+            LOG_ERROR("[VkcTrace] Failed to write %zu records.", count);
+        }
+        total += count;
+    }
+}
+
+static void* vkc_trace_writer(void* arg) {
+    VkcTrace* trace = (VkcTrace*) arg;
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = VKC_TRACE_IDLE_NS};
+
+    while (!atomic_load_explicit(&trace->stop, memory_order_acquire)) {
+        if (0 == vkc_trace_drain(trace)) {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    vkc_trace_drain(trace);
+    return NULL;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcTrace* vkc_trace_create(const char* path, size_t capacity) {
+    if (!path) {
+        LOG_ERROR("[VkcTrace] Missing trace path.");
+        return NULL;
+    }
+
+    if (0 == capacity) {
+        capacity = VKC_TRACE_CAPACITY;
+    }
+    size_t rounded = 2;
+    while (rounded < capacity && rounded <= SIZE_MAX / 2) {
+        rounded <<= 1;
+    }
+
+    VkcTrace* trace = calloc(1, sizeof(*trace));
+    if (!trace) {
+        LOG_ERROR("[VkcTrace] Failed to allocate recorder.");
+        return NULL;
+    }
+
+    trace->cells = calloc(rounded, sizeof(VkcTraceCell));
+    if (!trace->cells) {
+        LOG_ERROR("[VkcTrace] Failed to allocate a ring of %zu records.", rounded);
+        free(trace);
+        return NULL;
+    }
+
+    trace->mask = rounded - 1;
+    for (size_t i = 0; i < rounded; i++) {
+        atomic_init(&trace->cells[i].sequence, i);
+    }
+
+    trace->file = fopen(path, "wb");
+    if (!trace->file) {
+        LOG_ERROR("[VkcTrace] Failed to open %s.", path);
+        free(trace->cells);
+        free(trace);
+        return NULL;
+    }
+
+    VkcTraceHeader header = {
+        .version = VKC_TRACE_VERSION,
+        .record_size = sizeof(VkcTraceRecord),
+    };
+    memcpy(header.magic, VKC_TRACE_MAGIC, sizeof(header.magic));
+    if (1 != fwrite(&header, sizeof(header), 1, trace->file)) {
+        LOG_ERROR("[VkcTrace] Failed to write the header of %s.", path);
+        fclose(trace->file);
+        free(trace->cells);
+        free(trace);
+        return NULL;
+    }
+
+    if (0 != pthread_key_create(&trace->key, NULL)) {
+        LOG_ERROR("[VkcTrace] Failed to create thread key.");
+        fclose(trace->file);
+        free(trace->cells);
+        free(trace);
+        return NULL;
+    }
+
+    trace->epoch = vkc_trace_now();
+    if (0 != pthread_create(&trace->writer, NULL, vkc_trace_writer, trace)) {
+        LOG_ERROR("[VkcTrace] Failed to start the writer thread.");
+        pthread_key_delete(trace->key);
+        fclose(trace->file);
+        free(trace->cells);
+        free(trace);
+        return NULL;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG("[VkcTrace] Recording to %s (ring=%zu records).", path, rounded);
+#endif
+
+    return trace;
+}
+
+void vkc_trace_destroy(VkcTrace* trace) {
+    if (!trace) {
+        return;
+    }
+
+    atomic_store_explicit(&trace->stop, true, memory_order_release);
+    pthread_join(trace->writer, NULL);
+
+    uint64_t dropped = atomic_load_explicit(&trace->dropped, memory_order_relaxed);
+    if (dropped) {
+        LOG_ERROR(
+            "[VkcTrace] Dropped %llu records: the ring was full.", (unsigned long long) dropped
+        );
+    }
+
+    pthread_key_delete(trace->key);
+    fclose(trace->file);
+    free(trace->cells);
+    free(trace);
+}
+
+void vkc_trace_record(
+    VkcTrace* trace,
+    VkcTraceOp op,
+    const void* original,
+    const void* address,
+    size_t size,
+    size_t alignment,
+    uint32_t scope
+) {
+    if (!trace) {
+        return;
+    }
+
+    // Bounded multi-producer ring: claim a position whose cell has been drained.
+    VkcTraceCell* cell = NULL;
+    size_t position = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+    for (;;) {
+        cell = &trace->cells[position & trace->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t lag = (intptr_t) sequence - (intptr_t) position;
+        if (0 == lag) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &trace->tail,
+                    &position,
+                    position + 1,
+                    memory_order_relaxed,
+                    memory_order_relaxed
+                )) {
+                break;
+            }
+        } else if (lag < 0) {
+            // The writer is a full lap behind.
+            atomic_fetch_add_explicit(&trace->dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            position = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+        }
+    }
+
+    cell->record = (VkcTraceRecord) {
+        .timestamp = vkc_trace_now() - trace->epoch,
+        .address = (uint64_t) (uintptr_t) address,
+        .original = (uint64_t) (uintptr_t) original,
+        .size = size,
+        .alignment = (uint32_t) alignment,
+        .thread = vkc_trace_thread(trace),
+        .op = (uint8_t) op,
+        .scope = (uint8_t) scope,
+    };
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+}
+
+uint64_t vkc_trace_dropped(VkcTrace* trace) {
+    return trace ? atomic_load_explicit(&trace->dropped, memory_order_relaxed) : 0;
+}
+
+/** @} */
@@ -0,0 +1,384 @@
+/**
+ * @file src/vk/transient.c
+ * @brief Transient buffers that share memory when their lifetimes do not overlap.
+ */
+
+#include "core/posix.h"
+#include "core/memory.h"
+#include "core/logger.h"
+#include "vk/transient.h"
+
+/**
+ * @name Private
+ * @{
+ */
+
+// Initial capacity of the buffer list.
+#define VKC_TRANSIENT_BUFFERS 16
+
+/**
+ * @brief Buffer waiting to be placed, and the bytes it takes.
+ */
+typedef struct VkcTransientSlot {
+    uint32_t id;
+    VkDeviceSize size; /**< From the buffer's memory requirements. */
+    VkDeviceSize alignment;
+} VkcTransientSlot;
+
+struct VkcTransient {
+    VkcMemoryPool* pool;
+    VkDevice device;
+    VkcMemoryUsage memory;
+    VkcTransientBuffer* buffers;
+    uint32_t count;
+    uint32_t capacity;
+    VkcMemoryAllocation allocation; /**< The shared range, once built. */
+    bool built;
+    VkcTransientStats stats;
+};
+
+static VkDeviceSize vkc_transient_align(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool vkc_transient_overlap(const VkcTransientBuffer* a, const VkcTransientBuffer* b) {
+    return a->first <= b->last && b->first <= a->last;
+}
+
+static int vkc_transient_compare(const void* a, const void* b) {
+    const VkcTransientSlot* x = a;
+    const VkcTransientSlot* y = b;
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static int vkc_transient_compare_offset(const void* a, const void* b) {
+    const VkcTransientSlot* x = a;
+    const VkcTransientSlot* y = b;
+    return (x->size > y->size) - (x->size < y->size);
+}
+
+/**
+ * @brief Destroy every VkBuffer and return the shared range.
+ */
+static void vkc_transient_release(VkcTransient* transient) {
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(transient->pool);
+    for (uint32_t i = 0; i < transient->count; i++) {
+        VkcTransientBuffer* buffer = &transient->buffers[i];
+        if (buffer->object) {
+            vkDestroyBuffer(transient->device, buffer->object, callbacks);
+        }
+        buffer->object = VK_NULL_HANDLE;
+        buffer->offset = 0;
+        buffer->data = NULL;
+        buffer->address = 0;
+    }
+
+    if (transient->allocation.region && VKC_MEMORY_USAGE_GPU_ONLY != transient->memory) {
+        vkc_memory_pool_unmap(transient->pool, &transient->allocation);
+    }
+    vkc_memory_pool_free(transient->pool, &transient->allocation);
+    transient->built = false;
+}
+
+/**
+ * @brief Give every slot an offset, largest first, and return the bytes they span.
+ *
+ * `slots` is sorted largest first. `placed` is scratch for as many slots; each entry's
+ * `size` holds an offset while it is sorted by offset.
+ */
+static VkDeviceSize vkc_transient_place(
+    VkcTransient* transient, const VkcTransientSlot* slots, VkcTransientSlot* placed
+) {
+    VkDeviceSize span = 0;
+    for (uint32_t i = 0; i < transient->count; i++) {
+        VkcTransientBuffer* buffer = &transient->buffers[slots[i].id];
+
+        // Buffers already placed that are live with this one, in offset order.
+        uint32_t conflicts = 0;
+        for (uint32_t j = 0; j < i; j++) {
+            const VkcTransientBuffer* other = &transient->buffers[slots[j].id];
+            if (vkc_transient_overlap(buffer, other)) {
+                placed[conflicts++] = (VkcTransientSlot) {.id = j, .size = other->offset};
+            }
+        }
+        qsort(placed, conflicts, sizeof(*placed), vkc_transient_compare_offset);
+
+        // Lowest gap between them that fits.
+        VkDeviceSize offset = 0;
+        for (uint32_t j = 0; j < conflicts; j++) {
+            VkDeviceSize start = vkc_transient_align(offset, slots[i].alignment);
+            if (start + slots[i].size <= placed[j].size) {
+                break;
+            }
+            VkDeviceSize end = placed[j].size + slots[placed[j].id].size;
+            offset = end > offset ? end : offset;
+        }
+
+        buffer->offset = vkc_transient_align(offset, slots[i].alignment);
+        if (buffer->offset + slots[i].size > span) {
+            span = buffer->offset + slots[i].size;
+        }
+    }
+    return span;
+}
+
+/**
+ * @brief Most bytes the buffers live in any one stage hold.
+ */
+static VkDeviceSize
+vkc_transient_live(const VkcTransient* transient, const VkcTransientSlot* slots) {
+    VkDeviceSize peak = 0;
+    for (uint32_t stage = 0; stage < transient->stats.stages; stage++) {
+        VkDeviceSize live = 0;
+        for (uint32_t i = 0; i < transient->count; i++) {
+            const VkcTransientBuffer* buffer = &transient->buffers[slots[i].id];
+            if (buffer->first <= stage && stage <= buffer->last) {
+                live += slots[i].size;
+            }
+        }
+        peak = live > peak ? live : peak;
+    }
+    return peak;
+}
+
+/** @} */
+
+/**
+ * @name Public
+ * @{
+ */
+
+VkcTransient* vkc_transient_create(VkcMemoryPool* pool, VkcMemoryUsage memory) {
+    if (!pool || memory >= VKC_MEMORY_USAGE_COUNT) {
+        LOG_ERROR("[VkcTransient] Invalid plan request.");
+        return NULL;
+    }
+
+    VkcTransient* transient = calloc(1, sizeof(*transient));
+    if (!transient) {
+        LOG_ERROR("[VkcTransient] Failed to allocate plan.");
+        return NULL;
+    }
+
+    transient->pool = pool;
+    transient->device = vkc_memory_pool_device(pool);
+    transient->memory = memory;
+    return transient;
+}
+
+void vkc_transient_destroy(VkcTransient* transient) {
+    if (!transient) {
+        return;
+    }
+
+    vkc_transient_release(transient);
+    free(transient->buffers);
+    free(transient);
+}
+
+uint32_t
+vkc_transient_declare(VkcTransient* transient, VkDeviceSize size, VkBufferUsageFlags usage) {
+    if (!transient || transient->built || 0 == size
+        || VKC_TRANSIENT_INVALID == transient->count) {
+        LOG_ERROR("[VkcTransient] Invalid buffer declaration.");
+        return VKC_TRANSIENT_INVALID;
+    }
+    if ((usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+        && !(vkc_memory_pool_flags(transient->pool) & VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT)) {
+        LOG_ERROR("[VkcTransient] Device address usage needs VKC_MEMORY_POOL_DEVICE_ADDRESS_BIT.");
+        return VKC_TRANSIENT_INVALID;
+    }
+
+    if (transient->count == transient->capacity) {
+        uint32_t capacity
+            = transient->capacity ? transient->capacity * 2 : VKC_TRANSIENT_BUFFERS;
+        VkcTransientBuffer* buffers
+            = realloc(transient->buffers, capacity * sizeof(*transient->buffers));
+        if (!buffers) {
+            LOG_ERROR("[VkcTransient] Failed to grow buffer list to %u.", capacity);
+            return VKC_TRANSIENT_INVALID;
+        }
+        transient->buffers = buffers;
+        transient->capacity = capacity;
+    }
+
+    // Used by no stage yet: an empty lifetime overlaps nothing.
+    transient->buffers[transient->count] = (VkcTransientBuffer) {
+        .size = size,
+        .usage = usage,
+        .first = UINT32_MAX,
+        .last = 0,
+    };
+    transient->stats.buffers = transient->count + 1;
+    return transient->count++;
+}
+
+bool vkc_transient_use(VkcTransient* transient, uint32_t id, uint32_t stage) {
+    if (!transient || transient->built || id >= transient->count || UINT32_MAX == stage) {
+        LOG_ERROR("[VkcTransient] Invalid use of buffer %u in stage %u.", id, stage);
+        return false;
+    }
+
+    VkcTransientBuffer* buffer = &transient->buffers[id];
+    buffer->first = stage < buffer->first ? stage : buffer->first;
+    buffer->last = stage > buffer->last ? stage : buffer->last;
+    if (stage >= transient->stats.stages) {
+        transient->stats.stages = stage + 1;
+    }
+    return true;
+}
+
+VkResult vkc_transient_build(VkcTransient* transient) {
+    if (!transient || transient->built) {
+        LOG_ERROR("[VkcTransient] Invalid or already built plan.");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    transient->built = true;
+    if (0 == transient->count) {
+        return VK_SUCCESS;
+    }
+
+    VkcTransientSlot* slots = calloc(2 * (size_t) transient->count, sizeof(*slots));
+    if (!slots) {
+        transient->built = false;
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    // Every buffer exists before placement: their requirements decide the layout.
+    const VkAllocationCallbacks* callbacks = vkc_memory_pool_callbacks(transient->pool);
+    VkMemoryRequirements shared = {.alignment = 1, .memoryTypeBits = UINT32_MAX};
+    VkResult result = VK_SUCCESS;
+    transient->stats.unaliased_bytes = 0;
+    for (uint32_t i = 0; i < transient->count && VK_SUCCESS == result; i++) {
+        VkcTransientBuffer* buffer = &transient->buffers[i];
+        VkBufferCreateInfo info = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = buffer->size,
+            .usage = buffer->usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+        result = vkCreateBuffer(transient->device, &info, callbacks, &buffer->object);
+        if (VK_SUCCESS != result) {
+            buffer->object = VK_NULL_HANDLE;
+            LOG_ERROR("[VkcTransient] Failed to create buffer %u: %d.", i, result);
+            break;
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(transient->device, buffer->object, &requirements);
+        slots[i] = (VkcTransientSlot) {
+            .id = i,
+            .size = requirements.size,
+            .alignment = requirements.alignment,
+        };
+        shared.memoryTypeBits &= requirements.memoryTypeBits;
+        if (requirements.alignment > shared.alignment) {
+            shared.alignment = requirements.alignment;
+        }
+        transient->stats.unaliased_bytes += vkc_transient_align(
+            requirements.size, requirements.alignment
+        );
+    }
+
+    if (VK_SUCCESS == result && 0 == shared.memoryTypeBits) {
+        LOG_ERROR("[VkcTransient] No memory type suits all %u buffers.", transient->count);
+        result = VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    if (VK_SUCCESS == result) {
+        transient->stats.live_bytes = vkc_transient_live(transient, slots);
+        qsort(slots, transient->count, sizeof(*slots), vkc_transient_compare);
+        shared.size = vkc_transient_place(transient, slots, slots + transient->count);
+        transient->stats.aliased_bytes = shared.size;
+
+        result = vkc_memory_pool_alloc(
+            transient->pool,
+            &shared,
+            transient->memory,
+            VKC_MEMORY_RESOURCE_LINEAR,
+            &transient->allocation
+        );
+    }
+
+    void* base = NULL;
+    if (VK_SUCCESS == result && VKC_MEMORY_USAGE_GPU_ONLY != transient->memory) {
+        result = vkc_memory_pool_map(transient->pool, &transient->allocation, &base);
+        if (VK_SUCCESS != result) {
+            vkc_memory_pool_free(transient->pool, &transient->allocation);
+        }
+    }
+
+    // Every buffer starts at its own offset of the one shared range.
+    for (uint32_t i = 0; i < transient->count && VK_SUCCESS == result; i++) {
+        VkcTransientBuffer* buffer = &transient->buffers[i];
+        VkDeviceSize offset = transient->allocation.offset + buffer->offset;
+        result = vkBindBufferMemory(
+            transient->device, buffer->object, transient->allocation.memory, offset
+        );
+        if (VK_SUCCESS != result) {
+            LOG_ERROR("[VkcTransient] Failed to bind buffer %u: %d.", i, result);
+            break;
+        }
+
+        buffer->data = base ? (uint8_t*) base + buffer->offset : NULL;
+        if (buffer->usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+            VkBufferDeviceAddressInfo address = {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+                .buffer = buffer->object,
+            };
+            buffer->address = vkGetBufferDeviceAddress(transient->device, &address);
+        }
+    }
+
+    free(slots);
+    if (VK_SUCCESS != result) {
+        vkc_transient_release(transient);
+        return result;
+    }
+
+#if defined(VKC_DEBUG) && (1 == VKC_DEBUG)
+    LOG_DEBUG(
+        "[VkcTransient] Placed %u buffers over %u stages in %llu bytes (unaliased=%llu, "
+        "live=%llu).",
+        transient->count,
+        transient->stats.stages,
+        (unsigned long long) transient->stats.aliased_bytes,
+        (unsigned long long) transient->stats.unaliased_bytes,
+        (unsigned long long) transient->stats.live_bytes
+    );
+#endif
+
+    return VK_SUCCESS;
+}
+
+const VkcTransientBuffer* vkc_transient_buffer(const VkcTransient* transient, uint32_t id) {
+    if (!transient || !transient->built || id >= transient->count) {
+        return NULL;
+    }
+    return &transient->buffers[id];
+}
+
+void vkc_transient_reset(VkcTransient* transient) {
+    if (!transient) {
+        return;
+    }
+
+    vkc_transient_release(transient);
+    transient->count = 0;
+    transient->stats = (VkcTransientStats) {0};
+}
+
+bool vkc_transient_stats(const VkcTransient* transient, VkcTransientStats* stats) {
+    if (!transient || !stats) {
+        return false;
+    }
+
+    *stats = transient->stats;
+    return true;
+}
+
+/** @} */
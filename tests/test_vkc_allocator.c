@@ -0,0 +1,269 @@
+/**
+ * @file tests/test_vkc_allocator.c
+ * @brief Allocation contexts: scope counters, in-place and remapped reallocation, trim,
+ *        and teardown with blocks still live.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "vk/extent.h"
+#include "vk/slab.h"
+#include "vk/allocator.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_BLOCKS 20000
+#define TEST_CYCLES 20
+
+static VkcAllocatorScopeStats test_scope(VkcAllocatorContext* context, size_t scope) {
+    VkcAllocatorStats stats;
+    assert(vkc_allocator_context_stats(context, &stats));
+    return stats.scopes[scope];
+}
+
+static void test_allocator_counters(void) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    assert(context);
+    const VkAllocationCallbacks* callbacks = vkc_allocator_context_callbacks(context);
+    void* data = callbacks->pUserData;
+
+    // Live bytes count what a block occupies; the histogram counts what was asked for.
+    VkSystemAllocationScope cache = VK_SYSTEM_ALLOCATION_SCOPE_CACHE;
+    void* block = callbacks->pfnAllocation(data, 20, 16, cache);
+    assert(block);
+    VkcAllocatorScopeStats stats = test_scope(context, cache);
+    assert(1 == stats.allocations && 0 == stats.frees);
+    assert(vkc_slab_usable(20, 16) == stats.live_bytes);
+    assert(1 == stats.histogram[vkc_allocator_histogram_bin(20)]);
+    assert(0 == test_scope(context, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT).allocations);
+
+    callbacks->pfnFree(data, block);
+    stats = test_scope(context, cache);
+    assert(1 == stats.frees && 0 == stats.live_bytes);
+
+    // The peak outlives the block that set it.
+    VkSystemAllocationScope device = VK_SYSTEM_ALLOCATION_SCOPE_DEVICE;
+    block = callbacks->pfnAllocation(data, 1 << 20, 16, device);
+    assert(block);
+    callbacks->pfnFree(data, block);
+    stats = test_scope(context, device);
+    assert(0 == stats.live_bytes && stats.peak_bytes >= 1 << 20);
+
+    // Driver-internal allocations are tracked apart from the callbacks'.
+    VkInternalAllocationType executable = VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE;
+    callbacks->pfnInternalAllocation(data, 4096, executable, device);
+    VkcAllocatorStats all;
+    assert(vkc_allocator_context_stats(context, &all));
+    assert(4096 == all.internal[device].live_bytes && 1 == all.internal[device].allocations);
+    callbacks->pfnInternalFree(data, 4096, executable, device);
+    assert(vkc_allocator_context_stats(context, &all));
+    assert(0 == all.internal[device].live_bytes && 1 == all.internal[device].frees);
+
+    assert(1 == vkc_allocator_histogram_bin(17) && 1 == vkc_allocator_histogram_bin(32));
+    assert(2 == vkc_allocator_histogram_bin(33));
+    assert(VKC_ALLOCATOR_HISTOGRAM_BINS - 1 == vkc_allocator_histogram_bin(SIZE_MAX));
+
+    vkc_allocator_context_destroy(context);
+}
+
+static void test_allocator_in_place(void) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    assert(context);
+    const VkAllocationCallbacks* callbacks = vkc_allocator_context_callbacks(context);
+    void* data = callbacks->pUserData;
+
+    // A request that still fits the block's size class keeps it in place. Growth is
+    // measured against the bytes the block already held, so this is not one.
+    VkSystemAllocationScope object = VK_SYSTEM_ALLOCATION_SCOPE_OBJECT;
+    uint8_t* block = callbacks->pfnAllocation(data, 20, 16, object);
+    memset(block, 3, 20);
+    assert(block == callbacks->pfnReallocation(data, block, vkc_slab_size(block), 16, object));
+    VkcAllocatorScopeStats stats = test_scope(context, object);
+    assert(1 == stats.reallocations && 0 == stats.growths && 1 == stats.in_place);
+
+    // Past the class it moves, contents intact.
+    uint8_t* moved = callbacks->pfnReallocation(data, block, 1000, 16, object);
+    assert(moved && moved != block && 3 == moved[19]);
+    callbacks->pfnFree(data, moved);
+
+    // The last block of the thread's arena chunk grows in place.
+    VkSystemAllocationScope command = VK_SYSTEM_ALLOCATION_SCOPE_COMMAND;
+    callbacks->pfnAllocation(data, 100, 16, command);
+    block = callbacks->pfnAllocation(data, 100, 16, command);
+    assert(block == callbacks->pfnReallocation(data, block, 8000, 16, command));
+    assert(1 == test_scope(context, command).in_place);
+
+    // Shrinking never moves a block.
+    uint8_t* large = callbacks->pfnAllocation(data, 1 << 20, 16, object);
+    assert(large == callbacks->pfnReallocation(data, large, 300000, 16, object));
+    callbacks->pfnFree(data, large);
+
+    vkc_allocator_context_destroy(context);
+}
+
+static void test_allocator_remap(void) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    assert(context);
+    const VkAllocationCallbacks* callbacks = vkc_allocator_context_callbacks(context);
+    void* data = callbacks->pUserData;
+    VkSystemAllocationScope object = VK_SYSTEM_ALLOCATION_SCOPE_OBJECT;
+
+    // A slab block growing past the slab range moves to a mapping of its own, which
+    // later growths extend or remap without copying; either way nothing is lost.
+    size_t size = 3000;
+    uint8_t* block = callbacks->pfnAllocation(data, size, 16, object);
+    assert(block);
+    memset(block, 0x42, size);
+    for (size_t next = 5000; next <= (size_t) 64 << 20; next *= 2) {
+        block = callbacks->pfnReallocation(data, block, next, 16, object);
+        assert(block);
+        assert(0 == (uintptr_t) block % 16);
+        assert(0x42 == block[0] && 0x42 == block[size - 1]);
+        memset(block + size, 0x42, next - size);
+        size = next;
+
+        // A block the extent map knows can be freed and resized without a hash lookup.
+        assert(vkc_extent_lookup(block));
+    }
+    VkcAllocatorScopeStats stats = test_scope(context, object);
+    assert(stats.growths == stats.reallocations);
+    assert(size == stats.live_bytes);
+
+    callbacks->pfnFree(data, block);
+    assert(0 == test_scope(context, object).live_bytes);
+    vkc_allocator_context_destroy(context);
+}
+
+static void test_allocator_trim(void) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    assert(context);
+    const VkAllocationCallbacks* callbacks = vkc_allocator_context_callbacks(context);
+    void* data = callbacks->pUserData;
+
+    static void* blocks[TEST_BLOCKS];
+    for (size_t i = 0; i < TEST_BLOCKS; i++) {
+        VkSystemAllocationScope scope = (VkSystemAllocationScope) (i % 5);
+        blocks[i] = callbacks->pfnAllocation(data, 200, 16, scope);
+        assert(blocks[i]);
+        memset(blocks[i], (int) i, 200);
+    }
+    for (size_t i = 0; i < TEST_BLOCKS; i++) {
+        if (i % 64) {
+            callbacks->pfnFree(data, blocks[i]);
+            blocks[i] = NULL;
+        }
+    }
+
+    // Trims return idle and free pages only: every surviving block reads back intact.
+    assert(vkc_allocator_context_trim(context, 0, true) > 0);
+    for (size_t i = 0; i < TEST_BLOCKS; i++) {
+        for (size_t j = 0; blocks[i] && j < 200; j++) {
+            assert((unsigned char) i == ((unsigned char*) blocks[i])[j]);
+        }
+    }
+    VkcAllocatorStats stats;
+    assert(vkc_allocator_context_stats(context, &stats));
+    assert(1 == stats.trims && stats.trimmed_bytes > 0);
+
+    // The background policy runs passes of its own until it is cleared.
+    VkcAllocatorTrimPolicy policy = {.interval_ns = 1000 * 1000};
+    assert(vkc_allocator_context_trim_policy(context, &policy));
+    struct timespec pause = {.tv_nsec = 1000 * 1000};
+    for (int i = 0; i < 2000 && stats.trims < 3; i++) {
+        nanosleep(&pause, NULL);
+        assert(vkc_allocator_context_stats(context, &stats));
+    }
+    assert(stats.trims >= 3);
+    assert(vkc_allocator_context_trim_policy(context, NULL));
+
+    for (size_t i = 0; i < TEST_BLOCKS; i++) {
+        for (size_t j = 0; blocks[i] && j < 200; j++) {
+            assert((unsigned char) i == ((unsigned char*) blocks[i])[j]);
+        }
+        callbacks->pfnFree(data, blocks[i]);
+    }
+    vkc_allocator_context_destroy(context);
+}
+
+static size_t test_mappings(void) {
+    FILE* file = fopen("/proc/self/maps", "r");
+    assert(file);
+    size_t count = 0;
+    for (int c = fgetc(file); EOF != c; c = fgetc(file)) {
+        count += '\n' == c;
+    }
+    fclose(file);
+    return count;
+}
+
+static void* test_allocator_worker(void* argument) {
+    const VkAllocationCallbacks* callbacks = argument;
+    for (size_t i = 0; i < 1000; i++) {
+        VkSystemAllocationScope scope = (VkSystemAllocationScope) (i % 5);
+        assert(callbacks->pfnAllocation(callbacks->pUserData, 16 + i * 7, 16, scope));
+    }
+    return NULL;
+}
+
+/**
+ * @brief Leave blocks of every kind live, optionally some from an exited thread, then destroy.
+ */
+static void test_allocator_cycle(bool threaded) {
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    assert(context);
+    const VkAllocationCallbacks* callbacks = vkc_allocator_context_callbacks(context);
+    void* data = callbacks->pUserData;
+
+    size_t sizes[] = {24, 1000, 4000, 50000, 300000, (size_t) 4 << 20};
+    for (size_t scope = 0; scope < VKC_ALLOCATOR_SCOPE_COUNT; scope++) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            void* block = callbacks->pfnAllocation(data, sizes[i], 16, scope);
+            assert(block);
+            memset(block, 1, sizes[i]);
+        }
+        assert(callbacks->pfnAllocation(data, 100, 8192, scope));
+    }
+
+    if (threaded) {
+        pthread_t thread;
+        assert(0 == pthread_create(&thread, NULL, test_allocator_worker, (void*) callbacks));
+        assert(0 == pthread_join(thread, NULL));
+    }
+    vkc_allocator_context_destroy(context);
+}
+
+static void test_allocator_teardown(void) {
+    // Destroying a context releases every mapping its blocks held. Threads stay out of
+    // the measured cycles: some runtimes keep mappings for every thread that exited.
+    test_allocator_cycle(true);
+    size_t baseline = test_mappings();
+    for (size_t i = 0; i < TEST_CYCLES; i++) {
+        test_allocator_cycle(false);
+    }
+    assert(test_mappings() < baseline + TEST_CYCLES);
+
+    // The process-wide context comes and goes the same way.
+    assert(vkc_allocator_create());
+    assert(vkc_allocator_context_callbacks(NULL) == vkc_allocator_callbacks());
+    const VkAllocationCallbacks* callbacks = vkc_allocator_callbacks();
+    assert(callbacks->pfnAllocation(callbacks->pUserData, 64, 16, 0));
+    assert(vkc_allocator_destroy());
+    assert(!vkc_allocator_get());
+}
+
+int main(void) {
+    test_allocator_counters();
+    test_allocator_in_place();
+    test_allocator_remap();
+    test_allocator_trim();
+    test_allocator_teardown();
+    puts("test_vkc_allocator: ok");
+    return 0;
+}
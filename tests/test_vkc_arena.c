@@ -0,0 +1,160 @@
+/**
+ * @file tests/test_vkc_arena.c
+ * @brief Bump arenas: rewinding drained chunks, spare reuse, in-place resize, trim.
+ */
+
+#include "vk/extent.h"
+#include "vk/numa.h"
+#include "vk/arena.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_CHUNK (64 * 1024)
+#define TEST_BLOCK 1000
+
+static bool test_inside(const void* address, const void* base) {
+    uintptr_t start = (uintptr_t) base & ~(uintptr_t) (TEST_CHUNK - 1);
+    return (uintptr_t) address - start < TEST_CHUNK;
+}
+
+static void test_arena_rewind(void) {
+    VkcArena* arena = vkc_arena_create(TEST_CHUNK, VKC_NUMA_NODE_ANY);
+    assert(arena);
+
+    void* first = vkc_arena_malloc(arena, 100, 0);
+    void* second = vkc_arena_malloc(arena, 100, 0);
+    assert(first && second && first != second);
+    assert(0 == (uintptr_t) first % VKC_ARENA_ALIGNMENT);
+    assert(arena == vkc_arena_owner(first));
+    assert(100 == vkc_arena_size(second));
+
+    // Once the chunk is drained the next block starts over at its base.
+    vkc_arena_free(arena, second);
+    vkc_arena_free(arena, first);
+    assert(first == vkc_arena_malloc(arena, 100, 0));
+
+    void* aligned = vkc_arena_malloc(arena, 24, 256);
+    assert(aligned && 0 == (uintptr_t) aligned % 256);
+    assert(!vkc_arena_accepts(arena, TEST_CHUNK, 0));
+    assert(!vkc_arena_malloc(arena, TEST_CHUNK, 0));
+
+    vkc_arena_destroy(arena);
+}
+
+static void test_arena_spare(void) {
+    VkcArena* arena = vkc_arena_create(TEST_CHUNK, VKC_NUMA_NODE_ANY);
+    assert(arena);
+
+    // Fill the first chunk until a block lands in a second one.
+    void* blocks[2 * TEST_CHUNK / TEST_BLOCK];
+    size_t count = 0;
+    do {
+        blocks[count] = vkc_arena_malloc(arena, TEST_BLOCK, 0);
+        assert(blocks[count]);
+        memset(blocks[count], (int) count, TEST_BLOCK);
+    } while (test_inside(blocks[count++], blocks[0]));
+    void* first = blocks[0];
+    void* second = blocks[count - 1];
+
+    // Draining the first chunk keeps it as a spare; the next chunk reuses it.
+    for (size_t i = 0; i + 1 < count; i++) {
+        vkc_arena_free(arena, blocks[i]);
+    }
+    void* block = second;
+    while (test_inside(block, second)) {
+        block = vkc_arena_malloc(arena, TEST_BLOCK, 0);
+        assert(block);
+    }
+    assert(test_inside(block, first));
+    assert(((unsigned char*) second)[TEST_BLOCK - 1] == (unsigned char) (count - 1));
+
+    vkc_arena_destroy(arena);
+}
+
+static void test_arena_resize(void) {
+    VkcArena* arena = vkc_arena_create(TEST_CHUNK, VKC_NUMA_NODE_ANY);
+    assert(arena);
+
+    void* head = vkc_arena_malloc(arena, 64, 0);
+    void* tail = vkc_arena_malloc(arena, 64, 0);
+    assert(head && tail);
+
+    // Only the thread's last block can grow; any block can shrink.
+    assert(vkc_arena_resize(arena, tail, 4096));
+    assert(4096 == vkc_arena_size(tail));
+    assert(!vkc_arena_resize(arena, head, 128));
+    assert(vkc_arena_resize(arena, head, 32));
+    assert(32 == vkc_arena_size(head));
+
+    // The grown tail pushed the cursor past itself.
+    void* next = vkc_arena_malloc(arena, 16, 0);
+    assert((uintptr_t) next >= (uintptr_t) tail + 4096);
+
+    vkc_arena_destroy(arena);
+}
+
+typedef struct TestArenaWorker {
+    VkcArena* arena;
+    void* block;
+} TestArenaWorker;
+
+static void* test_arena_worker(void* argument) {
+    TestArenaWorker* worker = argument;
+    worker->block = vkc_arena_malloc(worker->arena, 100, 0);
+    return NULL;
+}
+
+/**
+ * @brief Leave a rewound spare chunk: one another thread carved and then exited.
+ */
+static void test_arena_leave_spare(VkcArena* arena, const void* live) {
+    // The exiting thread hands its chunk back; freeing the block recycles it.
+    TestArenaWorker worker = {.arena = arena};
+    pthread_t thread;
+    assert(0 == pthread_create(&thread, NULL, test_arena_worker, &worker));
+    assert(0 == pthread_join(thread, NULL));
+    assert(worker.block && !test_inside(worker.block, live));
+    memset(worker.block, 1, 100);
+    vkc_arena_free(arena, worker.block);
+}
+
+static void test_arena_trim(void) {
+    VkcArena* arena = vkc_arena_create(TEST_CHUNK, VKC_NUMA_NODE_ANY);
+    assert(arena);
+
+    void* live = vkc_arena_malloc(arena, 200, 0);
+    assert(live);
+    memset(live, 0x5a, 200);
+
+    // A fresh spare is kept until idle_ns passes, then unmapped.
+    test_arena_leave_spare(arena, live);
+    assert(0 == vkc_arena_trim(arena, UINT64_MAX, false));
+    assert(vkc_arena_trim(arena, 0, false) > 0);
+    assert(0 == vkc_arena_trim(arena, 0, false));
+
+    // Purging drops a kept spare's pages once.
+    test_arena_leave_spare(arena, live);
+    assert(vkc_arena_trim(arena, UINT64_MAX, true) > 0);
+    assert(0 == vkc_arena_trim(arena, UINT64_MAX, true));
+
+    // The caller's chunk still holds a block, so even a full purge leaves it be.
+    vkc_arena_trim(arena, 0, true);
+    for (size_t i = 0; i < 200; i++) {
+        assert(0x5a == ((unsigned char*) live)[i]);
+    }
+
+    vkc_arena_destroy(arena);
+}
+
+int main(void) {
+    test_arena_rewind();
+    test_arena_spare();
+    test_arena_resize();
+    test_arena_trim();
+    puts("test_vkc_arena: ok");
+    return 0;
+}
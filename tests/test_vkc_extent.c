@@ -0,0 +1,111 @@
+/**
+ * @file tests/test_vkc_extent.c
+ * @brief Extent map: registration, radix lookups at granule edges, and resizing.
+ */
+
+#include "vk/extent.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_EXTENTS 64
+
+static void test_extent_lookup(void) {
+    int owner = 0;
+    VkcExtent extents[TEST_EXTENTS];
+    for (size_t i = 0; i < TEST_EXTENTS; i++) {
+        size_t size = (i % 4 + 1) * VKC_EXTENT_GRANULE;
+        extents[i] = (VkcExtent) {
+            .base = vkc_extent_map(size),
+            .size = size,
+            .kind = VKC_EXTENT_LARGE,
+            .owner = &owner,
+        };
+        assert(extents[i].base);
+        assert(0 == (uintptr_t) extents[i].base % VKC_EXTENT_GRANULE);
+        assert(!vkc_extent_lookup(extents[i].base));
+        assert(vkc_extent_register(&extents[i]));
+    }
+
+    // Every byte of a region resolves to it, from its first granule to its last.
+    for (size_t i = 0; i < TEST_EXTENTS; i++) {
+        uint8_t* base = extents[i].base;
+        assert(&extents[i] == vkc_extent_lookup(base));
+        assert(&extents[i] == vkc_extent_lookup(base + VKC_EXTENT_GRANULE - 1));
+        assert(&extents[i] == vkc_extent_lookup(base + extents[i].size - 1));
+        assert(&extents[i] != vkc_extent_lookup(base - 1));
+        assert(&extents[i] != vkc_extent_lookup(base + extents[i].size));
+    }
+
+    int local = 0;
+    assert(!vkc_extent_lookup(&local));
+    assert(!vkc_extent_lookup(NULL));
+
+    // Deregistering every other region leaves the rest resolvable.
+    for (size_t i = 0; i < TEST_EXTENTS; i += 2) {
+        vkc_extent_deregister(&extents[i]);
+        assert(!vkc_extent_lookup(extents[i].base));
+        vkc_extent_unmap(extents[i].base, extents[i].size);
+    }
+    for (size_t i = 1; i < TEST_EXTENTS; i += 2) {
+        uint8_t* last = (uint8_t*) extents[i].base + extents[i].size - 1;
+        assert(&extents[i] == vkc_extent_lookup(last));
+        vkc_extent_deregister(&extents[i]);
+        vkc_extent_unmap(extents[i].base, extents[i].size);
+    }
+}
+
+static void test_extent_resize(void) {
+    int owner = 0;
+    VkcExtent extent = {
+        .base = vkc_extent_map(VKC_EXTENT_GRANULE),
+        .size = VKC_EXTENT_GRANULE,
+        .kind = VKC_EXTENT_LARGE,
+        .owner = &owner,
+    };
+    assert(extent.base && vkc_extent_register(&extent));
+    memset(extent.base, 0x77, extent.size);
+
+    // Growing keeps the contents and publishes the new granules, moved or not.
+    for (size_t size = 2 * VKC_EXTENT_GRANULE; size <= 64 * VKC_EXTENT_GRANULE; size *= 2) {
+        assert(vkc_extent_resize(&extent, size, 0));
+        assert(size == extent.size);
+        uint8_t* base = extent.base;
+        assert(0x77 == base[0] && 0x77 == base[VKC_EXTENT_GRANULE - 1]);
+        assert(&extent == vkc_extent_lookup(base + size - 1));
+    }
+
+    // Moves honour the requested alignment.
+    assert(vkc_extent_resize(&extent, 128 * VKC_EXTENT_GRANULE, VKC_EXTENT_HUGE));
+    assert(0 == (uintptr_t) extent.base % VKC_EXTENT_HUGE);
+    assert(0x77 == ((uint8_t*) extent.base)[0]);
+
+    // Shrinking unpublishes the tail.
+    uint8_t* tail = (uint8_t*) extent.base + extent.size - 1;
+    assert(vkc_extent_resize(&extent, VKC_EXTENT_GRANULE, 0));
+    assert(&extent == vkc_extent_lookup(extent.base));
+    assert(&extent != vkc_extent_lookup(tail));
+
+    vkc_extent_deregister(&extent);
+    vkc_extent_unmap(extent.base, extent.size);
+}
+
+static void test_extent_huge(void) {
+    VkcExtentPages pages = VKC_EXTENT_PAGES_ADVISE;
+    void* base = vkc_extent_map_huge(VKC_EXTENT_HUGE + 1, &pages);
+    assert(base);
+    assert(0 == (uintptr_t) base % VKC_EXTENT_HUGE);
+    assert(VKC_EXTENT_PAGES_ADVISE == pages);
+    memset(base, 1, 2 * VKC_EXTENT_HUGE);
+    vkc_extent_unmap(base, 2 * VKC_EXTENT_HUGE);
+}
+
+int main(void) {
+    test_extent_lookup();
+    test_extent_resize();
+    test_extent_huge();
+    puts("test_vkc_extent: ok");
+    return 0;
+}
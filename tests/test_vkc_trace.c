@@ -0,0 +1,170 @@
+/**
+ * @file tests/test_vkc_trace.c
+ * @brief Trace recorder: records written from several threads read back from the file.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include "vk/allocator.h"
+#include "vk/trace.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_THREADS 4
+#define TEST_RECORDS 10000
+
+typedef struct TestTraceFile {
+    VkcTraceRecord* records;
+    size_t count;
+} TestTraceFile;
+
+static void test_trace_path(char* path, size_t size) {
+    snprintf(path, size, "/tmp/vkc-trace-XXXXXX");
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+}
+
+/**
+ * @brief Read a whole trace file back, checking its header.
+ */
+static TestTraceFile test_trace_read(const char* path) {
+    FILE* file = fopen(path, "rb");
+    assert(file);
+
+    VkcTraceHeader header;
+    assert(1 == fread(&header, sizeof(header), 1, file));
+    assert(0 == memcmp(header.magic, VKC_TRACE_MAGIC, sizeof(header.magic)));
+    assert(VKC_TRACE_VERSION == header.version);
+    assert(sizeof(VkcTraceRecord) == header.record_size);
+
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file) - (long) sizeof(header);
+    assert(0 == bytes % (long) sizeof(VkcTraceRecord));
+    fseek(file, sizeof(header), SEEK_SET);
+
+    TestTraceFile trace = {.count = (size_t) bytes / sizeof(VkcTraceRecord)};
+    trace.records = calloc(trace.count ? trace.count : 1, sizeof(VkcTraceRecord));
+    assert(trace.records);
+    assert(trace.count == fread(trace.records, sizeof(VkcTraceRecord), trace.count, file));
+    fclose(file);
+    return trace;
+}
+
+typedef struct TestTraceWorker {
+    VkcTrace* trace;
+    size_t index;
+} TestTraceWorker;
+
+static void* test_trace_worker(void* argument) {
+    TestTraceWorker* worker = argument;
+    for (size_t i = 0; i < TEST_RECORDS; i++) {
+        // The size encodes the thread and the order it recorded in.
+        size_t size = worker->index * TEST_RECORDS + i + 1;
+        vkc_trace_record(worker->trace, VKC_TRACE_ALLOCATE, NULL, &size, size, 16, 1);
+        if (0 == i % 1000) {
+            usleep(1000); // Give the writer a chance to keep up
+        }
+    }
+    return NULL;
+}
+
+static void test_trace_threads(void) {
+    char path[64];
+    test_trace_path(path, sizeof(path));
+    VkcTrace* trace = vkc_trace_create(path, 0);
+    assert(trace);
+
+    pthread_t threads[TEST_THREADS];
+    TestTraceWorker workers[TEST_THREADS];
+    for (size_t i = 0; i < TEST_THREADS; i++) {
+        workers[i] = (TestTraceWorker) {.trace = trace, .index = i};
+        assert(0 == pthread_create(&threads[i], NULL, test_trace_worker, &workers[i]));
+    }
+    for (size_t i = 0; i < TEST_THREADS; i++) {
+        assert(0 == pthread_join(threads[i], NULL));
+    }
+    uint64_t dropped = vkc_trace_dropped(trace);
+    vkc_trace_destroy(trace);
+
+    // Nothing is lost silently, and each thread's records keep their order.
+    TestTraceFile file = test_trace_read(path);
+    assert(file.count + dropped == TEST_THREADS * TEST_RECORDS);
+
+    uint64_t last[TEST_THREADS + 1] = {0};
+    uint64_t stamps[TEST_THREADS + 1] = {0};
+    for (size_t i = 0; i < file.count; i++) {
+        VkcTraceRecord* record = &file.records[i];
+        assert(VKC_TRACE_ALLOCATE == record->op);
+        assert(16 == record->alignment && 1 == record->scope);
+        assert(record->thread >= 1 && record->thread <= TEST_THREADS);
+        assert(record->size > last[record->thread]);
+        assert(record->timestamp >= stamps[record->thread]);
+        if (last[record->thread]) {
+            uint64_t index = (record->size - 1) / TEST_RECORDS;
+            assert(index == (last[record->thread] - 1) / TEST_RECORDS);
+        }
+        last[record->thread] = record->size;
+        stamps[record->thread] = record->timestamp;
+    }
+
+    free(file.records);
+    unlink(path);
+}
+
+static void test_trace_context(void) {
+    char path[64];
+    test_trace_path(path, sizeof(path));
+    VkcTrace* trace = vkc_trace_create(path, 16);
+    assert(trace);
+
+    VkcAllocatorContext* context = vkc_allocator_context_create();
+    assert(context);
+    assert(vkc_allocator_context_trace(context, trace));
+    const VkAllocationCallbacks* callbacks = vkc_allocator_context_callbacks(context);
+
+    VkSystemAllocationScope scope = VK_SYSTEM_ALLOCATION_SCOPE_OBJECT;
+    void* block = callbacks->pfnAllocation(callbacks->pUserData, 100, 16, scope);
+    void* grown = callbacks->pfnReallocation(callbacks->pUserData, block, 5000, 64, scope);
+    assert(block && grown);
+    callbacks->pfnFree(callbacks->pUserData, grown);
+
+    assert(vkc_allocator_context_trace(context, NULL));
+    vkc_allocator_context_destroy(context);
+    assert(0 == vkc_trace_dropped(trace));
+    vkc_trace_destroy(trace);
+
+    // The callbacks replay as allocate, reallocate, free on the same addresses.
+    TestTraceFile file = test_trace_read(path);
+    assert(3 == file.count);
+    VkcTraceRecord* records = file.records;
+    assert(VKC_TRACE_ALLOCATE == records[0].op);
+    assert((uintptr_t) block == records[0].address && 0 == records[0].original);
+    assert(100 == records[0].size && 16 == records[0].alignment && scope == records[0].scope);
+    assert(VKC_TRACE_REALLOCATE == records[1].op);
+    assert((uintptr_t) block == records[1].original);
+    assert((uintptr_t) grown == records[1].address);
+    assert(5000 == records[1].size && 64 == records[1].alignment);
+    assert(VKC_TRACE_FREE == records[2].op);
+    assert((uintptr_t) grown == records[2].original && 0 == records[2].address);
+    assert(records[0].thread == records[2].thread);
+    assert(records[0].timestamp <= records[1].timestamp);
+    assert(records[1].timestamp <= records[2].timestamp);
+
+    free(file.records);
+    unlink(path);
+}
+
+int main(void) {
+    test_trace_threads();
+    test_trace_context();
+    puts("test_vkc_trace: ok");
+    return 0;
+}
@@ -69,4 +69,4 @@ if [[ ! $# -gt 0 ]]; then
     exit 1
 fi
 
-./"$1"
+./"$1" "${@:2}"